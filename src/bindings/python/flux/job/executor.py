@@ -22,8 +22,14 @@ import time
 import os
 
 import flux
+import flux.constants
 from flux.job.submit import submit_async, submit_get_id
-from flux.job.event import event_watch_async, JobException, MAIN_EVENTS
+from flux.job.event import (
+    event_watch_async,
+    EventLogEvent,
+    JobException,
+    MAIN_EVENTS,
+)
 
 
 class _FluxExecutorThread(threading.Thread):
@@ -31,13 +37,19 @@ class _FluxExecutorThread(threading.Thread):
 
     Completes FluxExecutorFutures as events indicate that they finish.
 
+    Events are read either from one eventlog watch per job, or, if ``journal``
+    is True, from a single job-manager journal stream that is demultiplexed
+    by jobid.  The stream is filtered to the jobs of this thread, each added
+    once its jobid is known, so other users' jobs are never sent.
+
     :param exit_event: ``threading.Event`` indicating when the associated
         Executor has shut down.
     :param jobspecs_to_submit: a queue filled with jobspecs by the Executor
     :param poll_interval: the interval (in seconds) to check for new jobs.
+    :param journal: if True, read events from the job-manager journal.
     """
 
-    # pylint: disable=too-many-arguments
+    # pylint: disable=too-many-arguments,too-many-instance-attributes
     def __init__(
         self,
         exit_event,
@@ -45,6 +57,7 @@ class _FluxExecutorThread(threading.Thread):
         poll_interval,
         handle_args,
         handle_kwargs,
+        journal=False,
         **kwargs,
     ):
         super().__init__(**kwargs)
@@ -53,18 +66,25 @@ class _FluxExecutorThread(threading.Thread):
         self.__remaining_flux_futures = 0  # number of unfulfilled futures
         self.__poll_interval = poll_interval
         self.__flux_handle = flux.Flux(*handle_args, **handle_kwargs)
+        self.__journal = journal
+        self.__journal_rpc = None
+        self.__tracked_jobs = {}  # jobid -> (user_future, eventlog events seen)
+        self.__skip_events = {}  # jobid -> events to skip in eventlog watch
 
     def run(self):
         """Loop indefinitely, submitting jobspecs and fetching jobids."""
         self.__flux_handle.timer_watcher_create(
             self.__poll_interval, self.__submit_new_jobs, repeat=self.__poll_interval
         ).start()
+        if self.__journal:
+            self.__journal_subscribe()
         while self.__work_remains():
             self.__submit_new_jobs(reactor_run=False)
             if self.__flux_handle.reactor_run() < 0:
                 msg = "reactor start failed"
                 self.__flux_handle.fatal_error(msg)
                 raise RuntimeError(msg)
+        self.__journal_unsubscribe()
 
     def __work_remains(self):
         """Return True if and only if there is still work to be done.
@@ -106,31 +126,125 @@ class _FluxExecutorThread(threading.Thread):
         """Callback invoked when a jobid is ready for a submitted jobspec."""
         jobid = submit_get_id(submission_future)
         user_future._set_jobid(jobid)  # pylint: disable=protected-access
-        event_watch_async(self.__flux_handle, jobid).then(
-            self.__event_update, user_future
-        )
+        self.__track_job(jobid, user_future)
+
+    def __track_job(self, jobid, user_future):
+        """Start delivering events for ``jobid`` to ``user_future``."""
+        if self.__journal_rpc is None:
+            event_watch_async(self.__flux_handle, jobid).then(
+                self.__event_update, user_future
+            )
+            return
+        self.__tracked_jobs[jobid] = (user_future, 0)
+        # events the job has already posted are sent from the journal history
+        self.__journal_update_ids("add", jobid)
 
     def __event_update(self, event_future, user_future):
         """Callback invoked when a job has an event update."""
         event = event_future.get_event()
         if event is not None:
-            if event.name in user_future.EVENTS:
-                user_future._set_event(event)  # pylint: disable=protected-access
-            # check if the event tells us that the job is done
-            if not user_future.done():
-                if event.name == "finish":
-                    exit_status = event.context["status"]
-                    if os.WIFEXITED(exit_status):
-                        user_future.set_result(os.WEXITSTATUS(exit_status))
-                    elif os.WIFSIGNALED(exit_status):
-                        user_future.set_result(-os.WTERMSIG(exit_status))
-                    else:
-                        user_future.set_exception(ValueError(exit_status))
-                elif event.name == "exception" and event.context["severity"] == 0:
-                    user_future.set_exception(JobException(event))
+            if self.__skip_events:
+                # already delivered from the journal before falling back
+                jobid = user_future.jobid()
+                if self.__skip_events.get(jobid, 0) > 0:
+                    self.__skip_events[jobid] -= 1
+                    return
+                self.__skip_events.pop(jobid, None)
+            self.__set_event(user_future, event)
         else:  # no more events
             self.__remaining_flux_futures -= 1
 
+    @staticmethod
+    def __set_event(user_future, event):
+        """Pass an event to ``user_future`` and complete it if the job is done."""
+        if event.name in user_future.EVENTS:
+            user_future._set_event(event)  # pylint: disable=protected-access
+        # check if the event tells us that the job is done
+        if not user_future.done():
+            if event.name == "finish":
+                exit_status = event.context["status"]
+                if os.WIFEXITED(exit_status):
+                    user_future.set_result(os.WEXITSTATUS(exit_status))
+                elif os.WIFSIGNALED(exit_status):
+                    user_future.set_result(-os.WTERMSIG(exit_status))
+                else:
+                    user_future.set_exception(ValueError(exit_status))
+            elif event.name == "exception" and event.context["severity"] == 0:
+                user_future.set_exception(JobException(event))
+
+    def __journal_subscribe(self):
+        """Open one job-manager journal stream for all jobs of this thread.
+
+        The stream starts with no jobs.  Each is added once its jobid is known.
+        """
+        self.__journal_rpc = self.__flux_handle.rpc(
+            "job-manager.events-journal",
+            {"ids": []},
+            flags=flux.constants.FLUX_RPC_STREAMING,
+        ).then(self.__journal_update)
+
+    def __journal_update_ids(self, action, jobid):
+        """Add ``jobid`` to, or remove it from, the journal stream's jobs."""
+        self.__flux_handle.rpc(
+            "job-manager.events-journal-update",
+            {"matchtag": self.__journal_rpc.pimpl.get_matchtag(), action: [jobid]},
+            flags=flux.constants.FLUX_RPC_NORESPONSE,
+        )
+
+    def __journal_unsubscribe(self):
+        if self.__journal_rpc is not None:
+            matchtag = self.__journal_rpc.pimpl.get_matchtag()
+            self.__journal_rpc = None
+            self.__flux_handle.rpc(
+                "job-manager.events-journal-cancel",
+                {"matchtag": matchtag},
+                flags=flux.constants.FLUX_RPC_NORESPONSE,
+            )
+
+    def __journal_update(self, journal_rpc):
+        """Callback invoked when the journal has a batch of events."""
+        try:
+            events = journal_rpc.get()["events"]
+        except OSError:
+            if self.__journal_rpc is journal_rpc:
+                self.__journal_fallback()
+            return
+        journal_rpc.reset()
+        for wrapped_entry in events:
+            jobid = wrapped_entry["id"]
+            seq = wrapped_entry["eventlog_seq"]
+            if seq < 0:  # journal-only event, not in the job eventlog
+                continue
+            if jobid in self.__tracked_jobs:
+                event = EventLogEvent(wrapped_entry["entry"])
+                self.__journal_event(jobid, seq, event)
+
+    def __journal_event(self, jobid, seq, event):
+        user_future, seen = self.__tracked_jobs[jobid]
+        if seq < seen:  # duplicate from the journal history
+            return
+        self.__tracked_jobs[jobid] = (user_future, seq + 1)
+        self.__set_event(user_future, event)
+        if event.name == "clean":  # last event in the eventlog
+            del self.__tracked_jobs[jobid]
+            self.__remaining_flux_futures -= 1
+            if self.__journal_rpc is not None:
+                self.__journal_update_ids("remove", jobid)
+
+    def __journal_fallback(self):
+        """The journal is unavailable: watch the eventlog of each job instead.
+
+        Events already delivered from the journal are skipped.
+        """
+        self.__journal_rpc = None
+        for jobid, (user_future, seen) in self.__tracked_jobs.items():
+            if seen > 0:
+                self.__skip_events[jobid] = seen
+            event_watch_async(self.__flux_handle, jobid).then(
+                self.__event_update, user_future
+            )
+        self.__tracked_jobs.clear()
+
 
 class FluxExecutorFuture(concurrent.futures.Future):
     """A ``concurrent.futures.Future`` subclass that represents a single Flux job.
@@ -365,6 +479,12 @@ class FluxExecutor:
         the executor.
     :param handle_kwargs: keyword arguments to the ``flux.Flux`` instances used by
         the executor.
+    :param journal: if True, each worker thread subscribes once to the
+        job-manager journal and dispatches events to futures by jobid,
+        rather than watching the eventlog of every job it submits. This
+        keeps the number of server-side watchers independent of the number
+        of jobs. Guests are only sent events for their own jobs. If the
+        journal is unavailable, the executor falls back to watching eventlogs.
     """
 
     # Used to assign unique thread names when thread_name_prefix is not supplied.
@@ -380,6 +500,7 @@ class FluxExecutor:
         poll_interval=0.1,
         handle_args=(),
         handle_kwargs={},
+        journal=False,
     ):
         if threads < 0:
             raise ValueError("the number of threads must be > 0")
@@ -398,6 +519,7 @@ class FluxExecutor:
                 poll_interval,
                 handle_args,
                 handle_kwargs,
+                journal=journal,
                 name=(f"{thread_name_prefix}-{i}"),
                 daemon=True,
             )
@@ -70,6 +70,7 @@
 #include "exec.h"
 #include "ping.h"
 #include "rusage.h"
+#include "rpcstats.h"
 #include "boot_config.h"
 #include "boot_pmi.h"
 #include "publisher.h"
@@ -104,6 +105,7 @@ static int unload_module_byname (broker_ctx_t *ctx, const char *name,
 static void set_proctitle (uint32_t rank);
 
 static int create_rundir (attr_t *attrs);
+static int init_overlay_transport (struct overlay *ov, attr_t *attrs);
 static int create_broker_rundir (struct overlay *ov, void *arg);
 static int create_dummyattrs (flux_t *h, uint32_t rank, uint32_t size);
 
@@ -344,6 +346,8 @@ int main (int argc, char *argv[])
     }
     overlay_set_parent_cb (ctx.overlay, parent_cb, &ctx);
     overlay_set_child_cb (ctx.overlay, child_cb, &ctx);
+    if (init_overlay_transport (ctx.overlay, ctx.attrs) < 0)
+        goto cleanup;
 
     /* Arrange for the publisher to route event messages.
      * handle_event - local subscribers (ctx.h)
@@ -483,6 +487,10 @@ int main (int argc, char *argv[])
         log_err ("rusage_initialize");
         goto cleanup;
     }
+    if (!(ctx.rpcstats = rpcstats_create (ctx.h))) {
+        log_err ("rpcstats_create");
+        goto cleanup;
+    }
 
     if (!(handlers = broker_add_services (&ctx))) {
         log_err ("broker_add_services");
@@ -581,6 +589,7 @@ cleanup:
     heartbeat_destroy (ctx.heartbeat);
     service_switch_destroy (ctx.services);
     broker_remove_services (handlers);
+    rpcstats_destroy (ctx.rpcstats);
     publisher_destroy (ctx.publisher);
     brokercfg_destroy (ctx.config);
     runat_destroy (ctx.runat);
@@ -794,6 +803,29 @@ cleanup:
     return rc;
 }
 
+/* Select the overlay transport with the tbon.transport attribute,
+ * which becomes immutable once the broker is running.
+ */
+static int init_overlay_transport (struct overlay *ov, attr_t *attrs)
+{
+    const char *name = "zmq";
+    const char *val;
+
+    if (attr_get (attrs, "tbon.transport", &val, NULL) == 0 && val)
+        name = val;
+    if (overlay_set_transport (ov, name) < 0) {
+        log_msg ("tbon.transport: unknown transport %s", name);
+        return -1;
+    }
+    name = overlay_get_transport (ov);
+    (void)attr_delete (attrs, "tbon.transport", true);
+    if (attr_add (attrs, "tbon.transport", name, FLUX_ATTRFLAG_IMMUTABLE) < 0) {
+        log_err ("attr_add tbon.transport");
+        return -1;
+    }
+    return 0;
+}
+
 /*  Handle global rundir attribute.
  *
  *  If not set, create a temporary directory and use it as the rundir.
@@ -1801,12 +1833,15 @@ static int broker_request_sendmsg_internal (broker_ctx_t *ctx,
                 return -1;
             }
         }
+        else
+            rpcstats_request (ctx->rpcstats, msg);
     }
     /* Deliver to local service if this broker is the addressed rank.
      */
     else if (nodeid == ctx->rank) {
         if (service_send (ctx->services, msg) < 0)
             return -1;
+        rpcstats_request (ctx->rpcstats, msg);
     }
     /* Send the request up or down TBON as addressed.
      */
@@ -1892,6 +1927,7 @@ static int broker_response_sendmsg (broker_ctx_t *ctx, const flux_msg_t *msg)
     char *uuid = NULL;
     uint32_t rank;
 
+    rpcstats_response (ctx->rpcstats, msg);
     if (flux_msg_get_route_last (msg, &uuid) < 0)
         goto done;
     if (uuid == NULL) { // broker resident service
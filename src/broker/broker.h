@@ -36,6 +36,7 @@ struct broker {
     zlist_t *subscriptions;     /* subscripts for internal services */
     struct content_cache *cache;
     struct publisher *publisher;
+    struct rpcstats *rpcstats;
     int tbon_k;
 
     struct runat *runat;
@@ -0,0 +1,466 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* channel.c - lock-free in-process message channel
+ *
+ * Ring indices are free running counters: the producer owns 'head', the
+ * consumer owns 'tail', and the ring is full when head - tail exceeds
+ * the mask.  The slot is written before 'head' is published, and read
+ * before 'tail' is published, so neither side touches a slot the other
+ * may be using.
+ *
+ * Wakeups avoid a syscall per message.  The producer signals the
+ * consumer's eventfd only if, after publishing, it finds that the
+ * consumer had already caught up (tail == old head).  The consumer
+ * clears its eventfd before testing the ring for emptiness.  Both
+ * sides use sequentially consistent ordering for the head/tail store
+ * followed by the load of the other index, so at least one of them
+ * observes the other's update and a message can't be left unnoticed.
+ * The 'want_space' flag is handled the same way in the other direction.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "channel.h"
+
+#define CACHELINE_SIZE 64
+
+struct ring {
+    size_t head __attribute__ ((aligned (CACHELINE_SIZE)));
+    size_t tail __attribute__ ((aligned (CACHELINE_SIZE)));
+    int want_space __attribute__ ((aligned (CACHELINE_SIZE)));
+    size_t mask;
+    flux_msg_t **slots;
+};
+
+struct endpoint {
+    struct channel *ch;
+    int end;
+    int efd;
+    struct ring *in;        /* ring consumed by this end */
+    struct ring *out;       /* ring produced by this end */
+    struct endpoint *peer;
+    zlist_t *backlog;       /* broker end only: overflow of 'out' */
+    flux_t *h;
+};
+
+struct channel {
+    struct ring ring[2];    /* ring[n] is consumed by end n */
+    struct endpoint ep[2];
+};
+
+static const struct flux_handle_ops broker_ops;
+static const struct flux_handle_ops module_ops;
+
+static int ring_init (struct ring *r, int capacity)
+{
+    size_t size = 1;
+
+    while (size < capacity)
+        size <<= 1;
+    if (!(r->slots = calloc (size, sizeof (r->slots[0]))))
+        return -1;
+    r->mask = size - 1;
+    return 0;
+}
+
+static bool ring_full (struct ring *r)
+{
+    size_t head = __atomic_load_n (&r->head, __ATOMIC_RELAXED);
+    size_t tail = __atomic_load_n (&r->tail, __ATOMIC_SEQ_CST);
+
+    return head - tail > r->mask;
+}
+
+static bool ring_empty (struct ring *r)
+{
+    size_t tail = __atomic_load_n (&r->tail, __ATOMIC_RELAXED);
+    size_t head = __atomic_load_n (&r->head, __ATOMIC_SEQ_CST);
+
+    return head == tail;
+}
+
+/* Producer side.  Return -1 if the ring is full.
+ * Set 'wake' if the consumer may be waiting on its eventfd.
+ */
+static int ring_push (struct ring *r, flux_msg_t *msg, bool *wake)
+{
+    size_t head = __atomic_load_n (&r->head, __ATOMIC_RELAXED);
+    size_t tail = __atomic_load_n (&r->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail > r->mask)
+        return -1;
+    r->slots[head & r->mask] = msg;
+    __atomic_store_n (&r->head, head + 1, __ATOMIC_SEQ_CST);
+    tail = __atomic_load_n (&r->tail, __ATOMIC_SEQ_CST);
+    if (tail == head)
+        *wake = true;
+    return 0;
+}
+
+/* Consumer side.  Return NULL if the ring is empty.
+ * Set 'wake' if the producer is waiting for space.
+ */
+static flux_msg_t *ring_pop (struct ring *r, bool *wake)
+{
+    size_t tail = __atomic_load_n (&r->tail, __ATOMIC_RELAXED);
+    size_t head = __atomic_load_n (&r->head, __ATOMIC_SEQ_CST);
+    flux_msg_t *msg;
+
+    if (head == tail)
+        return NULL;
+    msg = r->slots[tail & r->mask];
+    __atomic_store_n (&r->tail, tail + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n (&r->want_space, __ATOMIC_SEQ_CST)
+        && __atomic_exchange_n (&r->want_space, 0, __ATOMIC_SEQ_CST))
+        *wake = true;
+    return msg;
+}
+
+/* Ask the consumer for a wakeup when space frees up.
+ * Return true if the ring is still full afterwards.
+ */
+static bool ring_want_space (struct ring *r)
+{
+    __atomic_store_n (&r->want_space, 1, __ATOMIC_SEQ_CST);
+    return ring_full (r);
+}
+
+static void ring_fini (struct ring *r)
+{
+    if (r->slots) {
+        flux_msg_t *msg;
+        bool wake;
+        while ((msg = ring_pop (r, &wake)))
+            flux_msg_destroy (msg);
+        free (r->slots);
+    }
+}
+
+static void endpoint_signal (struct endpoint *ep)
+{
+    uint64_t val = 1;
+
+    /* EAGAIN would mean the counter is about to overflow,
+     * in which case the peer has a wakeup pending anyway.
+     */
+    if (write (ep->efd, &val, sizeof (val)) < 0)
+        return;
+}
+
+static void endpoint_clear (struct endpoint *ep)
+{
+    uint64_t val;
+
+    if (read (ep->efd, &val, sizeof (val)) < 0)
+        return;
+}
+
+/* Block until this end's eventfd is signaled.
+ */
+static int endpoint_wait (struct endpoint *ep)
+{
+    struct pollfd pfd = { .fd = ep->efd, .events = POLLIN };
+
+    while (poll (&pfd, 1, -1) < 0) {
+        if (errno != EINTR)
+            return -1;
+    }
+    endpoint_clear (ep);
+    return 0;
+}
+
+/* Move as much of the broker end's backlog into the ring as will fit.
+ */
+static void backlog_flush (struct endpoint *ep)
+{
+    flux_msg_t *msg;
+    bool wake = false;
+
+    while ((msg = zlist_head (ep->backlog))) {
+        if (ring_push (ep->out, msg, &wake) < 0) {
+            if (ring_want_space (ep->out))
+                break;
+            continue;
+        }
+        (void)zlist_pop (ep->backlog);
+    }
+    if (wake)
+        endpoint_signal (ep->peer);
+}
+
+int channel_send (struct channel *ch, int end, flux_msg_t *msg)
+{
+    struct endpoint *ep;
+    bool wake = false;
+
+    if (!ch || (end != CHANNEL_BROKER && end != CHANNEL_MODULE) || !msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    ep = &ch->ep[end];
+    if (ep->backlog) {
+        if (zlist_size (ep->backlog) > 0
+            || ring_push (ep->out, msg, &wake) < 0) {
+            if (zlist_append (ep->backlog, msg) < 0) {
+                errno = ENOMEM;
+                return -1;
+            }
+            backlog_flush (ep);
+            return 0;
+        }
+    }
+    else {
+        while (ring_push (ep->out, msg, &wake) < 0) {
+            if (ring_want_space (ep->out) && endpoint_wait (ep) < 0)
+                return -1;
+        }
+    }
+    if (wake)
+        endpoint_signal (ep->peer);
+    return 0;
+}
+
+flux_msg_t *channel_recv (struct channel *ch, int end, int flags)
+{
+    struct endpoint *ep;
+    flux_msg_t *msg;
+    bool wake = false;
+
+    if (!ch || (end != CHANNEL_BROKER && end != CHANNEL_MODULE)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    ep = &ch->ep[end];
+    while (!(msg = ring_pop (ep->in, &wake))) {
+        if ((flags & FLUX_O_NONBLOCK)) {
+            errno = EWOULDBLOCK;
+            return NULL;
+        }
+        if (endpoint_wait (ep) < 0)
+            return NULL;
+        if (ep->backlog)
+            backlog_flush (ep);
+    }
+    if (wake)
+        endpoint_signal (ep->peer);
+    return msg;
+}
+
+static int op_pollfd (void *impl)
+{
+    struct endpoint *ep = impl;
+
+    return ep->efd;
+}
+
+/* Clear the eventfd before testing the rings (see above).
+ */
+static int op_pollevents (void *impl)
+{
+    struct endpoint *ep = impl;
+    int revents = 0;
+
+    endpoint_clear (ep);
+    if (ep->backlog)
+        backlog_flush (ep);
+    if (!ring_empty (ep->in))
+        revents |= FLUX_POLLIN;
+    if (ep->backlog || !ring_full (ep->out))
+        revents |= FLUX_POLLOUT;
+    return revents;
+}
+
+static int op_send (void *impl, const flux_msg_t *msg, int flags)
+{
+    struct endpoint *ep = impl;
+    flux_msg_t *cpy;
+
+    if (!(cpy = flux_msg_copy (msg, true)))
+        return -1;
+    if (channel_send (ep->ch, ep->end, cpy) < 0) {
+        flux_msg_destroy (cpy);
+        return -1;
+    }
+    return 0;
+}
+
+static flux_msg_t *op_recv (void *impl, int flags)
+{
+    struct endpoint *ep = impl;
+
+    return channel_recv (ep->ch, ep->end, flags);
+}
+
+static int op_event_subscribe (void *impl, const char *topic)
+{
+    struct endpoint *ep = impl;
+    flux_future_t *f;
+    int rc = -1;
+
+    if (!(f = flux_rpc_pack (ep->h, "broker.sub", FLUX_NODEID_ANY, 0,
+                             "{ s:s }", "topic", topic)))
+        goto done;
+    if (flux_future_get (f, NULL) < 0)
+        goto done;
+    rc = 0;
+done:
+    flux_future_destroy (f);
+    return rc;
+}
+
+static int op_event_unsubscribe (void *impl, const char *topic)
+{
+    struct endpoint *ep = impl;
+    flux_future_t *f;
+    int rc = -1;
+
+    if (!(f = flux_rpc_pack (ep->h, "broker.unsub", FLUX_NODEID_ANY, 0,
+                             "{ s:s }", "topic", topic)))
+        goto done;
+    if (flux_future_get (f, NULL) < 0)
+        goto done;
+    rc = 0;
+done:
+    flux_future_destroy (f);
+    return rc;
+}
+
+/* The channel outlives its handles, so there is nothing to free here.
+ */
+static void op_fini (void *impl)
+{
+    struct endpoint *ep = impl;
+
+    ep->h = NULL;
+}
+
+flux_t *channel_open (struct channel *ch, int end, int flags)
+{
+    struct endpoint *ep;
+    const struct flux_handle_ops *ops;
+
+    if (!ch || (end != CHANNEL_BROKER && end != CHANNEL_MODULE)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    ep = &ch->ep[end];
+    if (ep->h) {
+        errno = EEXIST;
+        return NULL;
+    }
+    ops = end == CHANNEL_MODULE ? &module_ops : &broker_ops;
+    if (!(ep->h = flux_handle_create (ep, ops, flags)))
+        return NULL;
+    return ep->h;
+}
+
+void channel_destroy (struct channel *ch)
+{
+    if (ch) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < 2; i++) {
+            struct endpoint *ep = &ch->ep[i];
+            if (ep->backlog) {
+                flux_msg_t *msg;
+                while ((msg = zlist_pop (ep->backlog)))
+                    flux_msg_destroy (msg);
+                zlist_destroy (&ep->backlog);
+            }
+            if (ep->efd >= 0)
+                (void)close (ep->efd);
+            ring_fini (&ch->ring[i]);
+        }
+        free (ch);
+        errno = saved_errno;
+    }
+}
+
+struct channel *channel_create (int capacity)
+{
+    struct channel *ch;
+    int i;
+
+    if (capacity < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((errno = posix_memalign ((void **)&ch, CACHELINE_SIZE, sizeof (*ch))))
+        return NULL;
+    memset (ch, 0, sizeof (*ch));
+    for (i = 0; i < 2; i++) {
+        struct endpoint *ep = &ch->ep[i];
+        ep->ch = ch;
+        ep->end = i;
+        ep->in = &ch->ring[i];
+        ep->out = &ch->ring[!i];
+        ep->peer = &ch->ep[!i];
+        ep->efd = -1;
+    }
+    for (i = 0; i < 2; i++) {
+        if (ring_init (&ch->ring[i], capacity) < 0)
+            goto nomem;
+        if ((ch->ep[i].efd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+            goto error;
+    }
+    if (!(ch->ep[CHANNEL_BROKER].backlog = zlist_new ()))
+        goto nomem;
+    return ch;
+nomem:
+    errno = ENOMEM;
+error:
+    channel_destroy (ch);
+    return NULL;
+}
+
+/* The broker end is wrapped in a handle so flux_handle_watcher_create()
+ * can drive it, but the broker sends and receives with channel_send()
+ * and channel_recv() directly.
+ */
+static const struct flux_handle_ops broker_ops = {
+    .pollfd = op_pollfd,
+    .pollevents = op_pollevents,
+    .send = op_send,
+    .recv = op_recv,
+    .getopt = NULL,
+    .setopt = NULL,
+    .event_subscribe = NULL,
+    .event_unsubscribe = NULL,
+    .impl_destroy = op_fini,
+};
+
+static const struct flux_handle_ops module_ops = {
+    .pollfd = op_pollfd,
+    .pollevents = op_pollevents,
+    .send = op_send,
+    .recv = op_recv,
+    .getopt = NULL,
+    .setopt = NULL,
+    .event_subscribe = op_event_subscribe,
+    .event_unsubscribe = op_event_unsubscribe,
+    .impl_destroy = op_fini,
+};
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,66 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_CHANNEL_H
+#define _BROKER_CHANNEL_H
+
+#include <flux/core.h>
+
+/* In-process message channel between the broker and a module thread.
+ *
+ * Each direction is a bounded single-producer, single-consumer ring of
+ * flux_msg_t pointers.  Messages are not serialized: the sender hands
+ * its reference to the channel and the receiver takes it over.  Each end
+ * has an eventfd that is signaled when its inbound ring goes non-empty,
+ * or when its outbound ring frees space after it was found full.
+ *
+ * The broker end never blocks.  Messages that don't fit in the ring
+ * toward the module are held on a backlog that is moved into the ring
+ * as the module drains it.  The module end blocks in send until space
+ * is available, which cannot deadlock since the broker never waits on
+ * a module.
+ */
+
+enum {
+    CHANNEL_BROKER = 0,
+    CHANNEL_MODULE = 1,
+};
+
+/* Create a channel whose rings hold at least 'capacity' messages.
+ */
+struct channel *channel_create (int capacity);
+
+/* Destroy the channel and any messages still in flight.
+ * Both ends must be idle, e.g. the module thread has been joined.
+ */
+void channel_destroy (struct channel *ch);
+
+/* Send 'msg' from 'end'.  On success, the channel takes over the
+ * caller's reference.  On failure, the caller retains it.
+ */
+int channel_send (struct channel *ch, int end, flux_msg_t *msg);
+
+/* Receive a message at 'end'.  If FLUX_O_NONBLOCK is set in 'flags'
+ * and no message is available, return NULL with errno = EWOULDBLOCK.
+ */
+flux_msg_t *channel_recv (struct channel *ch, int end, int flags);
+
+/* Wrap 'end' in a flux_t handle.  Since flux_send() takes a const message,
+ * sending on the handle costs one flux_msg_copy(); use channel_send()
+ * where the message can be given away.  Event subscriptions on the
+ * module end are forwarded to the broker as broker.sub/unsub RPCs.
+ */
+flux_t *channel_open (struct channel *ch, int end, int flags);
+
+#endif /* !_BROKER_CHANNEL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -17,6 +17,7 @@
 #include "config.h"
 #endif
 #include <czmq.h>
+#include <arpa/inet.h>
 
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/wallclock.h"
@@ -34,6 +35,14 @@ static const int default_critical_level = LOG_CRIT;
 static const int default_stderr_level = LOG_ERR;
 static const stderr_mode_t default_stderr_mode = MODE_LEADER;
 static const int default_level = LOG_DEBUG;
+static const int default_forward_rate_limit = 1000;
+
+/* Log entries forwarded upstream are batched into one log.forward request
+ * of up to forward_batch_size bytes, sent at most forward_batch_timeout
+ * seconds after the first entry was added.
+ */
+static const int forward_batch_size = 65536;
+static const double forward_batch_timeout = 0.005;
 
 #define LOGBUF_MAGIC 0xe1e2e3e4
 typedef struct {
@@ -52,8 +61,24 @@ typedef struct {
     int ring_size;
     int seq;
     zlist_t *followers;
+    int forward_rate_limit;
+    char *fwd_buf;          // batch of length-prefixed entries
+    int fwd_used;
+    flux_watcher_t *fwd_timer;
+    char *fwd_last;         // last entry added to batch, for dup detection
+    int fwd_last_len;
+    int fwd_repeat;         // number of suppressed repeats of fwd_last
+    zhash_t *fwd_sources;   // appname => struct fwd_source
 } logbuf_t;
 
+/* Per-source (local appname) token bucket for forward rate limiting.
+ */
+struct fwd_source {
+    double tokens;
+    double t_last;
+    int dropped;
+};
+
 struct logbuf_entry {
     char *buf;
     int seq;
@@ -162,6 +187,7 @@ static logbuf_t *logbuf_create (void)
     logbuf->stderr_mode = default_stderr_mode;
     logbuf->level = default_level;
     logbuf->ring_size = default_ring_size;
+    logbuf->forward_rate_limit = default_forward_rate_limit;
     if (!(logbuf->buf = zlist_new ())) {
         errno = ENOMEM;
         goto cleanup;
@@ -170,6 +196,10 @@ static logbuf_t *logbuf_create (void)
         errno = ENOMEM;
         goto cleanup;
     }
+    if (!(logbuf->fwd_sources = zhash_new ())) {
+        errno = ENOMEM;
+        goto cleanup;
+    }
     return logbuf;
 cleanup:
     logbuf_destroy (logbuf);
@@ -187,6 +217,10 @@ void logbuf_destroy (logbuf_t *logbuf)
         /* logbuf_destroy() would be called after local connector
          * unloaded, so no need to send ENODATA to followers */
         zlist_destroy (&logbuf->followers);
+        flux_watcher_destroy (logbuf->fwd_timer);
+        zhash_destroy (&logbuf->fwd_sources);
+        free (logbuf->fwd_buf);
+        free (logbuf->fwd_last);
         if (logbuf->f)
             (void)fclose (logbuf->f);
         if (logbuf->filename)
@@ -237,6 +271,16 @@ static int logbuf_set_level (logbuf_t *logbuf, int level)
 }
 
 
+static int logbuf_set_forward_rate_limit (logbuf_t *logbuf, int limit)
+{
+    if (limit < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    logbuf->forward_rate_limit = limit;
+    return 0;
+}
+
 static int logbuf_set_ring_size (logbuf_t *logbuf, int size)
 {
     if (size < 0) {
@@ -283,6 +327,10 @@ static int attr_get_log (const char *name, const char **val, void *arg)
         n = snprintf (s, sizeof (s), "%d", logbuf->forward_level);
         assert (n < sizeof (s));
         *val = s;
+    } else if (!strcmp (name, "log-forward-rate-limit")) {
+        n = snprintf (s, sizeof (s), "%d", logbuf->forward_rate_limit);
+        assert (n < sizeof (s));
+        *val = s;
     } else if (!strcmp (name, "log-critical-level")) {
         n = snprintf (s, sizeof (s), "%d", logbuf->critical_level);
         assert (n < sizeof (s));
@@ -332,6 +380,10 @@ static int attr_set_log (const char *name, const char *val, void *arg)
         int level = strtol (val, NULL, 10);
         if (logbuf_set_forward_level (logbuf, level) < 0)
             goto done;
+    } else if (!strcmp (name, "log-forward-rate-limit")) {
+        int limit = strtol (val, NULL, 10);
+        if (logbuf_set_forward_rate_limit (logbuf, limit) < 0)
+            goto done;
     } else if (!strcmp (name, "log-critical-level")) {
         int level = strtol (val, NULL, 10);
         if (logbuf_set_critical_level (logbuf, level) < 0)
@@ -398,6 +450,9 @@ static int logbuf_register_attrs (logbuf_t *logbuf, attr_t *attrs)
     if (attr_add_active (attrs, "log-forward-level", 0,
                          attr_get_log, attr_set_log, logbuf) < 0)
         goto done;
+    if (attr_add_active (attrs, "log-forward-rate-limit", 0,
+                         attr_get_log, attr_set_log, logbuf) < 0)
+        goto done;
     if (attr_add_active (attrs, "log-critical-level", 0,
                          attr_get_log, attr_set_log, logbuf) < 0)
         goto done;
@@ -415,18 +470,260 @@ done:
     return rc;
 }
 
-static int logbuf_forward (logbuf_t *logbuf, const char *buf, int len)
+/* Send the forward batch upstream in one log.forward request.
+ */
+static int fwd_batch_send (logbuf_t *logbuf)
 {
-    assert (logbuf->magic == LOGBUF_MAGIC);
-
     flux_future_t *f;
-    if (!(f = flux_rpc_raw (logbuf->h, "log.append", buf, len,
-                              FLUX_NODEID_UPSTREAM, FLUX_RPC_NORESPONSE)))
+
+    if (logbuf->fwd_used == 0)
+        return 0;
+    f = flux_rpc_raw (logbuf->h,
+                      "log.forward",
+                      logbuf->fwd_buf,
+                      logbuf->fwd_used,
+                      FLUX_NODEID_UPSTREAM,
+                      FLUX_RPC_NORESPONSE);
+    logbuf->fwd_used = 0;
+    if (!f)
         return -1;
     flux_future_destroy (f);
     return 0;
 }
 
+/* Append one entry to the forward batch, prefixed with its length
+ * as a 32-bit integer in network byte order.  If the batch is full,
+ * send it first.  An entry larger than a batch is truncated.
+ */
+static int fwd_batch_append (logbuf_t *logbuf, const char *buf, int len)
+{
+    uint32_t n;
+
+    if (!logbuf->fwd_buf
+        && !(logbuf->fwd_buf = malloc (forward_batch_size))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (len > forward_batch_size - sizeof (n))
+        len = forward_batch_size - sizeof (n);
+    if (logbuf->fwd_used + sizeof (n) + len > forward_batch_size) {
+        if (fwd_batch_send (logbuf) < 0)
+            return -1;
+    }
+    n = htonl (len);
+    memcpy (logbuf->fwd_buf + logbuf->fwd_used, &n, sizeof (n));
+    memcpy (logbuf->fwd_buf + logbuf->fwd_used + sizeof (n), buf, len);
+    logbuf->fwd_used += sizeof (n) + len;
+    return 0;
+}
+
+/* Add a notice generated by this broker to the forward batch, using
+ * header 'hdr' with a new timestamp and, if severity >= 0, severity.
+ */
+static int fwd_batch_append_notice (logbuf_t *logbuf,
+                                    struct stdlog_header *hdr,
+                                    int severity,
+                                    const char *fmt,
+                                    ...)
+{
+    char timestamp[WALLCLOCK_MAXLEN];
+    char notice[STDLOG_MAX_HEADER + 128];
+    va_list ap;
+    int n;
+
+    if (severity >= 0)
+        hdr->pri = STDLOG_PRI (severity, STDLOG_FACILITY (hdr->pri));
+    if (wallclock_get_zulu (timestamp, sizeof (timestamp)) >= 0)
+        hdr->timestamp = timestamp;
+    va_start (ap, fmt);
+    n = stdlog_vencodef (notice, sizeof (notice), hdr,
+                         STDLOG_NILVALUE, fmt, ap);
+    va_end (ap);
+    if (n > sizeof (notice))
+        n = sizeof (notice);
+    return fwd_batch_append (logbuf, notice, n);
+}
+
+/* If the last forwarded entry was repeated, add the count to the batch.
+ */
+static int fwd_batch_append_repeat (logbuf_t *logbuf)
+{
+    struct stdlog_header hdr;
+    int count = logbuf->fwd_repeat;
+
+    if (count == 0)
+        return 0;
+    logbuf->fwd_repeat = 0;
+    stdlog_init (&hdr);
+    if (stdlog_decode (logbuf->fwd_last, logbuf->fwd_last_len,
+                       &hdr, NULL, NULL, NULL, NULL) < 0)
+        return -1;
+    return fwd_batch_append_notice (logbuf,
+                                    &hdr,
+                                    -1,
+                                    "last message repeated %d times",
+                                    count);
+}
+
+/* Add notices for entries dropped by log-forward-rate-limit to the batch.
+ */
+static int fwd_batch_append_dropped (logbuf_t *logbuf)
+{
+    struct fwd_source *src;
+    char hostname[32];
+    int rc = 0;
+
+    snprintf (hostname, sizeof (hostname), "%" PRIu32, logbuf->rank);
+    src = zhash_first (logbuf->fwd_sources);
+    while (src) {
+        if (src->dropped > 0) {
+            struct stdlog_header hdr;
+
+            stdlog_init (&hdr);
+            hdr.hostname = hostname;
+            hdr.appname = (char *)zhash_cursor (logbuf->fwd_sources);
+            if (fwd_batch_append_notice (logbuf,
+                                         &hdr,
+                                         LOG_WARNING,
+                                         "%d messages dropped by"
+                                         " log-forward-rate-limit",
+                                         src->dropped) < 0)
+                rc = -1;
+            src->dropped = 0;
+        }
+        src = zhash_next (logbuf->fwd_sources);
+    }
+    return rc;
+}
+
+/* Send batched entries upstream, with notices for pending repeats and
+ * rate limited entries.
+ */
+static int logbuf_forward_flush (logbuf_t *logbuf)
+{
+    int rc = 0;
+
+    flux_watcher_stop (logbuf->fwd_timer);
+    if (fwd_batch_append_repeat (logbuf) < 0)
+        rc = -1;
+    if (fwd_batch_append_dropped (logbuf) < 0)
+        rc = -1;
+    if (fwd_batch_send (logbuf) < 0)
+        rc = -1;
+    return rc;
+}
+
+static void forward_timer_cb (flux_reactor_t *r,
+                              flux_watcher_t *w,
+                              int revents,
+                              void *arg)
+{
+    logbuf_t *logbuf = arg;
+    if (logbuf_forward_flush (logbuf) < 0)
+        log_err ("error forwarding log entries");
+}
+
+/* Return true if an entry from local source 'appname' should be dropped
+ * because the source has exceeded log-forward-rate-limit entries per second.
+ */
+static bool fwd_rate_limited (logbuf_t *logbuf, const char *appname)
+{
+    struct fwd_source *src;
+    double now;
+
+    if (logbuf->forward_rate_limit == 0)
+        return false;
+    now = flux_reactor_now (flux_get_reactor (logbuf->h));
+    if (!(src = zhash_lookup (logbuf->fwd_sources, appname))) {
+        if (!(src = calloc (1, sizeof (*src))))
+            return false;
+        src->tokens = logbuf->forward_rate_limit;
+        src->t_last = now;
+        if (zhash_insert (logbuf->fwd_sources, appname, src) < 0) {
+            free (src);
+            return false;
+        }
+        zhash_freefn (logbuf->fwd_sources, appname, free);
+    }
+    src->tokens += (now - src->t_last) * logbuf->forward_rate_limit;
+    if (src->tokens > logbuf->forward_rate_limit)
+        src->tokens = logbuf->forward_rate_limit;
+    src->t_last = now;
+    if (src->tokens < 1.) {
+        src->dropped++;
+        return true;
+    }
+    src->tokens -= 1.;
+    return false;
+}
+
+/* Return true if the entry with header 'hdr' and message 'msg' differs
+ * from the last forwarded entry only in its timestamp and procid.
+ */
+static bool fwd_is_repeat (logbuf_t *logbuf,
+                           struct stdlog_header *hdr,
+                           const char *msg,
+                           int msglen)
+{
+    struct stdlog_header last;
+    const char *lastmsg;
+    int lastmsglen;
+
+    if (!logbuf->fwd_last)
+        return false;
+    stdlog_init (&last);
+    if (stdlog_decode (logbuf->fwd_last, logbuf->fwd_last_len,
+                       &last, NULL, NULL, &lastmsg, &lastmsglen) < 0)
+        return false;
+    return (last.pri == hdr->pri
+            && lastmsglen == msglen
+            && memcmp (lastmsg, msg, msglen) == 0
+            && !strcmp (last.hostname, hdr->hostname)
+            && !strcmp (last.appname, hdr->appname));
+}
+
+/* Queue a log entry for forwarding upstream.  Consecutive repeats of the
+ * same entry are collapsed into a count, and entries originating on this
+ * rank are subject to log-forward-rate-limit, unless they are at or
+ * below log-critical-level, which also flushes the batch immediately.
+ */
+static int logbuf_forward (logbuf_t *logbuf,
+                           const char *buf,
+                           int len,
+                           int severity,
+                           bool local)
+{
+    assert (logbuf->magic == LOGBUF_MAGIC);
+    struct stdlog_header hdr;
+    const char *msg;
+    int msglen;
+    bool critical = (severity <= logbuf->critical_level);
+    char *cpy;
+
+    stdlog_init (&hdr);
+    if (stdlog_decode (buf, len, &hdr, NULL, NULL, &msg, &msglen) == 0) {
+        if (local && !critical && fwd_rate_limited (logbuf, hdr.appname))
+            goto done;
+        if (fwd_is_repeat (logbuf, &hdr, msg, msglen)) {
+            logbuf->fwd_repeat++;
+            goto done;
+        }
+    }
+    if (fwd_batch_append_repeat (logbuf) < 0
+        || fwd_batch_append (logbuf, buf, len) < 0)
+        return -1;
+    if (!(cpy = realloc (logbuf->fwd_last, len)))
+        return -1;
+    memcpy (cpy, buf, len);
+    logbuf->fwd_last = cpy;
+    logbuf->fwd_last_len = len;
+done:
+    if (critical)
+        return logbuf_forward_flush (logbuf);
+    flux_watcher_start (logbuf->fwd_timer);
+    return 0;
+}
+
 /* Log a message to 'fp', if non-NULL.
  * Set flags to LOG_NO_TIMESTAMP to suppress timestamp.
  */
@@ -489,7 +786,11 @@ static int logbuf_append (logbuf_t *logbuf, const char *buf, int len)
         if (logbuf->rank == 0) {
             log_fp (logbuf->f, 0, buf, len);
         } else {
-            if (logbuf_forward (logbuf, buf, len) < 0)
+            if (logbuf_forward (logbuf,
+                                buf,
+                                len,
+                                severity,
+                                rank == logbuf->rank) < 0)
                 rc = -1;
         }
     }
@@ -541,6 +842,34 @@ error:
     }
 }
 
+/* Receive a batch of log entries forwarded from downstream.
+ * N.B. log.forward requests have no response.
+ */
+static void forward_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                                const flux_msg_t *msg, void *arg)
+{
+    logbuf_t *logbuf = arg;
+    const char *buf;
+    int len;
+    uint32_t n;
+
+    if (flux_request_decode_raw (msg, NULL, (const void **)&buf, &len) < 0) {
+        log_err ("%s: malformed log.forward request", __FUNCTION__);
+        return;
+    }
+    while (len >= sizeof (n)) {
+        memcpy (&n, buf, sizeof (n));
+        n = ntohl (n);
+        if (n > len - sizeof (n)) {
+            log_msg ("%s: truncated log.forward entry", __FUNCTION__);
+            return;
+        }
+        (void)logbuf_append (logbuf, buf + sizeof (n), n);
+        buf += sizeof (n) + n;
+        len -= sizeof (n) + n;
+    }
+}
+
 static void clear_request_cb (flux_t *h, flux_msg_handler_t *mh,
                               const flux_msg_t *msg, void *arg)
 {
@@ -640,6 +969,7 @@ done:
 
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "log.append",         append_request_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "log.forward",        forward_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "log.clear",          clear_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "log.dmesg",          dmesg_request_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "log.disconnect",     disconnect_request_cb, 0 },
@@ -649,6 +979,7 @@ static const struct flux_msg_handler_spec htab[] = {
 static void logbuf_finalize (void *arg)
 {
     logbuf_t *logbuf = arg;
+    (void)logbuf_forward_flush (logbuf);
     flux_msg_handler_delvec (logbuf->handlers);
     logbuf_destroy (logbuf);
     /* FIXME: need logbuf_unregister_attrs() */
@@ -663,6 +994,12 @@ int logbuf_initialize (flux_t *h, uint32_t rank, attr_t *attrs)
     logbuf->rank = rank;
     if (logbuf_register_attrs (logbuf, attrs) < 0)
         goto error;
+    logbuf->fwd_timer = flux_timeout_watcher_create (flux_get_reactor (h),
+                                                     forward_batch_timeout,
+                                                     forward_timer_cb,
+                                                     logbuf);
+    if (!logbuf->fwd_timer)
+        goto error;
     if (flux_msg_handler_addvec (h, htab, logbuf, &logbuf->handlers) < 0)
         goto error;
     flux_log_set_appname (h, "broker");
@@ -40,12 +40,18 @@
 
 #include "module.h"
 #include "modservice.h"
+#include "channel.h"
 
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37     // defined in later libuuid headers
 #endif
 
 
+/* Ring capacity of each direction of the broker-module channel.
+ * Broker to module overflow is held on a backlog in the broker.
+ */
+#define MODULE_CHANNEL_CAPACITY 1024
+
 #define MODULE_MAGIC    0xfeefbe01
 struct broker_module {
     int magic;
@@ -56,7 +62,8 @@ struct broker_module {
 
     double lastseen;
 
-    zsock_t *sock;          /* broker end of PAIR socket */
+    struct channel *chan;   /* in-process message channel */
+    flux_t *chan_h;         /* broker end of channel (for watcher only) */
     struct flux_msg_cred cred; /* cred of connection */
 
     uuid_t uuid;            /* uuid for unique request sender identity */
@@ -146,7 +153,7 @@ static void *module_thread (void *arg)
     assert (p->magic == MODULE_MAGIC);
     sigset_t signal_set;
     int errnum;
-    char *uri = NULL;
+    int flags = 0;
     char **av = NULL;
     char *rankstr = NULL;
     int ac;
@@ -156,14 +163,12 @@ static void *module_thread (void *arg)
 
     setup_module_profiling (p);
 
-    /* Connect to broker socket, enable logging, register built-in services
+    /* Connect to broker channel, enable logging, register built-in services
      */
-    if (asprintf (&uri, "shmem://%s", p->uuid_str) < 0) {
-        log_err ("asprintf");
-        goto done;
-    }
-    if (!(p->h = flux_open (uri, 0))) {
-        log_err ("flux_open %s", uri);
+    if (getenv ("FLUX_HANDLE_TRACE"))
+        flags |= FLUX_O_TRACE;
+    if (!(p->h = channel_open (p->chan, CHANNEL_MODULE, flags))) {
+        log_err ("%s: channel_open", p->name);
         goto done;
     }
     if (asprintf (&rankstr, "%"PRIu32, p->rank) < 0) {
@@ -218,7 +223,7 @@ static void *module_thread (void *arg)
     /* Before processing unhandled requests, ensure that this module
      * is "muted" in the broker. This ensures the broker won't try to
      * feed a message to this module after we've closed the handle,
-     * which could cause the broker to block.
+     * where it would never be delivered.
      */
     if (module_finalizing (p) < 0)
         flux_log_error (p->h, "failed to set module state to finalizing");
@@ -242,7 +247,6 @@ static void *module_thread (void *arg)
         flux_log_error (p->h, "flux_send");
     flux_msg_destroy (msg);
 done:
-    free (uri);
     free (rankstr);
     if (av)
         free (av);
@@ -275,7 +279,7 @@ flux_msg_t *module_recvmsg (module_t *p)
 
     assert (p->magic == MODULE_MAGIC);
 
-    if (!(msg = flux_msg_recvzsock (p->sock)))
+    if (!(msg = channel_recv (p->chan, CHANNEL_BROKER, FLUX_O_NONBLOCK)))
         goto error;
     if (flux_msg_get_type (msg, &type) < 0)
         goto error;
@@ -292,7 +296,7 @@ flux_msg_t *module_recvmsg (module_t *p)
         default:
             break;
     }
-    /* All shmem:// connections to the broker have FLUX_ROLE_OWNER
+    /* All module connections to the broker have FLUX_ROLE_OWNER
      * and are "authenticated" as the instance owner.
      * Allow modules so endowed to change the userid/rolemask on messages when
      * sending on behalf of other users.  This is necessary for connectors
@@ -338,8 +342,6 @@ int module_sendmsg (module_t *p, const flux_msg_t *msg)
                 goto done;
             if (flux_msg_push_route (cpy, uuid) < 0)
                 goto done;
-            if (flux_msg_sendzsock (p->sock, cpy) < 0)
-                goto done;
             break;
         }
         case FLUX_MSGTYPE_RESPONSE: { /* simulate ROUTER socket */
@@ -347,15 +349,21 @@ int module_sendmsg (module_t *p, const flux_msg_t *msg)
                 goto done;
             if (flux_msg_pop_route (cpy, NULL) < 0)
                 goto done;
-            if (flux_msg_sendzsock (p->sock, cpy) < 0)
-                goto done;
             break;
         }
         default:
-            if (flux_msg_sendzsock (p->sock, msg) < 0)
+            /* 'msg' may be shared with other modules and its refcount
+             * is not thread safe, so the module gets its own copy.
+             */
+            if (!(cpy = flux_msg_copy (msg, true)))
                 goto done;
             break;
     }
+    /* The copy is handed to the module thread without serialization.
+     */
+    if (channel_send (p->chan, CHANNEL_BROKER, cpy) < 0)
+        goto done;
+    cpy = NULL;
     rc = 0;
 done:
     flux_msg_destroy (cpy);
@@ -422,7 +430,8 @@ static void module_destroy (module_t *p)
 
     flux_watcher_stop (p->broker_w);
     flux_watcher_destroy (p->broker_w);
-    zsock_destroy (&p->sock);
+    flux_close (p->chan_h);
+    channel_destroy (p->chan);
 
 #ifndef __SANITIZE_ADDRESS__
     dlclose (p->dso);
@@ -658,20 +667,21 @@ module_t *module_add (modhash_t *mh, const char *path)
     p->rank = mh->rank;
     p->broker_h = mh->broker_h;
 
-    /* Broker end of PAIR socket is opened here.
+    /* Both ends of the channel are created here.  The module end is
+     * opened by the module thread.
      */
-    if (!(p->sock = zsock_new_pair (NULL))) {
-        log_err ("zsock_new_pair");
+    if (!(p->chan = channel_create (MODULE_CHANNEL_CAPACITY))) {
+        log_err ("channel_create");
         goto cleanup;
     }
-    if (zsock_bind (p->sock, "inproc://%s", module_get_uuid (p)) < 0) {
-        log_err ("zsock_bind inproc://%s", module_get_uuid (p));
+    if (!(p->chan_h = channel_open (p->chan, CHANNEL_BROKER, 0))) {
+        log_err ("channel_open");
         goto cleanup;
     }
-    if (!(p->broker_w = flux_zmq_watcher_create (flux_get_reactor (p->broker_h),
-                                                 p->sock, FLUX_POLLIN,
-                                                 module_cb, p))) {
-        log_err ("flux_zmq_watcher_create");
+    if (!(p->broker_w = flux_handle_watcher_create (flux_get_reactor (p->broker_h),
+                                                    p->chan_h, FLUX_POLLIN,
+                                                    module_cb, p))) {
+        log_err ("flux_handle_watcher_create");
         goto cleanup;
     }
     /* Set creds for connection.
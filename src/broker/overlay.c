@@ -22,26 +22,69 @@
 #include "src/common/libutil/kary.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/fsd.h"
+#include "src/common/libutil/errno_safe.h"
 
 #include "heartbeat.h"
 #include "overlay.h"
 #include "attr.h"
+#include "stream.h"
 
 #define FLUX_ZAP_DOMAIN "flux"
 #define ZAP_ENDPOINT "inproc://zeromq.zap.01"
 
+/* Small messages sent with the zmq transport are coalesced per destination
+ * into one batch message, sent when the reactor is about to block, or
+ * sooner if the batch reaches BATCH_MAX_COUNT messages or BATCH_MAX_BYTES.
+ * A batch is a keepalive message with status KEEPALIVE_STATUS_BATCH, whose
+ * payload holds each message as a 4 byte network order length followed by
+ * its flux_msg_encode() representation.  Messages larger than
+ * BATCH_MSG_MAX bytes flush the batch and are sent on their own.
+ */
+#define BATCH_MSG_MAX   (16*1024)
+#define BATCH_MAX_BYTES (256*1024)
+#define BATCH_MAX_COUNT 1024
+
+struct batch {
+    uint8_t *buf;
+    size_t len;
+    size_t size;
+    int count;
+};
+
 struct endpoint {
     zsock_t *zsock;
+    struct stream *stream;
     char *uri;
     flux_watcher_t *w;
+    zlist_t *inbound;           /* messages unpacked from a batch */
+    flux_watcher_t *prep_w;
+    flux_watcher_t *idle_w;
+    flux_watcher_t *check_w;
 };
 
+/* Overlay transport.  The parent endpoint behaves like a DEALER socket
+ * and the child endpoint like a ROUTER socket, whatever the transport.
+ */
+struct overlay_transport {
+    const char *name;
+    int (*connect)(struct overlay *ov);
+    int (*bind)(struct overlay *ov);
+    int (*sendmsg_parent)(struct overlay *ov, const flux_msg_t *msg);
+    flux_msg_t *(*recvmsg_parent)(struct overlay *ov);
+    int (*sendmsg_child)(struct overlay *ov, const flux_msg_t *msg);
+    flux_msg_t *(*recvmsg_child)(struct overlay *ov);
+};
+
+static const struct overlay_transport zmq_transport;
+static const struct overlay_transport stream_transport;
+
 struct child {
     int lastseen;
     unsigned long rank;
     char uuid[16];
     bool connected;
     bool idle;
+    struct batch batch;
 };
 
 /* Wake up every heartbeat and:
@@ -52,6 +95,8 @@ static const double idle_min = 5.0;
 static const double idle_max = 30.0;
 
 struct overlay {
+    const struct overlay_transport *transport;
+
     zcert_t *cert;
     zcertstore_t *certstore;
     zsock_t *zap;
@@ -73,6 +118,8 @@ struct overlay {
     void *parent_arg;
     int parent_lastsent;
     char *parent_pubkey;
+    struct batch parent_batch;
+    flux_watcher_t *flush_w;
 
     struct endpoint *child;     /* ROUTER - requests from children */
     overlay_sock_cb_f child_cb;
@@ -104,7 +151,17 @@ static void endpoint_destroy (struct endpoint *ep)
         int saved_errno = errno;
         free (ep->uri);
         flux_watcher_destroy (ep->w);
+        flux_watcher_destroy (ep->prep_w);
+        flux_watcher_destroy (ep->idle_w);
+        flux_watcher_destroy (ep->check_w);
+        if (ep->inbound) {
+            flux_msg_t *msg;
+            while ((msg = zlist_pop (ep->inbound)))
+                flux_msg_destroy (msg);
+            zlist_destroy (&ep->inbound);
+        }
         zsock_destroy (&ep->zsock);
+        stream_destroy (ep->stream);
         free (ep);
         errno = saved_errno;
     }
@@ -118,12 +175,21 @@ static struct endpoint *endpoint_create (const char *uri)
         return NULL;
     if (!(ep->uri = strdup (uri)))
         goto error;
+    if (!(ep->inbound = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
     return ep;
 error:
     endpoint_destroy (ep);
     return NULL;
 }
 
+static bool endpoint_is_open (struct endpoint *ep)
+{
+    return ep && (ep->zsock || ep->stream);
+}
+
 void overlay_set_init_callback (struct overlay *ov,
                                 overlay_init_cb_f cb,
                                 void *arg)
@@ -286,15 +352,245 @@ const char *overlay_get_parent_uri (struct overlay *ov)
     return ov->parent->uri;
 }
 
+static bool is_batch (const flux_msg_t *msg)
+{
+    int type;
+    int status;
+
+    if (flux_msg_get_type (msg, &type) < 0
+        || type != FLUX_MSGTYPE_KEEPALIVE
+        || flux_keepalive_decode (msg, NULL, &status) < 0)
+        return false;
+    return status == KEEPALIVE_STATUS_BATCH;
+}
+
+/* Append the messages in batch 'msg' to ep->inbound, or 'msg' itself if
+ * it is not a batch.  Mimic socket routing for the batched messages:
+ * a ROUTER pushes the sender identity, and on the DEALER side the
+ * identity pushed by the parent broker must be popped.  Takes ownership
+ * of 'msg'.
+ */
+static int batch_unpack (struct endpoint *ep, flux_msg_t *msg, bool router)
+{
+    const uint8_t *buf;
+    int size;
+    char *uuid = NULL;
+    flux_msg_t *m;
+    uint32_t len;
+
+    if (!is_batch (msg)) {
+        if (zlist_append (ep->inbound, msg) < 0) {
+            flux_msg_destroy (msg);
+            errno = ENOMEM;
+            return -1;
+        }
+        return 0;
+    }
+    if (router && flux_msg_get_route_last (msg, &uuid) < 0)
+        goto error;
+    if (flux_msg_get_payload (msg, (const void **)&buf, &size) < 0)
+        goto error;
+    while (size > 0) {
+        if (size < 4)
+            goto error_proto;
+        len = (uint32_t)buf[0] << 24 | (uint32_t)buf[1] << 16
+            | (uint32_t)buf[2] << 8 | buf[3];
+        if (len > size - 4)
+            goto error_proto;
+        if (!(m = flux_msg_decode (buf + 4, len)))
+            goto error;
+        if (router) {
+            if (flux_msg_enable_route (m) < 0
+                || flux_msg_push_route (m, uuid) < 0) {
+                flux_msg_destroy (m);
+                goto error;
+            }
+        }
+        else {
+            if (flux_msg_pop_route (m, NULL) < 0) {
+                flux_msg_destroy (m);
+                goto error;
+            }
+        }
+        if (zlist_append (ep->inbound, m) < 0) {
+            flux_msg_destroy (m);
+            errno = ENOMEM;
+            goto error;
+        }
+        buf += len + 4;
+        size -= len + 4;
+    }
+    free (uuid);
+    flux_msg_destroy (msg);
+    return 0;
+error_proto:
+    errno = EPROTO;
+error:
+    ERRNO_SAFE_WRAP (free, uuid);
+    flux_msg_destroy (msg);
+    return -1;
+}
+
+/* A batch that could not be sent is lost, so fail the requests in it as
+ * the broker would have, had they been sent individually.  The error
+ * responses are derived from the requests as encoded in the batch, whose
+ * route stacks match a response received on 'ep', and are delivered from
+ * its inbound list.
+ */
+static void batch_fail (struct overlay *ov,
+                        struct batch *b,
+                        struct endpoint *ep,
+                        int errnum)
+{
+    const uint8_t *buf = b->buf;
+    size_t size = b->len;
+    flux_msg_t *msg;
+    flux_msg_t *rsp;
+    uint32_t len;
+    int type;
+
+    while (size >= 4) {
+        len = (uint32_t)buf[0] << 24 | (uint32_t)buf[1] << 16
+            | (uint32_t)buf[2] << 8 | buf[3];
+        if (len > size - 4)
+            break;
+        if ((msg = flux_msg_decode (buf + 4, len))) {
+            if (flux_msg_get_type (msg, &type) == 0
+                && type == FLUX_MSGTYPE_REQUEST
+                && !flux_msg_is_noresponse (msg)) {
+                if (!(rsp = flux_response_derive (msg, errnum))
+                    || zlist_append (ep->inbound, rsp) < 0) {
+                    flux_msg_destroy (rsp);
+                    flux_log (ov->h, LOG_ERR, "error failing batched request");
+                }
+            }
+            flux_msg_destroy (msg);
+        }
+        buf += len + 4;
+        size -= len + 4;
+    }
+}
+
+/* Send the contents of batch 'b' to the parent, or to 'child' if non-NULL.
+ * On failure, requests in the batch receive error responses.
+ */
+static int batch_flush (struct overlay *ov,
+                        struct batch *b,
+                        struct child *child)
+{
+    flux_msg_t *msg;
+    zsock_t *zsock;
+    int rc = -1;
+
+    if (b->count == 0)
+        return 0;
+    zsock = child ? ov->child->zsock : ov->parent->zsock;
+    if (b->count == 1) { // not worth a batch
+        if (!(msg = flux_msg_decode (b->buf + 4, b->len - 4)))
+            goto done;
+    }
+    else {
+        if (!(msg = flux_keepalive_encode (0, KEEPALIVE_STATUS_BATCH)))
+            goto done;
+        if (flux_msg_set_payload (msg, b->buf, b->len) < 0
+            || flux_msg_enable_route (msg) < 0
+            || (child && flux_msg_push_route (msg, child->uuid) < 0))
+            goto done_destroy;
+    }
+    rc = flux_msg_sendzsock_ex (zsock, msg, child ? true : false);
+done_destroy:
+    flux_msg_destroy (msg);
+done:
+    if (rc < 0) {
+        int saved_errno = errno;
+        batch_fail (ov, b, child ? ov->child : ov->parent, saved_errno);
+        if (child && saved_errno == EHOSTUNREACH && child->connected) {
+            child->connected = false;
+            overlay_monitor_notify (ov);
+        }
+        errno = saved_errno;
+    }
+    b->len = 0;
+    b->count = 0;
+    return rc;
+}
+
+static void batch_flush_all (struct overlay *ov)
+{
+    struct child *child;
+
+    if (batch_flush (ov, &ov->parent_batch, NULL) < 0)
+        flux_log_error (ov->h, "error sending batch to parent");
+    foreach_overlay_child (ov, child) {
+        if (batch_flush (ov, &child->batch, child) < 0) {
+            flux_log_error (ov->h,
+                            "error sending batch to child rank %lu",
+                            child->rank);
+        }
+    }
+}
+
+static void flush_cb (flux_reactor_t *r,
+                      flux_watcher_t *w,
+                      int revents,
+                      void *arg)
+{
+    struct overlay *ov = arg;
+
+    batch_flush_all (ov);
+    flux_watcher_stop (w);
+}
+
+/* Add 'msg' to batch 'b' bound for the parent, or 'child' if non-NULL.
+ */
+static int batch_append (struct overlay *ov,
+                         struct batch *b,
+                         struct child *child,
+                         const flux_msg_t *msg)
+{
+    size_t size = flux_msg_encode_size (msg);
+    size_t need = b->len + 4 + size;
+    uint8_t *p;
+
+    if (size > BATCH_MSG_MAX) {
+        zsock_t *zsock = child ? ov->child->zsock : ov->parent->zsock;
+        if (batch_flush (ov, b, child) < 0)
+            return -1;
+        return flux_msg_sendzsock_ex (zsock, msg, child ? true : false);
+    }
+    if (need > b->size) {
+        size_t newsize = b->size ? b->size : 4096;
+        while (newsize < need)
+            newsize *= 2;
+        if (!(p = realloc (b->buf, newsize)))
+            return -1;
+        b->buf = p;
+        b->size = newsize;
+    }
+    p = b->buf + b->len;
+    p[0] = size >> 24;
+    p[1] = size >> 16;
+    p[2] = size >> 8;
+    p[3] = size;
+    if (flux_msg_encode (msg, p + 4, size) < 0)
+        return -1;
+    b->len = need;
+    b->count++;
+    if (b->len >= BATCH_MAX_BYTES || b->count >= BATCH_MAX_COUNT)
+        return batch_flush (ov, b, child);
+    flux_watcher_start (ov->flush_w);
+    return 0;
+}
+
 int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg)
 {
     int rc = -1;
 
-    if (!ov->parent || !ov->parent->zsock) {
+    if (!endpoint_is_open (ov->parent)) {
         errno = EHOSTUNREACH;
         goto done;
     }
-    rc = flux_msg_sendzsock (ov->parent->zsock, msg);
+    rc = ov->transport->sendmsg_parent (ov, msg);
     if (rc == 0)
         ov->parent_lastsent = flux_reactor_now (flux_get_reactor (ov->h));
 done:
@@ -303,7 +599,15 @@ done:
 
 flux_msg_t *overlay_recvmsg_parent (struct overlay *ov)
 {
-    return flux_msg_recvzsock (ov->parent->zsock);
+    flux_msg_t *msg;
+
+    if ((msg = zlist_pop (ov->parent->inbound)))
+        return msg;
+    if (!(msg = ov->transport->recvmsg_parent (ov)))
+        return NULL;
+    if (batch_unpack (ov->parent, msg, false) < 0)
+        return NULL;
+    return zlist_pop (ov->parent->inbound);
 }
 
 static int overlay_keepalive_parent (struct overlay *ov, int status)
@@ -311,13 +615,13 @@ static int overlay_keepalive_parent (struct overlay *ov, int status)
     flux_msg_t *msg = NULL;
     int rc = -1;
 
-    if (!ov->parent || !ov->parent->zsock)
+    if (!endpoint_is_open (ov->parent))
         return 0;
     if (!(msg = flux_keepalive_encode (0, status)))
         goto done;
     if (flux_msg_enable_route (msg) < 0)
         goto done;
-    rc = flux_msg_sendzsock (ov->parent->zsock, msg);
+    rc = ov->transport->sendmsg_parent (ov, msg);
 done:
     flux_msg_destroy (msg);
     return rc;
@@ -361,21 +665,29 @@ int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
 {
     int rc = -1;
 
-    if (!ov->child || !ov->child->zsock) {
+    if (!endpoint_is_open (ov->child)) {
         errno = EINVAL;
         goto done;
     }
-    rc = flux_msg_sendzsock_ex (ov->child->zsock, msg, true);
+    rc = ov->transport->sendmsg_child (ov, msg);
 done:
     return rc;
 }
 
 flux_msg_t *overlay_recvmsg_child (struct overlay *ov)
 {
-    return flux_msg_recvzsock (ov->child->zsock);
+    flux_msg_t *msg;
+
+    if ((msg = zlist_pop (ov->child->inbound)))
+        return msg;
+    if (!(msg = ov->transport->recvmsg_child (ov)))
+        return NULL;
+    if (batch_unpack (ov->child, msg, true) < 0)
+        return NULL;
+    return zlist_pop (ov->child->inbound);
 }
 
-static int overlay_mcast_child_one (void *zsock,
+static int overlay_mcast_child_one (struct overlay *ov,
                                     const flux_msg_t *msg,
                                     struct child *child)
 {
@@ -388,7 +700,7 @@ static int overlay_mcast_child_one (void *zsock,
         goto done;
     if (flux_msg_push_route (cpy, child->uuid) < 0)
         goto done;
-    if (flux_msg_sendzsock_ex (zsock, cpy, true) < 0)
+    if (ov->transport->sendmsg_child (ov, cpy) < 0)
         goto done;
     rc = 0;
 done:
@@ -401,12 +713,12 @@ void overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
     struct child *child;
     int disconnects = 0;
 
-    if (!ov->child || !ov->child->zsock)
+    if (!endpoint_is_open (ov->child))
         return;
     foreach_overlay_child (ov, child) {
         if (!child->connected)
             continue;
-        if (overlay_mcast_child_one (ov->child->zsock, msg, child) < 0) {
+        if (overlay_mcast_child_one (ov, msg, child) < 0) {
             if (errno == EHOSTUNREACH) {
                 child->connected = false;
                 disconnects++;
@@ -438,6 +750,59 @@ static void parent_cb (flux_reactor_t *r, flux_watcher_t *w,
         ov->parent_cb (ov, ov->parent_arg);
 }
 
+/* Messages left on ep->inbound after a batch was received must be
+ * delivered without waiting for the socket to become readable again.
+ * Keep the reactor from blocking while any remain, and deliver them
+ * from a check watcher.
+ */
+static void inbound_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                             int revents, void *arg)
+{
+    struct endpoint *ep = arg;
+
+    if (zlist_size (ep->inbound) > 0)
+        flux_watcher_start (ep->idle_w);
+}
+
+static void child_check_cb (flux_reactor_t *r, flux_watcher_t *w,
+                            int revents, void *arg)
+{
+    struct overlay *ov = arg;
+
+    flux_watcher_stop (ov->child->idle_w);
+    if (zlist_size (ov->child->inbound) > 0)
+        child_cb (r, w, revents, arg);
+}
+
+static void parent_check_cb (flux_reactor_t *r, flux_watcher_t *w,
+                             int revents, void *arg)
+{
+    struct overlay *ov = arg;
+
+    flux_watcher_stop (ov->parent->idle_w);
+    if (zlist_size (ov->parent->inbound) > 0)
+        parent_cb (r, w, revents, arg);
+}
+
+static int endpoint_watch_inbound (struct overlay *ov,
+                                   struct endpoint *ep,
+                                   flux_watcher_f check_cb)
+{
+    flux_reactor_t *r = flux_get_reactor (ov->h);
+
+    if (!(ep->prep_w = flux_prepare_watcher_create (r, inbound_prep_cb, ep))
+        || !(ep->idle_w = flux_idle_watcher_create (r, NULL, NULL))
+        || !(ep->check_w = flux_check_watcher_create (r, check_cb, ov)))
+        return -1;
+    flux_watcher_start (ep->prep_w);
+    flux_watcher_start (ep->check_w);
+    if (!ov->flush_w) {
+        if (!(ov->flush_w = flux_prepare_watcher_create (r, flush_cb, ov)))
+            return -1;
+    }
+    return 0;
+}
+
 static zframe_t *get_zmsg_nth (zmsg_t *msg, int n)
 {
     zframe_t *zf;
@@ -559,45 +924,35 @@ static int overlay_zap_init (struct overlay *ov)
     return 0;
 }
 
-int overlay_connect (struct overlay *ov)
+static int zmq_connect (struct overlay *ov)
 {
-    if (!ov->h || ov->rank == FLUX_NODEID_ANY) {
-        errno = EINVAL;
+    if (!(ov->parent->zsock = zsock_new_dealer (NULL)))
+        goto nomem;
+    zsock_set_zap_domain (ov->parent->zsock, FLUX_ZAP_DOMAIN);
+    zcert_apply (ov->cert, ov->parent->zsock);
+    zsock_set_curve_serverkey (ov->parent->zsock, ov->parent_pubkey);
+    zsock_set_identity (ov->parent->zsock, ov->uuid);
+    if (zsock_connect (ov->parent->zsock, "%s", ov->parent->uri) < 0)
+        goto nomem;
+    if (!(ov->parent->w = flux_zmq_watcher_create (flux_get_reactor (ov->h),
+                                                   ov->parent->zsock,
+                                                   FLUX_POLLIN,
+                                                   parent_cb,
+                                                   ov)))
         return -1;
-    }
-    if (ov->parent) {
-        if (!(ov->parent->zsock = zsock_new_dealer (NULL)))
-            goto nomem;
-        zsock_set_zap_domain (ov->parent->zsock, FLUX_ZAP_DOMAIN);
-        zcert_apply (ov->cert, ov->parent->zsock);
-        zsock_set_curve_serverkey (ov->parent->zsock, ov->parent_pubkey);
-        zsock_set_identity (ov->parent->zsock, ov->uuid);
-        if (zsock_connect (ov->parent->zsock, "%s", ov->parent->uri) < 0)
-            goto nomem;
-        if (!(ov->parent->w = flux_zmq_watcher_create (flux_get_reactor (ov->h),
-                                                       ov->parent->zsock,
-                                                       FLUX_POLLIN,
-                                                       parent_cb,
-                                                       ov)))
+    flux_watcher_start (ov->parent->w);
+    if (endpoint_watch_inbound (ov, ov->parent, parent_check_cb) < 0)
         return -1;
-        flux_watcher_start (ov->parent->w);
-    }
     return 0;
 nomem:
     errno = ENOMEM;
     return -1;
 }
 
-int overlay_bind (struct overlay *ov, const char *uri)
+static int zmq_bind (struct overlay *ov)
 {
-    if (!ov->h || ov->rank == FLUX_NODEID_ANY || ov->child) {
-        errno = EINVAL;
-        return -1;
-    }
     if (!ov->zap && overlay_zap_init (ov) < 0)
         return -1;
-    if (!(ov->child = endpoint_create (uri)))
-        return -1;
     if (!(ov->child->zsock = zsock_new_router (NULL)))
         return -1;
     zsock_set_router_mandatory (ov->child->zsock, 1);
@@ -622,6 +977,209 @@ int overlay_bind (struct overlay *ov, const char *uri)
                                                   ov)))
         return -1;
     flux_watcher_start (ov->child->w);
+    if (endpoint_watch_inbound (ov, ov->child, child_check_cb) < 0)
+        return -1;
+    return 0;
+}
+
+static int zmq_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg)
+{
+    return batch_append (ov, &ov->parent_batch, NULL, msg);
+}
+
+static flux_msg_t *zmq_recvmsg_parent (struct overlay *ov)
+{
+    return flux_msg_recvzsock (ov->parent->zsock);
+}
+
+/* Only batch messages for children known to be connected, so that
+ * EHOSTUNREACH is still reported synchronously for the others.
+ */
+static int zmq_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
+{
+    struct child *child = NULL;
+    char *uuid;
+
+    if (flux_msg_get_route_last (msg, &uuid) == 0 && uuid) {
+        child = child_lookup (ov, uuid);
+        free (uuid);
+    }
+    if (child && child->connected)
+        return batch_append (ov, &child->batch, child, msg);
+    if (child && batch_flush (ov, &child->batch, child) < 0)
+        return -1;
+    return flux_msg_sendzsock_ex (ov->child->zsock, msg, true);
+}
+
+static flux_msg_t *zmq_recvmsg_child (struct overlay *ov)
+{
+    return flux_msg_recvzsock (ov->child->zsock);
+}
+
+static const struct overlay_transport zmq_transport = {
+    .name = "zmq",
+    .connect = zmq_connect,
+    .bind = zmq_bind,
+    .sendmsg_parent = zmq_sendmsg_parent,
+    .recvmsg_parent = zmq_recvmsg_parent,
+    .sendmsg_child = zmq_sendmsg_child,
+    .recvmsg_child = zmq_recvmsg_child,
+};
+
+static void stream_parent_cb (struct stream *s, void *arg)
+{
+    struct overlay *ov = arg;
+
+    if (ov->parent_cb)
+        ov->parent_cb (ov, ov->parent_arg);
+}
+
+static void stream_child_cb (struct stream *s, void *arg)
+{
+    struct overlay *ov = arg;
+
+    if (ov->child_cb)
+        ov->child_cb (ov, ov->child_arg);
+}
+
+/* Authorize a peer against the same certificate store as ZAP.
+ */
+static int stream_auth_cb (const char *uuid, const char *pubkey, void *arg)
+{
+    struct overlay *ov = arg;
+    zcert_t *cert;
+    const char *name = NULL;
+
+    if ((cert = zcertstore_lookup (ov->certstore, pubkey)))
+        name = zcert_meta (cert, "name");
+    flux_log (ov->h,
+              cert ? LOG_INFO : LOG_ERR,
+              "overlay auth %s %s",
+              name ? name : "unknown",
+              cert ? "OK" : "No access");
+    return cert ? 0 : -1;
+}
+
+static int stream_transport_connect (struct overlay *ov)
+{
+    uint8_t server_key[32];
+
+    if (!ov->parent_pubkey
+        || strlen (ov->parent_pubkey) != 40
+        || !zmq_z85_decode (server_key, ov->parent_pubkey)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(ov->parent->stream = stream_connect (ov->h,
+                                               ov->parent->uri,
+                                               ov->uuid,
+                                               zcert_public_key (ov->cert),
+                                               zcert_secret_key (ov->cert),
+                                               server_key,
+                                               stream_parent_cb,
+                                               ov)))
+        return -1;
+    return 0;
+}
+
+static int stream_transport_bind (struct overlay *ov)
+{
+    if (!(ov->child->stream = stream_bind (ov->h,
+                                           ov->child->uri,
+                                           zcert_secret_key (ov->cert),
+                                           stream_auth_cb,
+                                           ov,
+                                           stream_child_cb,
+                                           ov)))
+        return -1;
+    free (ov->child->uri);
+    if (!(ov->child->uri = strdup (stream_get_uri (ov->child->stream))))
+        return -1;
+    return 0;
+}
+
+static int stream_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg)
+{
+    return stream_send (ov->parent->stream, msg);
+}
+
+static flux_msg_t *stream_recvmsg_parent (struct overlay *ov)
+{
+    return stream_recv (ov->parent->stream);
+}
+
+static int stream_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
+{
+    return stream_send (ov->child->stream, msg);
+}
+
+static flux_msg_t *stream_recvmsg_child (struct overlay *ov)
+{
+    return stream_recv (ov->child->stream);
+}
+
+static const struct overlay_transport stream_transport = {
+    .name = "stream",
+    .connect = stream_transport_connect,
+    .bind = stream_transport_bind,
+    .sendmsg_parent = stream_sendmsg_parent,
+    .recvmsg_parent = stream_recvmsg_parent,
+    .sendmsg_child = stream_sendmsg_child,
+    .recvmsg_child = stream_recvmsg_child,
+};
+
+static const struct overlay_transport *transports[] = {
+    &zmq_transport,
+    &stream_transport,
+    NULL,
+};
+
+int overlay_set_transport (struct overlay *ov, const char *name)
+{
+    int i;
+
+    if (!name || endpoint_is_open (ov->parent) || ov->child) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = 0; transports[i] != NULL; i++) {
+        if (!strcmp (transports[i]->name, name)) {
+            ov->transport = transports[i];
+            return 0;
+        }
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+const char *overlay_get_transport (struct overlay *ov)
+{
+    return ov->transport->name;
+}
+
+int overlay_connect (struct overlay *ov)
+{
+    if (!ov->h || ov->rank == FLUX_NODEID_ANY) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (ov->parent) {
+        if (ov->transport->connect (ov) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int overlay_bind (struct overlay *ov, const char *uri)
+{
+    if (!ov->h || ov->rank == FLUX_NODEID_ANY || ov->child) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(ov->child = endpoint_create (uri)))
+        return -1;
+    if (ov->transport->bind (ov) < 0)
+        return -1;
     /* Ensure that ipc files are removed when the broker exits.
      */
     char *ipc_path = strstr (ov->child->uri, "ipc://");
@@ -809,9 +1367,19 @@ void overlay_destroy (struct overlay *ov)
             (void)flux_event_unsubscribe (ov->h, "hb");
         flux_msg_handler_delvec (ov->handlers);
         overlay_keepalive_parent (ov, KEEPALIVE_STATUS_DISCONNECT);
+        if (ov->flush_w) {
+            batch_flush_all (ov);
+            flux_watcher_destroy (ov->flush_w);
+        }
         endpoint_destroy (ov->parent);
         endpoint_destroy (ov->child);
         free (ov->parent_pubkey);
+        free (ov->parent_batch.buf);
+        if (ov->children) {
+            struct child *child;
+            foreach_overlay_child (ov, child)
+                free (child->batch.buf);
+        }
         free (ov->children);
         free (ov);
         errno = saved_errno;
@@ -830,6 +1398,7 @@ struct overlay *overlay_create (flux_t *h)
 
     if (!(ov = calloc (1, sizeof (*ov))))
         return NULL;
+    ov->transport = &zmq_transport;
     ov->rank = FLUX_NODEID_ANY;
     ov->parent_lastsent = -1;
     ov->h = h;
@@ -16,6 +16,7 @@
 enum {
     KEEPALIVE_STATUS_NORMAL = 0,
     KEEPALIVE_STATUS_DISCONNECT = 1,
+    KEEPALIVE_STATUS_BATCH = 2,         /* internal to overlay */
 };
 
 struct overlay;
@@ -41,6 +42,12 @@ int overlay_init (struct overlay *ov,
                   int tbon_k);
 
 
+/* Select the overlay transport by name ("zmq" or "stream").
+ * Call before connect/bind.  The default is "zmq".
+ */
+int overlay_set_transport (struct overlay *ov, const char *name);
+const char *overlay_get_transport (struct overlay *ov);
+
 /* CURVE key management
  * If downstream peers, call overlay_authorize() with public key of each peer.
  */
@@ -0,0 +1,423 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <czmq.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/histogram.h"
+
+#include "rpcstats.h"
+
+/* Bound memory use if clients send requests to many distinct topics,
+ * or requests are never answered.  Topics beyond the limit are counted
+ * under OTHER_TOPIC.  Beyond the pending limit, the oldest pending
+ * request is forgotten to make room for the new one.  A client's pending
+ * requests are also forgotten when it disconnects.
+ */
+#define MAX_TOPICS      1024
+#define MAX_PENDING     16384
+#define OTHER_TOPIC     "(other)"
+
+struct topic_stats {
+    uint64_t requests;
+    uint64_t errors;
+    histogram_t latency;        /* microseconds */
+    histogram_t request_size;   /* payload bytes */
+    histogram_t response_size;  /* payload bytes */
+};
+
+struct pending {
+    struct topic_stats *ts;
+    uint64_t start;
+    bool streaming;
+    bool responded;
+    char sender[96];        // original sender of the request
+    char key[128];          // sender:matchtag
+    void *handle;           // position in rpcstats 'order'
+};
+
+struct rpcstats {
+    flux_t *h;
+    zhashx_t *topics;
+    zhashx_t *pending;      // sender:matchtag => struct pending
+    zlistx_t *order;        // struct pending, oldest first
+    zhashx_t *senders;      // sender => count of pending requests
+    flux_msg_handler_t **handlers;
+};
+
+static uint64_t now_usec (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int payload_size (const flux_msg_t *msg)
+{
+    int size;
+
+    if (flux_msg_get_payload (msg, NULL, &size) < 0)
+        return 0;
+    return size;
+}
+
+/* The original sender of a message is the route closest to the
+ * delimiter, or "" for the broker itself.
+ */
+static int msg_sender (const flux_msg_t *msg, char *buf, size_t size)
+{
+    char *sender = NULL;
+    int n;
+
+    if (flux_msg_get_route_first (msg, &sender) < 0)
+        return -1;
+    n = snprintf (buf, size, "%s", sender ? sender : "");
+    free (sender);
+    if (n >= size)
+        return -1;
+    return 0;
+}
+
+/* A request is identified by its sender and matchtag.
+ */
+static int pending_key (const flux_msg_t *msg, char *buf, size_t size)
+{
+    char sender[96];
+    uint32_t matchtag;
+
+    if (flux_msg_get_matchtag (msg, &matchtag) < 0
+        || matchtag == FLUX_MATCHTAG_NONE
+        || msg_sender (msg, sender, sizeof (sender)) < 0
+        || snprintf (buf, size, "%s:%"PRIu32, sender, matchtag) >= size)
+        return -1;
+    return 0;
+}
+
+static void pending_remove (struct rpcstats *rs, struct pending *p)
+{
+    int *count;
+
+    if ((count = zhashx_lookup (rs->senders, p->sender)) && --(*count) == 0)
+        zhashx_delete (rs->senders, p->sender);
+    zlistx_delete (rs->order, p->handle);
+    zhashx_delete (rs->pending, p->key); // frees p
+}
+
+/* Start tracking request 'msg', making room if needed.  A request
+ * that reuses the key of one that was never answered replaces it.
+ */
+static struct pending *pending_add (struct rpcstats *rs,
+                                    const flux_msg_t *msg)
+{
+    struct pending *p;
+    struct pending *old;
+    int *count;
+
+    if (!(p = calloc (1, sizeof (*p))))
+        return NULL;
+    if (msg_sender (msg, p->sender, sizeof (p->sender)) < 0
+        || pending_key (msg, p->key, sizeof (p->key)) < 0)
+        goto error;
+    if ((old = zhashx_lookup (rs->pending, p->key)))
+        pending_remove (rs, old);
+    else if (zhashx_size (rs->pending) >= MAX_PENDING
+        && (old = zlistx_first (rs->order)))
+        pending_remove (rs, old);
+    if (!(count = zhashx_lookup (rs->senders, p->sender))) {
+        if (!(count = calloc (1, sizeof (*count))))
+            goto error;
+        (void)zhashx_insert (rs->senders, p->sender, count);
+    }
+    if (!(p->handle = zlistx_add_end (rs->order, p))) {
+        if (*count == 0)
+            zhashx_delete (rs->senders, p->sender);
+        goto error;
+    }
+    (*count)++;
+    (void)zhashx_insert (rs->pending, p->key, p);
+    return p;
+error:
+    free (p);
+    return NULL;
+}
+
+/* Forget the pending requests of a client that has disconnected.
+ * Most clients have none, so the walk is only taken when needed.
+ */
+static void pending_disconnect (struct rpcstats *rs, const flux_msg_t *msg)
+{
+    char sender[96];
+    struct pending *p;
+    zlist_t *gone;
+
+    if (msg_sender (msg, sender, sizeof (sender)) < 0
+        || !zhashx_lookup (rs->senders, sender)
+        || !(gone = zlist_new ()))
+        return;
+    p = zlistx_first (rs->order);
+    while (p) {
+        if (!strcmp (p->sender, sender) && zlist_append (gone, p) < 0)
+            break;
+        p = zlistx_next (rs->order);
+    }
+    while ((p = zlist_pop (gone)))
+        pending_remove (rs, p);
+    zlist_destroy (&gone);
+}
+
+static bool is_disconnect (const char *topic)
+{
+    const char *suffix = "disconnect";
+    size_t len = strlen (topic);
+    size_t slen = strlen (suffix);
+
+    if (len < slen || strcmp (topic + len - slen, suffix) != 0)
+        return false;
+    return len == slen || topic[len - slen - 1] == '.';
+}
+
+static struct topic_stats *topic_lookup (struct rpcstats *rs,
+                                         const char *topic)
+{
+    struct topic_stats *ts;
+
+    if (!(ts = zhashx_lookup (rs->topics, topic))) {
+        if (zhashx_size (rs->topics) >= MAX_TOPICS) {
+            topic = OTHER_TOPIC;
+            if ((ts = zhashx_lookup (rs->topics, topic)))
+                return ts;
+        }
+        if (!(ts = calloc (1, sizeof (*ts))))
+            return NULL;
+        (void)zhashx_insert (rs->topics, topic, ts);
+    }
+    return ts;
+}
+
+void rpcstats_request (struct rpcstats *rs, const flux_msg_t *msg)
+{
+    const char *topic;
+    struct topic_stats *ts;
+    struct pending *p;
+    uint8_t flags;
+
+    if (!rs
+        || flux_msg_get_topic (msg, &topic) < 0
+        || flux_msg_get_flags (msg, &flags) < 0
+        || !(ts = topic_lookup (rs, topic)))
+        return;
+    ts->requests++;
+    histogram_record (&ts->request_size, payload_size (msg));
+
+    if (is_disconnect (topic))
+        pending_disconnect (rs, msg);
+    if ((flags & FLUX_MSGFLAG_NORESPONSE) || !(p = pending_add (rs, msg)))
+        return;
+    p->ts = ts;
+    p->start = now_usec ();
+    p->streaming = (flags & FLUX_MSGFLAG_STREAMING) ? true : false;
+}
+
+void rpcstats_response (struct rpcstats *rs, const flux_msg_t *msg)
+{
+    struct pending *p;
+    int errnum;
+    char key[128];
+
+    if (!rs
+        || zhashx_size (rs->pending) == 0
+        || pending_key (msg, key, sizeof (key)) < 0
+        || !(p = zhashx_lookup (rs->pending, key))
+        || flux_msg_get_errnum (msg, &errnum) < 0)
+        return;
+    if (!p->responded) {
+        histogram_record (&p->ts->latency, now_usec () - p->start);
+        p->responded = true;
+    }
+    histogram_record (&p->ts->response_size, payload_size (msg));
+    if (errnum != 0 && !(p->streaming && errnum == ENODATA))
+        p->ts->errors++;
+    if (!p->streaming || errnum != 0)
+        pending_remove (rs, p);
+}
+
+/* Encode only the non-empty buckets, as [index, count] pairs.
+ */
+static json_t *histogram_encode (const histogram_t *hist)
+{
+    json_t *buckets;
+    json_t *o;
+    int i;
+
+    if (!(buckets = json_array ()))
+        goto nomem;
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        json_t *entry;
+        if (hist->buckets[i] == 0)
+            continue;
+        if (!(entry = json_pack ("[iI]", i, (json_int_t)hist->buckets[i]))
+            || json_array_append_new (buckets, entry) < 0) {
+            json_decref (buckets);
+            goto nomem;
+        }
+    }
+    if (!(o = json_pack ("{s:I s:I s:I s:I s:o}",
+                         "count", (json_int_t)hist->count,
+                         "sum", (json_int_t)hist->sum,
+                         "min", (json_int_t)hist->min,
+                         "max", (json_int_t)hist->max,
+                         "buckets", buckets)))
+        goto nomem;
+    return o;
+nomem:
+    errno = ENOMEM;
+    return NULL;
+}
+
+static json_t *topic_encode (const char *topic, struct topic_stats *ts)
+{
+    json_t *latency = NULL;
+    json_t *request_size = NULL;
+    json_t *response_size = NULL;
+    json_t *o;
+
+    if (!(latency = histogram_encode (&ts->latency))
+        || !(request_size = histogram_encode (&ts->request_size))
+        || !(response_size = histogram_encode (&ts->response_size)))
+        goto error;
+    if (!(o = json_pack ("{s:s s:I s:I s:o s:o s:o}",
+                         "topic", topic,
+                         "requests", (json_int_t)ts->requests,
+                         "errors", (json_int_t)ts->errors,
+                         "latency", latency,
+                         "request_size", request_size,
+                         "response_size", response_size))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return o;
+error:
+    json_decref (latency);
+    json_decref (request_size);
+    json_decref (response_size);
+    return NULL;
+}
+
+static void rpcstats_cb (flux_t *h,
+                         flux_msg_handler_t *mh,
+                         const flux_msg_t *msg,
+                         void *arg)
+{
+    struct rpcstats *rs = arg;
+    int clear = 0;
+    struct topic_stats *ts;
+    json_t *topics;
+    json_t *o;
+    int pending;
+
+    if (flux_request_unpack (msg, NULL, "{s?b}", "clear", &clear) < 0)
+        goto error;
+    if (!(topics = json_array ()))
+        goto nomem;
+    ts = zhashx_first (rs->topics);
+    while (ts) {
+        const char *topic = zhashx_cursor (rs->topics);
+        if (!(o = topic_encode (topic, ts))
+            || json_array_append_new (topics, o) < 0) {
+            json_decref (topics);
+            goto nomem;
+        }
+        ts = zhashx_next (rs->topics);
+    }
+    pending = zhashx_size (rs->pending);
+    if (clear) {
+        zlistx_purge (rs->order);
+        zhashx_purge (rs->senders);
+        zhashx_purge (rs->pending);
+        zhashx_purge (rs->topics);
+    }
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:o s:i}",
+                           "topics", topics,
+                           "pending", pending) < 0)
+        flux_log_error (h, "error responding to broker.rpcstats request");
+    return;
+nomem:
+    errno = ENOMEM;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to broker.rpcstats request");
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "broker.rpcstats", rpcstats_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+static void item_free (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+void rpcstats_destroy (struct rpcstats *rs)
+{
+    if (rs) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (rs->handlers);
+        zlistx_destroy (&rs->order);
+        zhashx_destroy (&rs->senders);
+        zhashx_destroy (&rs->pending);
+        zhashx_destroy (&rs->topics);
+        free (rs);
+        errno = saved_errno;
+    }
+}
+
+struct rpcstats *rpcstats_create (flux_t *h)
+{
+    struct rpcstats *rs;
+
+    if (!(rs = calloc (1, sizeof (*rs))))
+        return NULL;
+    rs->h = h;
+    if (!(rs->topics = zhashx_new ())
+        || !(rs->pending = zhashx_new ())
+        || !(rs->order = zlistx_new ())
+        || !(rs->senders = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhashx_set_destructor (rs->topics, item_free);
+    zhashx_set_destructor (rs->pending, item_free);
+    zhashx_set_destructor (rs->senders, item_free);
+    if (flux_msg_handler_addvec (h, htab, rs, &rs->handlers) < 0)
+        goto error;
+    return rs;
+error:
+    rpcstats_destroy (rs);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
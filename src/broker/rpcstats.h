@@ -0,0 +1,41 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_RPCSTATS_H
+#define _BROKER_RPCSTATS_H
+
+#include <flux/core.h>
+
+/* Per-topic statistics for requests handled by services on this broker:
+ * request and error counts, and histograms of response latency,
+ * request payload size, and response payload size.
+ *
+ * The broker calls rpcstats_request() when it delivers a request to a
+ * local service, and rpcstats_response() for every response it routes.
+ * A response is matched to its request by sender and matchtag.
+ * Latency is measured to the first response, and so includes time spent
+ * queued for the service.  Requests still awaiting a response are
+ * forgotten when their sender disconnects.
+ *
+ * Statistics are fetched (and optionally cleared) with broker.rpcstats,
+ * along with the number of requests awaiting a response.
+ */
+
+struct rpcstats *rpcstats_create (flux_t *h);
+void rpcstats_destroy (struct rpcstats *rs);
+
+void rpcstats_request (struct rpcstats *rs, const flux_msg_t *msg);
+void rpcstats_response (struct rpcstats *rs, const flux_msg_t *msg);
+
+#endif /* !_BROKER_RPCSTATS_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,1132 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* stream.c - overlay transport over plain stream sockets
+ *
+ * Handshake, after the connection is established:
+ *   listener -> peer:      challenge[24]
+ *   peer -> listener:      uuid[16] pubkey[32] nonce[24]
+ *                            box[16 + challenge[24] challenge'[24] eph[32]]
+ *   listener -> peer:      nonce[24] box[16 + challenge'[24] eph'[32]]
+ * The peer's box is crypto_box_easy() from the peer's secret key to the
+ * listener's public key, and echoes the listener's challenge, proving the
+ * peer holds its key.  The listener's box goes the other way and echoes
+ * the peer's challenge', proving the listener holds the server key.
+ * eph and eph' are per-connection ephemeral public keys.
+ *
+ * Thereafter both directions carry frames of a 4 byte network order
+ * length followed by the encoded message sealed with crypto_box_easy_afternm()
+ * under the key shared by the ephemeral key pairs.  Nonces are not sent:
+ * each side counts frames per direction, so a frame that is altered,
+ * replayed, dropped or reordered fails to open and ends the connection.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <unistd.h>
+#include <stddef.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sodium.h>
+#include <czmq.h>
+#include <zmq.h>
+#include <flux/core.h>
+
+#include "stream.h"
+
+#define UUID_SIZE       16
+#define CHALLENGE_SIZE  crypto_box_NONCEBYTES
+#define HELLO_PLAIN     (CHALLENGE_SIZE * 2 + crypto_box_PUBLICKEYBYTES)
+#define HELLO_SIZE      (UUID_SIZE \
+                         + crypto_box_PUBLICKEYBYTES \
+                         + crypto_box_NONCEBYTES \
+                         + crypto_box_MACBYTES + HELLO_PLAIN)
+#define WELCOME_PLAIN   (CHALLENGE_SIZE + crypto_box_PUBLICKEYBYTES)
+#define WELCOME_SIZE    (crypto_box_NONCEBYTES \
+                         + crypto_box_MACBYTES + WELCOME_PLAIN)
+#define FRAME_HDR_SIZE  4
+#define FRAME_MAX       (1U << 30)
+#define READ_CHUNK      65536
+#define WRITE_IOV_MAX   64
+
+static const double reconnect_interval = 0.1;
+
+/* A listener drops a connection that has not completed the handshake
+ * within handshake_timeout seconds, and refuses new connections while
+ * handshake_max are incomplete, so that unauthenticated clients cannot
+ * hold descriptors and buffers indefinitely.
+ */
+static const double handshake_timeout = 10.;
+static const int handshake_max = 256;
+
+enum conn_state {
+    CONN_CLOSED,
+    CONN_CONNECTING,    // connect(2) in progress
+    CONN_CHALLENGE,     // peer: awaiting challenge
+    CONN_HELLO,         // listener: awaiting hello
+    CONN_WELCOME,       // peer: awaiting listener's response
+    CONN_READY,
+};
+
+/* A queued message is sealed when it is first written, since the session
+ * key is not known until the handshake completes.  If the connection is
+ * lost, unsent frames are resealed for the next session.
+ */
+struct frame {
+    uint8_t *wire;      // FRAME_HDR_SIZE length + sealed message, or NULL
+    size_t wire_size;
+    size_t size;
+    uint8_t data[];     // encoded message
+};
+
+struct conn {
+    struct stream *s;
+    int fd;
+    enum conn_state state;
+    char uuid[UUID_SIZE + 1];
+    uint8_t challenge[CHALLENGE_SIZE];  // the challenge this side sent
+    uint8_t eph_pk[crypto_box_PUBLICKEYBYTES];
+    uint8_t eph_sk[crypto_box_SECRETKEYBYTES];
+    uint8_t key[crypto_box_BEFORENMBYTES];
+    uint64_t txseq;
+    uint64_t rxseq;
+    uint8_t *plain;     // receive buffer for opened frames
+    size_t plain_size;
+    flux_watcher_t *rw;
+    flux_watcher_t *ww;
+    uint8_t *rbuf;
+    size_t rlen;
+    size_t rsize;
+    zlist_t *txq;       // struct frame
+    size_t txoff;       // bytes of first frame already sent
+    void *handle;       // listener: entry in s->conns
+    flux_watcher_t *hs_w; // listener: handshake deadline, or NULL
+};
+
+struct stream {
+    flux_t *h;
+    flux_reactor_t *r;
+    char *uri;
+    bool listener;
+    int fd;
+    flux_watcher_t *w;
+    zlistx_t *conns;            // listener: all connections
+    zhashx_t *peers;            // listener: uuid => authenticated conn
+    int handshakes;             // listener: conns awaiting hello
+    struct conn *conn;          // peer: connection to listener
+    flux_watcher_t *retry_w;    // peer: reconnect timer
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    zlist_t *rxq;
+    char uuid[UUID_SIZE + 1];
+    uint8_t public_key[crypto_box_PUBLICKEYBYTES];
+    uint8_t secret_key[crypto_box_SECRETKEYBYTES];
+    uint8_t server_key[crypto_box_PUBLICKEYBYTES];
+    stream_auth_f auth;
+    void *auth_arg;
+    stream_recv_f cb;
+    void *cb_arg;
+};
+
+static void conn_read_cb (flux_reactor_t *r, flux_watcher_t *w,
+                          int revents, void *arg);
+static void conn_write_cb (flux_reactor_t *r, flux_watcher_t *w,
+                           int revents, void *arg);
+static void peer_connect (struct stream *s);
+
+static void frame_unseal (struct frame *f)
+{
+    free (f->wire);
+    f->wire = NULL;
+    f->wire_size = 0;
+}
+
+static void frame_destroy (struct frame *f)
+{
+    if (f) {
+        frame_unseal (f);
+        free (f);
+    }
+}
+
+static struct frame *frame_encode (const flux_msg_t *msg)
+{
+    struct frame *f;
+    size_t size = flux_msg_encode_size (msg);
+
+    if (size > FRAME_MAX) {
+        errno = EMSGSIZE;
+        return NULL;
+    }
+    if (!(f = calloc (1, sizeof (*f) + size)))
+        return NULL;
+    f->size = size;
+    if (flux_msg_encode (msg, f->data, size) < 0) {
+        frame_destroy (f);
+        return NULL;
+    }
+    return f;
+}
+
+/* Nonces are never reused under a session key: the first byte tells the
+ * directions apart, and the last eight bytes hold the frame count.
+ */
+static void session_nonce (uint8_t *nonce, bool from_listener, uint64_t seq)
+{
+    int i;
+
+    memset (nonce, 0, crypto_box_NONCEBYTES);
+    nonce[0] = from_listener ? 1 : 2;
+    for (i = 0; i < 8; i++)
+        nonce[crypto_box_NONCEBYTES - 1 - i] = (seq >> (i * 8)) & 0xff;
+}
+
+static int frame_seal (struct conn *c, struct frame *f)
+{
+    uint8_t nonce[crypto_box_NONCEBYTES];
+    size_t size = crypto_box_MACBYTES + f->size;
+    uint32_t hdr = htonl (size);
+
+    if (!(f->wire = malloc (FRAME_HDR_SIZE + size)))
+        return -1;
+    f->wire_size = FRAME_HDR_SIZE + size;
+    memcpy (f->wire, &hdr, FRAME_HDR_SIZE);
+    session_nonce (nonce, c->s->listener, c->txseq++);
+    if (crypto_box_easy_afternm (f->wire + FRAME_HDR_SIZE,
+                                 f->data,
+                                 f->size,
+                                 nonce,
+                                 c->key) < 0) {
+        frame_unseal (f);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Listener: the connection has left the handshake, one way or another.
+ */
+static void conn_handshake_done (struct conn *c)
+{
+    if (c->hs_w) {
+        flux_watcher_destroy (c->hs_w);
+        c->hs_w = NULL;
+        c->s->handshakes--;
+    }
+}
+
+/* Derive the session key from this side's ephemeral secret key and the
+ * other side's ephemeral public key.
+ */
+static int conn_session_start (struct conn *c, const uint8_t *eph_pk)
+{
+    if (crypto_box_beforenm (c->key, eph_pk, c->eph_sk) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    sodium_memzero (c->eph_sk, sizeof (c->eph_sk));
+    conn_handshake_done (c);
+    c->txseq = 0;
+    c->rxseq = 0;
+    c->state = CONN_READY;
+    return 0;
+}
+
+/* Write 'len' bytes of handshake data.  The socket buffer of a new
+ * connection is empty, so a short write is treated as an error.
+ */
+static int write_all (int fd, const void *buf, size_t len)
+{
+    ssize_t n;
+
+    do {
+        n = send (fd, buf, len, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return -1;
+    if (n < len) {
+        errno = EPROTO;
+        return -1;
+    }
+    return 0;
+}
+
+static void conn_txq_clear (struct conn *c)
+{
+    struct frame *f;
+
+    while ((f = zlist_pop (c->txq)))
+        frame_destroy (f);
+    c->txoff = 0;
+}
+
+/* Tear down the socket and session but keep the conn and its transmit
+ * queue.  A frame that was partially written is dropped.
+ */
+static void conn_close (struct conn *c)
+{
+    struct frame *f;
+
+    conn_handshake_done (c);
+    flux_watcher_destroy (c->rw);
+    flux_watcher_destroy (c->ww);
+    c->rw = c->ww = NULL;
+    if (c->fd >= 0)
+        (void)close (c->fd);
+    c->fd = -1;
+    c->state = CONN_CLOSED;
+    c->rlen = 0;
+    if (c->txoff > 0) {
+        frame_destroy (zlist_pop (c->txq));
+        c->txoff = 0;
+    }
+    f = zlist_first (c->txq);
+    while (f) {
+        frame_unseal (f);
+        f = zlist_next (c->txq);
+    }
+    sodium_memzero (c->eph_sk, sizeof (c->eph_sk));
+    sodium_memzero (c->key, sizeof (c->key));
+}
+
+static void conn_destroy (struct conn *c)
+{
+    if (c) {
+        int saved_errno = errno;
+        conn_close (c);
+        conn_txq_clear (c);
+        zlist_destroy (&c->txq);
+        free (c->rbuf);
+        free (c->plain);
+        free (c);
+        errno = saved_errno;
+    }
+}
+
+static struct conn *conn_create (struct stream *s)
+{
+    struct conn *c;
+
+    if (!(c = calloc (1, sizeof (*c))))
+        return NULL;
+    c->s = s;
+    c->fd = -1;
+    if (!(c->txq = zlist_new ())) {
+        conn_destroy (c);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return c;
+}
+
+static int conn_watch (struct conn *c)
+{
+    if (!(c->rw = flux_fd_watcher_create (c->s->r,
+                                          c->fd,
+                                          FLUX_POLLIN,
+                                          conn_read_cb,
+                                          c))
+        || !(c->ww = flux_fd_watcher_create (c->s->r,
+                                             c->fd,
+                                             FLUX_POLLOUT,
+                                             conn_write_cb,
+                                             c)))
+        return -1;
+    return 0;
+}
+
+/* Called when a connection fails.  A listener forgets the peer,
+ * while a connecting stream retries after a short delay.
+ */
+static void conn_lost (struct conn *c)
+{
+    struct stream *s = c->s;
+
+    if (s->listener) {
+        if (c->state == CONN_READY && zhashx_lookup (s->peers, c->uuid) == c)
+            zhashx_delete (s->peers, c->uuid);
+        zlistx_delete (s->conns, c->handle); // destroys c
+    }
+    else {
+        conn_close (c);
+        flux_timer_watcher_reset (s->retry_w, reconnect_interval, 0.);
+        flux_watcher_start (s->retry_w);
+    }
+}
+
+/* Queue a frame and arrange for it to be written when the socket is
+ * writable, which coalesces everything queued in this loop iteration.
+ */
+static int conn_send (struct conn *c, const flux_msg_t *msg)
+{
+    struct frame *f;
+
+    if (!(f = frame_encode (msg)))
+        return -1;
+    if (zlist_append (c->txq, f) < 0) {
+        frame_destroy (f);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (c->state == CONN_READY)
+        flux_watcher_start (c->ww);
+    return 0;
+}
+
+static int conn_flush (struct conn *c)
+{
+    struct iovec iov[WRITE_IOV_MAX];
+    struct msghdr mh = { .msg_iov = iov };
+    struct frame *f;
+    ssize_t n;
+    int i = 0;
+
+    f = zlist_first (c->txq);
+    while (f && i < WRITE_IOV_MAX) {
+        if (!f->wire && frame_seal (c, f) < 0)
+            return -1;
+        iov[i].iov_base = f->wire + (i == 0 ? c->txoff : 0);
+        iov[i].iov_len = f->wire_size - (i == 0 ? c->txoff : 0);
+        i++;
+        f = zlist_next (c->txq);
+    }
+    if (i == 0)
+        return 0;
+    mh.msg_iovlen = i;
+    do {
+        n = sendmsg (c->fd, &mh, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        return -1;
+    }
+    n += c->txoff;
+    while ((f = zlist_first (c->txq)) && f->wire && n >= f->wire_size) {
+        n -= f->wire_size;
+        frame_destroy (zlist_pop (c->txq));
+    }
+    c->txoff = n;
+    return 0;
+}
+
+static void conn_write_cb (flux_reactor_t *r, flux_watcher_t *w,
+                           int revents, void *arg)
+{
+    struct conn *c = arg;
+    struct stream *s = c->s;
+
+    if (c->state == CONN_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof (err);
+        if (getsockopt (c->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err) {
+            conn_lost (c);
+            return;
+        }
+        c->state = CONN_CHALLENGE;
+        flux_watcher_stop (c->ww);
+        flux_watcher_start (c->rw);
+        return;
+    }
+    if (conn_flush (c) < 0) {
+        flux_log_error (s->h, "stream: write to %s", s->uri);
+        conn_lost (c);
+        return;
+    }
+    if (zlist_size (c->txq) == 0)
+        flux_watcher_stop (c->ww);
+}
+
+/* Listener: check the peer's response to our challenge, and prove to
+ * the peer that we hold the server key by answering its challenge.
+ */
+static int conn_recv_hello (struct conn *c, const uint8_t *buf)
+{
+    struct stream *s = c->s;
+    const uint8_t *pk = buf + UUID_SIZE;
+    const uint8_t *nonce = pk + crypto_box_PUBLICKEYBYTES;
+    const uint8_t *box = nonce + crypto_box_NONCEBYTES;
+    uint8_t plain[HELLO_PLAIN];
+    uint8_t welcome[WELCOME_SIZE];
+    uint8_t reply[WELCOME_PLAIN];
+    char pubkey[41];
+    struct conn *old;
+
+    memcpy (c->uuid, buf, UUID_SIZE);
+    c->uuid[UUID_SIZE] = '\0';
+    zmq_z85_encode (pubkey, pk, crypto_box_PUBLICKEYBYTES);
+    if (s->auth && s->auth (c->uuid, pubkey, s->auth_arg) < 0)
+        goto denied;
+    if (crypto_box_open_easy (plain,
+                              box,
+                              crypto_box_MACBYTES + HELLO_PLAIN,
+                              nonce,
+                              pk,
+                              s->secret_key) < 0
+        || sodium_memcmp (plain, c->challenge, CHALLENGE_SIZE) != 0) {
+        flux_log (s->h, LOG_ERR, "stream: %s failed challenge", c->uuid);
+        goto denied;
+    }
+    crypto_box_keypair (c->eph_pk, c->eph_sk);
+    memcpy (reply, plain + CHALLENGE_SIZE, CHALLENGE_SIZE);
+    memcpy (reply + CHALLENGE_SIZE, c->eph_pk, crypto_box_PUBLICKEYBYTES);
+    randombytes_buf (welcome, crypto_box_NONCEBYTES);
+    if (crypto_box_easy (welcome + crypto_box_NONCEBYTES,
+                         reply,
+                         sizeof (reply),
+                         welcome,
+                         pk,
+                         s->secret_key) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (write_all (c->fd, welcome, sizeof (welcome)) < 0
+        || conn_session_start (c, plain + CHALLENGE_SIZE * 2) < 0)
+        return -1;
+    if ((old = zhashx_lookup (s->peers, c->uuid))) {
+        zhashx_delete (s->peers, c->uuid);
+        zlistx_delete (s->conns, old->handle);
+    }
+    if (zhashx_insert (s->peers, c->uuid, c) < 0) {
+        c->state = CONN_HELLO; // not in s->peers
+        errno = ENOMEM;
+        return -1;
+    }
+    return HELLO_SIZE;
+denied:
+    errno = EPERM;
+    return -1;
+}
+
+/* Peer: answer the listener's challenge with our own.
+ */
+static int conn_recv_challenge (struct conn *c, const uint8_t *buf)
+{
+    struct stream *s = c->s;
+    uint8_t hello[HELLO_SIZE];
+    uint8_t *pk = hello + UUID_SIZE;
+    uint8_t *nonce = pk + crypto_box_PUBLICKEYBYTES;
+    uint8_t *box = nonce + crypto_box_NONCEBYTES;
+    uint8_t plain[HELLO_PLAIN];
+
+    randombytes_buf (c->challenge, CHALLENGE_SIZE);
+    crypto_box_keypair (c->eph_pk, c->eph_sk);
+    memcpy (plain, buf, CHALLENGE_SIZE);
+    memcpy (plain + CHALLENGE_SIZE, c->challenge, CHALLENGE_SIZE);
+    memcpy (plain + CHALLENGE_SIZE * 2,
+            c->eph_pk,
+            crypto_box_PUBLICKEYBYTES);
+
+    memset (hello, 0, UUID_SIZE);
+    memcpy (hello, s->uuid, strlen (s->uuid));
+    memcpy (pk, s->public_key, crypto_box_PUBLICKEYBYTES);
+    randombytes_buf (nonce, crypto_box_NONCEBYTES);
+    if (crypto_box_easy (box,
+                         plain,
+                         sizeof (plain),
+                         nonce,
+                         s->server_key,
+                         s->secret_key) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (write_all (c->fd, hello, sizeof (hello)) < 0)
+        return -1;
+    c->state = CONN_WELCOME;
+    return CHALLENGE_SIZE;
+}
+
+/* Peer: check that the listener answered our challenge, which only the
+ * holder of the server key can do.
+ */
+static int conn_recv_welcome (struct conn *c, const uint8_t *buf)
+{
+    struct stream *s = c->s;
+    uint8_t plain[WELCOME_PLAIN];
+
+    if (crypto_box_open_easy (plain,
+                              buf + crypto_box_NONCEBYTES,
+                              crypto_box_MACBYTES + WELCOME_PLAIN,
+                              buf,
+                              s->server_key,
+                              s->secret_key) < 0
+        || sodium_memcmp (plain, c->challenge, CHALLENGE_SIZE) != 0) {
+        flux_log (s->h, LOG_ERR, "stream: %s failed challenge", s->uri);
+        errno = EPERM;
+        return -1;
+    }
+    if (conn_session_start (c, plain + CHALLENGE_SIZE) < 0)
+        return -1;
+    if (zlist_size (c->txq) > 0)
+        flux_watcher_start (c->ww);
+    return WELCOME_SIZE;
+}
+
+/* Decode one frame from the receive buffer, if complete.
+ * Return the number of bytes consumed, 0 if more data is needed,
+ * or -1 on error.
+ */
+static int conn_recv_frame (struct conn *c, const uint8_t *buf, size_t len)
+{
+    struct stream *s = c->s;
+    uint8_t nonce[crypto_box_NONCEBYTES];
+    uint32_t hdr;
+    size_t size;
+    flux_msg_t *msg;
+
+    if (len < FRAME_HDR_SIZE)
+        return 0;
+    memcpy (&hdr, buf, FRAME_HDR_SIZE);
+    size = ntohl (hdr);
+    if (size < crypto_box_MACBYTES
+        || size > FRAME_MAX + crypto_box_MACBYTES) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (len < FRAME_HDR_SIZE + size)
+        return 0;
+    if (c->plain_size < size - crypto_box_MACBYTES) {
+        uint8_t *p;
+        if (!(p = realloc (c->plain, size - crypto_box_MACBYTES)))
+            return -1;
+        c->plain = p;
+        c->plain_size = size - crypto_box_MACBYTES;
+    }
+    session_nonce (nonce, !s->listener, c->rxseq++);
+    if (crypto_box_open_easy_afternm (c->plain,
+                                      buf + FRAME_HDR_SIZE,
+                                      size,
+                                      nonce,
+                                      c->key) < 0) {
+        flux_log (s->h, LOG_ERR, "stream: %s: frame failed to open",
+                  s->listener ? c->uuid : s->uri);
+        errno = EPERM;
+        return -1;
+    }
+    if (!(msg = flux_msg_decode (c->plain, size - crypto_box_MACBYTES)))
+        return -1;
+    if (s->listener) {
+        if (flux_msg_enable_route (msg) < 0
+            || flux_msg_push_route (msg, c->uuid) < 0)
+            goto error;
+    }
+    if (zlist_append (s->rxq, msg) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return FRAME_HDR_SIZE + size;
+error:
+    flux_msg_destroy (msg);
+    return -1;
+}
+
+static int conn_parse (struct conn *c)
+{
+    size_t off = 0;
+    int n;
+
+    while (off < c->rlen) {
+        const uint8_t *buf = c->rbuf + off;
+        size_t len = c->rlen - off;
+
+        switch (c->state) {
+            case CONN_CHALLENGE:
+                n = len < CHALLENGE_SIZE ? 0 : conn_recv_challenge (c, buf);
+                break;
+            case CONN_HELLO:
+                n = len < HELLO_SIZE ? 0 : conn_recv_hello (c, buf);
+                break;
+            case CONN_WELCOME:
+                n = len < WELCOME_SIZE ? 0 : conn_recv_welcome (c, buf);
+                break;
+            case CONN_READY:
+                n = conn_recv_frame (c, buf, len);
+                break;
+            default:
+                errno = EPROTO;
+                n = -1;
+                break;
+        }
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+        off += n;
+    }
+    if (off > 0) {
+        memmove (c->rbuf, c->rbuf + off, c->rlen - off);
+        c->rlen -= off;
+    }
+    return 0;
+}
+
+static void conn_read_cb (flux_reactor_t *r, flux_watcher_t *w,
+                          int revents, void *arg)
+{
+    struct conn *c = arg;
+    struct stream *s = c->s;
+    ssize_t n;
+    int count;
+
+    if (c->rsize - c->rlen < READ_CHUNK) {
+        uint8_t *buf;
+        if (!(buf = realloc (c->rbuf, c->rlen + READ_CHUNK))) {
+            flux_log_error (s->h, "stream: read from %s", s->uri);
+            conn_lost (c);
+            goto deliver;
+        }
+        c->rbuf = buf;
+        c->rsize = c->rlen + READ_CHUNK;
+    }
+    do {
+        n = read (c->fd, c->rbuf + c->rlen, c->rsize - c->rlen);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return;
+    if (n <= 0) {
+        conn_lost (c);
+        goto deliver;
+    }
+    c->rlen += n;
+    if (conn_parse (c) < 0) {
+        if (errno != EPERM)
+            flux_log_error (s->h, "stream: %s", s->uri);
+        conn_lost (c);
+    }
+deliver:
+    /* Call the receive callback once per message that is queued now.
+     */
+    count = zlist_size (s->rxq);
+    while (count-- > 0 && zlist_size (s->rxq) > 0 && s->cb)
+        s->cb (s, s->cb_arg);
+}
+
+static void conn_handshake_timeout_cb (flux_reactor_t *r,
+                                       flux_watcher_t *w,
+                                       int revents,
+                                       void *arg)
+{
+    struct conn *c = arg;
+
+    flux_log (c->s->h,
+              LOG_ERR,
+              "stream: handshake timed out on %s",
+              c->s->uri);
+    conn_lost (c);
+}
+
+static void listener_accept_cb (flux_reactor_t *r, flux_watcher_t *w,
+                                int revents, void *arg)
+{
+    struct stream *s = arg;
+    struct conn *c;
+    int fd;
+    int refused = 0;
+
+    while ((fd = accept4 (s->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC))
+        >= 0) {
+        if (s->handshakes >= handshake_max) {
+            (void)close (fd);
+            refused++;
+            continue;
+        }
+        if (!(c = conn_create (s))) {
+            (void)close (fd);
+            continue;
+        }
+        c->fd = fd;
+        c->state = CONN_HELLO;
+        if (!(c->hs_w = flux_timer_watcher_create (r,
+                                                   handshake_timeout,
+                                                   0.,
+                                                   conn_handshake_timeout_cb,
+                                                   c))) {
+            conn_destroy (c);
+            continue;
+        }
+        s->handshakes++;
+        randombytes_buf (c->challenge, sizeof (c->challenge));
+        if (write_all (fd, c->challenge, sizeof (c->challenge)) < 0
+            || conn_watch (c) < 0
+            || !(c->handle = zlistx_add_end (s->conns, c))) {
+            conn_destroy (c);
+            continue;
+        }
+        flux_watcher_start (c->hs_w);
+        flux_watcher_start (c->rw);
+    }
+    if (refused > 0) {
+        flux_log (s->h,
+                  LOG_ERR,
+                  "stream: refused %d connections on %s: %d handshakes pending",
+                  refused,
+                  s->uri,
+                  s->handshakes);
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        flux_log_error (s->h, "stream: accept on %s", s->uri);
+}
+
+static void peer_retry_cb (flux_reactor_t *r, flux_watcher_t *w,
+                           int revents, void *arg)
+{
+    struct stream *s = arg;
+
+    flux_watcher_stop (w);
+    peer_connect (s);
+}
+
+static void peer_connect (struct stream *s)
+{
+    struct conn *c = s->conn;
+    int one = 1;
+
+    if ((c->fd = socket (s->addr.ss_family,
+                         SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                         0)) < 0)
+        goto retry;
+    if (s->addr.ss_family != AF_UNIX)
+        (void)setsockopt (c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+    if (conn_watch (c) < 0)
+        goto retry;
+    if (connect (c->fd, (struct sockaddr *)&s->addr, s->addrlen) < 0) {
+        if (errno != EINPROGRESS)
+            goto retry;
+        c->state = CONN_CONNECTING;
+        flux_watcher_start (c->ww);
+        return;
+    }
+    c->state = CONN_CHALLENGE;
+    flux_watcher_start (c->rw);
+    return;
+retry:
+    conn_lost (c);
+}
+
+/* Parse "tcp://host:port" or "ipc://path".  A host or port of "*" is
+ * a wildcard, valid only when binding.
+ */
+static int parse_uri (const char *uri,
+                      bool passive,
+                      struct sockaddr_storage *addr,
+                      socklen_t *addrlen)
+{
+    memset (addr, 0, sizeof (*addr));
+    if (!strncmp (uri, "ipc://", 6)) {
+        struct sockaddr_un *sun = (struct sockaddr_un *)addr;
+        const char *path = uri + 6;
+        if (strlen (path) == 0 || strlen (path) >= sizeof (sun->sun_path)) {
+            errno = EINVAL;
+            return -1;
+        }
+        sun->sun_family = AF_UNIX;
+        strcpy (sun->sun_path, path);
+        *addrlen = sizeof (*sun);
+        if (path[0] == '@') { // abstract namespace, as with zeromq
+            sun->sun_path[0] = '\0';
+            *addrlen = offsetof (struct sockaddr_un, sun_path) + strlen (path);
+        }
+        return 0;
+    }
+    if (!strncmp (uri, "tcp://", 6)) {
+        struct addrinfo hints = {
+            .ai_socktype = SOCK_STREAM,
+            .ai_flags = passive ? AI_PASSIVE : 0,
+        };
+        struct addrinfo *res;
+        char *host;
+        char *port;
+        int e;
+
+        if (!(host = strdup (uri + 6)))
+            return -1;
+        if (!(port = strrchr (host, ':'))) {
+            free (host);
+            errno = EINVAL;
+            return -1;
+        }
+        *port++ = '\0';
+        if (host[0] == '[' && host[strlen (host) - 1] == ']') {
+            host[strlen (host) - 1] = '\0';
+            memmove (host, host + 1, strlen (host));
+        }
+        e = getaddrinfo (!strcmp (host, "*") ? NULL : host,
+                         !strcmp (port, "*") ? "0" : port,
+                         &hints,
+                         &res);
+        free (host);
+        if (e != 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        memcpy (addr, res->ai_addr, res->ai_addrlen);
+        *addrlen = res->ai_addrlen;
+        freeaddrinfo (res);
+        return 0;
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+/* Build the URI peers should use, after binding.
+ */
+static char *bound_uri (int fd, const char *uri)
+{
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof (addr);
+    char host[INET6_ADDRSTRLEN];
+    char *s = NULL;
+
+    if (!strncmp (uri, "ipc://", 6))
+        return strdup (uri);
+    if (getsockname (fd, (struct sockaddr *)&addr, &len) < 0)
+        return NULL;
+    if (addr.ss_family == AF_INET) {
+        struct sockaddr_in *sin = (struct sockaddr_in *)&addr;
+        if (!inet_ntop (AF_INET, &sin->sin_addr, host, sizeof (host))
+            || asprintf (&s, "tcp://%s:%d", host, ntohs (sin->sin_port)) < 0)
+            return NULL;
+    }
+    else {
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&addr;
+        if (!inet_ntop (AF_INET6, &sin6->sin6_addr, host, sizeof (host))
+            || asprintf (&s, "tcp://[%s]:%d", host, ntohs (sin6->sin6_port)) < 0)
+            return NULL;
+    }
+    return s;
+}
+
+static void conn_destructor (void **item)
+{
+    if (item) {
+        conn_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static void msg_destructor (void *item)
+{
+    flux_msg_destroy (item);
+}
+
+void stream_destroy (struct stream *s)
+{
+    if (s) {
+        int saved_errno = errno;
+        flux_msg_t *msg;
+
+        /* Best effort to deliver anything queued for the listener,
+         * such as a disconnect keepalive sent just before destruction.
+         */
+        if (s->conn && s->conn->state == CONN_READY)
+            (void)conn_flush (s->conn);
+        zhashx_destroy (&s->peers);
+        zlistx_destroy (&s->conns);
+        conn_destroy (s->conn);
+        flux_watcher_destroy (s->retry_w);
+        flux_watcher_destroy (s->w);
+        if (s->fd >= 0)
+            (void)close (s->fd);
+        if (s->rxq) {
+            while ((msg = zlist_pop (s->rxq)))
+                msg_destructor (msg);
+            zlist_destroy (&s->rxq);
+        }
+        free (s->uri);
+        sodium_memzero (s->secret_key, sizeof (s->secret_key));
+        free (s);
+        errno = saved_errno;
+    }
+}
+
+static struct stream *stream_create (flux_t *h,
+                                     const uint8_t *secret_key,
+                                     stream_recv_f cb,
+                                     void *arg)
+{
+    struct stream *s;
+
+    if (sodium_init () < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(s = calloc (1, sizeof (*s))))
+        return NULL;
+    s->h = h;
+    s->r = flux_get_reactor (h);
+    s->fd = -1;
+    s->cb = cb;
+    s->cb_arg = arg;
+    memcpy (s->secret_key, secret_key, sizeof (s->secret_key));
+    if (!(s->rxq = zlist_new ())) {
+        stream_destroy (s);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return s;
+}
+
+struct stream *stream_bind (flux_t *h,
+                            const char *uri,
+                            const uint8_t *secret_key,
+                            stream_auth_f auth,
+                            void *auth_arg,
+                            stream_recv_f cb,
+                            void *arg)
+{
+    struct stream *s;
+    int one = 1;
+
+    if (!h || !uri || !secret_key) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(s = stream_create (h, secret_key, cb, arg)))
+        return NULL;
+    s->listener = true;
+    s->auth = auth;
+    s->auth_arg = auth_arg;
+    if (!(s->conns = zlistx_new ()) || !(s->peers = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zlistx_set_destructor (s->conns, conn_destructor);
+    if (parse_uri (uri, true, &s->addr, &s->addrlen) < 0)
+        goto error;
+    if ((s->fd = socket (s->addr.ss_family,
+                         SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                         0)) < 0)
+        goto error;
+    if (s->addr.ss_family == AF_UNIX) {
+        const char *path = ((struct sockaddr_un *)&s->addr)->sun_path;
+        if (path[0] != '\0')
+            (void)unlink (path);
+    }
+    else
+        (void)setsockopt (s->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+    if (bind (s->fd, (struct sockaddr *)&s->addr, s->addrlen) < 0
+        || listen (s->fd, SOMAXCONN) < 0)
+        goto error;
+    if (!(s->uri = bound_uri (s->fd, uri)))
+        goto error;
+    if (!(s->w = flux_fd_watcher_create (s->r,
+                                         s->fd,
+                                         FLUX_POLLIN,
+                                         listener_accept_cb,
+                                         s)))
+        goto error;
+    flux_watcher_start (s->w);
+    return s;
+error:
+    stream_destroy (s);
+    return NULL;
+}
+
+struct stream *stream_connect (flux_t *h,
+                               const char *uri,
+                               const char *uuid,
+                               const uint8_t *public_key,
+                               const uint8_t *secret_key,
+                               const uint8_t *server_key,
+                               stream_recv_f cb,
+                               void *arg)
+{
+    struct stream *s;
+
+    if (!h || !uri || !uuid || strlen (uuid) > UUID_SIZE
+        || !public_key || !secret_key || !server_key) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(s = stream_create (h, secret_key, cb, arg)))
+        return NULL;
+    strcpy (s->uuid, uuid);
+    memcpy (s->public_key, public_key, sizeof (s->public_key));
+    memcpy (s->server_key, server_key, sizeof (s->server_key));
+    if (!(s->uri = strdup (uri)))
+        goto error;
+    if (parse_uri (uri, false, &s->addr, &s->addrlen) < 0)
+        goto error;
+    if (!(s->conn = conn_create (s)))
+        goto error;
+    if (!(s->retry_w = flux_timer_watcher_create (s->r,
+                                                  reconnect_interval,
+                                                  0.,
+                                                  peer_retry_cb,
+                                                  s)))
+        goto error;
+    peer_connect (s);
+    return s;
+error:
+    stream_destroy (s);
+    return NULL;
+}
+
+const char *stream_get_uri (struct stream *s)
+{
+    return s ? s->uri : NULL;
+}
+
+int stream_send (struct stream *s, const flux_msg_t *msg)
+{
+    struct conn *c;
+    flux_msg_t *cpy;
+    char *uuid = NULL;
+    int rc = -1;
+
+    if (!s || !msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!s->listener)
+        return conn_send (s->conn, msg);
+    if (!(cpy = flux_msg_copy (msg, true)))
+        return -1;
+    if (flux_msg_pop_route (cpy, &uuid) < 0)
+        goto done;
+    if (!uuid || !(c = zhashx_lookup (s->peers, uuid))) {
+        errno = EHOSTUNREACH;
+        goto done;
+    }
+    rc = conn_send (c, cpy);
+done:
+    free (uuid);
+    flux_msg_destroy (cpy);
+    return rc;
+}
+
+flux_msg_t *stream_recv (struct stream *s)
+{
+    flux_msg_t *msg;
+
+    if (!s) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(msg = zlist_pop (s->rxq))) {
+        errno = EWOULDBLOCK;
+        return NULL;
+    }
+    return msg;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,85 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_STREAM_H
+#define _BROKER_STREAM_H
+
+#include <stdint.h>
+#include <flux/core.h>
+
+/* Overlay transport over plain stream sockets (tcp:// or ipc://).
+ *
+ * Messages travel as a 4 byte network order length followed by the
+ * flux_msg_encode() representation sealed with a per-connection session
+ * key.  Messages queued during a reactor loop iteration are written
+ * together with one sendmsg(2) call.
+ *
+ * When a connection is established, the listener and the connecting
+ * peer each answer a random challenge from the other with a box made
+ * with their CURVE keys, the same keys used by the zeromq transport,
+ * and exchange ephemeral public keys from which the session key is
+ * derived.  A peer whose public key is not authorized, or a listener
+ * that does not hold the expected server key, is disconnected.
+ *
+ * A listening stream behaves like a ROUTER socket: received messages
+ * have the sender's uuid pushed onto the route stack, and messages are
+ * sent to the peer named by the top route, which is popped.
+ * A connecting stream behaves like a DEALER socket, reconnecting and
+ * holding outgoing messages if the connection is lost.
+ */
+
+struct stream;
+
+/* Return 0 if peer 'uuid' with Z85 public key 'pubkey' may connect,
+ * or -1 if it may not.
+ */
+typedef int (*stream_auth_f)(const char *uuid, const char *pubkey, void *arg);
+
+/* Called when received messages are ready for stream_recv().
+ */
+typedef void (*stream_recv_f)(struct stream *s, void *arg);
+
+struct stream *stream_bind (flux_t *h,
+                            const char *uri,
+                            const uint8_t *secret_key,
+                            stream_auth_f auth,
+                            void *auth_arg,
+                            stream_recv_f cb,
+                            void *arg);
+
+struct stream *stream_connect (flux_t *h,
+                               const char *uri,
+                               const char *uuid,
+                               const uint8_t *public_key,
+                               const uint8_t *secret_key,
+                               const uint8_t *server_key,
+                               stream_recv_f cb,
+                               void *arg);
+
+void stream_destroy (struct stream *s);
+
+/* Return the bound URI, with wildcard host or port filled in.
+ */
+const char *stream_get_uri (struct stream *s);
+
+/* Queue 'msg' for sending.  On a listening stream, fail with
+ * EHOSTUNREACH if the peer named by the top route is not connected.
+ */
+int stream_send (struct stream *s, const flux_msg_t *msg);
+
+/* Return the next received message, or NULL with errno = EWOULDBLOCK.
+ */
+flux_msg_t *stream_recv (struct stream *s);
+
+#endif /* !_BROKER_STREAM_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
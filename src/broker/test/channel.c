@@ -0,0 +1,223 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <pthread.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+
+#include "channel.h"
+
+static flux_msg_t *create_seq (const char *topic, int seq)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_request_encode (topic, NULL))
+        || flux_msg_set_matchtag (msg, seq) < 0)
+        BAIL_OUT ("could not create test message");
+    return msg;
+}
+
+static int get_seq (const flux_msg_t *msg)
+{
+    uint32_t seq;
+
+    if (flux_msg_get_matchtag (msg, &seq) < 0)
+        return -1;
+    return seq;
+}
+
+void test_badargs (void)
+{
+    struct channel *ch;
+    flux_msg_t *msg;
+
+    errno = 0;
+    ok (channel_create (0) == NULL && errno == EINVAL,
+        "channel_create capacity=0 fails with EINVAL");
+    if (!(ch = channel_create (4)))
+        BAIL_OUT ("channel_create failed");
+    msg = create_seq ("foo", 0);
+    errno = 0;
+    ok (channel_send (NULL, CHANNEL_BROKER, msg) < 0 && errno == EINVAL,
+        "channel_send ch=NULL fails with EINVAL");
+    errno = 0;
+    ok (channel_send (ch, 42, msg) < 0 && errno == EINVAL,
+        "channel_send end=42 fails with EINVAL");
+    errno = 0;
+    ok (channel_send (ch, CHANNEL_BROKER, NULL) < 0 && errno == EINVAL,
+        "channel_send msg=NULL fails with EINVAL");
+    errno = 0;
+    ok (channel_recv (ch, 42, FLUX_O_NONBLOCK) == NULL && errno == EINVAL,
+        "channel_recv end=42 fails with EINVAL");
+    errno = 0;
+    ok (channel_recv (ch, CHANNEL_MODULE, FLUX_O_NONBLOCK) == NULL
+        && errno == EWOULDBLOCK,
+        "channel_recv on empty channel fails with EWOULDBLOCK");
+    flux_msg_destroy (msg);
+    channel_destroy (ch);
+}
+
+/* Send more messages than the ring holds from the broker end,
+ * forcing some onto the backlog, and check that they arrive in order.
+ * The first message is received by identity: no copy was made.
+ */
+void test_backlog (void)
+{
+    struct channel *ch;
+    flux_t *h;
+    flux_msg_t *first;
+    flux_msg_t *msg;
+    int count = 0;
+    int errors = 0;
+    int i;
+
+    if (!(ch = channel_create (4)))
+        BAIL_OUT ("channel_create failed");
+    first = create_seq ("foo", 0);
+    ok (channel_send (ch, CHANNEL_BROKER, first) == 0,
+        "channel_send broker->module works");
+    for (i = 1; i < 100; i++) {
+        msg = create_seq ("foo", i);
+        if (channel_send (ch, CHANNEL_BROKER, msg) < 0) {
+            flux_msg_destroy (msg);
+            errors++;
+        }
+    }
+    ok (errors == 0,
+        "channel_send broker->module beyond ring capacity works");
+    msg = channel_recv (ch, CHANNEL_MODULE, FLUX_O_NONBLOCK);
+    ok (msg == first,
+        "module received the same message object that was sent");
+    flux_msg_destroy (msg);
+    count = 1;
+    while ((msg = channel_recv (ch, CHANNEL_MODULE, FLUX_O_NONBLOCK))) {
+        if (get_seq (msg) != count)
+            errors++;
+        count++;
+        flux_msg_destroy (msg);
+    }
+    /* The module end drained the ring and flagged the broker, which
+     * moves the backlog forward as its handle is polled.
+     */
+    if (!(h = channel_open (ch, CHANNEL_BROKER, 0)))
+        BAIL_OUT ("channel_open failed");
+    while (count < 100) {
+        if (flux_pollevents (h) < 0)
+            BAIL_OUT ("flux_pollevents failed");
+        while ((msg = channel_recv (ch, CHANNEL_MODULE, FLUX_O_NONBLOCK))) {
+            if (get_seq (msg) != count)
+                errors++;
+            count++;
+            flux_msg_destroy (msg);
+        }
+    }
+    ok (count == 100 && errors == 0,
+        "module received all messages in order");
+    flux_close (h);
+
+    /* Leave some messages in flight in both directions.
+     */
+    for (i = 0; i < 10; i++) {
+        msg = create_seq ("foo", i);
+        if (channel_send (ch, CHANNEL_BROKER, msg) < 0)
+            flux_msg_destroy (msg);
+    }
+    msg = create_seq ("bar", 0);
+    if (channel_send (ch, CHANNEL_MODULE, msg) < 0)
+        flux_msg_destroy (msg);
+    channel_destroy (ch);
+    pass ("channel_destroy with messages in flight works");
+}
+
+#define THREAD_COUNT 10000
+
+static void *module_thread (void *arg)
+{
+    struct channel *ch = arg;
+    flux_t *h;
+    flux_msg_t *msg;
+    int i;
+
+    if (!(h = channel_open (ch, CHANNEL_MODULE, 0)))
+        BAIL_OUT ("channel_open module end failed");
+    for (i = 0; i < THREAD_COUNT; i++) {
+        if (!(msg = flux_recv (h, FLUX_MATCH_ANY, 0)))
+            BAIL_OUT ("flux_recv failed");
+        if (flux_send (h, msg, 0) < 0)
+            BAIL_OUT ("flux_send failed");
+        flux_msg_destroy (msg);
+    }
+    flux_close (h);
+    return NULL;
+}
+
+/* Echo messages through a module thread using a small ring, so that
+ * both the broker backlog and the module's blocking send are exercised.
+ */
+void test_thread (void)
+{
+    struct channel *ch;
+    pthread_t t;
+    flux_msg_t *msg;
+    int sent = 0;
+    int received = 0;
+    int errors = 0;
+    int e;
+
+    if (!(ch = channel_create (8)))
+        BAIL_OUT ("channel_create failed");
+    if ((e = pthread_create (&t, NULL, module_thread, ch)))
+        BAIL_OUT ("pthread_create failed");
+    while (received < THREAD_COUNT) {
+        if (sent < THREAD_COUNT) {
+            msg = create_seq ("foo", sent);
+            if (channel_send (ch, CHANNEL_BROKER, msg) < 0)
+                BAIL_OUT ("channel_send failed");
+            sent++;
+        }
+        while ((msg = channel_recv (ch,
+                                    CHANNEL_BROKER,
+                                    sent < THREAD_COUNT ? FLUX_O_NONBLOCK
+                                                        : 0))) {
+            if (get_seq (msg) != received)
+                errors++;
+            received++;
+            flux_msg_destroy (msg);
+            if (received == THREAD_COUNT)
+                break;
+        }
+    }
+    if ((e = pthread_join (t, NULL)))
+        BAIL_OUT ("pthread_join failed");
+    ok (received == THREAD_COUNT && errors == 0,
+        "echoed %d messages through module thread in order", received);
+    channel_destroy (ch);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_badargs ();
+    test_backlog ();
+    test_thread ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -13,9 +13,15 @@
 #endif
 
 #include <errno.h>
+#include <stddef.h>
 #include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <flux/core.h>
 #include <czmq.h>
+#include <sodium.h>
 
 #include "src/common/libtap/tap.h"
 #include "src/common/libtestutil/util.h"
@@ -210,6 +216,49 @@ flux_msg_t *recvmsg_parent_timeout (struct context *ctx, double timeout)
     return overlay_recvmsg_parent (ctx->ov);
 }
 
+#define BATCH_COUNT 1000
+
+void batch_check (struct context *src, struct context *dst, bool upstream)
+{
+    flux_msg_t *msg;
+    int errors = 0;
+    int count = 0;
+    uint32_t seq;
+    int i;
+
+    for (i = 0; i < BATCH_COUNT; i++) {
+        if (!(msg = flux_request_encode ("batch", NULL))
+            || flux_msg_set_matchtag (msg, i) < 0)
+            BAIL_OUT ("could not create batch test message");
+        if (flux_msg_enable_route (msg) < 0
+            || (!upstream && flux_msg_push_route (msg, "1") < 0))
+            BAIL_OUT ("could not set up route stack");
+        if ((upstream ? overlay_sendmsg_parent (src->ov, msg)
+                      : overlay_sendmsg_child (src->ov, msg)) < 0)
+            errors++;
+        flux_msg_destroy (msg);
+    }
+    ok (errors == 0,
+        "%s: sent %d messages %s",
+        src->name, BATCH_COUNT, upstream ? "upstream" : "downstream");
+    for (i = 0; i < BATCH_COUNT; i++) {
+        msg = upstream ? recvmsg_child_timeout (dst, 5)
+                       : recvmsg_parent_timeout (dst, 5);
+        if (!msg)
+            break;
+        if (flux_msg_get_matchtag (msg, &seq) < 0 || seq != i)
+            errors++;
+        if ((upstream && flux_msg_get_route_count (msg) != 1)
+            || (!upstream && flux_msg_get_route_count (msg) != 0))
+            errors++;
+        count++;
+        flux_msg_destroy (msg);
+    }
+    ok (count == BATCH_COUNT && errors == 0,
+        "%s: received %d messages in order with expected routes",
+        dst->name, count);
+}
+
 void trio (flux_t *h)
 {
     struct context *ctx[2];
@@ -296,6 +345,13 @@ void trio (flux_t *h)
         "%s: received message has expected topic", ctx[1]->name);
     flux_msg_destroy (msg);
 
+    /* Send many messages each way, so they are coalesced into batches,
+     * and check that they are unpacked in order.
+     */
+    batch_check (ctx[1], ctx[0], true);
+    overlay_keepalive_child (ctx[0]->ov, "1", KEEPALIVE_STATUS_NORMAL);
+    batch_check (ctx[0], ctx[1], false);
+
     errno = 0;
     ok (overlay_bind (ctx[1]->ov, "ipc://@foo") < 0 && errno == EINVAL,
         "%s: second overlay_bind in proc fails with EINVAL", ctx[0]->name);
@@ -357,6 +413,210 @@ void trio (flux_t *h)
     ctx_destroy (ctx[0]);
 }
 
+/* Exchange messages between rank 0 and 1 over the stream transport,
+ * and check that an unauthorized peer gets nowhere.
+ */
+void stream_duo (flux_t *h)
+{
+    struct context *ctx[3];
+    int size = 3;
+    int k_ary = 2;
+    char parent_uri[64];
+    const char *server_pubkey;
+    const char *client_pubkey;
+    flux_msg_t *msg;
+    const char *topic;
+    char *id = NULL;
+
+    ctx[0] = ctx_create (h, "stream", size, 0);
+    ok (overlay_set_transport (ctx[0]->ov, "stream") == 0,
+        "%s: overlay_set_transport stream works", ctx[0]->name);
+    ok (overlay_get_transport (ctx[0]->ov) != NULL
+        && !strcmp (overlay_get_transport (ctx[0]->ov), "stream"),
+        "%s: overlay_get_transport returns stream", ctx[0]->name);
+    ok (overlay_init (ctx[0]->ov, size, 0, k_ary) == 0,
+        "%s: overlay_init works", ctx[0]->name);
+    server_pubkey = overlay_cert_pubkey (ctx[0]->ov);
+    snprintf (parent_uri, sizeof (parent_uri), "ipc://@%s", ctx[0]->name);
+    ok (overlay_bind (ctx[0]->ov, parent_uri) == 0,
+        "%s: overlay_bind %s works", ctx[0]->name, parent_uri);
+    errno = 0;
+    ok (overlay_set_transport (ctx[0]->ov, "zmq") < 0 && errno == EINVAL,
+        "%s: overlay_set_transport after bind fails with EINVAL",
+        ctx[0]->name);
+
+    ctx[1] = ctx_create (h, "stream", size, 1);
+    ok (overlay_set_transport (ctx[1]->ov, "stream") == 0,
+        "%s: overlay_set_transport stream works", ctx[1]->name);
+    ok (overlay_init (ctx[1]->ov, size, 1, k_ary) == 0,
+        "%s: overlay_init works", ctx[1]->name);
+    client_pubkey = overlay_cert_pubkey (ctx[1]->ov);
+    if (overlay_set_parent_uri (ctx[1]->ov, parent_uri) < 0
+        || overlay_set_parent_pubkey (ctx[1]->ov, server_pubkey) < 0)
+        BAIL_OUT ("could not set parent uri/pubkey");
+    ok (overlay_authorize (ctx[0]->ov, ctx[1]->name, client_pubkey) == 0,
+        "%s: overlay_authorize %s works", ctx[0]->name, client_pubkey);
+    ok (overlay_connect (ctx[1]->ov) == 0,
+        "%s: overlay_connect works", ctx[1]->name);
+
+    /* Send 1->0
+     */
+    if (!(msg = flux_request_encode ("meep", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    ok (overlay_sendmsg_parent (ctx[1]->ov, msg) == 0,
+        "%s: overlay_sendmsg_parent works", ctx[1]->name);
+    flux_msg_destroy (msg);
+
+    msg = recvmsg_child_timeout (ctx[0], 5);
+    ok (msg != NULL,
+        "%s: overlay_recvmsg_child works", ctx[0]->name);
+    ok (flux_msg_get_topic (msg, &topic) == 0 && !strcmp (topic, "meep"),
+        "%s: received message has expected topic", ctx[0]->name);
+    ok (flux_msg_get_route_first (msg, &id) == 0
+        && id != NULL && !strcmp (id, "1"),
+        "%s: received message has sender's route", ctx[0]->name);
+    free (id);
+    flux_msg_destroy (msg);
+
+    /* Send 0->1
+     */
+    if (!(msg = flux_response_encode ("moop", NULL)))
+        BAIL_OUT ("flux_response_encode failed");
+    if (flux_msg_push_route (msg, "1") < 0)
+        BAIL_OUT ("flux_msg_push_route failed");
+    ok (overlay_sendmsg_child (ctx[0]->ov, msg) == 0,
+        "%s: overlay_sendmsg_child works", ctx[0]->name);
+    flux_msg_destroy (msg);
+
+    msg = recvmsg_parent_timeout (ctx[1], 5);
+    ok (msg != NULL,
+        "%s: overlay_recvmsg_parent works", ctx[1]->name);
+    ok (flux_msg_get_topic (msg, &topic) == 0 && !strcmp (topic, "moop"),
+        "%s: received message has expected topic", ctx[1]->name);
+    flux_msg_destroy (msg);
+
+    /* Send to a peer that is not connected.
+     */
+    if (!(msg = flux_response_encode ("moop", NULL)))
+        BAIL_OUT ("flux_response_encode failed");
+    if (flux_msg_push_route (msg, "2") < 0)
+        BAIL_OUT ("flux_msg_push_route failed");
+    errno = 0;
+    ok (overlay_sendmsg_child (ctx[0]->ov, msg) < 0 && errno == EHOSTUNREACH,
+        "%s: overlay_sendmsg_child to unknown peer fails with EHOSTUNREACH",
+        ctx[0]->name);
+    flux_msg_destroy (msg);
+
+    /* Rank 2 was not authorized, so its messages don't get through.
+     */
+    ctx[2] = ctx_create (h, "stream", size, 2);
+    if (overlay_set_transport (ctx[2]->ov, "stream") < 0
+        || overlay_init (ctx[2]->ov, size, 2, k_ary) < 0
+        || overlay_set_parent_uri (ctx[2]->ov, parent_uri) < 0
+        || overlay_set_parent_pubkey (ctx[2]->ov, server_pubkey) < 0)
+        BAIL_OUT ("could not set up rank 2");
+    ok (overlay_connect (ctx[2]->ov) == 0,
+        "%s: overlay_connect works", ctx[2]->name);
+    if (!(msg = flux_request_encode ("erp", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    ok (overlay_sendmsg_parent (ctx[2]->ov, msg) == 0,
+        "%s: overlay_sendmsg_parent works", ctx[2]->name);
+    flux_msg_destroy (msg);
+    errno = 0;
+    ok (recvmsg_child_timeout (ctx[0], 1.0) == NULL && errno == ETIMEDOUT,
+        "%s: no messages received from unauthorized peer", ctx[0]->name);
+    ok (match_list (logs, "overlay auth unknown No access") > 0,
+        "%s: unauthorized peer was logged", ctx[0]->name);
+
+    ctx_destroy (ctx[2]);
+    ctx_destroy (ctx[1]);
+    ctx_destroy (ctx[0]);
+}
+
+/* A listener that does not hold the server key cannot answer the
+ * peer's challenge, so nothing it sends is delivered.
+ */
+void stream_impostor (flux_t *h)
+{
+    struct context *ctx;
+    struct context *server;
+    struct sockaddr_un addr;
+    char parent_uri[64];
+    uint8_t challenge[crypto_box_NONCEBYTES];
+    uint8_t hello[16 + crypto_box_PUBLICKEYBYTES + crypto_box_NONCEBYTES
+                  + crypto_box_MACBYTES + crypto_box_NONCEBYTES * 2
+                  + crypto_box_PUBLICKEYBYTES];
+    uint8_t welcome[crypto_box_NONCEBYTES + crypto_box_MACBYTES
+                    + crypto_box_NONCEBYTES + crypto_box_PUBLICKEYBYTES];
+    uint8_t frame[4 + 64];
+    uint32_t hdr;
+    int lfd, fd;
+    ssize_t n;
+
+    /* Rank 1 expects the public key of a real rank 0, which never binds.
+     */
+    server = ctx_create (h, "impostor", 2, 0);
+    if (overlay_set_transport (server->ov, "stream") < 0
+        || overlay_init (server->ov, 2, 0, 2) < 0)
+        BAIL_OUT ("could not set up rank 0");
+    ctx = ctx_create (h, "impostor", 2, 1);
+    if (overlay_set_transport (ctx->ov, "stream") < 0
+        || overlay_init (ctx->ov, 2, 1, 2) < 0)
+        BAIL_OUT ("could not set up rank 1");
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sun_family = AF_UNIX;
+    snprintf (addr.sun_path + 1, sizeof (addr.sun_path) - 1, "%s", ctx->name);
+    if ((lfd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0
+        || bind (lfd,
+                 (struct sockaddr *)&addr,
+                 offsetof (struct sockaddr_un, sun_path)
+                 + 1 + strlen (ctx->name)) < 0
+        || listen (lfd, 8) < 0)
+        BAIL_OUT ("could not listen on @%s", ctx->name);
+    snprintf (parent_uri, sizeof (parent_uri), "ipc://@%s", ctx->name);
+    if (overlay_set_parent_uri (ctx->ov, parent_uri) < 0
+        || overlay_set_parent_pubkey (ctx->ov,
+                                      overlay_cert_pubkey (server->ov)) < 0)
+        BAIL_OUT ("could not set parent uri/pubkey");
+    ok (overlay_connect (ctx->ov) == 0,
+        "%s: overlay_connect works", ctx->name);
+    if ((fd = accept (lfd, NULL, NULL)) < 0)
+        BAIL_OUT ("accept failed");
+
+    /* Play the listener's part of the handshake, answering the peer's
+     * hello with random bytes, then send a plaintext frame.
+     */
+    randombytes_buf (challenge, sizeof (challenge));
+    if (write (fd, challenge, sizeof (challenge)) != sizeof (challenge))
+        BAIL_OUT ("could not write challenge");
+    (void)recvmsg_parent_timeout (ctx, 0.1);
+    ok (read (fd, hello, sizeof (hello)) == sizeof (hello),
+        "%s: peer answered challenge", ctx->name);
+    randombytes_buf (welcome, sizeof (welcome));
+    hdr = htonl (sizeof (frame) - 4);
+    memset (frame, 0, sizeof (frame));
+    memcpy (frame, &hdr, 4);
+    if (write (fd, welcome, sizeof (welcome)) != sizeof (welcome)
+        || write (fd, frame, sizeof (frame)) != sizeof (frame))
+        BAIL_OUT ("could not write welcome");
+    errno = 0;
+    ok (recvmsg_parent_timeout (ctx, 0.5) == NULL && errno == ETIMEDOUT,
+        "%s: no messages received from impostor", ctx->name);
+    ok (match_list (logs, "failed challenge") > 0,
+        "%s: impostor was logged", ctx->name);
+    do {
+        n = read (fd, hello, sizeof (hello));
+    } while (n < 0 && errno == EINTR);
+    ok (n == 0,
+        "%s: peer closed the connection", ctx->name);
+
+    (void)close (fd);
+    (void)close (lfd);
+    ctx_destroy (ctx);
+    ctx_destroy (server);
+}
+
 /* Probe some possible failure cases
  */
 void wrongness (flux_t *h)
@@ -370,6 +630,13 @@ void wrongness (flux_t *h)
     if (!(ov = overlay_create (h)))
         BAIL_OUT ("overlay_create failed");
 
+    errno = 0;
+    ok (overlay_set_transport (ov, "carrier-pigeon") < 0 && errno == EINVAL,
+        "overlay_set_transport with unknown name fails with EINVAL");
+    ok (overlay_get_transport (ov) != NULL
+        && !strcmp (overlay_get_transport (ov), "zmq"),
+        "overlay_get_transport returns zmq by default");
+
     errno = 0;
     ok (overlay_bind (ov, "ipc://@foobar") < 0 && errno == EINVAL,
         "overlay_bind fails if called before rank is known");
@@ -422,6 +689,12 @@ int main (int argc, char *argv[])
     trio (h);
     clear_list (logs);
 
+    stream_duo (h);
+    clear_list (logs);
+
+    stream_impostor (h);
+    clear_list (logs);
+
     wrongness (h);
 
     flux_close (h);
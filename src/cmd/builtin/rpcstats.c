@@ -0,0 +1,255 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include "builtin.h"
+#include <inttypes.h>
+#include <fnmatch.h>
+#include <jansson.h>
+
+#include "src/common/libutil/histogram.h"
+
+static struct optparse_option rpcstats_opts[] = {
+    { .name = "rank", .key = 'r', .has_arg = 1, .arginfo = "NODEID",
+      .usage = "Query broker on NODEID (default: local broker)", },
+    { .name = "service", .key = 's', .has_arg = 0,
+      .usage = "Aggregate statistics by service name", },
+    { .name = "clear", .key = 'C', .has_arg = 0,
+      .usage = "Clear statistics after printing them", },
+    { .name = "json", .key = 'j', .has_arg = 0,
+      .usage = "Print the raw JSON response", },
+    OPTPARSE_TABLE_END,
+};
+
+struct entry {
+    char *name;
+    uint64_t requests;
+    uint64_t errors;
+    histogram_t latency;
+    histogram_t request_size;
+    histogram_t response_size;
+};
+
+struct table {
+    struct entry **entries;
+    int count;
+};
+
+static void histogram_decode (json_t *o, histogram_t *hist)
+{
+    json_int_t count, sum, min, max;
+    json_t *buckets;
+    json_t *entry;
+    size_t i;
+
+    memset (hist, 0, sizeof (*hist));
+    if (json_unpack (o,
+                     "{s:I s:I s:I s:I s:o}",
+                     "count", &count,
+                     "sum", &sum,
+                     "min", &min,
+                     "max", &max,
+                     "buckets", &buckets) < 0)
+        log_msg_exit ("error decoding histogram");
+    hist->count = count;
+    hist->sum = sum;
+    hist->min = min;
+    hist->max = max;
+    json_array_foreach (buckets, i, entry) {
+        int index;
+        json_int_t n;
+        if (json_unpack (entry, "[iI]", &index, &n) < 0
+            || index < 0
+            || index >= HISTOGRAM_BUCKETS)
+            log_msg_exit ("error decoding histogram bucket");
+        hist->buckets[index] = n;
+    }
+}
+
+static struct entry *table_lookup (struct table *t, const char *name)
+{
+    struct entry *e;
+    int i;
+
+    for (i = 0; i < t->count; i++) {
+        if (!strcmp (t->entries[i]->name, name))
+            return t->entries[i];
+    }
+    e = xzmalloc (sizeof (*e));
+    e->name = xstrdup (name);
+    t->entries = realloc (t->entries, sizeof (e) * (t->count + 1));
+    if (!t->entries)
+        log_msg_exit ("out of memory");
+    t->entries[t->count++] = e;
+    return e;
+}
+
+static void table_add (struct table *t, json_t *o, bool by_service)
+{
+    const char *topic;
+    json_int_t requests, errors;
+    json_t *latency, *request_size, *response_size;
+    histogram_t hist;
+    struct entry *e;
+    char *name;
+    char *cp;
+
+    if (json_unpack (o,
+                     "{s:s s:I s:I s:o s:o s:o}",
+                     "topic", &topic,
+                     "requests", &requests,
+                     "errors", &errors,
+                     "latency", &latency,
+                     "request_size", &request_size,
+                     "response_size", &response_size) < 0)
+        log_msg_exit ("error decoding broker.rpcstats response");
+    name = xstrdup (topic);
+    if (by_service && (cp = strchr (name, '.')))
+        *cp = '\0';
+    e = table_lookup (t, name);
+    free (name);
+    e->requests += requests;
+    e->errors += errors;
+    histogram_decode (latency, &hist);
+    histogram_merge (&e->latency, &hist);
+    histogram_decode (request_size, &hist);
+    histogram_merge (&e->request_size, &hist);
+    histogram_decode (response_size, &hist);
+    histogram_merge (&e->response_size, &hist);
+}
+
+static void table_destroy (struct table *t)
+{
+    int i;
+
+    for (i = 0; i < t->count; i++) {
+        free (t->entries[i]->name);
+        free (t->entries[i]);
+    }
+    free (t->entries);
+}
+
+static int entry_cmp (const void *a, const void *b)
+{
+    const struct entry *e1 = *(const struct entry **)a;
+    const struct entry *e2 = *(const struct entry **)b;
+    return strcmp (e1->name, e2->name);
+}
+
+/* Format a latency in microseconds with a readable unit.
+ */
+static const char *fmt_usec (char *buf, size_t size, uint64_t usec)
+{
+    if (usec < 1000)
+        snprintf (buf, size, "%" PRIu64 "us", usec);
+    else if (usec < 1000000)
+        snprintf (buf, size, "%.1fms", usec / 1E3);
+    else
+        snprintf (buf, size, "%.1fs", usec / 1E6);
+    return buf;
+}
+
+static void table_print (struct table *t)
+{
+    char p50[16], p90[16], p99[16], max[16];
+    int i;
+
+    qsort (t->entries, t->count, sizeof (t->entries[0]), entry_cmp);
+    printf ("%-32s %8s %6s %8s %8s %8s %8s %8s %8s\n",
+            "TOPIC", "COUNT", "ERRORS", "P50", "P90", "P99", "MAX",
+            "REQSIZE", "RSPSIZE");
+    for (i = 0; i < t->count; i++) {
+        struct entry *e = t->entries[i];
+        printf ("%-32s %8" PRIu64 " %6" PRIu64 " %8s %8s %8s %8s %8.0f %8.0f\n",
+                e->name,
+                e->requests,
+                e->errors,
+                fmt_usec (p50, sizeof (p50),
+                          histogram_percentile (&e->latency, 50)),
+                fmt_usec (p90, sizeof (p90),
+                          histogram_percentile (&e->latency, 90)),
+                fmt_usec (p99, sizeof (p99),
+                          histogram_percentile (&e->latency, 99)),
+                fmt_usec (max, sizeof (max), e->latency.max),
+                histogram_mean (&e->request_size),
+                histogram_mean (&e->response_size));
+    }
+}
+
+static int cmd_rpcstats (optparse_t *p, int ac, char *av[])
+{
+    int n = optparse_option_index (p);
+    const char *glob = NULL;
+    uint32_t nodeid = FLUX_NODEID_ANY;
+    const char *s;
+    flux_t *h;
+    flux_future_t *f;
+    json_t *topics;
+    json_t *o;
+    size_t index;
+    struct table t = { 0 };
+
+    if (n < ac - 1) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (n == ac - 1)
+        glob = av[n];
+    if ((s = optparse_get_str (p, "rank", NULL)))
+        nodeid = strtoul (s, NULL, 10);
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc_pack (h,
+                             "broker.rpcstats",
+                             nodeid,
+                             0,
+                             "{s:b}",
+                             "clear", optparse_hasopt (p, "clear")))
+        || flux_rpc_get_unpack (f, "{s:o}", "topics", &topics) < 0)
+        log_msg_exit ("broker.rpcstats: %s", future_strerror (f, errno));
+    if (optparse_hasopt (p, "json")) {
+        char *str;
+        if (!(str = json_dumps (topics, JSON_COMPACT)))
+            log_msg_exit ("error encoding JSON");
+        printf ("%s\n", str);
+        free (str);
+    }
+    else {
+        json_array_foreach (topics, index, o) {
+            const char *topic;
+            if (json_unpack (o, "{s:s}", "topic", &topic) < 0)
+                log_msg_exit ("error decoding broker.rpcstats response");
+            if (glob && fnmatch (glob, topic, 0) != 0)
+                continue;
+            table_add (&t, o, optparse_hasopt (p, "service"));
+        }
+        table_print (&t);
+        table_destroy (&t);
+    }
+    flux_future_destroy (f);
+    flux_close (h);
+    return (0);
+}
+
+int subcommand_rpcstats_register (optparse_t *p)
+{
+    optparse_err_t e;
+    e = optparse_reg_subcommand (p,
+        "rpcstats",
+        cmd_rpcstats,
+        "[OPTIONS...] [TOPIC-GLOB]",
+        "Print request statistics for services on a broker",
+        0,
+        rpcstats_opts);
+    return (e == OPTPARSE_SUCCESS ? 0 : -1);
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
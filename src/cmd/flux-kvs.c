@@ -717,6 +717,10 @@ void cmd_get_one (flux_t *h, const char *key, struct lookup_ctx *ctx)
     }
     if (optparse_hasopt (ctx->p, "waitcreate"))
         flags |= FLUX_KVS_WAITCREATE;
+    /* kvs-watch does not support raw responses */
+    if (optparse_hasopt (ctx->p, "raw")
+        && !(flags & (FLUX_KVS_TREEOBJ | FLUX_KVS_WATCH | FLUX_KVS_WAITCREATE)))
+        flags |= FLUX_KVS_RAW;
     if (optparse_hasopt (ctx->p, "at")) {
         const char *reference = optparse_get_str (ctx->p, "at", NULL);
         if (!(f = flux_kvs_lookupat (h, flags, key, reference)))
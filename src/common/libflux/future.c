@@ -21,6 +21,7 @@
 
 #include "future.h"
 #include "flog.h"
+#include "reactor_private.h"
 
 struct now_context {
     flux_t *h;              // (optional) cloned flux_t handle
@@ -30,12 +31,28 @@ struct now_context {
     bool running;
 };
 
+/* Futures with a ready result and a registered continuation are placed
+ * on a ready queue shared by all futures on the same reactor, so that one
+ * check/idle watcher pair dispatches all pending continuations instead of
+ * each future carrying its own.  The queue is refcounted by then contexts
+ * and registered with the reactor as a weak reference (no destructor),
+ * since its watchers already hold a reference on the reactor.
+ */
+struct ready_queue {
+    flux_reactor_t *r;
+    zlistx_t *futures;
+    flux_watcher_t *check;
+    flux_watcher_t *idle;
+    int refcount;
+};
+
 struct then_context {
     flux_reactor_t *r;      // external reactor for then
     flux_watcher_t *timer;  // timer watcher (if timeout set)
     double timeout;
-    flux_watcher_t *check;
-    flux_watcher_t *idle;
+    struct ready_queue *rq; // shared per-reactor ready queue
+    void *handle;           // position in rq->futures (if queued)
+    flux_future_t *f;
     bool init_called;
     flux_continuation_f continuation;
     void *continuation_arg;
@@ -67,8 +84,8 @@ struct flux_future {
     int refcount;
 };
 
-static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
-                      int revents, void *arg);
+static void ready_queue_check_cb (flux_reactor_t *r, flux_watcher_t *w,
+                                  int revents, void *arg);
 static void now_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
                           int revents, void *arg);
 static void then_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -111,13 +128,13 @@ static int now_context_set_timeout (struct now_context *now,
             flux_watcher_stop (now->timer);
         else {
             if (!now->timer) {  // set
-                now->timer = flux_timer_watcher_create (now->r, timeout, 0.,
-                                                        now_timer_cb, arg);
+                now->timer = flux_timeout_watcher_create (now->r, timeout,
+                                                          now_timer_cb, arg);
                 if (!now->timer)
                     return -1;
             }
             else {              // reset
-                flux_timer_watcher_reset (now->timer, timeout, 0.);
+                flux_timeout_watcher_reset (now->timer, timeout);
             }
             flux_watcher_start (now->timer);
         }
@@ -136,26 +153,95 @@ static void now_context_clear_timer (struct now_context *now)
  * N.B. then() can only be called once.
  */
 
+static const char *ready_queue_auxkey = "flux::future_ready_queue";
+
+static void ready_queue_decref (struct ready_queue *rq)
+{
+    if (rq && --rq->refcount == 0) {
+        int saved_errno = errno;
+        (void)reactor_aux_set (rq->r, ready_queue_auxkey, NULL, NULL);
+        flux_watcher_destroy (rq->check);
+        flux_watcher_destroy (rq->idle);
+        zlistx_destroy (&rq->futures);
+        free (rq);
+        errno = saved_errno;
+    }
+}
+
+static struct ready_queue *ready_queue_incref (flux_reactor_t *r)
+{
+    struct ready_queue *rq;
+
+    if ((rq = reactor_aux_get (r, ready_queue_auxkey))) {
+        rq->refcount++;
+        return rq;
+    }
+    if (!(rq = calloc (1, sizeof (*rq))))
+        return NULL;
+    rq->r = r;
+    rq->refcount = 1;
+    if (!(rq->futures = zlistx_new ()))
+        goto nomem;
+    if (!(rq->check = flux_check_watcher_create (r,
+                                                 ready_queue_check_cb,
+                                                 rq)))
+        goto error;
+    if (!(rq->idle = flux_idle_watcher_create (r, NULL, NULL)))
+        goto error;
+    if (reactor_aux_set (r, ready_queue_auxkey, rq, NULL) < 0)
+        goto error;
+    return rq;
+nomem:
+    errno = ENOMEM;
+error:
+    ready_queue_decref (rq);
+    return NULL;
+}
+
+static void ready_queue_start (struct ready_queue *rq)
+{
+    flux_watcher_start (rq->idle); // prevent reactor from blocking
+    flux_watcher_start (rq->check);
+}
+
+static void ready_queue_stop (struct ready_queue *rq)
+{
+    flux_watcher_stop (rq->idle);
+    flux_watcher_stop (rq->check);
+}
+
+static void then_context_stop (struct then_context *then)
+{
+    if (then->handle) {
+        (void)zlistx_detach (then->rq->futures, then->handle);
+        then->handle = NULL;
+        if (zlistx_size (then->rq->futures) == 0)
+            ready_queue_stop (then->rq);
+    }
+}
+
 static void then_context_destroy (struct then_context *then)
 {
     if (then) {
         flux_watcher_destroy (then->timer);
-        flux_watcher_destroy (then->check);
-        flux_watcher_destroy (then->idle);
+        if (then->rq) {
+            then_context_stop (then);
+            ready_queue_decref (then->rq);
+        }
         free (then);
     }
 }
 
-static struct then_context *then_context_create (flux_reactor_t *r, void *arg)
+static struct then_context *then_context_create (flux_reactor_t *r,
+                                                 flux_future_t *f)
 {
     struct then_context *then;
 
     if (!(then = calloc (1, sizeof (*then))))
         return NULL;
     then->r = r;
-    if (!(then->check = flux_check_watcher_create (r, check_cb, arg)))
-        goto error;
-    if (!(then->idle = flux_idle_watcher_create (r, NULL, NULL)))
+    then->f = f;
+    if (!(then->rq = ready_queue_incref (r)))
         goto error;
     return then;
 error:
@@ -165,14 +251,13 @@ error:
 
 static void then_context_start (struct then_context *then)
 {
-    flux_watcher_start (then->idle); // prevent reactor from blocking
-    flux_watcher_start (then->check);
-}
-
-static void then_context_stop (struct then_context *then)
-{
-    flux_watcher_stop (then->idle);
-    flux_watcher_stop (then->check);
+    if (!then->handle) {
+        /* zlistx_add_end() can only fail on allocation failure,
+         * which czmq treats as fatal.
+         */
+        then->handle = zlistx_add_end (then->rq->futures, then->f);
+        ready_queue_start (then->rq);
+    }
 }
 
 static int then_context_set_timeout (struct then_context *then,
@@ -184,12 +269,14 @@ static int then_context_set_timeout (struct then_context *then,
             flux_watcher_stop (then->timer);
         else {
             if (!then->timer) {
-                then->timer = flux_timer_watcher_create (then->r, 0., timeout,
-                                                         then_timer_cb, arg);
+                then->timer = flux_timeout_watcher_create (then->r, timeout,
+                                                           then_timer_cb, arg);
                 if (!then->timer)
                     return -1;
             }
-            flux_timer_watcher_again (then->timer);
+            else
+                flux_timeout_watcher_reset (then->timer, timeout);
+            flux_watcher_start (then->timer);
         }
     }
     return 0;
@@ -769,20 +856,33 @@ static void now_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
     flux_reactor_stop_error (r);
 }
 
-/* check - if results are ready, call the continuation
+/* check - call the continuation of each future on the ready queue.
+ * Only futures queued before this pass are dispatched; a future that
+ * becomes ready again from within a continuation (e.g. reset with a
+ * queued result) runs on the next loop iteration, as before.
+ * Hold a reference on the queue, since a continuation may destroy
+ * the last future that refers to it.
  */
-static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
-                      int revents, void *arg)
-{
-    flux_future_t *f = arg;
-
-    assert (f->then != NULL);
-
-    flux_watcher_stop (f->then->timer);
-    then_context_stop (f->then);
-    if (f->then->continuation)
-        f->then->continuation (f, f->then->continuation_arg);
-    // N.B. callback might destroy future
+static void ready_queue_check_cb (flux_reactor_t *r, flux_watcher_t *w,
+                                  int revents, void *arg)
+{
+    struct ready_queue *rq = arg;
+    size_t count = zlistx_size (rq->futures);
+
+    rq->refcount++;
+    while (count-- > 0 && zlistx_size (rq->futures) > 0) {
+        flux_future_t *f = zlistx_detach (rq->futures, NULL);
+
+        assert (f->then != NULL);
+        f->then->handle = NULL;
+        flux_watcher_stop (f->then->timer);
+        if (f->then->continuation)
+            f->then->continuation (f, f->then->continuation_arg);
+        // N.B. callback might destroy future
+    }
+    if (zlistx_size (rq->futures) == 0)
+        ready_queue_stop (rq);
+    ready_queue_decref (rq);
 }
 
 
@@ -25,6 +25,32 @@
 
 #include "plugin.h"
 
+/*  Maximum number of topic strings remembered by the match cache
+ *   before it is emptied and starts over.
+ */
+#define MATCH_CACHE_MAX 1024
+
+/*  Handler lookup index, compiled from the handler list on first lookup
+ *   after handlers are added or removed.  'topics' maps each registered
+ *   topic to its first handler, 'globs' holds glob handlers in
+ *   registration order, and 'cache' maps topic strings passed to
+ *   flux_plugin_call() to the matching handler (or &no_match).
+ */
+struct handler_index {
+    zhashx_t *topics;
+    zlistx_t *globs;
+    zhashx_t *cache;
+};
+
+struct handler_entry {
+    const struct flux_plugin_handler *h;
+    int seq;            /* position in p->handlers */
+    bool is_glob;
+    size_t prefix_len;  /* length of literal prefix of a glob */
+};
+
+static struct flux_plugin_handler no_match;
+
 struct flux_plugin {
     char *path;
     char *name;
@@ -33,6 +59,7 @@ struct flux_plugin {
     struct aux_item *aux;
     void *dso;
     zlistx_t *handlers;
+    struct handler_index *index;
     int flags;
     char last_error [128];
 };
@@ -87,6 +114,140 @@ static const struct flux_plugin_handler * match_handler (flux_plugin_t *p,
     return NULL;
 }
 
+static void handler_index_destroy (struct handler_index *idx)
+{
+    if (idx) {
+        int saved_errno = errno;
+        zhashx_destroy (&idx->topics);
+        zlistx_destroy (&idx->globs);
+        zhashx_destroy (&idx->cache);
+        free (idx);
+        errno = saved_errno;
+    }
+}
+
+static void entry_free (void **item)
+{
+    if (*item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static struct handler_entry *entry_create (const struct flux_plugin_handler *h,
+                                           int seq)
+{
+    struct handler_entry *e;
+
+    if (!(e = calloc (1, sizeof (*e))))
+        return NULL;
+    e->h = h;
+    e->seq = seq;
+    e->prefix_len = strcspn (h->topic, "*?[\\");
+    e->is_glob = (h->topic[e->prefix_len] != '\0');
+    return e;
+}
+
+/*  Compile the handler list into a handler_index.
+ */
+static struct handler_index *handler_index_create (zlistx_t *handlers)
+{
+    struct handler_index *idx;
+    struct flux_plugin_handler *h;
+    int seq = 0;
+
+    if (!(idx = calloc (1, sizeof (*idx)))
+        || !(idx->topics = zhashx_new ())
+        || !(idx->globs = zlistx_new ())
+        || !(idx->cache = zhashx_new ()))
+        goto nomem;
+    zhashx_set_destructor (idx->topics, entry_free);
+    h = zlistx_first (handlers);
+    while (h) {
+        struct handler_entry *e;
+
+        if (!(e = entry_create (h, seq++)))
+            goto nomem;
+        /*  Only the first handler registered for a topic is ever matched.
+         */
+        if (zhashx_insert (idx->topics, h->topic, e) < 0)
+            free (e);
+        else if (e->is_glob && !zlistx_add_end (idx->globs, e))
+            goto nomem;
+        h = zlistx_next (handlers);
+    }
+    return idx;
+nomem:
+    handler_index_destroy (idx);
+    errno = ENOMEM;
+    return NULL;
+}
+
+static struct handler_index *plugin_index (flux_plugin_t *p)
+{
+    if (!p->index)
+        p->index = handler_index_create (p->handlers);
+    return p->index;
+}
+
+static void plugin_index_invalidate (flux_plugin_t *p)
+{
+    handler_index_destroy (p->index);
+    p->index = NULL;
+}
+
+static const struct flux_plugin_handler *index_find (flux_plugin_t *p,
+                                                     const char *string)
+{
+    struct handler_index *idx;
+    struct handler_entry *e;
+
+    if (!(idx = plugin_index (p)))
+        return find_handler (p, string);
+    if ((e = zhashx_lookup (idx->topics, string)))
+        return e->h;
+    return NULL;
+}
+
+/*  Return the first registered handler matching 'string', preserving
+ *   the semantics of match_handler(): an exact (non-glob) topic match
+ *   only wins over globs registered after it.  Results, including
+ *   misses, are cached per topic string.
+ */
+static const struct flux_plugin_handler *index_match (flux_plugin_t *p,
+                                                      const char *string)
+{
+    struct handler_index *idx;
+    const struct flux_plugin_handler *h;
+    struct handler_entry *exact;
+    struct handler_entry *e;
+
+    if (!(idx = plugin_index (p)))
+        return match_handler (p, string);
+    if ((h = zhashx_lookup (idx->cache, string)))
+        return h == &no_match ? NULL : h;
+
+    if ((exact = zhashx_lookup (idx->topics, string)) && exact->is_glob)
+        exact = NULL;
+    h = exact ? exact->h : NULL;
+    e = zlistx_first (idx->globs);
+    while (e && (!exact || e->seq < exact->seq)) {
+        if (strncmp (e->h->topic, string, e->prefix_len) == 0
+            && fnmatch (e->h->topic, string, 0) == 0) {
+            h = e->h;
+            break;
+        }
+        e = zlistx_next (idx->globs);
+    }
+
+    if (zhashx_size (idx->cache) >= MATCH_CACHE_MAX)
+        zhashx_purge (idx->cache);
+    (void)zhashx_insert (idx->cache,
+                         string,
+                         h ? (void *)h : (void *)&no_match);
+    return h;
+}
+
 static struct flux_plugin_handler *
 flux_plugin_handler_create (const char *topic, flux_plugin_f cb, void *arg)
 {
@@ -106,6 +267,7 @@ void flux_plugin_destroy (flux_plugin_t *p)
     if (p) {
         int saved_errno = errno;
         json_decref (p->conf);
+        handler_index_destroy (p->index);
         zlistx_destroy (&p->handlers);
         free (p->conf_str);
         free (p->path);
@@ -326,6 +488,7 @@ int flux_plugin_remove_handler (flux_plugin_t *p,
     if (!p || !topic)
         return plugin_seterror (p, EINVAL, NULL);
     if (find_handler (p, topic)) {
+        plugin_index_invalidate (p);
         if (zlistx_delete (p->handlers, zlistx_cursor (p->handlers)) < 0)
             return plugin_seterror (p, errno, NULL);
     }
@@ -349,12 +512,12 @@ static flux_plugin_f get_handler (flux_plugin_t *p,
 
 flux_plugin_f flux_plugin_get_handler (flux_plugin_t *p, const char *topic)
 {
-    return get_handler (p, topic, find_handler);
+    return get_handler (p, topic, index_find);
 }
 
 flux_plugin_f flux_plugin_match_handler (flux_plugin_t *p, const char *topic)
 {
-    return get_handler (p, topic, match_handler);
+    return get_handler (p, topic, index_match);
 }
 
 
@@ -378,6 +541,7 @@ int flux_plugin_add_handler (flux_plugin_t *p,
         flux_plugin_handler_destroy (h);
         return plugin_seterror (p, errno, NULL);
     }
+    plugin_index_invalidate (p);
 
     return 0;
 }
@@ -543,7 +707,7 @@ int flux_plugin_call (flux_plugin_t *p, const char *string,
     plugin_error_clear (p);
     if (!p || !string)
         return plugin_seterror (p, EINVAL, NULL);
-    if (!(h = match_handler (p, string)))
+    if (!(h = index_match (p, string)))
         return 0;
     assert (h->cb);
     if ((*h->cb) (p, string, args, h->data) < 0)
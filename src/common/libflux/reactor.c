@@ -15,10 +15,12 @@
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <czmq.h>
 
 #include "handle.h"
 #include "reactor.h"
+#include "reactor_private.h"
 #include "ev_flux.h"
 #include "ev_buffer_read.h"
 #include "ev_buffer_write.h"
@@ -29,11 +31,15 @@
 #include "src/common/libutil/ev_zmq.h"
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/fdutils.h"
+#include "src/common/libutil/aux.h"
+#include "src/common/libutil/monotime.h"
 
 struct flux_reactor {
     struct ev_loop *loop;
     int usecount;
     unsigned int errflag:1;
+    struct aux_item *aux;
+    struct timer_wheel *wheel;
 };
 
 struct flux_watcher {
@@ -44,10 +50,14 @@ struct flux_watcher {
     void *data;
 };
 
+static void timer_wheel_destroy (struct timer_wheel *tw);
+
 static void reactor_usecount_decr (flux_reactor_t *r)
 {
     if (r && --r->usecount == 0) {
         int saved_errno = errno;
+        aux_destroy (&r->aux);
+        timer_wheel_destroy (r->wheel);
         if (r->loop) {
             if (ev_is_default_loop (r->loop))
                 ev_default_destroy ();
@@ -88,6 +98,27 @@ flux_reactor_t *flux_reactor_create (int flags)
     return r;
 }
 
+int reactor_aux_set (flux_reactor_t *r,
+                     const char *name,
+                     void *aux,
+                     flux_free_f destroy)
+{
+    if (!r) {
+        errno = EINVAL;
+        return -1;
+    }
+    return aux_set (&r->aux, name, aux, destroy);
+}
+
+void *reactor_aux_get (flux_reactor_t *r, const char *name)
+{
+    if (!r) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return aux_get (r->aux, name);
+}
+
 int flux_set_reactor (flux_t *h, flux_reactor_t *r)
 {
     if (flux_aux_get (h, "flux::reactor")) {
@@ -695,6 +726,312 @@ void flux_timer_watcher_again (flux_watcher_t *w)
     ev_timer_again (loop, tw);
 }
 
+/* Timeout
+ *
+ * One-shot timers kept on a per-reactor hierarchical timing wheel, so that
+ * starting and stopping one is O(1) instead of a libev heap operation.
+ * The wheel has TW_LEVELS levels of TW_SLOTS slots, each level covering
+ * TW_SLOTS times the span of the one below it, at a resolution of
+ * TW_TICK_MS.  Timeouts on level n > 0 are cascaded down to a lower level
+ * when the wheel reaches their slot.  A single ev_timer is armed for the
+ * next tick on which a slot must be run or cascaded.
+ */
+#define TW_BITS         6
+#define TW_SLOTS        (1 << TW_BITS)
+#define TW_MASK         (TW_SLOTS - 1)
+#define TW_LEVELS       4
+#define TW_TICK_MS      1.0
+#define TW_MAX_TICKS    ((UINT64_C(1) << (TW_BITS * TW_LEVELS)) - 1)
+
+struct tw_node {
+    struct tw_node *prev;
+    struct tw_node *next;
+};
+
+struct f_timeout {
+    struct tw_node node;    // must be first
+    flux_watcher_t *w;
+    struct timer_wheel *tw;
+    double after;
+    uint64_t expires;       // absolute tick
+    bool active;
+};
+
+struct timer_wheel {
+    flux_reactor_t *r;
+    ev_timer timer;
+    struct timespec t0;     // time of tick 0
+    uint64_t cur;           // last tick run
+    uint64_t armed;         // tick ev_timer is armed for (if active)
+    int count;              // number of active timeouts
+    struct tw_node slots[TW_LEVELS][TW_SLOTS];
+};
+
+static void tw_list_init (struct tw_node *head)
+{
+    head->prev = head->next = head;
+}
+
+static bool tw_list_empty (struct tw_node *head)
+{
+    return head->next == head;
+}
+
+static void tw_list_add (struct tw_node *head, struct tw_node *n)
+{
+    n->prev = head->prev;
+    n->next = head;
+    head->prev->next = n;
+    head->prev = n;
+}
+
+static void tw_list_del (struct tw_node *n)
+{
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->prev = n->next = NULL;
+}
+
+/* Move all entries of 'from' to the empty list 'to'.
+ */
+static void tw_list_move (struct tw_node *from, struct tw_node *to)
+{
+    if (tw_list_empty (from))
+        tw_list_init (to);
+    else {
+        to->next = from->next;
+        to->prev = from->prev;
+        to->next->prev = to;
+        to->prev->next = to;
+        tw_list_init (from);
+    }
+}
+
+static uint64_t tw_now (struct timer_wheel *tw)
+{
+    return (uint64_t)(monotime_since (tw->t0) / TW_TICK_MS);
+}
+
+static void tw_insert (struct timer_wheel *tw, struct f_timeout *t)
+{
+    uint64_t expires = t->expires;
+    uint64_t delta;
+    int level;
+
+    if (expires < tw->cur)
+        expires = tw->cur;
+    delta = expires - tw->cur;
+    if (delta > TW_MAX_TICKS) { // re-inserted when this expires
+        delta = TW_MAX_TICKS;
+        expires = tw->cur + delta;
+    }
+    for (level = 0; level < TW_LEVELS - 1; level++) {
+        if (delta < (UINT64_C(1) << (TW_BITS * (level + 1))))
+            break;
+    }
+    tw_list_add (&tw->slots[level][(expires >> (TW_BITS * level)) & TW_MASK],
+                 &t->node);
+}
+
+/* Find the next tick after tw->cur on which a non-empty slot is
+ * run (level 0) or cascaded (level > 0).
+ */
+static uint64_t tw_next (struct timer_wheel *tw)
+{
+    uint64_t next = UINT64_MAX;
+    int level;
+
+    for (level = 0; level < TW_LEVELS; level++) {
+        int shift = TW_BITS * level;
+        uint64_t base = tw->cur >> shift;
+        uint64_t i;
+
+        for (i = base + 1; i <= base + TW_SLOTS; i++) {
+            if ((i << shift) >= next)
+                break;
+            if (!tw_list_empty (&tw->slots[level][i & TW_MASK])) {
+                next = i << shift;
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+static void tw_cascade (struct timer_wheel *tw, int level, int slot)
+{
+    struct tw_node list;
+
+    tw_list_move (&tw->slots[level][slot], &list);
+    while (!tw_list_empty (&list)) {
+        struct f_timeout *t = (struct f_timeout *)list.next;
+        tw_list_del (&t->node);
+        tw_insert (tw, t);
+    }
+}
+
+/* Run tick tw->cur: cascade higher levels whose slot has come around,
+ * then call the watchers of timeouts in the current level 0 slot.
+ * A callback may stop or start any timeout, including those not yet run
+ * from the local list.
+ */
+static void tw_run (struct timer_wheel *tw)
+{
+    struct tw_node list;
+    int level;
+    int slot = tw->cur & TW_MASK;
+
+    for (level = 1; slot == 0 && level < TW_LEVELS; level++) {
+        slot = (tw->cur >> (TW_BITS * level)) & TW_MASK;
+        tw_cascade (tw, level, slot);
+    }
+    tw_list_move (&tw->slots[0][tw->cur & TW_MASK], &list);
+    while (!tw_list_empty (&list)) {
+        struct f_timeout *t = (struct f_timeout *)list.next;
+        tw_list_del (&t->node);
+        if (t->expires > tw->cur)
+            tw_insert (tw, t);
+        else {
+            t->active = false;
+            tw->count--;
+            if (t->w->fn)
+                t->w->fn (tw->r, t->w, 0, t->w->arg);
+        }
+    }
+}
+
+static void tw_arm (struct timer_wheel *tw, uint64_t tick)
+{
+    uint64_t now = tw_now (tw);
+    double delay = tick > now ? (tick - now) * TW_TICK_MS * 1E-3 : 0.;
+
+    ev_timer_stop (tw->r->loop, &tw->timer);
+    ev_timer_set (&tw->timer, delay, 0.);
+    ev_timer_start (tw->r->loop, &tw->timer);
+    tw->armed = tick;
+}
+
+static void tw_timer_cb (struct ev_loop *loop, ev_timer *evt, int revents)
+{
+    struct timer_wheel *tw = evt->data;
+    flux_reactor_t *r = tw->r;
+    uint64_t now = tw_now (tw);
+    uint64_t next;
+
+    reactor_usecount_incr (r); // callbacks may drop last watcher
+    while (tw->count > 0 && (next = tw_next (tw)) <= now) {
+        tw->cur = next;
+        tw_run (tw);
+    }
+    if (tw->cur < now)
+        tw->cur = now;
+    if (tw->count > 0)
+        tw_arm (tw, tw_next (tw));
+    else
+        ev_timer_stop (loop, &tw->timer);
+    reactor_usecount_decr (r);
+}
+
+static void timer_wheel_destroy (struct timer_wheel *tw)
+{
+    if (tw) {
+        ev_timer_stop (tw->r->loop, &tw->timer);
+        free (tw);
+    }
+}
+
+static struct timer_wheel *timer_wheel_create (flux_reactor_t *r)
+{
+    struct timer_wheel *tw;
+    int level, slot;
+
+    if (!(tw = calloc (1, sizeof (*tw))))
+        return NULL;
+    tw->r = r;
+    for (level = 0; level < TW_LEVELS; level++)
+        for (slot = 0; slot < TW_SLOTS; slot++)
+            tw_list_init (&tw->slots[level][slot]);
+    monotime (&tw->t0);
+    ev_timer_init (&tw->timer, tw_timer_cb, 0., 0.);
+    tw->timer.data = tw;
+    return tw;
+}
+
+static void timeout_start (flux_watcher_t *w)
+{
+    struct f_timeout *t = w->data;
+    struct timer_wheel *tw = t->tw;
+    uint64_t now;
+
+    if (t->active)
+        return;
+    now = tw_now (tw);
+    if (tw->count == 0 && tw->cur < now)
+        tw->cur = now;
+    /* Round up, plus one tick since 'now' may be up to a tick old.
+     */
+    t->expires = now + (uint64_t)(t->after * 1E3 / TW_TICK_MS + 0.999999) + 1;
+    tw_insert (tw, t);
+    t->active = true;
+    if (tw->count++ == 0
+        || !ev_is_active (&tw->timer)
+        || t->expires < tw->armed)
+        tw_arm (tw, t->expires);
+}
+
+static void timeout_stop (flux_watcher_t *w)
+{
+    struct f_timeout *t = w->data;
+    struct timer_wheel *tw = t->tw;
+
+    if (!t->active)
+        return;
+    tw_list_del (&t->node);
+    t->active = false;
+    if (--tw->count == 0)
+        ev_timer_stop (tw->r->loop, &tw->timer);
+}
+
+static struct flux_watcher_ops timeout_watcher = {
+    .start = timeout_start,
+    .stop = timeout_stop,
+    .destroy = NULL,
+};
+
+flux_watcher_t *flux_timeout_watcher_create (flux_reactor_t *r,
+                                             double after,
+                                             flux_watcher_f cb,
+                                             void *arg)
+{
+    struct f_timeout *t;
+    flux_watcher_t *w;
+
+    if (!r || after < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!r->wheel && !(r->wheel = timer_wheel_create (r)))
+        return NULL;
+    if (!(w = flux_watcher_create (r, sizeof (*t), &timeout_watcher, cb, arg)))
+        return NULL;
+    t = flux_watcher_get_data (w);
+    t->w = w;
+    t->tw = r->wheel;
+    t->after = after;
+    return w;
+}
+
+void flux_timeout_watcher_reset (flux_watcher_t *w, double after)
+{
+    assert (flux_watcher_get_ops (w) == &timeout_watcher);
+    struct f_timeout *t = w->data;
+    t->after = after < 0 ? 0. : after;
+    if (t->active) {
+        timeout_stop (w);
+        timeout_start (w);
+    }
+}
+
 /* Periodic
  */
 struct f_periodic {
@@ -149,6 +149,21 @@ void flux_timer_watcher_reset (flux_watcher_t *w, double after, double repeat);
 
 void flux_timer_watcher_again (flux_watcher_t *w);
 
+/* timeout
+ * A one-shot timer for large numbers of short-lived timeouts, such as
+ * RPC deadlines.  Timeouts share a timing wheel per reactor, so starting
+ * and stopping one is O(1), at one millisecond resolution.  The callback
+ * runs no earlier than 'after' seconds from flux_watcher_start().
+ * flux_timeout_watcher_reset() sets a new timeout, restarting the watcher
+ * if it is active.
+ */
+
+flux_watcher_t *flux_timeout_watcher_create (flux_reactor_t *r,
+                                             double after,
+                                             flux_watcher_f cb, void *arg);
+
+void flux_timeout_watcher_reset (flux_watcher_t *w, double after);
+
 /* periodic
  */
 
@@ -0,0 +1,32 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_CORE_REACTOR_PRIVATE_H
+#define _FLUX_CORE_REACTOR_PRIVATE_H
+
+#include "types.h"
+#include "reactor.h"
+
+/* Associate named auxiliary data with reactor 'r', for use by other
+ * libflux components that keep per-reactor state.  Items are destroyed
+ * when the reactor is destroyed.  Setting 'aux' to NULL deletes 'name'.
+ */
+int reactor_aux_set (flux_reactor_t *r,
+                     const char *name,
+                     void *aux,
+                     flux_free_f destroy);
+
+void *reactor_aux_get (flux_reactor_t *r, const char *name);
+
+#endif /* !_FLUX_CORE_REACTOR_PRIVATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -34,6 +34,7 @@
 
 struct flux_rpc {
     uint32_t matchtag;
+    uint32_t nodeid;
     int flags;
     flux_future_t *f;
     bool sent;
@@ -248,6 +249,7 @@ static flux_future_t *flux_rpc_message_nocopy (flux_t *h,
         rpc_destroy (rpc);
         goto error;
     }
+    rpc->nodeid = nodeid;
     if (flux_msg_set_matchtag (msg, rpc->matchtag) < 0)
         goto error;
     if (flux_msg_get_flags (msg, &msgflags) < 0)
@@ -412,6 +414,35 @@ uint32_t flux_rpc_get_matchtag (flux_future_t *f)
     return rpc ? rpc->matchtag : FLUX_MATCHTAG_NONE;
 }
 
+/* Send the credit grant to the same nodeid as the original request,
+ * so it follows the same route and reaches the same service instance.
+ */
+int flux_rpc_credit (flux_future_t *f, const char *topic, int credit)
+{
+    struct flux_rpc *rpc;
+    flux_future_t *f2;
+
+    if (!f
+        || !topic
+        || credit <= 0
+        || !(rpc = flux_future_aux_get (f, "flux::rpc"))
+        || !(rpc->flags & FLUX_RPC_STREAMING)
+        || rpc->matchtag == FLUX_MATCHTAG_NONE) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(f2 = flux_rpc_pack (flux_future_get_flux (f),
+                              topic,
+                              rpc->nodeid,
+                              FLUX_RPC_NORESPONSE,
+                              "{s:i s:i}",
+                              "matchtag", (int)rpc->matchtag,
+                              "credit", credit)))
+        return -1;
+    flux_future_destroy (f2);
+    return 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -52,6 +52,17 @@ int flux_rpc_get_raw (flux_future_t *f, const void **data, int *len);
  */
 uint32_t flux_rpc_get_matchtag (flux_future_t *f);
 
+/* Streaming RPC flow control.
+ * A service may allow a client to bound the number of responses in flight
+ * on a streaming RPC by including an integer "credit" in the request
+ * payload.  The service sends at most that many responses, then pauses
+ * until the client grants more credit by calling flux_rpc_credit(),
+ * which sends {"matchtag":i, "credit":i} to 'topic' with no response.
+ * The terminating error response does not consume credit.
+ * Requests without "credit" are not flow controlled.
+ */
+int flux_rpc_credit (flux_future_t *f, const char *topic, int credit);
+
 #ifdef __cplusplus
 }
 #endif
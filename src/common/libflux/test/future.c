@@ -762,6 +762,68 @@ void test_reset (void)
     flux_reactor_destroy (r);
 }
 
+#define MANY_FUTURES 64
+
+struct many_ctx {
+    int count;
+    flux_future_t *victim;
+};
+
+void test_many_continuation (flux_future_t *f, void *arg)
+{
+    struct many_ctx *ctx = arg;
+
+    ctx->count++;
+    /* Destroy another future that is still on the ready queue.
+     */
+    if (ctx->victim && ctx->victim != f) {
+        flux_future_destroy (ctx->victim);
+        ctx->victim = NULL;
+    }
+}
+
+void test_many (void)
+{
+    flux_reactor_t *r;
+    flux_future_t *f[MANY_FUTURES];
+    struct many_ctx ctx = { 0 };
+    int i;
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    for (i = 0; i < MANY_FUTURES; i++) {
+        if (!(f[i] = flux_future_create (NULL, NULL)))
+            BAIL_OUT ("flux_future_create failed");
+        flux_future_set_reactor (f[i], r);
+        if (flux_future_then (f[i], -1., test_many_continuation, &ctx) < 0)
+            BAIL_OUT ("flux_future_then failed");
+    }
+    for (i = 0; i < MANY_FUTURES; i++)
+        flux_future_fulfill (f[i], NULL, NULL);
+    ok (flux_reactor_run (r, 0) == 0,
+        "reactor exits once all continuations have run");
+    ok (ctx.count == MANY_FUTURES,
+        "continuation was called once for each of %d futures", MANY_FUTURES);
+
+    /* Re-arm all futures, and have the first continuation destroy the
+     * last future before its continuation can run.
+     */
+    for (i = 0; i < MANY_FUTURES; i++)
+        flux_future_reset (f[i]);
+    ctx.count = 0;
+    ctx.victim = f[MANY_FUTURES - 1];
+    for (i = 0; i < MANY_FUTURES; i++)
+        flux_future_fulfill (f[i], NULL, NULL);
+    ok (flux_reactor_run (r, 0) == 0,
+        "reactor exits after a queued future was destroyed");
+    ok (ctx.count == MANY_FUTURES - 1,
+        "continuation was not called on destroyed future");
+
+    for (i = 0; i < MANY_FUTURES - 1; i++)
+        flux_future_destroy (f[i]);
+    flux_reactor_destroy (r);
+}
+
 void test_fatal_error (void)
 {
     flux_future_t *f;
@@ -1465,6 +1527,7 @@ int main (int argc, char *argv[])
     test_walk ();
 
     test_reset ();
+    test_many ();
 
     test_fatal_error ();
     test_fatal_error_async ();
@@ -388,6 +388,44 @@ void test_register ()
     flux_plugin_destroy (p);
 }
 
+void test_match_order ()
+{
+    flux_plugin_t *p = flux_plugin_create ();
+    if (!p)
+        BAIL_OUT ("flux_plugin_create()");
+
+    ok (flux_plugin_add_handler (p, "job.state.*", foo, NULL) == 0
+        && flux_plugin_add_handler (p, "job.state.run", bar, NULL) == 0
+        && flux_plugin_add_handler (p, "job.event.submit", bar, NULL) == 0
+        && flux_plugin_add_handler (p, "job.*", foo, NULL) == 0,
+        "added exact and glob handlers");
+    ok (flux_plugin_match_handler (p, "job.state.run") == foo,
+        "glob registered before exact topic is matched first");
+    ok (flux_plugin_match_handler (p, "job.event.submit") == bar,
+        "exact topic registered before glob is matched first");
+    ok (flux_plugin_match_handler (p, "job.event.submit") == bar,
+        "repeated match returns the same handler");
+    ok (flux_plugin_match_handler (p, "job.event.alloc") == foo,
+        "unmatched exact topic falls through to later glob");
+    ok (flux_plugin_match_handler (p, "other") == NULL,
+        "topic with no match returns NULL");
+    ok (flux_plugin_match_handler (p, "other") == NULL,
+        "topic with no match returns NULL again");
+    ok (flux_plugin_get_handler (p, "job.state.run") == bar,
+        "flux_plugin_get_handler returns exact topic handler");
+
+    ok (flux_plugin_add_handler (p, "oth*", bar, NULL) == 0,
+        "added a handler after lookups");
+    ok (flux_plugin_match_handler (p, "other") == bar,
+        "new handler is matched for previously unmatched topic");
+    ok (flux_plugin_remove_handler (p, "job.state.*") == 0,
+        "removed a glob handler");
+    ok (flux_plugin_match_handler (p, "job.state.run") == bar,
+        "exact topic is matched after earlier glob is removed");
+
+    flux_plugin_destroy (p);
+}
+
 void test_load ()
 {
     char *out;
@@ -471,6 +509,7 @@ int main (int argc, char *argv[])
     test_plugin_args ();
     test_basic ();
     test_register ();
+    test_match_order ();
     test_load ();
     test_load_rtld_now ();
     done_testing();
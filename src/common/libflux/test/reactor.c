@@ -1030,6 +1030,76 @@ static void test_timer (flux_reactor_t *reactor)
 }
 
 
+static int timeout_runs = 0;
+static void timeout_count (flux_reactor_t *r, flux_watcher_t *w,
+                           int revents, void *arg)
+{
+    timeout_runs++;
+}
+
+static void test_timeout (flux_reactor_t *reactor)
+{
+    flux_watcher_t *w;
+    flux_watcher_t *many[1000];
+    double elapsed, t0, t[] = { 0.001, 0.010, 0.050, 0.100, 0.200 };
+    int i, rc;
+
+    flux_reactor_now_update (reactor);
+
+    errno = 0;
+    ok (!flux_timeout_watcher_create (reactor, -1, oneshot, NULL)
+        && errno == EINVAL,
+        "timeout: creating negative timeout fails with EINVAL");
+    ok ((w = flux_timeout_watcher_create (reactor, 0, oneshot, NULL)) != NULL,
+        "timeout: creating zero timeout works");
+    flux_watcher_start (w);
+    oneshot_runs = 0;
+    ok (flux_reactor_run (reactor, 0) == 0,
+        "timeout: reactor exited normally");
+    ok (oneshot_runs == 1,
+        "timeout: callback was executed once");
+    oneshot_runs = 0;
+    ok (flux_reactor_run (reactor, 0) == 0 && oneshot_runs == 0,
+        "timeout: expired timeout didn't run again");
+
+    for (i = 0; i < sizeof (t) / sizeof (t[0]); i++) {
+        flux_timeout_watcher_reset (w, t[i]);
+        flux_watcher_start (w);
+        t0 = flux_reactor_now (reactor);
+        oneshot_runs = 0;
+        rc = flux_reactor_run (reactor, 0);
+        elapsed = flux_reactor_now (reactor) - t0;
+        ok (rc == 0 && oneshot_runs == 1 && elapsed >= t[i],
+            "timeout: reactor ran %.3fs timeout at >= time (%.3fs)",
+            t[i], elapsed);
+    }
+    flux_watcher_destroy (w);
+
+    /* Many timeouts spread over several wheel levels, half stopped.
+     */
+    for (i = 0; i < 1000; i++) {
+        if (!(many[i] = flux_timeout_watcher_create (reactor,
+                                                     0.0005 * i,
+                                                     timeout_count,
+                                                     NULL)))
+            BAIL_OUT ("flux_timeout_watcher_create failed");
+        flux_watcher_start (many[i]);
+    }
+    for (i = 0; i < 1000; i += 2)
+        flux_watcher_stop (many[i]);
+    timeout_runs = 0;
+    t0 = flux_reactor_now (reactor);
+    ok (flux_reactor_run (reactor, 0) == 0,
+        "timeout: reactor exited normally after many timeouts");
+    elapsed = flux_reactor_now (reactor) - t0;
+    ok (timeout_runs == 500,
+        "timeout: only the 500 timeouts left running were called");
+    ok (elapsed >= 0.0005 * 999,
+        "timeout: elapsed time is >= longest timeout (%.3fs)", elapsed);
+    for (i = 0; i < 1000; i++)
+        flux_watcher_destroy (many[i]);
+}
+
 /* A reactor callback that immediately stops reactor without error */
 static bool do_stop_callback_ran = false;
 static void do_stop_reactor (flux_reactor_t *r, flux_watcher_t *w,
@@ -1457,6 +1527,7 @@ int main (int argc, char *argv[])
         "reactor ran to completion (no watchers)");
 
     test_timer (reactor);
+    test_timeout (reactor);
     test_periodic (reactor);
     test_fd (reactor);
     test_buffer (reactor);
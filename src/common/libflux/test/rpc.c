@@ -181,6 +181,71 @@ error:
         BAIL_OUT ("flux_respond_error: %s", flux_strerror (errno));
 }
 
+/* Stream 'count' responses, sending at most 'credit' before waiting for
+ * more credit from rpctest.credit-grant.  One stream at a time.
+ */
+static struct {
+    const flux_msg_t *msg;
+    int count;
+    int seq;
+    int credit;
+} stream;
+
+static void stream_flush (flux_t *h)
+{
+    while (stream.seq < stream.count && stream.credit > 0) {
+        if (flux_respond_pack (h, stream.msg, "{s:i}", "seq", stream.seq++) < 0)
+            BAIL_OUT ("flux_respond_pack: %s", flux_strerror (errno));
+        stream.credit--;
+    }
+    if (stream.seq == stream.count) {
+        if (flux_respond_error (h, stream.msg, ENODATA, NULL) < 0)
+            BAIL_OUT ("flux_respond_error: %s", flux_strerror (errno));
+        flux_msg_decref (stream.msg);
+        stream.msg = NULL;
+    }
+}
+
+void rpctest_credit_cb (flux_t *h, flux_msg_handler_t *mh,
+                        const flux_msg_t *msg, void *arg)
+{
+    int count, credit;
+
+    if (flux_request_unpack (msg, NULL, "{s:i s:i}", "count", &count,
+                                                     "credit", &credit) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg) || credit <= 0 || stream.msg) {
+        errno = EPROTO;
+        goto error;
+    }
+    stream.msg = flux_msg_incref (msg);
+    stream.count = count;
+    stream.seq = 0;
+    stream.credit = credit;
+    stream_flush (h);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        BAIL_OUT ("flux_respond_error: %s", flux_strerror (errno));
+}
+
+void rpctest_credit_grant_cb (flux_t *h, flux_msg_handler_t *mh,
+                              const flux_msg_t *msg, void *arg)
+{
+    uint32_t matchtag, t;
+    int credit;
+
+    if (flux_request_unpack (msg, NULL, "{s:i s:i}", "matchtag", &matchtag,
+                                                     "credit", &credit) < 0)
+        BAIL_OUT ("rpctest.credit-grant: %s", flux_strerror (errno));
+    if (!stream.msg
+        || flux_msg_get_matchtag (stream.msg, &t) < 0
+        || t != matchtag)
+        return;
+    stream.credit += credit;
+    stream_flush (h);
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,   "rpctest.incr",    rpctest_incr_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,   "rpctest.hello",   rpctest_hello_cb, 0 },
@@ -190,6 +255,9 @@ static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,   "rpctest.rawecho", rpctest_rawecho_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,   "rpctest.nodeid",  rpctest_nodeid_cb, 0 },
     { FLUX_MSGTYPE_REQUEST,   "rpctest.multi",   rpctest_multi_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,   "rpctest.credit",  rpctest_credit_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,   "rpctest.credit-grant",
+                                                 rpctest_credit_grant_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
@@ -728,6 +796,62 @@ void test_multi_response_then_chain (flux_t *h)
         BAIL_OUT ("flux_reactor_run failed");
 }
 
+/* Count responses that arrive within a short timeout.
+ */
+static int credit_drain (flux_future_t *f, int *seq)
+{
+    int count = 0;
+
+    while (flux_future_wait_for (f, 0.1) == 0) {
+        if (flux_rpc_get_unpack (f, "{s:i}", "seq", seq) < 0)
+            break;
+        count++;
+        flux_future_reset (f);
+    }
+    return count;
+}
+
+void test_credit (flux_t *h)
+{
+    flux_future_t *f;
+    int seq = -1;
+
+    f = flux_rpc_pack (h, "rpctest.credit", FLUX_NODEID_ANY, FLUX_RPC_STREAMING,
+                       "{s:i s:i}", "count", 5, "credit", 2);
+    if (!f)
+        BAIL_OUT ("flux_rpc_pack failed");
+    ok (credit_drain (f, &seq) == 2 && seq == 1,
+        "credit: service paused after initial 2 credits");
+    ok (flux_rpc_credit (f, "rpctest.credit-grant", 2) == 0,
+        "credit: flux_rpc_credit granted 2 more");
+    ok (credit_drain (f, &seq) == 2 && seq == 3,
+        "credit: service sent 2 more responses then paused");
+    ok (flux_rpc_credit (f, "rpctest.credit-grant", 10) == 0,
+        "credit: flux_rpc_credit granted 10 more");
+    errno = 0;
+    ok (credit_drain (f, &seq) == 1 && seq == 4
+        && flux_rpc_get (f, NULL) < 0 && errno == ENODATA,
+        "credit: got final response and ENODATA");
+    flux_future_destroy (f);
+
+    errno = 0;
+    ok (flux_rpc_credit (NULL, "rpctest.credit-grant", 1) < 0
+        && errno == EINVAL,
+        "flux_rpc_credit f=NULL fails with EINVAL");
+    if (!(f = flux_rpc (h, "rpctest.hello", NULL, FLUX_NODEID_ANY, 0)))
+        BAIL_OUT ("flux_rpc failed");
+    errno = 0;
+    ok (flux_rpc_credit (f, "rpctest.credit-grant", 1) < 0
+        && errno == EINVAL,
+        "flux_rpc_credit on non-streaming RPC fails with EINVAL");
+    errno = 0;
+    ok (flux_rpc_credit (f, NULL, 1) < 0 && errno == EINVAL,
+        "flux_rpc_credit topic=NULL fails with EINVAL");
+    ok (flux_rpc_get (f, NULL) == 0,
+        "non-streaming RPC completed");
+    flux_future_destroy (f);
+}
+
 /* Try flux_rpc_message() with various bad arguments
  */
 void test_rpc_message_inval (flux_t *h)
@@ -860,6 +984,7 @@ int main (int argc, char *argv[])
     test_multi_response_server_noterm (h);
     test_multi_response_then (h);
     test_multi_response_then_chain (h);
+    test_credit (h);
     test_rpc_message_inval (h);
     test_rpc_message (h);
 
@@ -16,6 +16,9 @@
 #include <string.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <arpa/inet.h>
 
 #include <jansson.h>
 
@@ -123,6 +126,126 @@ cleanup:
     return rv;
 }
 
+/* Binary frame layout (all integers in network byte order):
+ *
+ *   uint8_t  version (IOENCODE_RAW_VERSION)
+ *   uint8_t  flags (IOENCODE_RAW_EOF)
+ *   uint16_t stream length, including NUL terminator
+ *   uint16_t rank length, including NUL terminator
+ *   char[]   stream
+ *   char[]   rank
+ *   char[]   data (remainder of frame)
+ */
+#define IOENCODE_RAW_VERSION    1
+#define IOENCODE_RAW_EOF        0x01
+#define IOENCODE_RAW_HDRLEN     6
+
+void *ioencode_raw (const char *stream,
+                    const char *rank,
+                    const char *data,
+                    int len,
+                    bool eof,
+                    int *sizep)
+{
+    size_t stream_len, rank_len;
+    uint16_t n;
+    char *buf, *cp;
+    int size;
+
+    if (!stream
+        || !rank
+        || !sizep
+        || (data && len <= 0)
+        || (!data && len != 0)
+        || (!data && !len && !eof)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    stream_len = strlen (stream) + 1;
+    rank_len = strlen (rank) + 1;
+    if (stream_len > UINT16_MAX || rank_len > UINT16_MAX) {
+        errno = EINVAL;
+        return NULL;
+    }
+    size = IOENCODE_RAW_HDRLEN + stream_len + rank_len + len;
+    if (!(buf = malloc (size)))
+        return NULL;
+    cp = buf;
+    *cp++ = IOENCODE_RAW_VERSION;
+    *cp++ = eof ? IOENCODE_RAW_EOF : 0;
+    n = htons (stream_len);
+    memcpy (cp, &n, sizeof (n));
+    cp += sizeof (n);
+    n = htons (rank_len);
+    memcpy (cp, &n, sizeof (n));
+    cp += sizeof (n);
+    memcpy (cp, stream, stream_len);
+    cp += stream_len;
+    memcpy (cp, rank, rank_len);
+    cp += rank_len;
+    if (len > 0)
+        memcpy (cp, data, len);
+    *sizep = size;
+    return buf;
+}
+
+int iodecode_raw (const void *buf,
+                  int size,
+                  const char **streamp,
+                  const char **rankp,
+                  const char **datap,
+                  int *lenp,
+                  bool *eofp)
+{
+    const char *cp = buf;
+    uint16_t stream_len, rank_len;
+    const char *stream, *rank;
+    int len;
+    bool eof;
+
+    if (!buf || size < IOENCODE_RAW_HDRLEN) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (cp[0] != IOENCODE_RAW_VERSION) {
+        errno = EPROTO;
+        return -1;
+    }
+    eof = (cp[1] & IOENCODE_RAW_EOF) ? true : false;
+    memcpy (&stream_len, cp + 2, sizeof (stream_len));
+    memcpy (&rank_len, cp + 4, sizeof (rank_len));
+    stream_len = ntohs (stream_len);
+    rank_len = ntohs (rank_len);
+    if (stream_len == 0
+        || rank_len == 0
+        || IOENCODE_RAW_HDRLEN + stream_len + rank_len > size) {
+        errno = EPROTO;
+        return -1;
+    }
+    stream = cp + IOENCODE_RAW_HDRLEN;
+    rank = stream + stream_len;
+    if (stream[stream_len - 1] != '\0' || rank[rank_len - 1] != '\0') {
+        errno = EPROTO;
+        return -1;
+    }
+    len = size - (IOENCODE_RAW_HDRLEN + stream_len + rank_len);
+    if (len == 0 && !eof) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (streamp)
+        (*streamp) = stream;
+    if (rankp)
+        (*rankp) = rank;
+    if (datap)
+        (*datap) = len > 0 ? rank + rank_len : NULL;
+    if (lenp)
+        (*lenp) = len;
+    if (eofp)
+        (*eofp) = eof;
+    return 0;
+}
+
 /*
  * vi: ts=4 sw=4 expandtab
  */
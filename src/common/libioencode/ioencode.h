@@ -37,4 +37,29 @@ int iodecode (json_t *o,
               int *len,
               bool *eof);
 
+/* encode io data and/or EOF into a compact binary frame, suitable for
+ * use as a raw message payload.  Same argument rules as ioencode().
+ * Data is copied verbatim, avoiding the JSON string escaping required
+ * by ioencode().  Frame size is returned in 'sizep'.
+ * - returned buffer must be freed after use
+ */
+void *ioencode_raw (const char *stream,
+                    const char *rank,
+                    const char *data,
+                    int len,
+                    bool eof,
+                    int *sizep);
+
+/* decode binary frame created by ioencode_raw()
+ * - stream, rank, and data point into 'buf' (no copy is made)
+ * - if no data available, data set to NULL and len to 0
+ */
+int iodecode_raw (const void *buf,
+                  int size,
+                  const char **stream,
+                  const char **rank,
+                  const char **data,
+                  int *len,
+                  bool *eof);
+
 #endif /* !_IOENCODE_H */
@@ -9,6 +9,7 @@
 \************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <jansson.h>
 #include <errno.h>
@@ -27,6 +28,35 @@ void basic_corner_case (void)
     ok (iodecode (NULL, NULL, NULL, NULL, NULL, NULL) < 0
         && errno == EINVAL,
         "iodecode returns EINVAL on bad input");
+
+    int size;
+    errno = 0;
+    ok (ioencode_raw (NULL, NULL, NULL, -1, false, &size) == NULL
+        && errno == EINVAL,
+        "ioencode_raw returns EINVAL on bad input");
+
+    errno = 0;
+    ok (iodecode_raw (NULL, 0, NULL, NULL, NULL, NULL, NULL) < 0
+        && errno == EINVAL,
+        "iodecode_raw returns EINVAL on bad input");
+
+    errno = 0;
+    ok (iodecode_raw ("\x02\x00\x00\x01\x00\x01\0\0", 8,
+                      NULL, NULL, NULL, NULL, NULL) < 0
+        && errno == EPROTO,
+        "iodecode_raw returns EPROTO on bad version");
+
+    errno = 0;
+    ok (iodecode_raw ("\x01\x00\x00\x08\x00\x02" "a\0b\0", 10,
+                      NULL, NULL, NULL, NULL, NULL) < 0
+        && errno == EPROTO,
+        "iodecode_raw returns EPROTO on truncated frame");
+
+    errno = 0;
+    ok (iodecode_raw ("\x01\x00\x00\x02\x00\x02" "a\0b\0", 10,
+                      NULL, NULL, NULL, NULL, NULL) < 0
+        && errno == EPROTO,
+        "iodecode_raw returns EPROTO on no data and no EOF");
 }
 
 void basic (void)
@@ -77,12 +107,61 @@ void basic (void)
     free (data);
 }
 
+void basic_raw (void)
+{
+    void *buf;
+    int size;
+    const char *stream;
+    const char *rank;
+    const char *data;
+    int len;
+    bool eof;
+
+    ok ((buf = ioencode_raw ("stdout", "1", "foo", 3, false, &size)) != NULL,
+        "ioencode_raw success (data, eof = false)");
+    ok (!iodecode_raw (buf, size, &stream, &rank, &data, &len, &eof),
+        "iodecode_raw success");
+    ok (!strcmp (stream, "stdout")
+        && !strcmp (rank, "1")
+        && len == 3
+        && !strncmp (data, "foo", len)
+        && eof == false,
+        "iodecode_raw returned correct info");
+    free (buf);
+
+    ok ((buf = ioencode_raw ("stdout", "[0-8]", "\0\"\n", 3, true, &size))
+        != NULL,
+        "ioencode_raw success (binary data, eof = true)");
+    ok (!iodecode_raw (buf, size, &stream, &rank, &data, &len, &eof),
+        "iodecode_raw success");
+    ok (!strcmp (stream, "stdout")
+        && !strcmp (rank, "[0-8]")
+        && len == 3
+        && !memcmp (data, "\0\"\n", len)
+        && eof == true,
+        "iodecode_raw returned correct info");
+    free (buf);
+
+    ok ((buf = ioencode_raw ("stderr", "[4,5]", NULL, 0, true, &size)) != NULL,
+        "ioencode_raw success (no data, eof = true)");
+    ok (!iodecode_raw (buf, size, &stream, &rank, &data, &len, &eof),
+        "iodecode_raw success");
+    ok (!strcmp (stream, "stderr")
+        && !strcmp (rank, "[4,5]")
+        && data == NULL
+        && len == 0
+        && eof == true,
+        "iodecode_raw returned correct info");
+    free (buf);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
 
     basic_corner_case ();
     basic ();
+    basic_raw ();
 
     done_testing ();
 
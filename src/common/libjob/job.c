@@ -158,6 +158,134 @@ int flux_job_submit_get_id (flux_future_t *f, flux_jobid_t *jobid)
     return 0;
 }
 
+flux_future_t *flux_job_submit_batch (flux_t *h,
+                                      int count,
+                                      const char **jobspecs,
+                                      int urgency,
+                                      int flags)
+{
+    flux_future_t *f = NULL;
+    json_t *jobs;
+    json_t *o;
+    int saved_errno;
+    int i;
+#if HAVE_FLUX_SECURITY
+    flux_security_t *sec = NULL;
+    const char *mech = NULL;
+    uint32_t owner;
+#endif
+
+    if (!h || count <= 0 || !jobspecs) {
+        errno = EINVAL;
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        if (!jobspecs[i]) {
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+#if HAVE_FLUX_SECURITY
+    /* Look up the signing mechanism and context once for all jobs.
+     * See security note in flux_job_submit().
+     */
+    if (!(flags & FLUX_JOB_PRE_SIGNED)) {
+        if (attr_get_u32 (h, "security.owner", &owner) == 0
+                && getuid () == owner)
+            mech = "none";
+        if (!(sec = get_security_ctx (h, &f)))
+            return f;
+    }
+#endif
+    if (!(jobs = json_array ()))
+        goto nomem;
+    for (i = 0; i < count; i++) {
+        const char *J;
+        char *s = NULL;
+
+        if (!(flags & FLUX_JOB_PRE_SIGNED)) {
+#if HAVE_FLUX_SECURITY
+            if (!(J = flux_sign_wrap (sec,
+                                      jobspecs[i],
+                                      strlen (jobspecs[i]),
+                                      mech,
+                                      0))) {
+                json_decref (jobs);
+                return get_security_error (sec);
+            }
+#else
+            if (!(s = sign_none_wrap (jobspecs[i],
+                                      strlen (jobspecs[i]),
+                                      getuid ())))
+                goto error;
+            J = s;
+#endif
+        }
+        else
+            J = jobspecs[i];
+        o = json_pack ("{s:s}", "J", J);
+        free (s);
+        if (!o || json_array_append_new (jobs, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    flags &= ~FLUX_JOB_PRE_SIGNED; // client only flag
+    if (!(f = flux_rpc_pack (h, "job-ingest.submit-batch", FLUX_NODEID_ANY, 0,
+                             "{s:O s:i s:i}",
+                             "jobs", jobs,
+                             "urgency", urgency,
+                             "flags", flags)))
+        goto error;
+    json_decref (jobs);
+    return f;
+nomem:
+    errno = ENOMEM;
+error:
+    saved_errno = errno;
+    json_decref (jobs);
+    errno = saved_errno;
+    return NULL;
+}
+
+int flux_job_submit_batch_get_id (flux_future_t *f,
+                                  int index,
+                                  flux_jobid_t *jobid,
+                                  const char **errstr)
+{
+    json_t *jobs;
+    json_t *entry;
+    flux_jobid_t id;
+    int errnum;
+    const char *s = NULL;
+
+    if (!f || index < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (flux_rpc_get_unpack (f, "{s:o}", "jobs", &jobs) < 0)
+        return -1;
+    if (!(entry = json_array_get (jobs, index))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_unpack (entry, "{s:I}", "id", &id) == 0) {
+        if (jobid)
+            *jobid = id;
+        return 0;
+    }
+    if (json_unpack (entry, "{s:i s?s}",
+                            "errnum", &errnum,
+                            "errstr", &s) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (errstr)
+        *errstr = s;
+    errno = errnum;
+    return -1;
+}
+
 flux_future_t *flux_job_wait (flux_t *h, flux_jobid_t id)
 {
     if (!h) {
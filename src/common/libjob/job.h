@@ -114,6 +114,27 @@ flux_future_t *flux_job_submit (flux_t *h, const char *jobspec,
  */
 int flux_job_submit_get_id (flux_future_t *f, flux_jobid_t *id);
 
+/* Submit 'count' jobs in one request, with the same 'urgency' and 'flags'.
+ * Each of 'jobspecs' is signed as in flux_job_submit().  Jobs that are
+ * accepted are committed together and assigned ascending jobids in order.
+ * The future is fulfilled with an error only if the whole request failed.
+ */
+flux_future_t *flux_job_submit_batch (flux_t *h,
+                                      int count,
+                                      const char **jobspecs,
+                                      int urgency,
+                                      int flags);
+
+/* Parse the jobid of job 'index' from response to flux_job_submit_batch().
+ * Returns 0 on success, -1 on failure with errno set.  If that job was
+ * rejected, 'errstr' (if non-NULL) is set to the reason, valid until the
+ * future is destroyed.
+ */
+int flux_job_submit_batch_get_id (flux_future_t *f,
+                                  int index,
+                                  flux_jobid_t *id,
+                                  const char **errstr);
+
 /* Wait for jobid to enter INACTIVE state.
  * If jobid=FLUX_JOBID_ANY, wait for the next waitable job.
  * Fails with ECHILD if there is nothing to wait for.
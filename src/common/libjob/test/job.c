@@ -114,6 +114,34 @@ void check_corner_case (void)
     ok (flux_job_submit_get_id (NULL, NULL) < 0 && errno == EINVAL,
         "flux_job_submit_get_id with NULL args fails with EINVAL");
 
+    /* flux_job_submit_batch */
+
+    const char *jobspecs[] = { "{}", NULL };
+
+    errno = 0;
+    ok (flux_job_submit_batch (NULL, 1, jobspecs, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_batch h=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_batch (h, 0, jobspecs, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_batch count=0 fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_batch (h, 1, NULL, 0, 0) == NULL && errno == EINVAL,
+        "flux_job_submit_batch jobspecs=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_batch (h, 2, jobspecs, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_batch with NULL jobspec fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_batch_get_id (NULL, 0, NULL, NULL) < 0
+        && errno == EINVAL,
+        "flux_job_submit_batch_get_id f=NULL fails with EINVAL");
+
     /* flux_job_list */
 
     errno = 0;
@@ -14,6 +14,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include <jansson.h>
 #include <czmq.h>
 #include <flux/core.h>
@@ -88,6 +89,11 @@ static int validate_lookup_flags (int flags, bool watch_ok)
      */
     if ((flags & FLUX_KVS_WAITCREATE) && !watch_ok)
         return -1;
+    /* The kvs-watch module only sends tree objects.
+     */
+    if ((flags & FLUX_KVS_RAW)
+        && (flags & (FLUX_KVS_WATCH | FLUX_KVS_WAITCREATE)))
+        return -1;
 
     flags &= ~FLUX_KVS_WATCH;
     flags &= ~(FLUX_KVS_WATCH_FLAGS);
@@ -96,6 +102,7 @@ static int validate_lookup_flags (int flags, bool watch_ok)
 
     switch (flags) {
         case 0:
+        case FLUX_KVS_RAW:
         case FLUX_KVS_TREEOBJ:
         case FLUX_KVS_READDIR:
         case FLUX_KVS_READDIR | FLUX_KVS_TREEOBJ:
@@ -223,6 +230,11 @@ static int parse_response (flux_future_t *f, struct lookup_ctx *ctx)
 {
     json_t *treeobj2;
 
+    /* FLUX_KVS_RAW responses carry no tree object */
+    if ((ctx->flags & FLUX_KVS_RAW)) {
+        errno = EINVAL;
+        return -1;
+    }
     if (decode_treeobj (f, &treeobj2) < 0)
         return -1;
     if (!ctx->treeobj || !json_equal (ctx->treeobj, treeobj2)) {
@@ -249,12 +261,32 @@ static int parse_response (flux_future_t *f, struct lookup_ctx *ctx)
     return 0;
 }
 
-int flux_kvs_lookup_get (flux_future_t *f, const char **value)
+/* Decode the value into ctx->val_data.  A FLUX_KVS_RAW response payload
+ * is the value itself, otherwise the value is base64 encoded in the 'val'
+ * tree object.  Either way val_data gets an extra 0 byte terminator not
+ * reflected in val_len.
+ */
+static int decode_val (flux_future_t *f, struct lookup_ctx *ctx)
 {
-    struct lookup_ctx *ctx;
+    if ((ctx->flags & FLUX_KVS_RAW)) {
+        const void *data;
+        int len;
 
-    if (!(ctx = get_lookup_ctx (f)))
-        return -1;
+        if (ctx->val_valid)
+            return 0;
+        if (flux_rpc_get_raw (f, &data, &len) < 0)
+            return -1;
+        if (!(ctx->val_data = malloc (len + 1))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        if (len > 0)
+            memcpy (ctx->val_data, data, len);
+        ((char *)ctx->val_data)[len] = '\0';
+        ctx->val_len = len;
+        ctx->val_valid = true;
+        return 0;
+    }
     if (parse_response (f, ctx) < 0)
         return -1;
     if (!ctx->val_valid) {
@@ -262,8 +294,18 @@ int flux_kvs_lookup_get (flux_future_t *f, const char **value)
                                               &ctx->val_len) < 0)
             return -1;
         ctx->val_valid = true;
-        // N.B. val_data includes xtra 0 byte term not reflected in val_len
     }
+    return 0;
+}
+
+int flux_kvs_lookup_get (flux_future_t *f, const char **value)
+{
+    struct lookup_ctx *ctx;
+
+    if (!(ctx = get_lookup_ctx (f)))
+        return -1;
+    if (decode_val (f, ctx) < 0)
+        return -1;
     if (value)
         *value = ctx->val_data;
     return 0;
@@ -294,14 +336,8 @@ int flux_kvs_lookup_get_unpack (flux_future_t *f, const char *fmt, ...)
 
     if (!(ctx = get_lookup_ctx (f)))
         return -1;
-    if (parse_response (f, ctx) < 0)
+    if (decode_val (f, ctx) < 0)
         return -1;
-    if (!ctx->val_valid) {
-        if (treeobj_decode_val (ctx->treeobj, &ctx->val_data,
-                                              &ctx->val_len) < 0)
-            return -1;
-        ctx->val_valid = true;
-    }
     if (!ctx->val_obj) {
         if (!(ctx->val_obj = json_loadb (ctx->val_data, ctx->val_len,
                                          JSON_DECODE_ANY, NULL))) {
@@ -323,14 +359,11 @@ int flux_kvs_lookup_get_raw (flux_future_t *f, const void **data, int *len)
 
     if (!(ctx = get_lookup_ctx (f)))
         return -1;
-    if (parse_response (f, ctx) < 0)
+    /* no copy needed, the value is the response payload */
+    if ((ctx->flags & FLUX_KVS_RAW))
+        return flux_rpc_get_raw (f, data, len);
+    if (decode_val (f, ctx) < 0)
         return -1;
-    if (!ctx->val_valid) {
-        if (treeobj_decode_val (ctx->treeobj, &ctx->val_data,
-                                              &ctx->val_len) < 0)
-            return -1;
-        ctx->val_valid = true;
-    }
     if (data)
         *data = ctx->val_data;
     if (len)
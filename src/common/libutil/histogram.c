@@ -0,0 +1,121 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdint.h>
+
+#include "histogram.h"
+
+/* Values below HISTOGRAM_SUB get one bucket each.  Above that, a value
+ * whose most significant bit is 'msb' lands in bucket group msb - SUB_BITS
+ * + 1, at the offset given by the SUB_BITS bits following the msb.
+ */
+int histogram_bucket_index (uint64_t value)
+{
+    int msb, shift;
+
+    if (value < HISTOGRAM_SUB)
+        return value;
+    msb = 63 - __builtin_clzll (value);
+    if (msb >= HISTOGRAM_MAX_BITS)
+        return HISTOGRAM_BUCKETS - 1;
+    shift = msb - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB
+           + ((value >> shift) & (HISTOGRAM_SUB - 1));
+}
+
+uint64_t histogram_bucket_lower (int index)
+{
+    int shift;
+
+    if (index < HISTOGRAM_SUB)
+        return index;
+    shift = index / HISTOGRAM_SUB - 1;
+    return (uint64_t)(HISTOGRAM_SUB + index % HISTOGRAM_SUB) << shift;
+}
+
+uint64_t histogram_bucket_upper (int index)
+{
+    int shift;
+
+    if (index < HISTOGRAM_SUB)
+        return index;
+    shift = index / HISTOGRAM_SUB - 1;
+    return histogram_bucket_lower (index) + ((uint64_t)1 << shift) - 1;
+}
+
+void histogram_record (histogram_t *hist, uint64_t value)
+{
+    if (hist->count == 0 || value < hist->min)
+        hist->min = value;
+    if (hist->count == 0 || value > hist->max)
+        hist->max = value;
+    hist->count++;
+    hist->sum += value;
+    hist->buckets[histogram_bucket_index (value)]++;
+}
+
+void histogram_merge (histogram_t *dst, const histogram_t *src)
+{
+    int i;
+
+    if (src->count == 0)
+        return;
+    if (dst->count == 0 || src->min < dst->min)
+        dst->min = src->min;
+    if (dst->count == 0 || src->max > dst->max)
+        dst->max = src->max;
+    dst->count += src->count;
+    dst->sum += src->sum;
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+        dst->buckets[i] += src->buckets[i];
+}
+
+uint64_t histogram_percentile (const histogram_t *hist, double pct)
+{
+    uint64_t target;
+    uint64_t total = 0;
+    uint64_t upper;
+    int i;
+
+    if (hist->count == 0)
+        return 0;
+    if (pct <= 0)
+        return hist->min;
+    if (pct >= 100)
+        return hist->max;
+    target = (uint64_t)(hist->count * (pct / 100.) + 0.5);
+    if (target == 0)
+        target = 1;
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += hist->buckets[i];
+        if (total >= target)
+            break;
+    }
+    upper = histogram_bucket_upper (i);
+    if (upper > hist->max)
+        upper = hist->max;
+    if (upper < hist->min)
+        upper = hist->min;
+    return upper;
+}
+
+double histogram_mean (const histogram_t *hist)
+{
+    if (hist->count == 0)
+        return 0;
+    return (double)hist->sum / hist->count;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
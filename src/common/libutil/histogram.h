@@ -0,0 +1,64 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_HISTOGRAM_H
+#define _UTIL_HISTOGRAM_H
+
+#include <stdint.h>
+
+/* Log-linear histogram of non-negative integers, in the style of
+ * HdrHistogram.  Each power of two is divided into HISTOGRAM_SUB linear
+ * buckets, so a value is reported with relative error of at most
+ * 1/HISTOGRAM_SUB.  Values of 2^HISTOGRAM_MAX_BITS or more are counted
+ * in the last bucket.  Recording a value costs a few integer operations.
+ * A zeroed histogram_t is empty.
+ */
+#define HISTOGRAM_SUB_BITS  3
+#define HISTOGRAM_SUB       (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_BITS  40
+#define HISTOGRAM_BUCKETS \
+    ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB)
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+} histogram_t;
+
+void histogram_record (histogram_t *hist, uint64_t value);
+
+/* Add the contents of 'src' to 'dst'.
+ */
+void histogram_merge (histogram_t *dst, const histogram_t *src);
+
+/* Return the smallest value v such that 'pct' percent of recorded values
+ * are <= v, to bucket precision, but never more than the maximum.
+ * Return 0 if the histogram is empty.
+ */
+uint64_t histogram_percentile (const histogram_t *hist, double pct);
+
+double histogram_mean (const histogram_t *hist);
+
+/* Return the lowest and highest value counted in bucket 'index'.
+ */
+uint64_t histogram_bucket_lower (int index);
+uint64_t histogram_bucket_upper (int index);
+
+/* Return the index of the bucket that counts 'value'.
+ */
+int histogram_bucket_index (uint64_t value);
+
+#endif /* !_UTIL_HISTOGRAM_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
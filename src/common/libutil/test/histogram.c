@@ -0,0 +1,105 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <string.h>
+#include <inttypes.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/histogram.h"
+
+void test_buckets (void)
+{
+    uint64_t v;
+    int errors = 0;
+    int prev = -1;
+    int i;
+
+    for (v = 0; v < 100000; v++) {
+        int index = histogram_bucket_index (v);
+        if (index < prev || index > prev + 1
+            || histogram_bucket_lower (index) > v
+            || histogram_bucket_upper (index) < v)
+            errors++;
+        prev = index;
+    }
+    ok (errors == 0,
+        "buckets are contiguous and contain their values up to 100000");
+
+    errors = 0;
+    for (i = 1; i < HISTOGRAM_BUCKETS; i++) {
+        if (histogram_bucket_lower (i) != histogram_bucket_upper (i - 1) + 1)
+            errors++;
+    }
+    ok (errors == 0,
+        "bucket boundaries are contiguous over the full range");
+
+    errors = 0;
+    for (i = HISTOGRAM_SUB; i < HISTOGRAM_BUCKETS; i++) {
+        uint64_t lower = histogram_bucket_lower (i);
+        uint64_t width = histogram_bucket_upper (i) - lower + 1;
+        if (width * HISTOGRAM_SUB > lower)
+            errors++;
+    }
+    ok (errors == 0,
+        "bucket width is at most 1/%d of its lower bound", HISTOGRAM_SUB);
+
+    ok (histogram_bucket_index (UINT64_MAX) == HISTOGRAM_BUCKETS - 1,
+        "huge values land in the last bucket");
+}
+
+void test_record (void)
+{
+    histogram_t hist;
+    histogram_t hist2;
+    uint64_t v;
+
+    memset (&hist, 0, sizeof (hist));
+    ok (histogram_percentile (&hist, 50) == 0 && histogram_mean (&hist) == 0,
+        "empty histogram has p50=0 mean=0");
+
+    for (v = 1; v <= 1000; v++)
+        histogram_record (&hist, v);
+    ok (hist.count == 1000 && hist.min == 1 && hist.max == 1000,
+        "recorded 1000 values with min=1 max=1000");
+    ok (histogram_mean (&hist) == 500.5,
+        "mean is 500.5");
+    v = histogram_percentile (&hist, 50);
+    ok (v >= 500 && v <= 500 + 500 / HISTOGRAM_SUB,
+        "p50 is %" PRIu64 ", within bucket precision of 500", v);
+    v = histogram_percentile (&hist, 99);
+    ok (v >= 990 && v <= 1000,
+        "p99 is %" PRIu64 ", clamped to max", v);
+    ok (histogram_percentile (&hist, 100) == 1000,
+        "p100 is max");
+    ok (histogram_percentile (&hist, 0) == 1,
+        "p0 is min");
+
+    memset (&hist2, 0, sizeof (hist2));
+    histogram_record (&hist2, 0);
+    histogram_record (&hist2, 5000);
+    histogram_merge (&hist, &hist2);
+    ok (hist.count == 1002 && hist.min == 0 && hist.max == 5000,
+        "histogram_merge updates count, min, and max");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_buckets ();
+    test_record ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -37,6 +37,7 @@ struct bulk_exec {
     int total;               /* Total processes expected to run */
     int started;             /* Number of processes that have reached start */
     int complete;            /* Number of processes that have completed */
+    int start_loops;         /* Event loop iterations that started procs */
 
     int exit_status;         /* Largest wait status of all complete procs */
 
@@ -54,6 +55,9 @@ struct bulk_exec {
     zlist_t *commands;
     zlist_t *processes;
 
+    char *input;             /* Data written to stdin of each process */
+    size_t input_len;
+
     struct bulk_exec_ops *handlers;
     void *arg;
 };
@@ -73,18 +77,59 @@ int bulk_exec_total (struct bulk_exec *exec)
     return exec->total;
 }
 
+int bulk_exec_start_loops (struct bulk_exec *exec)
+{
+    return exec->start_loops;
+}
+
 int bulk_exec_write (struct bulk_exec *exec, const char *stream,
                      const char *buf, size_t len)
 {
     flux_subprocess_t *p = zlist_first (exec->processes);
     while (p) {
-        if (flux_subprocess_write (p, stream, buf, len) < len)
+        int rc = flux_subprocess_write (p, stream, buf, len);
+        if (rc < 0 || (size_t)rc < len)
             return -1;
         p = zlist_next (exec->processes);
     }
     return 0;
 }
 
+int bulk_exec_set_input (struct bulk_exec *exec, const char *buf, size_t len)
+{
+    char *input;
+
+    if (!exec || !buf || !len || exec->active) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(input = malloc (len)))
+        return -1;
+    memcpy (input, buf, len);
+    free (exec->input);
+    exec->input = input;
+    exec->input_len = len;
+    return 0;
+}
+
+/*  Write exec->input to stdin of 'p' and close it. Remote subprocesses
+ *   buffer data written before the process is running, so this may be
+ *   called immediately after flux_rexec().
+ */
+static int exec_write_input (struct bulk_exec *exec, flux_subprocess_t *p)
+{
+    int rc = flux_subprocess_write (p, "stdin", exec->input, exec->input_len);
+    if (rc < 0)
+        return -1;
+    if ((size_t)rc < exec->input_len) {
+        errno = EIO;
+        return -1;
+    }
+    if (flux_subprocess_close (p, "stdin") < 0)
+        return -1;
+    return 0;
+}
+
 int bulk_exec_close (struct bulk_exec *exec, const char *stream)
 {
     flux_subprocess_t *p = zlist_first (exec->processes);
@@ -294,6 +339,10 @@ static int exec_start_cmd (struct bulk_exec *exec,
         zlist_freefn (exec->processes, p,
                      (zlist_free_fn *) flux_subprocess_unref,
                      true);
+        if (exec->input && exec_write_input (exec, p) < 0) {
+            flux_log_error (exec->h, "rank %u: failed to write input", rank);
+            return -1;
+        }
 
         idset_clear (cmd->ranks, rank);
         rank = idset_next (cmd->ranks, rank);
@@ -345,6 +394,8 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
                      int revents, void *arg)
 {
     struct bulk_exec *exec = arg;
+    size_t count = zlist_size (exec->processes);
+
     flux_watcher_stop (exec->idle);
     flux_watcher_stop (exec->check);
     if (exec_start_cmds (exec, exec->max_start_per_loop) < 0) {
@@ -352,6 +403,8 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
         if (exec->handlers->on_error)
             (*exec->handlers->on_error) (exec, NULL, exec->arg);
     }
+    if (zlist_size (exec->processes) > count)
+        exec->start_loops++;
 }
 
 void bulk_exec_destroy (struct bulk_exec *exec)
@@ -364,6 +417,7 @@ void bulk_exec_destroy (struct bulk_exec *exec)
         flux_watcher_destroy (exec->check);
         flux_watcher_destroy (exec->idle);
         aux_destroy (&exec->aux);
+        free (exec->input);
         free (exec);
     }
 }
@@ -83,7 +83,15 @@ int bulk_exec_write (struct bulk_exec *exec, const char *stream,
 
 int bulk_exec_close (struct bulk_exec *exec, const char *stream);
 
+/*  Write a copy of 'buf' to stdin of each process as it is started,
+ *   then close stdin. Must be called before bulk_exec_start().
+ */
+int bulk_exec_set_input (struct bulk_exec *exec, const char *buf, size_t len);
+
 /* Returns total number of processes expected to run */
 int bulk_exec_total (struct bulk_exec *exec);
 
+/* Returns number of event loop iterations in which processes were started */
+int bulk_exec_start_loops (struct bulk_exec *exec);
+
 #endif /* !HAVE_JOB_EXEC_BULK_EXEC_H */
@@ -31,6 +31,7 @@
 #endif
 
 #include <unistd.h>
+#include <limits.h>
 
 #include "job-exec.h"
 #include "bulk-exec.h"
@@ -40,6 +41,7 @@ extern char **environ;
 static const char *default_cwd = "/tmp";
 static const char *default_job_shell = NULL;
 static const char *flux_imp_path = NULL;
+static int max_start_per_loop = 1;
 
 /* Configuration for "bulk" execution implementation. Used only for testing
  *  for now.
@@ -111,6 +113,11 @@ static const char *job_get_cwd (struct jobinfo *job)
 static void start_cb (struct bulk_exec *exec, void *arg)
 {
     struct jobinfo *job = arg;
+    flux_log (job->h, LOG_DEBUG,
+              "%ju: started %d job shells in %d loop iterations",
+              (uintmax_t) job->id,
+              bulk_exec_total (exec),
+              bulk_exec_start_loops (exec));
     jobinfo_started (job, NULL);
     /*  This is going to be really slow. However, it should at least
      *   work for now. We wait for all imp's to start, then send input
@@ -211,6 +218,10 @@ static int exec_init (struct jobinfo *job)
         flux_log_error (job->h, "exec_init: bulk_exec_create");
         goto err;
     }
+    if (bulk_exec_set_max_per_loop (exec, max_start_per_loop) < 0) {
+        flux_log_error (job->h, "exec_init: bulk_exec_set_max_per_loop");
+        goto err;
+    }
     if (!(conf = exec_conf_create (job->jobspec))) {
         flux_log_error (job->h, "exec_init: exec_conf_create");
         goto err;
@@ -244,6 +255,23 @@ static int exec_init (struct jobinfo *job)
         flux_log_error (job->h, "exec_init: flux_cmd_setcwd");
         goto err;
     }
+    /*  Deliver jobspec and R to job shells on stdin, so they do not
+     *   need to look them up in the job-info service at startup.
+     */
+    if (job->shell_jobinfo) {
+        size_t len = strlen (job->shell_jobinfo);
+        char bufsize[32];
+        snprintf (bufsize, sizeof (bufsize), "%zu", len);
+        if (flux_cmd_setenvf (cmd, 1, "FLUX_SHELL_JOBINFO", "-") < 0
+            || flux_cmd_setopt (cmd, "stdin_BUFSIZE", bufsize) < 0
+            || bulk_exec_set_input (exec, job->shell_jobinfo, len) < 0) {
+            flux_log_error (job->h, "exec_init: failed to set shell jobinfo");
+            goto err;
+        }
+        /*  No longer needed, bulk_exec has its own copy */
+        free (job->shell_jobinfo);
+        job->shell_jobinfo = NULL;
+    }
     if (bulk_exec_push_cmd (exec, ranks, cmd, 0) < 0) {
         flux_log_error (job->h, "exec_init: bulk_exec_push_cmd");
         goto err;
@@ -387,12 +415,51 @@ static int exec_config (flux_t *h, int argc, char **argv)
         return -1;
     }
 
+    /*  Check configuration for exec.max-start-per-loop, the number of
+     *   job shells launched per reactor loop iteration (-1 = unlimited).
+     */
+    if (flux_conf_unpack (flux_get_conf (h),
+                          &err,
+                          "{s?:{s?i}}",
+                          "exec",
+                            "max-start-per-loop", &max_start_per_loop) < 0) {
+        flux_log (h, LOG_ERR,
+                  "error reading config value exec.max-start-per-loop: %s",
+                  err.errbuf);
+        return -1;
+    }
+
     /* Finally, override values on cmdline */
     for (int i = 0; i < argc; i++) {
         if (strncmp (argv[i], "job-shell=", 10) == 0)
             default_job_shell = argv[i]+10;
         else if (strncmp (argv[i], "imp=", 4) == 0)
             flux_imp_path = argv[i]+4;
+        else if (strncmp (argv[i], "max-start-per-loop=", 19) == 0) {
+            char *endptr;
+            long l;
+
+            errno = 0;
+            l = strtol (argv[i]+19, &endptr, 10);
+            if (errno != 0
+                || endptr == argv[i]+19
+                || *endptr != '\0'
+                || l > INT_MAX
+                || l < INT_MIN) {
+                flux_log (h, LOG_ERR,
+                          "invalid max-start-per-loop value: %s",
+                          argv[i]+19);
+                errno = EINVAL;
+                return -1;
+            }
+            max_start_per_loop = l;
+        }
+    }
+    if (max_start_per_loop == 0 || max_start_per_loop < -1) {
+        flux_log (h, LOG_ERR,
+                  "exec.max-start-per-loop must be positive or -1");
+        errno = EINVAL;
+        return -1;
     }
     flux_log (h, LOG_DEBUG, "using default shell path %s", default_job_shell);
     if (flux_imp_path)
@@ -133,6 +133,7 @@ void jobinfo_decref (struct jobinfo *job)
         flux_msg_decref (job->req);
         job->req = NULL;
         free (job->J);
+        free (job->shell_jobinfo);
         resource_set_destroy (job->R);
         json_decref (job->jobspec);
         free (job);
@@ -339,11 +340,11 @@ static void jobinfo_killtimer_start (struct jobinfo *job, double after)
 {
     /* Only start kill timer if not already running */
     if (job->kill_timer == NULL) {
-        job->kill_timer = flux_timer_watcher_create (flux_get_reactor (job->h),
-                                                     after,
-                                                     0.,
-                                                     kill_timer_cb,
-                                                     job);
+        flux_reactor_t *r = flux_get_reactor (job->h);
+        job->kill_timer = flux_timeout_watcher_create (r,
+                                                       after,
+                                                       kill_timer_cb,
+                                                       job);
         flux_watcher_start (job->kill_timer);
     }
 }
@@ -744,6 +745,22 @@ static void jobinfo_start_continue (flux_future_t *f, void *arg)
             goto done;
         }
     }
+    else {
+        /*  Prepare jobspec and R for delivery to job shells at launch.
+         *  On failure, shells fall back to fetching them from job-info.
+         */
+        const char *jobspec = jobinfo_kvs_lookup_get (f, "jobspec");
+        if (!jobspec
+            || asprintf (&job->shell_jobinfo,
+                         "{\"jobspec\":%s,\"R\":%s}",
+                         jobspec,
+                         R) < 0) {
+            flux_log_error (job->h,
+                            "%ju: unable to prepare shell jobinfo",
+                            (uintmax_t) job->id);
+            job->shell_jobinfo = NULL;
+        }
+    }
     if (jobinfo_load_implementation (job) < 0) {
         jobinfo_fatal_error (job, errno, "failed to initialize implementation");
         goto done;
@@ -849,6 +866,11 @@ static flux_future_t *jobinfo_start_init (struct jobinfo *job)
         || flux_future_push (f, "J", f_kvs) < 0)) {
         goto err;
     }
+    if (!job->multiuser
+        && (!(f_kvs = flux_jobid_kvs_lookup (h, job->id, 0, "jobspec"))
+        || flux_future_push (f, "jobspec", f_kvs) < 0)) {
+        goto err;
+    }
     if (!(f_kvs = ns_create_and_link (h, job, 0))
         || flux_future_push (f, "ns", f_kvs))
         goto err;
@@ -65,6 +65,7 @@ struct jobinfo {
     struct resource_set * R;         /* Fetched and parsed resource set R */
     json_t *              jobspec;   /* Fetched jobspec */
     char *                J;         /* Signed jobspec */
+    char *                shell_jobinfo; /* jobspec and R for job shells */
 
     uint8_t               multiuser:1;
     uint8_t               has_namespace:1;
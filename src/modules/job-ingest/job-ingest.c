@@ -31,7 +31,8 @@
  * performing the following tasks for each job:
  *
  * 1) verify that submitting userid == userid that signed jobspec
- * 2) verify that enclosed jobspec is valid per RFC 14
+ * 2) verify that enclosed jobspec is valid per RFC 14, with the built-in
+ *    validator or an external one set with validator=PATH
  * 3) assign jobid using distributed 64-bit FLUID generator
  * 4) commit job data to KVS per RFC 16 (KVS Job Schema)
  * 5) make "job-manager.submit" request announcing new jobid
@@ -43,6 +44,15 @@
  * The jobid is returned to the user in response to the job-ingest.submit RPC.
  * Responses are sent after the job has been successfully ingested.
  *
+ * The job-ingest.submit-batch RPC carries many signed jobspecs in one
+ * message.  Each is checked and validated as above, then all those that
+ * pass are added to the current batch together, in request order, so they
+ * are assigned ascending jobids and normally committed in one KVS
+ * transaction.  With batch-count=N, the batch is flushed each time it
+ * reaches N jobs, which may split a submit-batch request across
+ * transactions.
+ * One response carries the jobid or error for each job, in request order.
+ *
  * Currently all KVS data is committed under job.<fluid-dothex>,
  * where <fluid-dothex> is the jobid converted to 16-bit, 0-padded hex
  * strings delimited by periods, e.g.
@@ -75,6 +85,11 @@ const double batch_timeout = 0.01;
  */
 const double shutdown_timeout = 5.;
 
+/* Default maximum number of cached validator=PATH results, unless
+ * overridden with validator-cache=N (0 disables the cache).
+ */
+const int validator_cache_max = 1024;
+
 
 struct job_ingest_ctx {
     flux_t *h;
@@ -110,6 +125,9 @@ struct job {
                         //   N.B. after obj validation, environment is dropped
                         //   to reduce size, since job-manager doesn't need it
 
+    struct submit_batch *sb; // submit-batch request, if any
+    int index;          // index of job within submit-batch request
+
     struct job_ingest_ctx *ctx;
 };
 
@@ -120,6 +138,26 @@ struct batch {
     json_t *joblist;
 };
 
+/* A job-ingest.submit-batch request.  'validating' counts jobs whose
+ * jobspec validation is still in progress, plus one while the request
+ * is being unpacked or its validated jobs are being added to the batch.
+ * The response is sent once it is zero and every job has a result.
+ */
+struct submit_batch {
+    struct job_ingest_ctx *ctx;
+    const flux_msg_t *msg;
+    json_t *jobs;
+    int urgency;
+    int flags;
+    struct flux_msg_cred cred;
+
+    json_t *results;    // per-job {"id":I} or {"errnum":i, "errstr":s}
+    struct job **ready; // validated jobs, by index, awaiting the batch
+    int count;
+    int pending;        // jobs without a result
+    int validating;
+};
+
 struct batch_response {
     flux_future_t *f;
     bool batch_failed;
@@ -202,6 +240,131 @@ error:
     return NULL;
 }
 
+/* Create job 'index' of a submit-batch request, with signed jobspec 'J'.
+ */
+static struct job *job_create_batched (struct submit_batch *sb,
+                                       int index,
+                                       const char *J)
+{
+    struct job *job;
+
+    if (!(job = calloc (1, sizeof (*job))))
+        return NULL;
+    job->msg = flux_msg_incref (sb->msg);
+    job->J = J;
+    job->urgency = sb->urgency;
+    job->flags = sb->flags;
+    job->cred = sb->cred;
+    job->sb = sb;
+    job->index = index;
+    job->ctx = sb->ctx;
+    return job;
+}
+
+static void submit_batch_destroy (struct submit_batch *sb)
+{
+    if (sb) {
+        int saved_errno = errno;
+        flux_msg_decref (sb->msg);
+        json_decref (sb->results);
+        free (sb->ready);
+        free (sb);
+        errno = saved_errno;
+    }
+}
+
+static struct submit_batch *submit_batch_create (struct job_ingest_ctx *ctx,
+                                                 const flux_msg_t *msg)
+{
+    struct submit_batch *sb;
+    int i;
+
+    if (!(sb = calloc (1, sizeof (*sb))))
+        return NULL;
+    sb->msg = flux_msg_incref (msg);
+    if (flux_request_unpack (sb->msg, NULL, "{s:o s:i s:i}",
+                             "jobs", &sb->jobs,
+                             "urgency", &sb->urgency,
+                             "flags", &sb->flags) < 0)
+        goto error;
+    if (!json_is_array (sb->jobs) || json_array_size (sb->jobs) == 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (flux_msg_get_cred (sb->msg, &sb->cred) < 0)
+        goto error;
+    sb->count = json_array_size (sb->jobs);
+    if (!(sb->ready = calloc (sb->count, sizeof (sb->ready[0]))))
+        goto error;
+    if (!(sb->results = json_array ()))
+        goto nomem;
+    for (i = 0; i < sb->count; i++) {
+        if (json_array_append_new (sb->results, json_null ()) < 0)
+            goto nomem;
+    }
+    sb->pending = sb->count;
+    sb->validating = 1;
+    sb->ctx = ctx;
+    return sb;
+nomem:
+    errno = ENOMEM;
+error:
+    submit_batch_destroy (sb);
+    return NULL;
+}
+
+/* Respond to the submit-batch request once all jobs have a result.
+ */
+static void submit_batch_check_done (struct submit_batch *sb)
+{
+    flux_t *h = sb->ctx->h;
+
+    if (sb->pending > 0 || sb->validating > 0)
+        return;
+    if (flux_respond_pack (h, sb->msg, "{s:O}", "jobs", sb->results) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    submit_batch_destroy (sb);
+}
+
+static void submit_batch_set_result (struct submit_batch *sb,
+                                     int index,
+                                     json_t *result)
+{
+    if (!result
+        || json_array_set_new (sb->results, index, result) < 0)
+        flux_log (sb->ctx->h, LOG_ERR, "error recording submit-batch result");
+    sb->pending--;
+    submit_batch_check_done (sb);
+}
+
+static void job_respond_error (struct job *job,
+                               int errnum,
+                               const char *errmsg)
+{
+    flux_t *h = job->ctx->h;
+
+    if (job->sb) {
+        json_t *o = json_pack ("{s:i s:s}",
+                               "errnum", errnum,
+                               "errstr", errmsg ? errmsg : strerror (errnum));
+        submit_batch_set_result (job->sb, job->index, o);
+    }
+    else if (flux_respond_error (h, job->msg, errnum, errmsg) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
+static void job_respond_id (struct job *job)
+{
+    flux_t *h = job->ctx->h;
+
+    if (job->sb) {
+        json_t *o = json_pack ("{s:I}", "id", job->id);
+        submit_batch_set_result (job->sb, job->index, o);
+    }
+    else if (flux_respond_pack (h, job->msg, "{s:I}", "id", job->id) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+}
+
 static void batch_destroy (struct batch *batch)
 {
     if (batch) {
@@ -327,11 +490,9 @@ error:
 static void batch_respond_error (struct batch *batch,
                                  int errnum, const char *errstr)
 {
-    flux_t *h = batch->ctx->h;
     struct job *job = zlist_first (batch->jobs);
     while (job) {
-        if (flux_respond_error (h, job->msg, errnum, errstr) < 0)
-            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        job_respond_error (job, errnum, errstr);
         job = zlist_next (batch->jobs);
     }
 }
@@ -341,7 +502,6 @@ static void batch_respond_error (struct batch *batch,
  */
 static void batch_respond (struct batch *batch, struct batch_response *br)
 {
-    flux_t *h = batch->ctx->h;
     const char *errmsg;
     struct job *job = zlist_first (batch->jobs);
 
@@ -351,12 +511,10 @@ static void batch_respond (struct batch *batch, struct batch_response *br)
     }
 
     while (job) {
-        if ((errmsg = zhashx_lookup (br->errors, &job->id))) {
-            if (flux_respond_error (h, job->msg, EINVAL, errmsg) < 0)
-                flux_log_error (h, "batch_respond: flux_respond_error");
-        }
-        else if (flux_respond_pack (h, job->msg, "{s:I}", "id", job->id) < 0)
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        if ((errmsg = zhashx_lookup (br->errors, &job->id)))
+            job_respond_error (job, EINVAL, errmsg);
+        else
+            job_respond_id (job);
         job = zlist_next (batch->jobs);
     }
 }
@@ -597,11 +755,61 @@ error:
     return -1;
 }
 
+/* Assign a jobid to validated 'job' and add it to the current "batch"
+ * of new jobs, creating the batch if one doesn't exist already.
+ * Submit is finalized upon timer expiration, or when the batch is full.
+ */
+static int ingest_add_job (struct job_ingest_ctx *ctx, struct job *job)
+{
+    if (fluid_generate (&ctx->gen, &job->id) < 0)
+        return -1;
+    if (!ctx->batch) {
+        if (!(ctx->batch = batch_create (ctx)))
+            return -1;
+        if (!ctx->batch_count) {
+            flux_timer_watcher_reset (ctx->timer, batch_timeout, 0.);
+            flux_watcher_start (ctx->timer);
+        }
+    }
+    if (batch_add_job (ctx->batch, job) < 0)
+        return -1;
+    if (ctx->batch_count
+        && zlist_size (ctx->batch->jobs) >= ctx->batch_count)
+        batch_flush (ctx);
+    return 0;
+}
+
+/* A submit-batch job finished validation.  Once all have, add those
+ * that passed to the batch in request order, so they are assigned
+ * ascending jobids.  They share a KVS transaction unless batch-count
+ * flushes the batch partway through.
+ */
+static void submit_batch_validated (struct submit_batch *sb)
+{
+    int i;
+
+    if (sb->validating > 1) {
+        sb->validating--;
+        return;
+    }
+    for (i = 0; i < sb->count; i++) {
+        struct job *job;
+        if ((job = sb->ready[i])) {
+            sb->ready[i] = NULL;
+            if (ingest_add_job (sb->ctx, job) < 0) {
+                job_respond_error (job, errno, NULL);
+                job_destroy (job);
+            }
+        }
+    }
+    sb->validating = 0;
+    submit_batch_check_done (sb);
+}
+
 void validate_continuation (flux_future_t *f, void *arg)
 {
     struct job *job = arg;
-    struct job_ingest_ctx *ctx = job->ctx;
-    flux_t *h = flux_future_get_flux (f);
+    struct submit_batch *sb = job->sb;
     const char *errmsg = NULL;
 
     /* If jobspec validation failed, respond immediately to the user.
@@ -610,33 +818,22 @@ void validate_continuation (flux_future_t *f, void *arg)
         errmsg = future_strerror (f, errno);
         goto error;
     }
-    if (fluid_generate (&ctx->gen, &job->id) < 0)
-        goto error;
-    /* Add job to the current "batch" of new jobs, creating the batch if
-     * one doesn't exist already.  Submit is finalized upon timer expiration.
-     */
-    if (!ctx->batch) {
-        if (!(ctx->batch = batch_create (ctx)))
-            goto error;
-        if (!ctx->batch_count) {
-            flux_timer_watcher_reset (ctx->timer, batch_timeout, 0.);
-            flux_watcher_start (ctx->timer);
-        }
+    if (sb) {
+        sb->ready[job->index] = job;
+        flux_future_destroy (f);
+        submit_batch_validated (sb);
+        return;
     }
-    if (batch_add_job (ctx->batch, job) < 0)
+    if (ingest_add_job (job->ctx, job) < 0)
         goto error;
     flux_future_destroy (f);
-
-    if (ctx->batch_count
-        && zlist_size (ctx->batch->jobs) == ctx->batch_count)
-        batch_flush (ctx);
-
     return;
 error:
-    if (flux_respond_error (h, job->msg, errno, errmsg) < 0)
-        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    job_respond_error (job, errno, errmsg);
     job_destroy (job);
     flux_future_destroy (f);
+    if (sb)
+        submit_batch_validated (sb);
 }
 
 static int valid_flags (int flags)
@@ -649,13 +846,13 @@ static int valid_flags (int flags)
     return 0;
 }
 
-/* Handle "job-ingest.submit" request to add a new job.
+/* Check 'job' and start validating its jobspec.
+ * Continue submission process in validate_continuation().
+ * On failure, respond to the job and destroy it.
  */
-static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
-                       const flux_msg_t *msg, void *arg)
+static void job_submit (struct job *job)
 {
-    struct job_ingest_ctx *ctx = arg;
-    struct job *job = NULL;
+    struct job_ingest_ctx *ctx = job->ctx;
     const char *errmsg = NULL;
     char errbuf[256];
     int64_t userid_signer;
@@ -663,15 +860,6 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
     flux_future_t *f = NULL;
     json_error_t e;
 
-    if (ctx->shutdown) {
-        errno = ENOSYS;
-        goto error;
-    }
-
-    /* Parse request.
-     */
-    if (!(job = job_create (msg, ctx)))
-        goto error;
     /* Validate submit flags.
      */
     if (valid_flags (job->flags) < 0)
@@ -772,14 +960,83 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     if (flux_future_then (f, -1., validate_continuation, job) < 0)
         goto error;
+    if (job->sb)
+        job->sb->validating++;
     return;
 error:
-    if (flux_respond_error (h, msg, errno, errmsg) < 0)
-        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    job_respond_error (job, errno, errmsg);
     job_destroy (job);
     flux_future_destroy (f);
 }
 
+/* Handle "job-ingest.submit" request to add a new job.
+ */
+static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct job *job;
+
+    if (ctx->shutdown) {
+        errno = ENOSYS;
+        goto error;
+    }
+    if (!(job = job_create (msg, ctx)))
+        goto error;
+    job_submit (job);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
+/* Handle "job-ingest.submit-batch" request to add many jobs.
+ * A job that cannot be parsed or fails its checks gets an error result
+ * without failing the request.
+ */
+static void submit_batch_cb (flux_t *h, flux_msg_handler_t *mh,
+                             const flux_msg_t *msg, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct submit_batch *sb;
+    json_t *entry;
+    size_t index;
+
+    if (ctx->shutdown) {
+        errno = ENOSYS;
+        goto error;
+    }
+    if (!(sb = submit_batch_create (ctx, msg)))
+        goto error;
+    json_array_foreach (sb->jobs, index, entry) {
+        struct job *job;
+        const char *J;
+
+        if (json_unpack (entry, "{s:s}", "J", &J) < 0) {
+            submit_batch_set_result (sb,
+                                     index,
+                                     json_pack ("{s:i s:s}",
+                                                "errnum", EPROTO,
+                                                "errstr", "malformed job"));
+            continue;
+        }
+        if (!(job = job_create_batched (sb, index, J))) {
+            submit_batch_set_result (sb,
+                                     index,
+                                     json_pack ("{s:i s:s}",
+                                                "errnum", errno,
+                                                "errstr", strerror (errno)));
+            continue;
+        }
+        job_submit (job);
+    }
+    submit_batch_validated (sb);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 static void exit_cb (void *arg)
 {
     struct job_ingest_ctx *ctx = arg;
@@ -850,9 +1107,46 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+/* Site validators may apply policy from the config, so cached results
+ * are not trusted across a config reload.
+ */
+static void config_reload_cb (flux_t *h,
+                              flux_msg_handler_t *mh,
+                              const flux_msg_t *msg,
+                              void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    const flux_conf_t *conf;
+    const char *errstr = NULL;
+
+    if (flux_conf_reload_decode (msg, &conf) < 0)
+        goto error;
+    if (flux_set_conf (h, flux_conf_incref (conf)) < 0) {
+        errstr = "error updating cached configuration";
+        goto error;
+    }
+    validate_cache_flush (ctx->validate);
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "error responding to config-reload request");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to config-reload request");
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.getinfo", getinfo_cb, 0},
+    { FLUX_MSGTYPE_REQUEST,
+      "job-ingest.config-reload",
+      config_reload_cb,
+      0
+    },
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.submit", submit_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST,
+      "job-ingest.submit-batch",
+      submit_batch_cb,
+      FLUX_ROLE_USER
+    },
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.shutdown", shutdown_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
@@ -864,14 +1158,15 @@ int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
 {
     flux_reactor_t *r = flux_get_reactor (h);
     const char *usage_message = "Usage: flux module load [OPTIONS] job-ingest "
-                                " [validator-args=ARGS] [validator=PATH]";
-    const char *valpath;
+                                " [validator-args=ARGS] [validator=PATH]"
+                                " [validator-cache=N]";
+    const char *valpath = NULL; // use built-in validator
     const char *valargs;
+    int valcache = validator_cache_max;
 
     memset (ctx, 0, sizeof (*ctx));
     ctx->h = h;
 
-    valpath = flux_conf_builtin_get ("jobspec_validate_path", FLUX_CONF_AUTO);
     valargs = flux_conf_builtin_get ("jobspec_validator_args", FLUX_CONF_AUTO);
 
     /*  Process cmdline args */
@@ -886,6 +1181,16 @@ int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
                 return -1;
             }
         }
+        else if (!strncmp (argv[i], "validator-cache=", 16)) {
+            char *endptr;
+            errno = 0;
+            valcache = strtol (argv[i]+16, &endptr, 0);
+            if (errno != 0 || *endptr != '\0' || valcache < 0) {
+                flux_log (h, LOG_ERR, "Invalid validator-cache: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
         else if (!strncmp (argv[i], "batch-count=", 12)) {
             char *endptr;
             ctx->batch_count = strtol (argv[i]+12, &endptr, 0);
@@ -901,7 +1206,7 @@ int job_ingest_ctx_init (struct job_ingest_ctx *ctx,
             return -1;
         }
     }
-    if (!(ctx->validate = validate_create (h, valpath, valargs))) {
+    if (!(ctx->validate = validate_create (h, valpath, valargs, valcache))) {
         flux_log_error (h, "validate_create");
         return -1;
     }
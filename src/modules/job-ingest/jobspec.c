@@ -0,0 +1,373 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* jobspec - native validation of RFC 14 jobspec
+ *
+ * The rules and error messages follow the Jobspec and JobspecV1 classes
+ * in the python bindings, so that users see the same result whether the
+ * built-in validator or validate-jobspec.py is in use.  That includes the
+ * python quirks:
+ * - JSON booleans pass as integers (bool is an int subclass), so e.g.
+ *   "version":true selects version 1 and "count":true is a count of 1.
+ * - "exclusive" is compared with ==, so 0, 1, 0.0 and 1.0 are accepted.
+ * - strings are sequences, so "resources", "tasks", and "with" may be
+ *   strings, and each character fails as a resource or task that is not
+ *   a mapping.  "with" may also be a mapping, whose keys are iterated.
+ * - a non-mapping task "attributes" fails with "count must be a mapping".
+ * - where python raises an interpreter TypeError (a "with" that is not
+ *   iterable, a "command" that has no length), its message is reproduced.
+ *
+ * Intended differences:
+ * - a jobspec that is a JSON array fails here with "jobspec must be a
+ *   mapping", whereas the python validator raises an uncaught
+ *   AttributeError and exits.
+ * - when several keys are missing or extraneous, python names whichever
+ *   its set iteration (which varies with PYTHONHASHSEED) reaches first.
+ *   This names the first in the order listed in RFC 14.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <jansson.h>
+
+#include "jobspec.h"
+
+static int set_error (json_error_t *error, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (error) {
+        va_start (ap, fmt);
+        vsnprintf (error->text, sizeof (error->text), fmt, ap);
+        va_end (ap);
+    }
+    return -1;
+}
+
+/* Name of the python type that json.loads() would produce for 'o',
+ * for reproducing python's own TypeError messages.
+ */
+static const char *py_typename (json_t *o)
+{
+    switch (json_typeof (o)) {
+        case JSON_OBJECT:
+            return "dict";
+        case JSON_ARRAY:
+            return "list";
+        case JSON_STRING:
+            return "str";
+        case JSON_INTEGER:
+            return "int";
+        case JSON_REAL:
+            return "float";
+        case JSON_TRUE:
+        case JSON_FALSE:
+            return "bool";
+        case JSON_NULL:
+            break;
+    }
+    return "NoneType";
+}
+
+/* isinstance (o, int) - true for booleans too.
+ */
+static bool is_int (json_t *o)
+{
+    return json_is_integer (o) || json_is_boolean (o);
+}
+
+static json_int_t int_value (json_t *o)
+{
+    if (json_is_boolean (o))
+        return json_is_true (o) ? 1 : 0;
+    return json_integer_value (o);
+}
+
+/* o == n
+ */
+static bool num_equals (json_t *o, json_int_t n)
+{
+    if (json_is_real (o))
+        return json_real_value (o) == n;
+    return is_int (o) && int_value (o) == n;
+}
+
+/* isinstance (o, abc.Sequence)
+ */
+static bool is_sequence (json_t *o)
+{
+    return json_is_array (o) || json_is_string (o);
+}
+
+/* Call 'fn' on each element of python iterable 'o'.  The elements of a
+ * non-empty string or mapping are strings, which 'fn' rejects without
+ * looking at their value, so only the first is tried: 'o' itself if it
+ * is a string, or its first key if it is a mapping.
+ */
+static int validate_each (json_t *o,
+                          int (*fn)(json_t *o, json_error_t *error),
+                          json_error_t *error)
+{
+    size_t index;
+    json_t *val;
+    json_t *key;
+    int rc;
+
+    if (json_is_array (o)) {
+        json_array_foreach (o, index, val) {
+            if (fn (val, error) < 0)
+                return -1;
+        }
+        return 0;
+    }
+    if (json_is_string (o))
+        return json_string_length (o) > 0 ? fn (o, error) : 0;
+    if (json_is_object (o)) {
+        if (json_object_size (o) == 0)
+            return 0;
+        if (!(key = json_string (json_object_iter_key (json_object_iter (o)))))
+            return set_error (error, "out of memory");
+        rc = fn (key, error);
+        json_decref (key);
+        return rc;
+    }
+    return set_error (error, "'%s' object is not iterable", py_typename (o));
+}
+
+static bool key_in_list (const char *key, const char **keys)
+{
+    int i;
+
+    for (i = 0; keys[i] != NULL; i++) {
+        if (!strcmp (key, keys[i]))
+            return true;
+    }
+    return false;
+}
+
+/* Check that object 'o' has all of the NULL-terminated 'keys' (unless
+ * 'keys_optional'), and no others (unless 'allow_additional').
+ */
+static int validate_keys (json_t *o,
+                          const char **keys,
+                          bool keys_optional,
+                          bool allow_additional,
+                          json_error_t *error)
+{
+    const char *key;
+    json_t *val;
+    int i;
+
+    if (!keys_optional) {
+        for (i = 0; keys[i] != NULL; i++) {
+            if (!json_object_get (o, keys[i]))
+                return set_error (error, "Missing key (%s)", keys[i]);
+        }
+    }
+    if (!allow_additional) {
+        json_object_foreach (o, key, val) {
+            if (!key_in_list (key, keys))
+                return set_error (error, "Extraneous key (%s)", key);
+        }
+    }
+    return 0;
+}
+
+static int validate_complex_range (json_t *range, json_error_t *error)
+{
+    const char *keys[] = { "min", "max", "operator", "operand", NULL };
+    const char *intkeys[] = { "min", "max", "operand", NULL };
+    const char *op;
+    json_t *val;
+    int i;
+
+    if (!json_object_get (range, "min"))
+        return set_error (error, "min must be in range");
+    if (json_object_size (range) > 1
+        && validate_keys (range, keys, false, false, error) < 0)
+        return -1;
+    for (i = 0; intkeys[i] != NULL; i++) {
+        if (!(val = json_object_get (range, intkeys[i])))
+            continue;
+        if (!is_int (val))
+            return set_error (error, "%s must be an int", intkeys[i]);
+        if (int_value (val) < 1)
+            return set_error (error, "%s must be > 0", intkeys[i]);
+    }
+    if ((val = json_object_get (range, "operator"))) {
+        if (!(op = json_string_value (val))
+            || (strcmp (op, "+") && strcmp (op, "*") && strcmp (op, "^")))
+            return set_error (error,
+                              "operator must be one of ['+', '*', '^']");
+    }
+    return 0;
+}
+
+static int validate_resource (json_t *res, json_error_t *error)
+{
+    const char *strkeys[] = { "id", "unit", "label", NULL };
+    json_t *type;
+    json_t *count;
+    json_t *val;
+    int i;
+
+    if (!json_is_object (res))
+        return set_error (error, "resource must be a mapping");
+    if (!(type = json_object_get (res, "type")))
+        return set_error (error, "type is a required key for resources");
+    if (!json_is_string (type))
+        return set_error (error, "type must be a string");
+    if (!(count = json_object_get (res, "count")))
+        return set_error (error, "count is a required key for resources");
+    if (json_is_object (count)) {
+        if (validate_complex_range (count, error) < 0)
+            return -1;
+    }
+    else if (!is_int (count))
+        return set_error (error, "count must be an int or mapping");
+    else if (int_value (count) < 1)
+        return set_error (error, "count must be > 0");
+    for (i = 0; strkeys[i] != NULL; i++) {
+        if ((val = json_object_get (res, strkeys[i])) && !json_is_string (val))
+            return set_error (error, "%s must be a string", strkeys[i]);
+    }
+    if ((val = json_object_get (res, "exclusive"))
+        && !num_equals (val, 0)
+        && !num_equals (val, 1))
+        return set_error (error, "exclusive must be a boolean");
+    if (!strcmp (json_string_value (type), "slot")
+        && !json_object_get (res, "label"))
+        return set_error (error, "slots must have labels");
+    if ((val = json_object_get (res, "with"))
+        && validate_each (val, validate_resource, error) < 0)
+        return -1;
+    return 0;
+}
+
+static int validate_task (json_t *task, json_error_t *error)
+{
+    const char *keys[] = { "command", "slot", "count", NULL };
+    json_t *command;
+    json_t *val;
+    size_t index;
+    size_t len;
+
+    if (!json_is_object (task))
+        return set_error (error, "task must be a mapping");
+    if (validate_keys (task, keys, false, true, error) < 0)
+        return -1;
+    if (!json_is_object (json_object_get (task, "count")))
+        return set_error (error, "count must be a mapping");
+    if (!json_is_string (json_object_get (task, "slot")))
+        return set_error (error, "slot must be a string");
+    if ((val = json_object_get (task, "attributes")) && !json_is_object (val))
+        return set_error (error, "count must be a mapping");
+    command = json_object_get (task, "command");
+    if (json_is_array (command))
+        len = json_array_size (command);
+    else if (json_is_string (command))
+        len = json_string_length (command);
+    else if (json_is_object (command))
+        len = json_object_size (command);
+    else
+        return set_error (error,
+                          "object of type '%s' has no len()",
+                          py_typename (command));
+    if (len == 0)
+        return set_error (error, "command array cannot have length of zero");
+    if (!json_is_array (command))
+        return set_error (error, "command must be a list of strings");
+    json_array_foreach (command, index, val) {
+        if (!json_is_string (val))
+            return set_error (error, "command must be a list of strings");
+    }
+    return 0;
+}
+
+static int validate_attributes (json_t *attributes, json_error_t *error)
+{
+    const char *keys[] = { "system", "user", NULL };
+
+    return validate_keys (attributes, keys, true, false, error);
+}
+
+/* Version 1 requires attributes.system.duration.
+ */
+static int validate_v1 (json_t *attributes, json_error_t *error)
+{
+    json_t *system;
+    json_t *duration;
+
+    if (!(system = json_object_get (attributes, "system")))
+        return set_error (error, "attributes.system is a required key");
+    if (!json_is_object (system))
+        return set_error (error, "attributes.system must be a mapping");
+    if (!(duration = json_object_get (system, "duration")))
+        return set_error (error,
+                          "attributes.system.duration is a required key");
+    if (!json_is_number (duration) && !json_is_boolean (duration))
+        return set_error (error,
+                          "attributes.system.duration must be a number");
+    return 0;
+}
+
+int jobspec_validate (json_t *jobspec,
+                      int require_version,
+                      json_error_t *error)
+{
+    const char *keys[] = { "resources", "tasks", "version", "attributes", NULL };
+    json_t *resources;
+    json_t *tasks;
+    json_t *version;
+    json_t *attributes;
+
+    if (!json_is_object (jobspec))
+        return set_error (error, "jobspec must be a mapping");
+    if (validate_keys (jobspec, keys, false, false, error) < 0)
+        return -1;
+    resources = json_object_get (jobspec, "resources");
+    tasks = json_object_get (jobspec, "tasks");
+    version = json_object_get (jobspec, "version");
+    attributes = json_object_get (jobspec, "attributes");
+
+    if (require_version == 1
+        && !num_equals (version, 1))
+        return set_error (error, "version must be 1");
+    if (!is_sequence (resources))
+        return set_error (error, "resources must be a sequence");
+    if (!is_sequence (tasks))
+        return set_error (error, "tasks must be a sequence");
+    if (!is_int (version))
+        return set_error (error, "version must be an integer");
+    if (!json_is_object (attributes))
+        return set_error (error, "attributes must be a mapping");
+    if (int_value (version) < 1)
+        return set_error (error, "version must be >= 1");
+
+    if (validate_each (resources, validate_resource, error) < 0)
+        return -1;
+    if (validate_each (tasks, validate_task, error) < 0)
+        return -1;
+    if (validate_attributes (attributes, error) < 0)
+        return -1;
+    if (int_value (version) == 1) {
+        if (validate_v1 (attributes, error) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
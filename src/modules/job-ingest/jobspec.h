@@ -0,0 +1,32 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_INGEST_JOBSPEC_H
+#define _JOB_INGEST_JOBSPEC_H
+
+#include <jansson.h>
+
+/* Validate 'jobspec' per RFC 14, applying the same rules as the
+ * flux.job.validate_jobspec() python binding used by validate-jobspec.py
+ * (see jobspec.c for the few intended differences).
+ * If 'require_version' is nonzero, validate as that version (only 1 is
+ * supported), otherwise as the version found in the jobspec.
+ * Return 0 if valid, or -1 with a reason suitable for the submitting
+ * user in error->text.
+ */
+int jobspec_validate (json_t *jobspec,
+                      int require_version,
+                      json_error_t *error);
+
+#endif /* !_JOB_INGEST_JOBSPEC_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,263 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/job-ingest/jobspec.h"
+
+#define RESOURCES "[{\"type\":\"slot\",\"count\":1,\"label\":\"task\"," \
+                  "\"with\":[{\"type\":\"core\",\"count\":1}]}]"
+#define TASKS "[{\"command\":[\"app\"],\"slot\":\"task\"," \
+              "\"count\":{\"per_slot\":1}}]"
+#define ATTRS "{\"system\":{\"duration\":0}}"
+
+struct test {
+    const char *desc;
+    const char *jobspec;
+    int require_version;
+    const char *error;   // NULL if valid
+};
+
+struct test tests[] = {
+    { "minimal v1 jobspec",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      0, NULL },
+    { "minimal v1 jobspec with require_version=1",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, NULL },
+    { "version 2 jobspec without duration",
+      "{\"version\":2,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":{}}",
+      0, NULL },
+    { "version 2 jobspec with require_version=1",
+      "{\"version\":2,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":{}}",
+      1, "version must be 1" },
+    { "complex count range",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"task\","
+      "\"count\":{\"min\":1,\"max\":4,\"operator\":\"+\",\"operand\":1}}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, NULL },
+    { "not an object",
+      "[]",
+      0, "jobspec must be a mapping" },
+    { "missing tasks",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"attributes\":" ATTRS "}",
+      0, "Missing key (tasks)" },
+    { "extra top level key",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS ",\"foo\":1}",
+      0, "Extraneous key (foo)" },
+    { "non-integer version",
+      "{\"version\":4.2,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      0, "version must be an integer" },
+    { "null attributes",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":null}",
+      0, "attributes must be a mapping" },
+    { "unlabeled slot",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "slots must have labels" },
+    { "zero count in nested resource",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":[{\"type\":\"core\",\"count\":0}]}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "count must be > 0" },
+    { "incomplete count range",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"task\","
+      "\"count\":{\"min\":1,\"max\":2}}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "Missing key (operator)" },
+    { "bad count range operator",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"task\","
+      "\"count\":{\"min\":1,\"max\":2,\"operator\":\"-\",\"operand\":1}}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "operator must be one of ['+', '*', '^']" },
+    { "non-boolean exclusive",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"exclusive\":\"blah\"}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "exclusive must be a boolean" },
+    { "string command",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":[{\"command\":"
+      "\"app\",\"slot\":\"task\",\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTRS "}",
+      0, "command must be a list of strings" },
+    { "empty command",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":[{\"command\":"
+      "[],\"slot\":\"task\",\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTRS "}",
+      0, "command array cannot have length of zero" },
+    { "task missing slot",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":[{\"command\":"
+      "[\"app\"],\"count\":{\"per_slot\":1}}],\"attributes\":" ATTRS "}",
+      0, "Missing key (slot)" },
+    { "extra attributes key",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":0},\"foo\":1}}",
+      0, "Extraneous key (foo)" },
+    { "v1 without duration",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{}}}",
+      0, "attributes.system.duration is a required key" },
+    { "v1 with string duration",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":\"1h\"}}}",
+      0, "attributes.system.duration must be a number" },
+
+    /* python quirks, reproduced for identical results with
+     * validate-jobspec.py
+     */
+    { "boolean version true is version 1",
+      "{\"version\":true,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":{}}",
+      0, "attributes.system is a required key" },
+    { "boolean version true with require_version=1",
+      "{\"version\":true,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, NULL },
+    { "boolean version false",
+      "{\"version\":false,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      0, "version must be >= 1" },
+    { "real version 1.0 with require_version=1",
+      "{\"version\":1.0,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      1, "version must be an integer" },
+    { "boolean count true",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":true,"
+      "\"label\":\"task\"}],\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, NULL },
+    { "boolean count false",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":false,"
+      "\"label\":\"task\"}],\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "count must be > 0" },
+    { "boolean count range min",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"label\":\"task\","
+      "\"count\":{\"min\":true}}],\"tasks\":" TASKS ",\"attributes\":" ATTRS
+      "}",
+      0, NULL },
+    { "integer exclusive 1",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"exclusive\":1}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, NULL },
+    { "real exclusive 0.0",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"exclusive\":0.0}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, NULL },
+    { "integer exclusive 2",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"exclusive\":2}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "exclusive must be a boolean" },
+    { "non-mapping task attributes",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":[{\"command\":"
+      "[\"app\"],\"slot\":\"task\",\"count\":{\"per_slot\":1},"
+      "\"attributes\":[]}],\"attributes\":" ATTRS "}",
+      0, "count must be a mapping" },
+    { "string with",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":\"core\"}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "resource must be a mapping" },
+    { "empty string with",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":\"\"}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, NULL },
+    { "mapping with",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":{\"type\":\"core\",\"count\":1}}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "resource must be a mapping" },
+    { "integer with",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":1}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "'int' object is not iterable" },
+    { "null with",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":null}],"
+      "\"tasks\":" TASKS ",\"attributes\":" ATTRS "}",
+      0, "'NoneType' object is not iterable" },
+    { "string resources",
+      "{\"version\":1,\"resources\":\"slot\",\"tasks\":" TASKS
+      ",\"attributes\":" ATTRS "}",
+      0, "resource must be a mapping" },
+    { "string tasks",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":\"app\","
+      "\"attributes\":" ATTRS "}",
+      0, "task must be a mapping" },
+    { "integer command",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":[{\"command\":"
+      "42,\"slot\":\"task\",\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTRS "}",
+      0, "object of type 'int' has no len()" },
+    { "empty mapping command",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":[{\"command\":"
+      "{},\"slot\":\"task\",\"count\":{\"per_slot\":1}}],"
+      "\"attributes\":" ATTRS "}",
+      0, "command array cannot have length of zero" },
+    { "v1 with boolean duration",
+      "{\"version\":1,\"resources\":" RESOURCES ",\"tasks\":" TASKS
+      ",\"attributes\":{\"system\":{\"duration\":true}}}",
+      0, NULL },
+    { NULL, NULL, 0, NULL },
+};
+
+void run_tests (void)
+{
+    json_error_t error;
+    json_t *o;
+    int i;
+
+    for (i = 0; tests[i].desc != NULL; i++) {
+        if (!(o = json_loads (tests[i].jobspec, 0, &error)))
+            BAIL_OUT ("%s: %s", tests[i].desc, error.text);
+        memset (&error, 0, sizeof (error));
+        if (tests[i].error) {
+            ok (jobspec_validate (o, tests[i].require_version, &error) < 0
+                && !strcmp (error.text, tests[i].error),
+                "%s fails with '%s'", tests[i].desc, tests[i].error);
+            if (strcmp (error.text, tests[i].error) != 0)
+                diag ("got '%s'", error.text);
+        }
+        else {
+            ok (jobspec_validate (o, tests[i].require_version, &error) == 0,
+                "%s is valid", tests[i].desc);
+        }
+        json_decref (o);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    run_tests ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -10,12 +10,23 @@
 
 /* validate - asynchronous jobspec validation interface
  *
- * Spawn worker(s) to validate jobspec.  Up to 'DEFAULT_WORKER_COUNT'
- * workers may be active at one time.  They are started lazily, on demand,
- * and stop after a period of inactivity (see "tunables" below).
+ * If no validator executable is configured, jobspec is validated in
+ * the module by the built-in validator (see jobspec.c), and the future
+ * is fulfilled immediately.  If validator-args are given that only
+ * validate-jobspec.py understands, that is used as the validator instead.
  *
- * The validator executable and its command line, including the
- * location of jobspec.jsonschema, are currently hardwired.
+ * Otherwise spawn worker(s) to validate jobspec.  Up to
+ * 'DEFAULT_WORKER_COUNT' workers may be active at one time.  They are
+ * started lazily, on demand, and stop after a period of inactivity
+ * (see "tunables" below).
+ *
+ * Worker results are cached by hash of the normalized jobspec, so that
+ * identical jobspecs, as in an ensemble, are sent to a worker once.
+ * Requests that arrive while that jobspec is being validated share
+ * its result.  Only jobspecs that passed are remembered.  The cache
+ * size is set at creation, where zero disables it, and it may be
+ * flushed with validate_cache_flush(), e.g. when the validator's
+ * site policy has changed on config reload.
  *
  * Jobspec is expected to be in encoded JSON form, with or without
  * whitespace or NULL termination.  The encoding is normalized before
@@ -37,9 +48,11 @@
 #include <flux/core.h>
 
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/blobref.h"
 
 #include "validate.h"
 #include "worker.h"
+#include "jobspec.h"
 
 /* Tunables:
  */
@@ -57,12 +70,133 @@ const int worker_queue_threshold = 32;
 const double worker_inactivity_timeout = 5.0;
 
 
+/* Worker result for one jobspec.  While the worker is running, 'f' is
+ * its future and 'waiters' holds a reference on each future returned
+ * by validate_jobspec() for this jobspec.  Once the jobspec has passed,
+ * 'f' is NULL.
+ */
+struct vcache_entry {
+    struct validate *v;
+    char key[BLOBREF_MAX_STRING_SIZE];
+    flux_future_t *f;
+    zlist_t *waiters;
+};
 
 struct validate {
     flux_t *h;
+    bool native;                // use built-in validator, no workers
+    int require_version;        // built-in validator --require-version
+    zhashx_t *cache;            // jobspec hash => struct vcache_entry
+    int cache_max;              // max entries, 0 = validate every jobspec
     struct worker *worker[MAX_WORKER_COUNT];
 };
 
+static void vcache_entry_destroy (struct vcache_entry *e)
+{
+    if (e) {
+        int saved_errno = errno;
+        flux_future_t *f;
+        if (e->waiters) {
+            while ((f = zlist_pop (e->waiters)))
+                flux_future_decref (f);
+            zlist_destroy (&e->waiters);
+        }
+        flux_future_destroy (e->f);
+        free (e);
+        errno = saved_errno;
+    }
+}
+
+static void vcache_entry_destructor (void **item)
+{
+    if (item) {
+        vcache_entry_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct vcache_entry *vcache_entry_create (struct validate *v,
+                                                 const char *key)
+{
+    struct vcache_entry *e;
+
+    if (!(e = calloc (1, sizeof (*e))))
+        return NULL;
+    if (!(e->waiters = zlist_new ())) {
+        free (e);
+        errno = ENOMEM;
+        return NULL;
+    }
+    e->v = v;
+    strcpy (e->key, key);
+    return e;
+}
+
+/* Drop completed entries.  Those still being validated are kept,
+ * so their waiters get a result.
+ */
+static void vcache_drop_completed (struct validate *v)
+{
+    struct vcache_entry *e;
+    zlist_t *done;
+
+    if (!(done = zlist_new ()))
+        return;
+    e = zhashx_first (v->cache);
+    while (e) {
+        if (!e->f && zlist_append (done, e) < 0)
+            break;
+        e = zhashx_next (v->cache);
+    }
+    while ((e = zlist_pop (done)))
+        zhashx_delete (v->cache, e->key);
+    zlist_destroy (&done);
+}
+
+/* Drop completed entries once the cache is full.
+ */
+static void vcache_trim (struct validate *v)
+{
+    if (zhashx_size (v->cache) >= v->cache_max)
+        vcache_drop_completed (v);
+}
+
+void validate_cache_flush (struct validate *v)
+{
+    if (v->cache)
+        vcache_drop_completed (v);
+}
+
+/* Worker result is available.  Pass it on to all waiters.
+ * Forget the jobspec if it failed, so it is validated again next time.
+ */
+static void vcache_continuation (flux_future_t *f, void *arg)
+{
+    struct vcache_entry *e = arg;
+    struct validate *v = e->v;
+    flux_future_t *waiter;
+    const char *errstr = NULL;
+    int errnum = 0;
+
+    if (flux_future_get (f, NULL) < 0) {
+        errnum = errno;
+        errstr = flux_future_error_string (f);
+    }
+    while ((waiter = zlist_pop (e->waiters))) {
+        if (errnum)
+            flux_future_fulfill_error (waiter, errnum, errstr);
+        else
+            flux_future_fulfill (waiter, NULL, NULL);
+        flux_future_decref (waiter);
+    }
+    if (errnum)
+        zhashx_delete (v->cache, e->key); // destroys 'e' and 'f'
+    else {
+        flux_future_destroy (f);
+        e->f = NULL;
+    }
+}
+
 static void validate_killall (struct validate *v)
 {
     flux_future_t *cf = flux_future_wait_all_create ();
@@ -74,7 +208,7 @@ static void validate_killall (struct validate *v)
     }
     flux_future_set_flux (cf, v->h);
     for (i = 0; i < MAX_WORKER_COUNT; i++) {
-        if ((f = worker_kill (v->worker[i], SIGKILL)))
+        if (v->worker[i] && (f = worker_kill (v->worker[i], SIGKILL)))
             flux_future_push (cf, NULL, f);
     }
     /* Wait for up to 5s for response that signals have been delivered
@@ -94,8 +228,10 @@ int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg)
     int count;
 
     count = 0;
-    for (i = 0; i < MAX_WORKER_COUNT; i++)
-        count += worker_stop_notify (v->worker[i], cb, arg);
+    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+        if (v->worker[i])
+            count += worker_stop_notify (v->worker[i], cb, arg);
+    }
     return count;
 }
 
@@ -104,7 +240,9 @@ void validate_destroy (struct validate *v)
     if (v) {
         int saved_errno = errno;
         int i;
-        validate_killall (v);
+        if (!v->native)
+            validate_killall (v);
+        zhashx_destroy (&v->cache);
         for (i = 0; i < MAX_WORKER_COUNT; i++)
             worker_destroy (v->worker[i]);
         free (v);
@@ -121,9 +259,50 @@ static bool str_ends_with (const char *str, const char *suffix)
         (!strncmp ((str + str_len) - suffix_len, suffix, suffix_len));
 }
 
+/* The built-in validator understands validator-args=--require-version,1
+ * (or --require-version=1).  Return 1 if 'args' are understood, 0 if the
+ * validate-jobspec.py worker must be used instead, or -1 on error.
+ */
+static int validate_native_args (struct validate *v, const char *args)
+{
+    char *argz = NULL;
+    size_t argz_len = 0;
+    char *arg = NULL;
+    const char *val;
+    char *endptr;
+    long version;
+
+    if (!args || *args == '\0')
+        return 1;
+    if (argz_create_sep (args, ',', &argz, &argz_len) != 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    while ((arg = argz_next (argz, argz_len, arg))) {
+        val = NULL;
+        if (!strcmp (arg, "--require-version"))
+            val = arg = argz_next (argz, argz_len, arg);
+        else if (!strncmp (arg, "--require-version=", 18))
+            val = arg + 18;
+        if (!val)
+            goto unsupported;
+        errno = 0;
+        version = strtol (val, &endptr, 10);
+        if (errno != 0 || endptr == val || *endptr != '\0' || version != 1)
+            goto unsupported;
+        v->require_version = version;
+    }
+    free (argz);
+    return 1;
+unsupported:
+    free (argz);
+    return 0;
+}
+
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
-                                  const char *validator_args)
+                                  const char *validator_args,
+                                  int cache_max)
 {
     struct validate *v;
     char *argv[5];
@@ -137,7 +316,29 @@ struct validate *validate_create (flux_t *h,
         return NULL;
     v->h = h;
 
-    assert (validate_path != NULL);
+    if (!validate_path) {
+        int rc;
+        if ((rc = validate_native_args (v, validator_args)) < 0)
+            goto error;
+        if (rc > 0) {
+            v->native = true;
+            return v;
+        }
+        validate_path = flux_conf_builtin_get ("jobspec_validate_path",
+                                               FLUX_CONF_AUTO);
+        flux_log (h,
+                  LOG_INFO,
+                  "built-in validator does not support validator-args=%s,"
+                  " using %s",
+                  validator_args,
+                  validate_path);
+    }
+    v->cache_max = cache_max;
+    if (!(v->cache = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhashx_set_destructor (v->cache, vcache_entry_destructor);
 
     if (str_ends_with (validate_path, ".py"))
         argv[argc++] = PYTHON_INTERPRETER;
@@ -202,6 +403,67 @@ struct worker *select_best_worker (struct validate *v)
     return best;
 }
 
+static flux_future_t *validate_native (struct validate *v, json_t *jobspec)
+{
+    flux_future_t *f;
+    json_error_t error;
+
+    if (!(f = flux_future_create (NULL, NULL)))
+        return NULL;
+    flux_future_set_flux (f, v->h);
+    if (jobspec_validate (jobspec, v->require_version, &error) < 0)
+        flux_future_fulfill_error (f, EINVAL, error.text);
+    else
+        flux_future_fulfill (f, NULL, NULL);
+    return f;
+}
+
+/* Return a future for the worker result of encoded jobspec 's'.
+ * It is already fulfilled if the jobspec passed before.  Otherwise
+ * it is fulfilled when the (possibly already running) worker responds.
+ */
+static flux_future_t *validate_cached (struct validate *v, const char *s)
+{
+    char key[BLOBREF_MAX_STRING_SIZE];
+    struct vcache_entry *e;
+    struct worker *w;
+    flux_future_t *f;
+
+    if (blobref_hash ("sha1", s, strlen (s), key, sizeof (key)) < 0)
+        return NULL;
+    if (!(f = flux_future_create (NULL, NULL)))
+        return NULL;
+    flux_future_set_flux (f, v->h);
+    if ((e = zhashx_lookup (v->cache, key))) {
+        if (!e->f) {
+            flux_future_fulfill (f, NULL, NULL);
+            return f;
+        }
+    }
+    else {
+        if (!(e = vcache_entry_create (v, key)))
+            goto error;
+        w = select_best_worker (v);
+        assert (w != NULL);
+        if (!(e->f = worker_request (w, s))
+            || flux_future_then (e->f, -1., vcache_continuation, e) < 0) {
+            vcache_entry_destroy (e);
+            goto error;
+        }
+        vcache_trim (v);
+        (void)zhashx_insert (v->cache, key, e);
+    }
+    if (zlist_append (e->waiters, f) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    flux_future_incref (f);
+    return f;
+error:
+    flux_future_destroy (f);
+    return NULL;
+}
+
 /* Re-encode jobspec in compact form to eliminate any white space (esp \n),
  * then pass it to least busy validation worker, returning a future.
  */
@@ -209,15 +471,21 @@ flux_future_t *validate_jobspec (struct validate *v, json_t *jobspec)
 {
     flux_future_t *f;
     char *s;
-    struct worker *w;
 
+    if (v->native)
+        return validate_native (v, jobspec);
     if (!(s = json_dumps (jobspec, JSON_COMPACT))) {
         errno = ENOMEM;
         goto error;
     }
-    w = select_best_worker (v);
-    assert (w != NULL);
-    if (!(f = worker_request (w, s)))
+    if (v->cache_max == 0) {
+        struct worker *w = select_best_worker (v);
+        assert (w != NULL);
+        f = worker_request (w, s);
+    }
+    else
+        f = validate_cached (v, s);
+    if (!f)
         goto error;
     free (s);
     return f;
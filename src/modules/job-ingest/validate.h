@@ -28,9 +28,21 @@ flux_future_t *validate_jobspec (struct validate *v, json_t *jobspec);
  */
 int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg);
 
+/* Forget the results of completed validations, so that each jobspec
+ * is validated again when next submitted.
+ */
+void validate_cache_flush (struct validate *v);
+
+/* Create validation interface.  If 'validate_path' is NULL, the built-in
+ * validator is used, unless 'validator_args' are other than
+ * --require-version,1, in which case the default validate-jobspec.py
+ * worker is used with them.  Up to 'cache_max' results of a worker are
+ * cached (0 disables the cache).
+ */
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
-                                  const char *validator_args);
+                                  const char *validator_args,
+                                  int cache_max);
 
 void validate_destroy (struct validate *v);
 
@@ -645,6 +645,7 @@ int event_job_post_pack (struct event *event,
     /* call before eventlog_seq increment below */
     if (journal_process_event (event->ctx->journal,
                                job->id,
+                               job->userid,
                                eventlog_seq,
                                name,
                                entry) < 0)
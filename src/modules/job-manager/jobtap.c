@@ -83,6 +83,16 @@ static const char *jobtap_plugin_name (flux_plugin_t *p)
     return "unknown";
 }
 
+/*  Return true if a loaded plugin has a handler for 'topic'.
+ *  Callers skip building plugin args for topics with no handler, since
+ *   that is the common case for most job events.
+ */
+static bool jobtap_topic_handled (struct jobtap *jobtap, const char *topic)
+{
+    return jobtap->plugin
+           && flux_plugin_match_handler (jobtap->plugin, topic) != NULL;
+}
+
 static flux_plugin_arg_t *jobtap_args_create (struct jobtap *jobtap,
                                               struct job *job)
 {
@@ -147,7 +157,10 @@ int jobtap_get_priority (struct jobtap *jobtap,
         errno = EINVAL;
         return -1;
     }
-    if (!jobtap->plugin) {
+    if (!jobtap_topic_handled (jobtap, "job.priority.get")) {
+        /*
+         *  No priority.get callback: default priority == urgency
+         */
         *pprio = job->urgency;
         return 0;
     }
@@ -229,8 +242,7 @@ int jobtap_validate (struct jobtap *jobtap,
     flux_plugin_arg_t *args;
     const char *errmsg = NULL;
 
-    if (!jobtap->plugin
-        || !flux_plugin_match_handler (jobtap->plugin, "job.validate"))
+    if (!jobtap_topic_handled (jobtap, "job.validate"))
         return 0;
     if (!(args = jobtap_args_create (jobtap, job)))
         return -1;
@@ -266,9 +278,10 @@ int jobtap_call (struct jobtap *jobtap,
     int64_t priority = -1;
     va_list ap;
 
-    if (!jobtap->plugin) {
+    if (!jobtap_topic_handled (jobtap, topic)) {
         /*
-         * Default with no plugin: ensure we advance past PRIORITY state
+         * Default with no plugin handler for topic: ensure we advance
+         *  past PRIORITY state
          */
         if (job->state == FLUX_JOB_STATE_PRIORITY
            && reprioritize_job (jobtap->ctx, job, job->urgency) < 0)
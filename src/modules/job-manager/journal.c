@@ -14,6 +14,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <limits.h>
 #include <czmq.h>
 #include <jansson.h>
 #include <flux/core.h>
@@ -21,9 +22,14 @@
 #include "journal.h"
 
 #include "src/common/libeventlog/eventlog.h"
+#include "src/common/libjob/job_hash.h"
+#include "src/common/libutil/errno_safe.h"
 
 #define EVENTS_MAXLEN 1000
 
+/* Events are held as [name, userid, id, wrapped_entry] arrays, so that
+ * listener filters can be evaluated without decoding the wrapped entry.
+ */
 struct journal {
     struct job_manager *ctx;
     flux_msg_handler_t **handlers;
@@ -31,12 +37,32 @@ struct journal {
     /* holds most recent events for listeners */
     zlist_t *events;
     int events_maxlen;
+    /* events processed in this reactor loop iteration, sent to listeners
+     * from the prep watcher.  The same objects are at the tail of 'events'.
+     */
+    json_t *batch;
+    flux_watcher_t *prep;
 };
 
 struct journal_listener {
     const flux_msg_t *request;
     json_t *allow;
     json_t *deny;
+    uint32_t userid;    // only jobs of this user, unless FLUX_USERID_UNKNOWN
+    zhashx_t *ids;      // only these jobs, if non-NULL (updatable in-stream)
+    char *filter;       // allow/deny/userid encoded, listeners with equal
+                        //   filters and no 'ids' share one encoded response
+    int batch_start;    // first batch event not already sent as history
+    int credit;         // responses that may be sent, -1 = unlimited
+    json_t *backlog;    // events held while credit is exhausted
+};
+
+/* One encoded response, shared by listeners with the same filter that
+ * joined the same batch.
+ */
+struct journal_response {
+    json_t *events;
+    char *payload;
 };
 
 static bool allow_deny_check (struct journal_listener *jl, const char *name)
@@ -57,6 +83,36 @@ static bool allow_deny_check (struct journal_listener *jl, const char *name)
     return add_entry;
 }
 
+static bool journal_listener_check (struct journal_listener *jl,
+                                    const char *name,
+                                    uint32_t userid,
+                                    flux_jobid_t id)
+{
+    if (jl->userid != FLUX_USERID_UNKNOWN && jl->userid != userid)
+        return false;
+    if (jl->ids && !zhashx_lookup (jl->ids, &id))
+        return false;
+    return allow_deny_check (jl, name);
+}
+
+static int journal_event_unpack (json_t *event,
+                                 const char **name,
+                                 uint32_t *userid,
+                                 flux_jobid_t *id,
+                                 json_t **wrapped_entry)
+{
+    json_int_t i;
+    int u;
+
+    if (json_unpack (event, "[siIo]", name, &u, &i, wrapped_entry) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    *userid = u;
+    *id = i;
+    return 0;
+}
+
 /* wrap the eventlog entry in another object with the job id and
  * eventlog_seq.
  *
@@ -83,6 +139,240 @@ static json_t *wrap_events_entry (flux_jobid_t id,
     return wrapped_entry;
 }
 
+/* Hold events array 'a' in the backlog of a listener that has run out
+ * of credit.  Events held in the backlog are sent in a single response
+ * when credit is granted.  The backlog holds no more than the journal
+ * history, so fail with EOVERFLOW if that would be exceeded.
+ */
+static int journal_listener_hold (struct journal *journal,
+                                  struct journal_listener *jl,
+                                  json_t *a)
+{
+    if (json_array_size (jl->backlog) + json_array_size (a)
+        > (size_t)journal->events_maxlen) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    if (!jl->backlog && !(jl->backlog = json_array ()))
+        goto nomem;
+    if (json_array_extend (jl->backlog, a) < 0)
+        goto nomem;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* End the stream of a listener whose backlog has overflowed.
+ * The caller removes the listener.
+ */
+static void journal_listener_overflow (flux_t *h, struct journal_listener *jl)
+{
+    const char *errmsg = "too many events held waiting for credit";
+
+    if (flux_respond_error (h, jl->request, EOVERFLOW, errmsg) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
+/* Send events array 'a' to listener, or hold it in the backlog if the
+ * listener has run out of credit.
+ */
+static int journal_listener_send (struct journal *journal,
+                                  struct journal_listener *jl,
+                                  json_t *a)
+{
+    if (jl->credit == 0)
+        return journal_listener_hold (journal, jl, a);
+    if (flux_respond_pack (journal->ctx->h,
+                           jl->request,
+                           "{s:O}",
+                           "events", a) < 0)
+        return -1;
+    if (jl->credit > 0)
+        jl->credit--;
+    return 0;
+}
+
+static void journal_response_destroy (void **item)
+{
+    if (item) {
+        struct journal_response *rsp = *item;
+        if (rsp) {
+            json_decref (rsp->events);
+            free (rsp->payload);
+            free (rsp);
+        }
+        *item = NULL;
+    }
+}
+
+/* Collect the batch events that pass the filter of listener 'jl'.
+ * rsp->events is left NULL if there are none.
+ */
+static struct journal_response *journal_response_create (struct journal *journal,
+                                                         struct journal_listener *jl)
+{
+    struct journal_response *rsp;
+    size_t index;
+    json_t *event;
+
+    if (!(rsp = calloc (1, sizeof (*rsp))))
+        return NULL;
+    json_array_foreach (journal->batch, index, event) {
+        const char *name;
+        uint32_t userid;
+        flux_jobid_t id;
+        json_t *wrapped_entry;
+
+        if (index < (size_t)jl->batch_start
+            || journal_event_unpack (event,
+                                     &name,
+                                     &userid,
+                                     &id,
+                                     &wrapped_entry) < 0
+            || !journal_listener_check (jl, name, userid, id))
+            continue;
+        if (!rsp->events && !(rsp->events = json_array ()))
+            goto nomem;
+        if (json_array_append (rsp->events, wrapped_entry) < 0)
+            goto nomem;
+    }
+    return rsp;
+nomem:
+    journal_response_destroy ((void **)&rsp);
+    errno = ENOMEM;
+    return NULL;
+}
+
+static const char *journal_response_payload (struct journal_response *rsp)
+{
+    json_t *o;
+
+    if (!rsp->payload) {
+        if (!(o = json_pack ("{s:O}", "events", rsp->events)))
+            goto nomem;
+        rsp->payload = json_dumps (o, JSON_COMPACT);
+        json_decref (o);
+        if (!rsp->payload)
+            goto nomem;
+    }
+    return rsp->payload;
+nomem:
+    errno = ENOMEM;
+    return NULL;
+}
+
+static int create_zlist_and_append (zlist_t **lp, void *item)
+{
+    if (!*lp && !(*lp = zlist_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (zlist_append (*lp, item) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+/* Send the events processed in this reactor loop iteration.  Each
+ * listener gets at most one response, and that response is encoded once
+ * for all listeners with the same filter and batch_start.  Listeners
+ * with a jobid set get a response of their own.
+ */
+static void journal_flush (struct journal *journal)
+{
+    flux_t *h = journal->ctx->h;
+    struct journal_listener *jl;
+    zhashx_t *responses;
+    zlist_t *overflow = NULL;
+
+    if (json_array_size (journal->batch) == 0)
+        return;
+    if (!(responses = zhashx_new ())) {
+        flux_log (h, LOG_ERR, "%s: out of memory", __FUNCTION__);
+        goto done;
+    }
+    zhashx_set_destructor (responses, journal_response_destroy);
+
+    jl = zlist_first (journal->listeners);
+    while (jl) {
+        struct journal_response *rsp;
+        struct journal_response *private = NULL;
+        const char *payload;
+        char *key;
+
+        if (jl->ids) {
+            if (!(rsp = private = journal_response_create (journal, jl))) {
+                flux_log_error (h, "%s: journal_response_create",
+                                __FUNCTION__);
+                goto next;
+            }
+            goto send;
+        }
+        if (asprintf (&key, "%d:%s", jl->batch_start, jl->filter) < 0) {
+            flux_log_error (h, "%s: asprintf", __FUNCTION__);
+            goto next;
+        }
+        if (!(rsp = zhashx_lookup (responses, key))) {
+            if (!(rsp = journal_response_create (journal, jl))) {
+                flux_log_error (h, "%s: journal_response_create",
+                                __FUNCTION__);
+                free (key);
+                goto next;
+            }
+            (void)zhashx_insert (responses, key, rsp);
+        }
+        free (key);
+send:
+        if (!rsp->events)
+            goto next;
+        if (jl->credit == 0) {
+            if (journal_listener_hold (journal, jl, rsp->events) < 0) {
+                /* cannot remove from zlist while iterating, so we
+                 * store off listeners to end on another list */
+                if (errno != EOVERFLOW
+                    || create_zlist_and_append (&overflow, jl) < 0)
+                    flux_log_error (h, "%s: journal_listener_hold",
+                                    __FUNCTION__);
+            }
+            goto next;
+        }
+        if (!(payload = journal_response_payload (rsp))
+            || flux_respond (h, jl->request, payload) < 0) {
+            flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+            goto next;
+        }
+        if (jl->credit > 0)
+            jl->credit--;
+next:
+        journal_response_destroy ((void **)&private);
+        jl->batch_start = 0;
+        jl = zlist_next (journal->listeners);
+    }
+    zhashx_destroy (&responses);
+    if (overflow) {
+        while ((jl = zlist_pop (overflow))) {
+            journal_listener_overflow (h, jl);
+            zlist_remove (journal->listeners, jl);
+        }
+        zlist_destroy (&overflow);
+    }
+done:
+    json_array_clear (journal->batch);
+}
+
+static void journal_prep_cb (flux_reactor_t *r,
+                             flux_watcher_t *w,
+                             int revents,
+                             void *arg)
+{
+    struct journal *journal = arg;
+
+    journal_flush (journal);
+    flux_watcher_stop (w);
+}
+
 static void json_decref_wrapper (void *data)
 {
     json_t *o = (json_t *)data;
@@ -91,38 +381,38 @@ static void json_decref_wrapper (void *data)
 
 int journal_process_event (struct journal *journal,
                            flux_jobid_t id,
+                           uint32_t userid,
                            int eventlog_seq,
                            const char *name,
                            json_t *entry)
 {
-    struct journal_listener *jl;
     json_t *wrapped_entry = NULL;
+    json_t *event = NULL;
     int saved_errno;
 
     if (!(wrapped_entry = wrap_events_entry (id, eventlog_seq, entry)))
         goto error;
+    if (!(event = json_pack ("[siIO]", name, (int)userid, id, wrapped_entry)))
+        goto nomem;
 
-    jl = zlist_first (journal->listeners);
-    while (jl) {
-        if (allow_deny_check (jl, name)) {
-            if (flux_respond_pack (journal->ctx->h, jl->request,
-                                   "{s:[O]}", "events", wrapped_entry) < 0)
-                flux_log_error (journal->ctx->h, "%s: flux_respond_pack",
-                                __FUNCTION__);
-        }
-        jl = zlist_next (journal->listeners);
+    /* listeners are sent this event from the prep watcher */
+    if (zlist_size (journal->listeners) > 0) {
+        if (json_array_append (journal->batch, event) < 0)
+            goto nomem;
+        flux_watcher_start (journal->prep);
     }
 
     if (zlist_size (journal->events) > journal->events_maxlen)
         zlist_remove (journal->events, zlist_head (journal->events));
-    if (zlist_append (journal->events, json_incref (wrapped_entry)) < 0)
+    if (zlist_append (journal->events, json_incref (event)) < 0)
         goto nomem;
     zlist_freefn (journal->events,
-                  wrapped_entry,
+                  event,
                   json_decref_wrapper,
                   true);
 
     json_decref (wrapped_entry);
+    json_decref (event);
     return 0;
 
 nomem:
@@ -130,6 +420,7 @@ nomem:
 error:
     saved_errno = errno;
     json_decref (wrapped_entry);
+    json_decref (event);
     errno = saved_errno;
     return -1;
 }
@@ -142,14 +433,128 @@ static void journal_listener_destroy (void *data)
         flux_msg_decref (jl->request);
         json_decref (jl->allow);
         json_decref (jl->deny);
+        zhashx_destroy (&jl->ids);
+        free (jl->filter);
+        json_decref (jl->backlog);
         free (jl);
         errno = saved_errno;
     }
 }
 
+static void jobid_destructor (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+/* Add the jobids in array 'a' to 'ids'.  If 'added' is non-NULL, the
+ * jobids that were not already in 'ids' are also inserted there.
+ */
+static int ids_add (zhashx_t *ids, json_t *a, zhashx_t *added)
+{
+    size_t index;
+    json_t *value;
+
+    if (!json_is_array (a)) {
+        errno = EPROTO;
+        return -1;
+    }
+    json_array_foreach (a, index, value) {
+        flux_jobid_t key;
+        flux_jobid_t *id;
+
+        if (!json_is_integer (value)) {
+            errno = EPROTO;
+            return -1;
+        }
+        key = json_integer_value (value);
+        if (zhashx_lookup (ids, &key))
+            continue;
+        if (!(id = malloc (sizeof (*id))))
+            return -1;
+        *id = key;
+        if (zhashx_insert (ids, id, id) < 0
+            || (added && zhashx_insert (added, id, id) < 0)) {
+            if (!zhashx_lookup (ids, id))
+                free (id);
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int ids_remove (zhashx_t *ids, json_t *a)
+{
+    size_t index;
+    json_t *value;
+
+    if (!json_is_array (a)) {
+        errno = EPROTO;
+        return -1;
+    }
+    json_array_foreach (a, index, value) {
+        flux_jobid_t key;
+
+        if (!json_is_integer (value)) {
+            errno = EPROTO;
+            return -1;
+        }
+        key = json_integer_value (value);
+        zhashx_delete (ids, &key);
+    }
+    return 0;
+}
+
+static zhashx_t *ids_create (json_t *a)
+{
+    zhashx_t *ids;
+
+    if (!(ids = job_hash_create ()))
+        return NULL;
+    zhashx_set_destructor (ids, jobid_destructor);
+    if (ids_add (ids, a, NULL) < 0) {
+        int saved_errno = errno;
+        zhashx_destroy (&ids);
+        errno = saved_errno;
+        return NULL;
+    }
+    return ids;
+}
+
+/* Encode allow/deny/userid so that listeners with equal filters compare
+ * equal.
+ */
+static char *filter_encode (json_t *allow, json_t *deny, uint32_t userid)
+{
+    char *a = NULL;
+    char *d = NULL;
+    char *filter = NULL;
+    int flags = JSON_COMPACT | JSON_SORT_KEYS;
+
+    if ((allow && !(a = json_dumps (allow, flags)))
+        || (deny && !(d = json_dumps (deny, flags)))
+        || asprintf (&filter,
+                     "%s:%s:%ju",
+                     a ? a : "",
+                     d ? d : "",
+                     (uintmax_t)userid) < 0) {
+        filter = NULL;
+        errno = ENOMEM;
+    }
+    free (a);
+    free (d);
+    return filter;
+}
+
 static struct journal_listener *journal_listener_create (const flux_msg_t *msg,
                                                          json_t *allow,
-                                                         json_t *deny)
+                                                         json_t *deny,
+                                                         uint32_t userid,
+                                                         json_t *ids,
+                                                         int credit)
 {
     struct journal_listener *jl;
 
@@ -158,12 +563,75 @@ static struct journal_listener *journal_listener_create (const flux_msg_t *msg,
     jl->request = flux_msg_incref (msg);
     jl->allow = json_incref (allow);
     jl->deny = json_incref (deny);
+    jl->userid = userid;
+    jl->credit = credit;
+    if (ids && !(jl->ids = ids_create (ids)))
+        goto error;
+    if (!(jl->filter = filter_encode (allow, deny, userid)))
+        goto error;
     return jl;
  error:
     journal_listener_destroy (jl);
     return NULL;
 }
 
+/* Send listener 'jl' the events in the history that pass its filter.
+ * If 'added' is non-NULL, only events for those jobs are sent, and events
+ * still in the batch are left for journal_flush() to send.
+ */
+static int journal_listener_send_history (struct journal *journal,
+                                          struct journal_listener *jl,
+                                          zhashx_t *added)
+{
+    json_t *a = NULL;
+    json_t *event;
+    size_t count = zlist_size (journal->events);
+    size_t index = 0;
+
+    if (added) {
+        size_t unflushed = json_array_size (journal->batch) - jl->batch_start;
+        count = count > unflushed ? count - unflushed : 0;
+    }
+    event = zlist_first (journal->events);
+    while (event && index++ < count) {
+        const char *name;
+        uint32_t userid;
+        flux_jobid_t id;
+        json_t *wrapped_entry;
+
+        if (journal_event_unpack (event,
+                                  &name,
+                                  &userid,
+                                  &id,
+                                  &wrapped_entry) < 0) {
+            flux_log (journal->ctx->h, LOG_ERR, "invalid wrapped entry");
+            goto error;
+        }
+        if ((!added || zhashx_lookup (added, &id))
+            && journal_listener_check (jl, name, userid, id)) {
+            if (!a) {
+                if (!(a = json_array ()))
+                    goto nomem;
+            }
+            if (json_array_append (a, wrapped_entry) < 0)
+                goto nomem;
+        }
+        event = zlist_next (journal->events);
+    }
+
+    if (a && json_array_size (a) > 0) {
+        if (journal_listener_send (journal, jl, a) < 0)
+            goto error;
+    }
+    json_decref (a);
+    return 0;
+nomem:
+    errno = ENOMEM;
+error:
+    json_decref (a);
+    return -1;
+}
+
 static void journal_handle_request (flux_t *h,
                                     flux_msg_handler_t *mh,
                                     const flux_msg_t *msg,
@@ -172,15 +640,21 @@ static void journal_handle_request (flux_t *h,
     struct job_manager *ctx = arg;
     struct journal *journal = ctx->journal;
     struct journal_listener *jl = NULL;
+    struct flux_msg_cred cred;
     const char *errstr = NULL;
     json_t *allow = NULL;
     json_t *deny = NULL;
-    json_t *a = NULL;
-    json_t *wrapped_entry;
+    json_t *ids = NULL;
+    int userid = FLUX_USERID_UNKNOWN;
+    int credit = -1;
 
-    if (flux_request_unpack (msg, NULL, "{s?o s?o}",
+    if (flux_request_unpack (msg, NULL, "{s?o s?o s?o s?i s?i}",
                              "allow", &allow,
-                             "deny", &deny) < 0)
+                             "deny", &deny,
+                             "ids", &ids,
+                             "userid", &userid,
+                             "credit", &credit) < 0
+        || flux_msg_get_cred (msg, &cred) < 0)
         goto error;
 
     if (!flux_msg_is_streaming (msg)) {
@@ -201,57 +675,60 @@ static void journal_handle_request (flux_t *h,
         goto error;
     }
 
-    if (!(jl = journal_listener_create (msg, allow, deny)))
+    if (ids && !json_is_array (ids)) {
+        errno = EPROTO;
+        errstr = "job-manager.events ids should be an array";
         goto error;
+    }
 
-    if (zlist_append (journal->listeners, jl) < 0) {
-        errno = ENOMEM;
+    if (credit == 0 || credit < -1) {
+        errno = EPROTO;
+        errstr = "job-manager.events credit should be positive";
         goto error;
     }
-    zlist_freefn (journal->listeners, jl, journal_listener_destroy, true);
-
-    wrapped_entry = zlist_first (journal->events);
-    while (wrapped_entry) {
-        const char *name;
 
-        if (json_unpack (wrapped_entry,
-                         "{s:{s:s}}",
-                         "entry",
-                           "name", &name) < 0) {
-            flux_log (ctx->h, LOG_ERR, "invalid wrapped entry");
-            goto error;
-        }
+    /* Security: guests only see events for jobs that they submitted.
+     */
+    if (!(cred.rolemask & FLUX_ROLE_OWNER)
+        && userid == FLUX_USERID_UNKNOWN)
+        userid = cred.userid;
+    if (flux_msg_cred_authorize (cred, userid) < 0) {
+        errstr = "guests can only watch their own jobs";
+        goto error;
+    }
 
-        if (allow_deny_check (jl, name)) {
-            if (!a) {
-                if (!(a = json_array ()))
-                    goto nomem;
-            }
-            if (json_array_append (a, wrapped_entry) < 0)
-                goto nomem;
-        }
-        wrapped_entry = zlist_next (journal->events);
+    if (!(jl = journal_listener_create (msg,
+                                        allow,
+                                        deny,
+                                        userid,
+                                        ids,
+                                        credit))) {
+        if (errno == EPROTO)
+            errstr = "job-manager.events ids should be an array of jobids";
+        goto error;
     }
+    /* events already batched are sent below from the history */
+    jl->batch_start = json_array_size (journal->batch);
 
-    if (a && json_array_size (a) > 0) {
-        if (flux_respond_pack (ctx->h, jl->request,
-                               "{s:O}", "events", a) < 0) {
-            flux_log_error (ctx->h, "%s: flux_respond_pack",
-                            __FUNCTION__);
-            goto error;
-        }
+    if (zlist_append (journal->listeners, jl) < 0) {
+        errno = ENOMEM;
+        goto error;
     }
+    zlist_freefn (journal->listeners, jl, journal_listener_destroy, true);
 
-    json_decref (a);
+    if (journal_listener_send_history (journal, jl, NULL) < 0) {
+        flux_log_error (ctx->h, "%s: journal_listener_send_history",
+                        __FUNCTION__);
+        zlist_remove (journal->listeners, jl);
+        jl = NULL;
+        goto error;
+    }
     return;
 
-nomem:
-    errno = ENOMEM;
 error:
     if (flux_respond_error (h, msg, errno, errstr) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
     journal_listener_destroy (jl);
-    json_decref (a);
 }
 
 static bool match_journal_listener (struct journal_listener *jl,
@@ -299,17 +776,135 @@ static void journal_cancel_request (flux_t *h, flux_msg_handler_t *mh,
     free (sender);
 }
 
-static int create_zlist_and_append (zlist_t **lp, void *item)
+/* Grant more credit to a listener and send any held events.
+ */
+static void journal_credit_request (flux_t *h, flux_msg_handler_t *mh,
+                                    const flux_msg_t *msg, void *arg)
 {
-    if (!*lp && !(*lp = zlist_new ())) {
-        errno = ENOMEM;
-        return -1;
+    struct job_manager *ctx = arg;
+    struct journal *journal = ctx->journal;
+    struct journal_listener *jl;
+    uint32_t matchtag;
+    int credit;
+    char *sender = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s:i s:i}",
+                             "matchtag", &matchtag,
+                             "credit", &credit) < 0
+        || flux_msg_get_route_first (msg, &sender) < 0) {
+        flux_log_error (h, "error decoding events-journal-credit request");
+        return;
     }
-    if (zlist_append (*lp, item) < 0) {
-        errno = ENOMEM;
-        return -1;
+    jl = zlist_first (journal->listeners);
+    while (jl) {
+        if (match_journal_listener (jl, matchtag, sender))
+            break;
+        jl = zlist_next (journal->listeners);
     }
-    return 0;
+    if (jl && jl->credit >= 0 && credit > 0) {
+        /* clamp, so that large grants cannot overflow into "unlimited" */
+        jl->credit = (jl->credit > INT_MAX - credit)
+            ? INT_MAX : jl->credit + credit;
+        if (jl->backlog) {
+            json_t *a = jl->backlog;
+            jl->backlog = NULL;
+            if (journal_listener_send (journal, jl, a) < 0)
+                flux_log_error (h, "%s: journal_listener_send", __FUNCTION__);
+            json_decref (a);
+        }
+    }
+    free (sender);
+}
+
+static bool is_jobid_array (json_t *a)
+{
+    size_t index;
+    json_t *value;
+
+    if (!json_is_array (a))
+        return false;
+    json_array_foreach (a, index, value) {
+        if (!json_is_integer (value))
+            return false;
+    }
+    return true;
+}
+
+/* Add jobs to, or remove jobs from, the jobid set of a listener.  Events
+ * for added jobs that are still in the history are sent right away, so
+ * a client may subscribe to a job after it has started producing events.
+ * Only a stream opened with 'ids' has a jobid set to update.  The request
+ * gets a response, empty on success, unless sent with FLUX_RPC_NORESPONSE.
+ */
+static void journal_update_request (flux_t *h, flux_msg_handler_t *mh,
+                                    const flux_msg_t *msg, void *arg)
+{
+    struct job_manager *ctx = arg;
+    struct journal *journal = ctx->journal;
+    struct journal_listener *jl;
+    uint32_t matchtag;
+    json_t *add_ids = NULL;
+    json_t *remove_ids = NULL;
+    zhashx_t *added = NULL;
+    char *sender = NULL;
+    const char *errstr = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s:i s?o s?o}",
+                             "matchtag", &matchtag,
+                             "add", &add_ids,
+                             "remove", &remove_ids) < 0
+        || flux_msg_get_route_first (msg, &sender) < 0)
+        goto error;
+    if ((add_ids && !is_jobid_array (add_ids))
+        || (remove_ids && !is_jobid_array (remove_ids))) {
+        errstr = "add and remove should be arrays of jobids";
+        errno = EPROTO;
+        goto error;
+    }
+    jl = zlist_first (journal->listeners);
+    while (jl) {
+        if (match_journal_listener (jl, matchtag, sender))
+            break;
+        jl = zlist_next (journal->listeners);
+    }
+    if (!jl) {
+        errstr = "no such events-journal stream";
+        errno = ENOENT;
+        goto error;
+    }
+    if (!jl->ids) {
+        errstr = "events-journal stream was not opened with ids";
+        errno = EINVAL;
+        goto error;
+    }
+    if (remove_ids && ids_remove (jl->ids, remove_ids) < 0)
+        goto error;
+    if (add_ids) {
+        if (!(added = job_hash_create ())
+            || ids_add (jl->ids, add_ids, added) < 0)
+            goto error;
+        if (zhashx_size (added) > 0
+            && journal_listener_send_history (journal, jl, added) < 0) {
+            if (errno == EOVERFLOW) {
+                journal_listener_overflow (h, jl);
+                zlist_remove (journal->listeners, jl);
+                errstr = "events-journal stream ended: "
+                         "too many events held waiting for credit";
+                errno = EOVERFLOW;
+            }
+            goto error;
+        }
+    }
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "error responding to events-journal-update");
+    zhashx_destroy (&added);
+    free (sender);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to events-journal-update");
+    ERRNO_SAFE_WRAP (zhashx_destroy, &added);
+    ERRNO_SAFE_WRAP (free, sender);
 }
 
 void journal_listeners_disconnect_rpc (flux_t *h,
@@ -357,7 +952,10 @@ void journal_ctx_destroy (struct journal *journal)
     if (journal) {
         int saved_errno = errno;
         flux_msg_handler_delvec (journal->handlers);
+        flux_watcher_destroy (journal->prep);
         if (journal->listeners) {
+            if (journal->batch)
+                journal_flush (journal);
             struct journal_listener *jl;
             while ((jl = zlist_pop (journal->listeners))) {
                 if (flux_respond_error (journal->ctx->h,
@@ -371,6 +969,7 @@ void journal_ctx_destroy (struct journal *journal)
         }
         if (journal->events)
             zlist_destroy (&journal->events);
+        json_decref (journal->batch);
         free (journal);
         errno = saved_errno;
     }
@@ -381,13 +980,25 @@ static const struct flux_msg_handler_spec htab[] = {
         FLUX_MSGTYPE_REQUEST,
         "job-manager.events-journal",
         journal_handle_request,
-        0
+        FLUX_ROLE_USER
     },
     {
         FLUX_MSGTYPE_REQUEST,
         "job-manager.events-journal-cancel",
         journal_cancel_request,
-        0
+        FLUX_ROLE_USER
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.events-journal-credit",
+        journal_credit_request,
+        FLUX_ROLE_USER
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "job-manager.events-journal-update",
+        journal_update_request,
+        FLUX_ROLE_USER
     },
     FLUX_MSGHANDLER_TABLE_END,
 };
@@ -406,6 +1017,12 @@ struct journal *journal_ctx_create (struct job_manager *ctx)
         goto nomem;
     if (!(journal->events = zlist_new ()))
         goto nomem;
+    if (!(journal->batch = json_array ()))
+        goto nomem;
+    if (!(journal->prep = flux_prepare_watcher_create (flux_get_reactor (ctx->h),
+                                                       journal_prep_cb,
+                                                       journal)))
+        goto error;
     journal->events_maxlen = EVENTS_MAXLEN;
 
     if (flux_conf_unpack (flux_get_conf (ctx->h),
@@ -19,10 +19,12 @@
 #include "job-manager.h"
 
 /* Process the event by sending to any listeners that request the
- * event and append to the journal history.
+ * event and append to the journal history.  'userid' is the owner of
+ * job 'id', for listeners that filter by user.
  */
 int journal_process_event (struct journal *journal,
                            flux_jobid_t id,
+                           uint32_t userid,
                            int eventlog_seq,
                            const char *name,
                            json_t *entry);
@@ -143,6 +143,7 @@ static int submit_post_event (struct job_manager *ctx, struct job *job)
     /* call before eventlog_seq increment below */
     if (journal_process_event (ctx->journal,
                                job->id,
+                               job->userid,
                                job->eventlog_seq,
                                "submit",
                                entry) < 0)
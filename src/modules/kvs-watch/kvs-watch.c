@@ -13,6 +13,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <limits.h>
 #include <czmq.h>
 #include <jansson.h>
 #include <flux/core.h>
@@ -32,6 +33,8 @@ struct watcher {
     bool initial_rpc_sent;      // flag is initial watch rpc sent
     bool initial_rpc_received;  // flag is initial watch rpc received
     bool finished;              // flag indicates if watcher is finished
+    bool deferred;              // lookup deferred while out of credit
+    int credit;                 // responses that may be sent, -1 = unlimited
     int initial_rootseq;        // initial rootseq returned by initial rpc
     char *key;                  // lookup key
     int flags;                  // kvs_lookup flags
@@ -110,6 +113,7 @@ static struct watcher *watcher_create (const flux_msg_t *msg, const char *key,
         goto error_nomem;
     w->flags = flags;
     w->rootseq = -1;
+    w->credit = -1;
     return w;
 error_nomem:
     errno = ENOMEM;
@@ -226,6 +230,13 @@ static bool array_match (json_t *a, const char *key)
 
 static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
 {
+    flux_future_t *f;
+
+    /* discard completed lookups held back for lack of credit */
+    while ((f = zlist_first (w->lookups)) && flux_future_is_ready (f)) {
+        f = zlist_pop (w->lookups);
+        flux_future_destroy (f);
+    }
     /* wait for all in flight lookups to complete before destroying watcher */
     if (zlist_size (w->lookups) == 0) {
         zlist_remove (nsm->watchers, w);
@@ -237,6 +248,19 @@ static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
         zhash_delete (nsm->ctx->namespaces, nsm->ns_name);
 }
 
+/* Send a value response to the watcher, consuming one credit.
+ */
+static int watcher_respond_val (flux_t *h, struct watcher *w, json_t *val)
+{
+    if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        return -1;
+    }
+    if (w->credit > 0)
+        w->credit--;
+    return 0;
+}
+
 static int handle_initial_response (flux_t *h,
                                     struct watcher *w,
                                     json_t *val,
@@ -257,10 +281,8 @@ static int handle_initial_response (flux_t *h,
         }
     }
 
-    if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
-        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    if (watcher_respond_val (h, w, val) < 0)
         return -1;
-    }
 
     w->initial_rootseq = root_seq;
     w->responded = true;
@@ -277,10 +299,8 @@ static int handle_compare_response (flux_t *h,
          * ENOENT case */
         w->prev = json_incref (val);
 
-        if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        if (watcher_respond_val (h, w, val) < 0)
             return -1;
-        }
 
         w->responded = true;
     }
@@ -293,10 +313,8 @@ static int handle_compare_response (flux_t *h,
         json_decref (w->prev);
         w->prev = json_incref (val);
 
-        if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        if (watcher_respond_val (h, w, val) < 0)
             return -1;
-        }
     }
 
     return 0;
@@ -317,10 +335,8 @@ static int handle_append_response (flux_t *h,
             return -1;
         }
 
-        if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        if (watcher_respond_val (h, w, val) < 0)
             return -1;
-        }
 
         w->responded = true;
     }
@@ -358,11 +374,11 @@ static int handle_append_response (flux_t *h,
         free (new_data);
         w->append_offset = new_offset;
 
-        if (flux_respond_pack (h, w->request, "{ s:o }", "val", new_val) < 0) {
+        if (watcher_respond_val (h, w, new_val) < 0) {
             json_decref (new_val);
-            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
             return -1;
         }
+        json_decref (new_val);
     }
 
     return 0;
@@ -372,10 +388,8 @@ static int handle_normal_response (flux_t *h,
                                    struct watcher *w,
                                    json_t *val)
 {
-    if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
-        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    if (watcher_respond_val (h, w, val) < 0)
         return -1;
-    }
 
     w->responded = true;
     return 0;
@@ -485,16 +499,17 @@ error:
     w->finished = true;
 }
 
-/* One lookup has completed.
- * Pop ready futures off w->lookups and send responses, until
- * the list is empty, or a non-ready future is encountered.
+/* Pop ready futures off w->lookups and send responses, until
+ * the list is empty, a non-ready future is encountered, or the
+ * watcher runs out of credit.
  */
-static void lookup_continuation (flux_future_t *f, void *arg)
+static void lookup_drain (struct watcher *w)
 {
-    struct watcher *w = arg;
-    struct ns_monitor *nsm = w->nsm;
+    flux_future_t *f;
 
-    while ((f = zlist_first (w->lookups)) && flux_future_is_ready (f)) {
+    while ((f = zlist_first (w->lookups))
+           && flux_future_is_ready (f)
+           && (w->credit != 0 || w->finished)) {
         f = zlist_pop (w->lookups);
         if (!w->finished)
             handle_lookup_response (f, w);
@@ -508,6 +523,16 @@ static void lookup_continuation (flux_future_t *f, void *arg)
             && !(w->flags & FLUX_KVS_WATCH))
             w->finished = true;
     }
+}
+
+/* One lookup has completed.
+ */
+static void lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct watcher *w = arg;
+    struct ns_monitor *nsm = w->nsm;
+
+    lookup_drain (w);
     if (w->finished)
         watcher_cleanup (nsm, w);
 }
@@ -550,9 +575,9 @@ static flux_future_t *lookupat (flux_t *h,
                            "rootdir", o) < 0)
             goto error;
     }
-    /* N.B. Since this module is authenticated to the shmem:// connector
-     * with FLUX_ROLE_OWNER, we are allowed to switch the message credentials
-     * in this request message, and not be overridden at the connector,
+    /* N.B. Since the broker assigns this module's channel FLUX_ROLE_OWNER,
+     * we are allowed to switch the message credentials in this request
+     * message, and they are not overridden when the broker receives it,
      * as would be the case if we were not sufficiently privileged.
      */
     if (flux_msg_set_cred (msg, w->cred) < 0)
@@ -662,10 +687,20 @@ static void watcher_respond (struct ns_monitor *nsm, struct watcher *w)
      *
      * Note on FLUX_KVS_WATCH_FULL: A lookup / comparison is done on every
      * change.
+     *
+     * Flow control: if the watcher has as many lookups in flight as it
+     * has credit, defer the lookup.  When credit is granted, one lookup
+     * at the current root picks up all changes made in the meantime.
      */
     if (w->rootseq == -1
+        || w->deferred
         || (w->flags & FLUX_KVS_WATCH_FULL)
         || array_match (nsm->commit->keys, w->key)) {
+        if (w->credit >= 0 && zlist_size (w->lookups) >= w->credit) {
+            w->deferred = true;
+            return;
+        }
+        w->deferred = false;
         if (process_lookup_response (nsm, w) < 0)
             goto error_respond;
     }
@@ -830,45 +865,80 @@ done:
     watcher_respond_ns (nsm);
 }
 
+/* Update namespace with new commit info.
+ */
+static void setroot_update (struct watch_ctx *ctx,
+                            const char *ns,
+                            int rootseq,
+                            const char *rootref,
+                            int owner,
+                            json_t *keys)
+{
+    struct ns_monitor *nsm;
+    struct commit *commit;
+
+    if (!(nsm = zhash_lookup (ctx->namespaces, ns))
+            || (nsm->commit && rootseq <= nsm->commit->rootseq))
+        return;
+    if (!(commit = commit_create (rootref, rootseq, keys))) {
+        flux_log_error (ctx->h, "%s: error creating commit", __FUNCTION__);
+        nsm->errnum = errno;
+        goto done;
+    }
+    commit_destroy (nsm->commit);
+    nsm->commit = commit;
+    if (nsm->owner == FLUX_USERID_UNKNOWN)
+        nsm->owner = owner;
+done:
+    watcher_respond_ns (nsm);
+}
+
 /* kvs.setroot event
- * Update namespace with new commit info.
+ * A batched event carries several commits in 'setroots', which are
+ * applied in order so watchers see each change.
  * Subscribe/unsubscribe is tied to 'struct ns_monitor' create/destroy.
  */
 static void setroot_cb (flux_t *h, flux_msg_handler_t *mh,
                         const flux_msg_t *msg, void *arg)
 {
     struct watch_ctx *ctx = arg;
-    struct ns_monitor *nsm;
     const char *ns;
     int rootseq;
     const char *rootref;
     int owner;
-    json_t *keys;
-    struct commit *commit;
+    json_t *keys = NULL;
+    json_t *setroots = NULL;
+    size_t index;
+    json_t *entry;
 
-    if (flux_event_unpack (msg, NULL, "{s:s s:i s:s s:i s:o}",
+    if (flux_event_unpack (msg, NULL, "{s:s s:i s:s s:i s?o s?o}",
                            "namespace", &ns,
                            "rootseq", &rootseq,
                            "rootref", &rootref,
                            "owner", &owner,
-                           "keys", &keys) < 0) {
+                           "keys", &keys,
+                           "setroots", &setroots) < 0
+        || (!keys && !setroots)) {
         flux_log_error (h, "%s: flux_event_unpack", __FUNCTION__);
         return;
     }
-    if (!(nsm = zhash_lookup (ctx->namespaces, ns))
-            || (nsm->commit && rootseq <= nsm->commit->rootseq))
+    if (!setroots) {
+        setroot_update (ctx, ns, rootseq, rootref, owner, keys);
         return;
-    if (!(commit = commit_create (rootref, rootseq, keys))) {
-        flux_log_error (h, "%s: error creating commit", __FUNCTION__);
-        nsm->errnum = errno;
-        goto done;
     }
-    commit_destroy (nsm->commit);
-    nsm->commit = commit;
-    if (nsm->owner == FLUX_USERID_UNKNOWN)
-        nsm->owner = owner;
-done:
-    watcher_respond_ns (nsm);
+    /* N.B. watcher_respond_ns() may destroy the namespace, so
+     * setroot_update() looks it up for each commit.
+     */
+    json_array_foreach (setroots, index, entry) {
+        if (json_unpack (entry, "{s:i s:s s:o}",
+                         "rootseq", &rootseq,
+                         "rootref", &rootref,
+                         "keys", &keys) < 0) {
+            flux_log (h, LOG_ERR, "%s: invalid setroots entry", __FUNCTION__);
+            return;
+        }
+        setroot_update (ctx, ns, rootseq, rootref, owner, keys);
+    }
 }
 
 /* kvs.getroot response for initial namespace creation
@@ -957,20 +1027,27 @@ static void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
     const char *ns;
     const char *key;
     int flags;
+    int credit = -1;
     struct ns_monitor *nsm;
     struct watcher *w;
     const char *errmsg = NULL;
 
-    if (flux_request_unpack (msg, NULL, "{s:s s:s s:i}",
+    if (flux_request_unpack (msg, NULL, "{s:s s:s s:i s?i}",
                              "namespace", &ns,
                              "key", &key,
-                             "flags", &flags) < 0)
+                             "flags", &flags,
+                             "credit", &credit) < 0)
         goto error;
     if ((flags & FLUX_KVS_WATCH) && !flux_msg_is_streaming (msg)) {
         errno = EPROTO;
         errmsg = "KVS watch request rejected without streaming RPC flag";
         goto error;
     }
+    if (credit == 0 || credit < -1) {
+        errno = EPROTO;
+        errmsg = "KVS watch request credit must be positive";
+        goto error;
+    }
     if (!(nsm = namespace_monitor (ctx, ns)))
         goto error;
 
@@ -982,6 +1059,7 @@ static void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
     if (!(w = watcher_create (msg, key, flags)))
         goto error;
     w->nsm = nsm;
+    w->credit = credit;
     if (zlist_append (nsm->watchers, w) < 0) {
         watcher_destroy (w);
         errno = ENOMEM;
@@ -1020,6 +1098,77 @@ static void cancel_cb (flux_t *h, flux_msg_handler_t *mh,
     free (sender);
 }
 
+/* Find the watcher that matches (sender, matchtag).
+ */
+static struct watcher *watcher_find (struct watch_ctx *ctx,
+                                     const char *sender,
+                                     uint32_t matchtag)
+{
+    struct ns_monitor *nsm;
+    struct watcher *w;
+
+    nsm = zhash_first (ctx->namespaces);
+    while (nsm) {
+        w = zlist_first (nsm->watchers);
+        while (w) {
+            uint32_t t;
+            char *s;
+            if (flux_msg_get_matchtag (w->request, &t) == 0
+                && t == matchtag
+                && flux_msg_get_route_first (w->request, &s) == 0) {
+                bool match = !strcmp (sender, s);
+                free (s);
+                if (match)
+                    return w;
+            }
+            w = zlist_next (nsm->watchers);
+        }
+        nsm = zhash_next (ctx->namespaces);
+    }
+    return NULL;
+}
+
+/* kvs-watch.credit request
+ * The user granted more credit to a flow controlled watcher, which
+ * expects no response.  Send any responses held back for lack of credit,
+ * then issue a deferred lookup if one is needed.
+ */
+static void credit_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    struct watch_ctx *ctx = arg;
+    uint32_t matchtag;
+    int credit;
+    char *sender;
+    struct watcher *w;
+
+    if (flux_request_unpack (msg, NULL, "{s:i s:i}",
+                             "matchtag", &matchtag,
+                             "credit", &credit) < 0) {
+        flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
+        return;
+    }
+    if (flux_msg_get_route_first (msg, &sender) < 0) {
+        flux_log_error (h, "%s: flux_msg_get_route_first", __FUNCTION__);
+        return;
+    }
+    if ((w = watcher_find (ctx, sender, matchtag))
+        && w->credit >= 0
+        && credit > 0
+        && !w->finished) {
+        struct ns_monitor *nsm = w->nsm;
+
+        w->credit = (w->credit > INT_MAX - credit)
+            ? INT_MAX : w->credit + credit;
+        lookup_drain (w);
+        if (w->finished)
+            watcher_cleanup (nsm, w);
+        else if (w->deferred)
+            watcher_respond (nsm, w);
+    }
+    free (sender);
+}
+
 /* kvs-watch.disconnect request
  * This is sent automatically upon local connector disconnect.
  * The disconnect sender is used to find any watchers to be canceled.
@@ -1118,6 +1267,11 @@ static const struct flux_msg_handler_spec htab[] = {
       .cb           = cancel_cb,
       .rolemask     = FLUX_ROLE_USER
     },
+    { .typemask     = FLUX_MSGTYPE_REQUEST,
+      .topic_glob   = "kvs-watch.credit",
+      .cb           = credit_cb,
+      .rolemask     = FLUX_ROLE_USER
+    },
     { .typemask     = FLUX_MSGTYPE_REQUEST,
       .topic_glob   = "kvs-watch.disconnect",
       .cb           = disconnect_cb,
@@ -41,7 +41,7 @@ struct cache_entry {
     waitqueue_t *waitlist_valid;
     void *data;             /* value raw data */
     int len;
-    json_t *o;              /* value treeobj object */
+    json_t *o;              /* value treeobj object, decoded on demand */
     double lastuse_time;    /* time of last use for cache expiry */
     bool valid;             /* flag indicating if raw data or treeobj
                              * set, don't use data == NULL as test, as
@@ -50,21 +50,51 @@ struct cache_entry {
     int errnum;
     char *blobref;
     int refcount;
+    struct cache *cache;    /* set when inserted in cache */
 };
 
 struct cache {
     flux_reactor_t *r;
     double fake_time;       /* -1. for invalid */
+    double shared_time;     /* last time seen by owner, for shared readers */
     zhashx_t *zhx;
+    pthread_rwlock_t lock;  /* see cache_read_lock() */
+    pthread_mutex_t index_lock;
 };
 
+/* The owner takes the write lock to add or remove entries, to make an
+ * entry valid, and to iterate over the hash.  Shared readers only look
+ * up entries while holding the read lock.  zhashx_t is not safe for
+ * concurrent use, even by lookups, so lookups and other hash accesses
+ * made without the write lock are serialized on index_lock.
+ */
+
+/* Entry fields that shared readers may update (see cache_lookup_shared())
+ * are accessed atomically, since the owner may access them concurrently.
+ */
+static double entry_lastuse (struct cache_entry *entry)
+{
+    double t;
+    __atomic_load (&entry->lastuse_time, &t, __ATOMIC_RELAXED);
+    return t;
+}
+
+static void entry_touch (struct cache_entry *entry, double t)
+{
+    if (t > entry_lastuse (entry))
+        __atomic_store (&entry->lastuse_time, &t, __ATOMIC_RELAXED);
+}
+
 static double cache_now (struct cache *cache)
 {
+    double t = 0.;
+
     if (cache->fake_time >= 0.)
-        return cache->fake_time;
-    if (cache->r)
-        return flux_reactor_now (cache->r);
-    return 0.;
+        t = cache->fake_time;
+    else if (cache->r)
+        t = flux_reactor_now (cache->r);
+    __atomic_store (&cache->shared_time, &t, __ATOMIC_RELAXED);
+    return t;
 }
 
 struct cache_entry *cache_entry_create (const char *ref)
@@ -149,13 +179,13 @@ int cache_entry_force_clear_dirty (struct cache_entry *entry)
 void cache_entry_incref (struct cache_entry *entry)
 {
     if (entry)
-        entry->refcount++;
+        __atomic_add_fetch (&entry->refcount, 1, __ATOMIC_RELAXED);
 }
 
 void cache_entry_decref (struct cache_entry *entry)
 {
     if (entry)
-        entry->refcount--;
+        __atomic_sub_fetch (&entry->refcount, 1, __ATOMIC_RELAXED);
 }
 
 int cache_entry_get_raw (struct cache_entry *entry, const void **data,
@@ -172,6 +202,7 @@ int cache_entry_get_raw (struct cache_entry *entry, const void **data,
 
 int cache_entry_set_raw (struct cache_entry *entry, const void *data, int len)
 {
+    struct cache *cache;
     void *cpy = NULL;
 
     if (!entry || (data && len <= 0) || (!data && len)) {
@@ -193,19 +224,30 @@ int cache_entry_set_raw (struct cache_entry *entry, const void *data, int len)
             return -1;
         memcpy (cpy, data, len);
     }
+    /* Publish under the write lock, so shared readers see either an
+     * invalid entry or the complete data.
+     */
+    if ((cache = entry->cache))
+        pthread_rwlock_wrlock (&cache->lock);
     entry->data = cpy;
     entry->len = len;
     entry->valid = true;
+    if (cache)
+        pthread_rwlock_unlock (&cache->lock);
     if (entry->waitlist_valid) {
         if (wait_runqueue (entry->waitlist_valid) < 0)
             goto reset_invalid;
     }
     return 0;
 reset_invalid:
+    if (cache)
+        pthread_rwlock_wrlock (&cache->lock);
     free (entry->data);
     entry->data = NULL;
     entry->len = 0;
     entry->valid = false;
+    if (cache)
+        pthread_rwlock_unlock (&cache->lock);
     return -1;
 }
 
@@ -255,15 +297,31 @@ int cache_entry_set_errnum_on_notdirty (struct cache_entry *entry, int errnum)
     return 0;
 }
 
+/* The decoded object may be requested concurrently by shared readers,
+ * so it is published with compare-and-swap, and a losing decode is
+ * discarded.
+ */
 const json_t *cache_entry_get_treeobj (struct cache_entry *entry)
 {
+    json_t *o;
+    json_t *expected = NULL;
+
     if (!entry || !entry->valid || !entry->data)
         return NULL;
-    if (!entry->o) {
-        if (!(entry->o = treeobj_decodeb (entry->data, entry->len)))
-            return NULL;
+    if ((o = __atomic_load_n (&entry->o, __ATOMIC_ACQUIRE)))
+        return o;
+    if (!(o = treeobj_decodeb (entry->data, entry->len)))
+        return NULL;
+    if (!__atomic_compare_exchange_n (&entry->o,
+                                      &expected,
+                                      o,
+                                      false,
+                                      __ATOMIC_ACQ_REL,
+                                      __ATOMIC_ACQUIRE)) {
+        json_decref (o);
+        o = expected;
     }
-    return entry->o;
+    return o;
 }
 
 void cache_entry_destroy (void *arg)
@@ -309,21 +367,56 @@ int cache_entry_wait_valid (struct cache_entry *entry, wait_t *wait)
     return 0;
 }
 
+static struct cache_entry *index_lookup (struct cache *cache, const char *ref)
+{
+    struct cache_entry *entry;
+
+    pthread_mutex_lock (&cache->index_lock);
+    entry = zhashx_lookup (cache->zhx, ref);
+    pthread_mutex_unlock (&cache->index_lock);
+    return entry;
+}
+
 struct cache_entry *cache_lookup (struct cache *cache, const char *ref)
 {
-    struct cache_entry *entry = zhashx_lookup (cache->zhx, ref);
+    struct cache_entry *entry = index_lookup (cache, ref);
     double current_time = cache_now (cache);
-    if (entry && current_time > entry->lastuse_time)
-        entry->lastuse_time = current_time;
+    if (entry)
+        entry_touch (entry, current_time);
     return entry;
 }
 
+struct cache_entry *cache_lookup_shared (struct cache *cache, const char *ref)
+{
+    struct cache_entry *entry = index_lookup (cache, ref);
+    double t;
+
+    if (entry) {
+        __atomic_load (&cache->shared_time, &t, __ATOMIC_RELAXED);
+        entry_touch (entry, t);
+    }
+    return entry;
+}
+
+void cache_read_lock (struct cache *cache)
+{
+    pthread_rwlock_rdlock (&cache->lock);
+}
+
+void cache_read_unlock (struct cache *cache)
+{
+    pthread_rwlock_unlock (&cache->lock);
+}
+
 int cache_insert (struct cache *cache, struct cache_entry *entry)
 {
     int rc;
 
     if (cache && entry) {
+        pthread_rwlock_wrlock (&cache->lock);
         rc = zhashx_insert (cache->zhx, entry->blobref, entry);
+        entry->cache = cache;
+        pthread_rwlock_unlock (&cache->lock);
         assert (rc == 0);
     }
     return 0;
@@ -331,7 +424,7 @@ int cache_insert (struct cache *cache, struct cache_entry *entry)
 
 int cache_remove_entry (struct cache *cache, const char *ref)
 {
-    struct cache_entry *entry = zhashx_lookup (cache->zhx, ref);
+    struct cache_entry *entry = index_lookup (cache, ref);
 
     if (entry
         && !entry->dirty
@@ -339,7 +432,9 @@ int cache_remove_entry (struct cache *cache, const char *ref)
             || !wait_queue_length (entry->waitlist_notdirty))
         && (!entry->waitlist_valid
             || !wait_queue_length (entry->waitlist_valid))) {
+        pthread_rwlock_wrlock (&cache->lock);
         zhashx_delete (cache->zhx, ref);
+        pthread_rwlock_unlock (&cache->lock);
         return 1;
     }
     return 0;
@@ -347,7 +442,12 @@ int cache_remove_entry (struct cache *cache, const char *ref)
 
 int cache_count_entries (struct cache *cache)
 {
-    return zhashx_size (cache->zhx);
+    int count;
+
+    pthread_mutex_lock (&cache->index_lock);
+    count = zhashx_size (cache->zhx);
+    pthread_mutex_unlock (&cache->index_lock);
+    return count;
 }
 
 static int cache_entry_age (struct cache_entry *entry, struct cache *cache)
@@ -355,9 +455,9 @@ static int cache_entry_age (struct cache_entry *entry, struct cache *cache)
     double current_time = cache_now (cache);
     if (!entry)
         return -1;
-    if (entry->lastuse_time == 0.)
-        entry->lastuse_time = current_time;
-    return current_time - entry->lastuse_time;
+    if (entry_lastuse (entry) == 0.)
+        entry_touch (entry, current_time);
+    return current_time - entry_lastuse (entry);
 }
 
 int cache_expire_entries (struct cache *cache, double thresh)
@@ -369,7 +469,9 @@ int cache_expire_entries (struct cache *cache, double thresh)
 
     /* Do not use zhashx_first()/zhashx_next() or FOREACH_ZHASHX, as
      * zhashx_delete() call below modifies hash */
+    pthread_rwlock_wrlock (&cache->lock);
     if (!(keys = zhashx_keys (cache->zhx))) {
+        pthread_rwlock_unlock (&cache->lock);
         errno = ENOMEM;
         return -1;
     }
@@ -378,7 +480,7 @@ int cache_expire_entries (struct cache *cache, double thresh)
         if ((entry = zhashx_lookup (cache->zhx, ref))
             && !cache_entry_get_dirty (entry)
             && cache_entry_get_valid (entry)
-            && !entry->refcount
+            && !__atomic_load_n (&entry->refcount, __ATOMIC_RELAXED)
             && (thresh == 0.
                     || cache_entry_age (entry, cache) > thresh)) {
                 zhashx_delete (cache->zhx, ref);
@@ -386,6 +488,7 @@ int cache_expire_entries (struct cache *cache, double thresh)
         }
         ref = zlistx_next (keys);
     }
+    pthread_rwlock_unlock (&cache->lock);
     zlistx_destroy (&keys);
     return count;
 }
@@ -399,6 +502,7 @@ int cache_get_stats (struct cache *cache, tstat_t *ts, int *sizep,
     int incomplete = 0;
     int dirty = 0;
 
+    pthread_rwlock_wrlock (&cache->lock);
     FOREACH_ZHASHX (cache->zhx, key, entry) {
         if (cache_entry_get_valid (entry)) {
             int obj_size = 0;
@@ -413,6 +517,7 @@ int cache_get_stats (struct cache *cache, tstat_t *ts, int *sizep,
         if (cache_entry_get_dirty (entry))
             dirty++;
     }
+    pthread_rwlock_unlock (&cache->lock);
     if (sizep)
         *sizep = size;
     if (incompletep)
@@ -429,6 +534,7 @@ int cache_wait_destroy_msg (struct cache *cache, wait_test_msg_f cb, void *arg)
     int n, count = 0;
     int rc = -1;
 
+    pthread_rwlock_wrlock (&cache->lock);
     FOREACH_ZHASHX (cache->zhx, key, entry) {
         if (entry->waitlist_valid) {
             if ((n = wait_destroy_msg (entry->waitlist_valid, cb, arg)) < 0)
@@ -443,6 +549,7 @@ int cache_wait_destroy_msg (struct cache *cache, wait_test_msg_f cb, void *arg)
     }
     rc = count;
 done:
+    pthread_rwlock_unlock (&cache->lock);
     return rc;
 }
 
@@ -468,6 +575,19 @@ struct cache *cache_create (flux_reactor_t *r)
         errno = ENOMEM;
         return NULL;
     }
+    if (pthread_rwlock_init (&cache->lock, NULL) != 0) {
+        zhashx_destroy (&cache->zhx);
+        free (cache);
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (pthread_mutex_init (&cache->index_lock, NULL) != 0) {
+        pthread_rwlock_destroy (&cache->lock);
+        zhashx_destroy (&cache->zhx);
+        free (cache);
+        errno = ENOMEM;
+        return NULL;
+    }
     cache->r = r;
     cache->fake_time = -1.;
     /* do not duplicate hash keys, use blobrefs stored in cache entry */
@@ -481,6 +601,8 @@ void cache_destroy (struct cache *cache)
 {
     if (cache) {
         zhashx_destroy (&cache->zhx);
+        pthread_mutex_destroy (&cache->index_lock);
+        pthread_rwlock_destroy (&cache->lock);
         free (cache);
     }
 }
@@ -489,7 +611,7 @@ void cache_destroy (struct cache *cache)
 void cache_entry_set_fake_time (struct cache_entry *entry, double time)
 {
     if (entry)
-        entry->lastuse_time = time;
+        __atomic_store (&entry->lastuse_time, &time, __ATOMIC_RELAXED);
 }
 
 /* for testing */
@@ -121,6 +121,18 @@ void cache_destroy (struct cache *cache);
  */
 struct cache_entry *cache_lookup (struct cache *cache, const char *ref);
 
+/* Shared readers on other threads may look up entries with
+ * cache_lookup_shared() and read valid entries with
+ * cache_entry_get_raw() and cache_entry_get_treeobj(), while holding the
+ * cache read lock.  Entries are not added, removed, or made valid while
+ * the read lock is held.  Only the thread that owns the cache may call
+ * other functions.  cache_lookup_shared() updates the "last used" time
+ * using the time of the owner's most recent cache access.
+ */
+struct cache_entry *cache_lookup_shared (struct cache *cache, const char *ref);
+void cache_read_lock (struct cache *cache);
+void cache_read_unlock (struct cache *cache);
+
 /* Insert entry in the cache.  Reference for entry created during
  * cache_entry_create() time.  Ownership of the cache entry is
  * transferred to the cache.
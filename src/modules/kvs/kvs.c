@@ -39,6 +39,7 @@
 #include "kvstxn.h"
 #include "kvsroot.h"
 #include "kvssync.h"
+#include "readpool.h"
 
 /* Expire cache_entry after 'max_lastuse_age' seconds.
  */
@@ -61,6 +62,10 @@ struct kvs_ctx {
     flux_watcher_t *prep_w;
     flux_watcher_t *idle_w;
     flux_watcher_t *check_w;
+    flux_watcher_t *relay_w;
+    json_t *relay_commits;      /* commits queued for kvs.relaycommit */
+    struct readpool *readpool;  /* reader threads for lookups */
+    int lookup_threads;
     int transaction_merge;
     bool events_init;            /* flag */
     const char *hash_name;
@@ -80,6 +85,8 @@ static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
                                  int revents, void *arg);
 static void transaction_check_cb (flux_reactor_t *r, flux_watcher_t *w,
                                   int revents, void *arg);
+static void relay_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                           int revents, void *arg);
 static void start_root_remove (struct kvs_ctx *ctx, const char *ns);
 
 /*
@@ -89,11 +96,14 @@ static void kvs_ctx_destroy (struct kvs_ctx *ctx)
 {
     if (ctx) {
         int saved_errno = errno;
+        readpool_destroy (ctx->readpool);
         cache_destroy (ctx->cache);
         kvsroot_mgr_destroy (ctx->krm);
         flux_watcher_destroy (ctx->prep_w);
         flux_watcher_destroy (ctx->check_w);
         flux_watcher_destroy (ctx->idle_w);
+        flux_watcher_destroy (ctx->relay_w);
+        json_decref (ctx->relay_commits);
         free (ctx);
         errno = saved_errno;
     }
@@ -130,7 +140,13 @@ static struct kvs_ctx *kvs_ctx_create (flux_t *h)
         flux_watcher_start (ctx->prep_w);
         flux_watcher_start (ctx->check_w);
     }
+    else {
+        ctx->relay_w = flux_prepare_watcher_create (r, relay_prep_cb, ctx);
+        if (!ctx->relay_w)
+            goto error;
+    }
     ctx->transaction_merge = 1;
+    ctx->lookup_threads = 2;
     return ctx;
 error:
     kvs_ctx_destroy (ctx);
@@ -756,48 +772,192 @@ static void flux_msg_destroy_wrapper (void *arg)
     flux_msg_destroy (msg);
 }
 
-static int setroot_event_send (struct kvs_ctx *ctx, struct kvsroot *root,
-                               json_t *names, json_t *keys)
+/* Setroot events are queued as transactions are applied, and published
+ * from the prep watcher, so that commits applied in the same reactor loop
+ * iteration go out in a single event.  Capture the root directory that
+ * precedes the first queued commit, for computing the root dir delta.
+ */
+static int setroot_event_queue (struct kvs_ctx *ctx, struct kvsroot *root,
+                                const char *rootref, int rootseq,
+                                json_t *names, json_t *keys)
 {
-    const json_t *root_dir = NULL;
-    json_t *nullobj = NULL;
-    flux_msg_t *msg = NULL;
-    char *setroot_topic = NULL;
-    int saved_errno, rc = -1;
+    json_t *o;
 
     assert (ctx->rank == 0);
 
-    if (event_includes_rootdir) {
+    if (!root->setroot_batch) {
         struct cache_entry *entry;
 
-        if ((entry = cache_lookup (ctx->cache, root->ref)))
-            root_dir = cache_entry_get_treeobj (entry);
-        assert (root_dir != NULL); // root entry is always in cache on rank 0
+        if (!(root->setroot_batch = json_array ()))
+            goto nomem;
+        if (event_includes_rootdir
+            && (entry = cache_lookup (ctx->cache, root->ref))
+            && cache_entry_get_valid (entry)) {
+            const json_t *prevdir = cache_entry_get_treeobj (entry);
+            root->setroot_prevdir = json_incref ((json_t *)prevdir);
+            strcpy (root->setroot_prevref, root->ref);
+        }
+    }
+    if (!(o = json_pack ("{ s:i s:s s:O s:O }",
+                         "rootseq", rootseq,
+                         "rootref", rootref,
+                         "names", names,
+                         "keys", keys)))
+        goto nomem;
+    if (json_array_append_new (root->setroot_batch, o) < 0) {
+        json_decref (o);
+        goto nomem;
+    }
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Return the root directory entries that differ between 'prevdir' and
+ * 'dir', with removed entries set to null.
+ */
+static json_t *rootdir_delta (json_t *prevdir, json_t *dir)
+{
+    json_t *prev = treeobj_get_data (prevdir);
+    json_t *cur = treeobj_get_data (dir);
+    json_t *delta;
+    const char *name;
+    json_t *value;
+
+    if (!prev || !cur)
+        return NULL;
+    if (!(delta = json_object ()))
+        goto nomem;
+    json_object_foreach (cur, name, value) {
+        json_t *o = json_object_get (prev, name);
+        if (!o || !json_equal (o, value)) {
+            if (json_object_set (delta, name, value) < 0)
+                goto nomem;
+        }
+    }
+    json_object_foreach (prev, name, value) {
+        if (!json_object_get (cur, name)) {
+            if (json_object_set_new (delta, name, json_null ()) < 0)
+                goto nomem;
+        }
+    }
+    return delta;
+nomem:
+    json_decref (delta);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* Build the setroot event payload for the queued commits.
+ * A single commit is published as
+ *   {namespace, owner, rootseq, rootref, names, keys}
+ * Several commits are published as
+ *   {namespace, owner, rootseq, rootref, names, setroots:[{rootseq, rootref,
+ *    keys}, ...]}
+ * where the top level rootseq and rootref are from the last commit, and
+ * names is the concatenation of all transaction names.  The payload also
+ * includes either the new root directory ("rootdir"), or the entries of
+ * the root directory that changed since "prevref" ("rootdir_delta"),
+ * whichever is smaller.
+ */
+static json_t *setroot_event_encode (struct kvs_ctx *ctx,
+                                     struct kvsroot *root,
+                                     json_t *batch,
+                                     json_t *prevdir)
+{
+    json_t *last = json_array_get (batch, json_array_size (batch) - 1);
+    const char *rootref = json_string_value (json_object_get (last, "rootref"));
+    json_t *payload;
+    json_t *names;
+    json_t *entry;
+    size_t index;
+
+    if (!(payload = json_pack ("{ s:s s:i s:O s:O s:[] }",
+                               "namespace", root->ns_name,
+                               "owner", root->owner,
+                               "rootseq", json_object_get (last, "rootseq"),
+                               "rootref", json_object_get (last, "rootref"),
+                               "names")))
+        goto nomem;
+    names = json_object_get (payload, "names");
+    json_array_foreach (batch, index, entry) {
+        if (json_array_extend (names, json_object_get (entry, "names")) < 0)
+            goto nomem;
+        (void)json_object_del (entry, "names");
+    }
+    if (json_array_size (batch) == 1) {
+        if (json_object_set (payload, "keys", json_object_get (last, "keys")) < 0)
+            goto nomem;
     }
     else {
-        if (!(nullobj = json_null ())) {
-            saved_errno = errno;
-            flux_log_error (ctx->h, "%s: json_null", __FUNCTION__);
-            goto done;
+        if (json_object_set (payload, "setroots", batch) < 0)
+            goto nomem;
+    }
+    if (event_includes_rootdir) {
+        struct cache_entry *hentry;
+        json_t *rootdir = NULL;
+        json_t *delta = NULL;
+
+        if ((hentry = cache_lookup (ctx->cache, rootref)))
+            rootdir = (json_t *)cache_entry_get_treeobj (hentry);
+        assert (rootdir != NULL); // root entry is always in cache on rank 0
+
+        if (prevdir && (delta = rootdir_delta (prevdir, rootdir))) {
+            /* not worth it if most of the directory changed */
+            if (json_object_size (delta) * 2 > treeobj_get_count (rootdir)) {
+                json_decref (delta);
+                delta = NULL;
+            }
+        }
+        if (delta) {
+            if (json_object_set_new (payload,
+                                     "rootdir_delta",
+                                     json_pack ("{ s:s s:o }",
+                                                "prevref",
+                                                root->setroot_prevref,
+                                                "entries", delta)) < 0)
+                goto nomem;
+        }
+        else {
+            if (json_object_set (payload, "rootdir", rootdir) < 0)
+                goto nomem;
         }
-        root_dir = nullobj;
     }
+    return payload;
+nomem:
+    json_decref (payload);
+    errno = ENOMEM;
+    return NULL;
+}
 
+/* Publish queued setroot events for 'root', if any.
+ */
+static int setroot_event_flush (struct kvs_ctx *ctx, struct kvsroot *root)
+{
+    json_t *batch = root->setroot_batch;
+    json_t *prevdir = root->setroot_prevdir;
+    json_t *payload = NULL;
+    flux_msg_t *msg = NULL;
+    char *setroot_topic = NULL;
+    int saved_errno, rc = -1;
+
+    if (!batch)
+        return 0;
+    root->setroot_batch = NULL;
+    root->setroot_prevdir = NULL;
+
+    if (!(payload = setroot_event_encode (ctx, root, batch, prevdir))) {
+        saved_errno = errno;
+        flux_log_error (ctx->h, "%s: error encoding setroot", __FUNCTION__);
+        goto done;
+    }
     if (asprintf (&setroot_topic, "kvs.namespace-%s-setroot", root->ns_name) < 0) {
         saved_errno = errno;
         flux_log_error (ctx->h, "%s: asprintf", __FUNCTION__);
         goto done;
     }
-
-    if (!(msg = flux_event_pack (setroot_topic,
-                                 "{ s:s s:i s:s s:O s:O s:O s:i}",
-                                 "namespace", root->ns_name,
-                                 "rootseq", root->seq,
-                                 "rootref", root->ref,
-                                 "names", names,
-                                 "rootdir", root_dir,
-                                 "keys", keys,
-                                 "owner", root->owner))) {
+    if (!(msg = flux_event_pack (setroot_topic, "O", payload))) {
         saved_errno = errno;
         flux_log_error (ctx->h, "%s: flux_event_pack", __FUNCTION__);
         goto done;
@@ -814,12 +974,33 @@ static int setroot_event_send (struct kvs_ctx *ctx, struct kvsroot *root,
 done:
     free (setroot_topic);
     flux_msg_destroy (msg);
-    json_decref (nullobj);
+    json_decref (payload);
+    json_decref (batch);
+    json_decref (prevdir);
     if (rc < 0)
         errno = saved_errno;
     return rc;
 }
 
+static int setroot_flush_root_cb (struct kvsroot *root, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+
+    if (setroot_event_flush (ctx, root) < 0)
+        flux_log_error (ctx->h, "%s: setroot_event_flush", __FUNCTION__);
+    return 0;
+}
+
+/* Like setroot_flush_root_cb(), but leave setroot events queued while
+ * the test hook kvs.setroot-pause is in effect on rank 0.
+ */
+static int setroot_prep_root_cb (struct kvsroot *root, void *arg)
+{
+    if (root->setroot_pause)
+        return 0;
+    return setroot_flush_root_cb (root, arg);
+}
+
 static int error_event_send (struct kvs_ctx *ctx, const char *ns,
                              json_t *names, int errnum)
 {
@@ -1002,8 +1183,14 @@ done:
             flux_log (ctx->h, LOG_DEBUG, "aggregated %d transactions (%d ops)",
                       count, opcount);
         }
+        if (setroot_event_queue (ctx,
+                                 root,
+                                 kvstxn_get_newroot_ref (kt),
+                                 root->seq + 1,
+                                 names,
+                                 kvstxn_get_keys (kt)) < 0)
+            flux_log_error (ctx->h, "%s: setroot_event_queue", __FUNCTION__);
         setroot (ctx, root, kvstxn_get_newroot_ref (kt), root->seq + 1);
-        setroot_event_send (ctx, root, names, kvstxn_get_keys (kt));
     } else {
         fallback = kvstxn_fallback_mergeable (kt);
 
@@ -1051,6 +1238,14 @@ static void transaction_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct kvs_ctx *ctx = arg;
     struct kvs_cb_data cbd = { .ctx = ctx, .ready = false };
 
+    /* Publish setroot events queued by every root before looking for
+     * ready transactions, which stops at the first root that has one.
+     */
+    if (ctx->rank == 0) {
+        if (kvsroot_mgr_iter_roots (ctx->krm, setroot_prep_root_cb, ctx) < 0)
+            flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
+    }
+
     if (kvsroot_mgr_iter_roots (ctx->krm, kvstxn_prep_root_cb, &cbd) < 0) {
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
         return;
@@ -1385,20 +1580,29 @@ stall:
     return NULL;
 }
 
-static void lookup_request_cb (flux_t *h, flux_msg_handler_t *mh,
-                               const flux_msg_t *msg, void *arg)
+static void lookup_request_process (flux_t *h, flux_msg_handler_t *mh,
+                                    const flux_msg_t *msg, void *arg)
 {
     lookup_t *lh;
     json_t *val;
+    const void *data;
+    int len;
     bool stall = false;
 
-    if (!(lh = lookup_common (h, mh, msg, arg, lookup_request_cb,
+    if (!(lh = lookup_common (h, mh, msg, arg, lookup_request_process,
                               &stall))) {
         if (stall)
             return;
         goto error;
     }
 
+    /* FLUX_KVS_RAW: the value is the response payload */
+    if (lookup_get_raw (lh, &data, &len) == 0) {
+        if (flux_respond_raw (h, msg, data, len) < 0)
+            flux_log_error (h, "%s: flux_respond_raw", __FUNCTION__);
+        lookup_destroy (lh);
+        return;
+    }
     if (!(val = lookup_get_value (lh))) {
         errno = ENOENT;
         goto error;
@@ -1421,8 +1625,8 @@ error:
  * on lookups (including ENOENT failed lookups) to determine what
  * lookups can be considered to be read-your-writes consistency safe.
  */
-static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
-                                    const flux_msg_t *msg, void *arg)
+static void lookup_plus_request_process (flux_t *h, flux_msg_handler_t *mh,
+                                         const flux_msg_t *msg, void *arg)
 {
     lookup_t *lh;
     json_t *val = NULL;
@@ -1430,7 +1634,7 @@ static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
     int root_seq;
     bool stall = false;
 
-    if (!(lh = lookup_common (h, mh, msg, arg, lookup_plus_request_cb,
+    if (!(lh = lookup_common (h, mh, msg, arg, lookup_plus_request_process,
                               &stall))) {
         if (stall)
             return;
@@ -1464,6 +1668,156 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+/* Hand a new lookup to a reader thread if its root is known here and
+ * the requester may read it.  The reader serves the lookup only if every
+ * blob it needs is cached.  Anything else, including errors in the
+ * request, is left to lookup_common() on this thread.
+ * Returns 0 if the lookup was handed off, -1 if not.
+ */
+static int lookup_offload (struct kvs_ctx *ctx,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           bool plus)
+{
+    const char *ns = NULL;
+    const char *key;
+    const char *root_ref;
+    json_t *root_dirent = NULL;
+    int root_seq = -1;
+    int flags;
+    struct flux_msg_cred cred;
+
+    if (!ctx->readpool
+        || flux_request_unpack (msg, NULL, "{ s:s s:i s?s s?o s?i }",
+                                "key", &key,
+                                "flags", &flags,
+                                "namespace", &ns,
+                                "rootdir", &root_dirent,
+                                "rootseq", &root_seq) < 0
+        || (flags & FLUX_KVS_RAW)
+        || flux_msg_get_cred (msg, &cred) < 0)
+        return -1;
+
+    if (root_dirent) {
+        if (treeobj_validate (root_dirent) < 0
+            || !treeobj_is_dirref (root_dirent)
+            || !(root_ref = treeobj_get_blobref (root_dirent, 0))
+            || (plus && root_seq < 0))
+            return -1;
+    }
+    else {
+        struct kvsroot *root;
+
+        if (!ns
+            || !(root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns))
+            || kvsroot_check_user (ctx->krm, root, cred) < 0)
+            return -1;
+        root_ref = root->ref;
+        root_seq = root->seq;
+    }
+    return readpool_submit (ctx->readpool,
+                            msg,
+                            plus,
+                            ns,
+                            root_ref,
+                            root_seq,
+                            key,
+                            flags,
+                            cred,
+                            mh);
+}
+
+/* Continue a lookup that stalled on a reader thread from where its walk
+ * stopped, by passing the handle to lookup_common() as on a replay.
+ * Returns 0 if the lookup was resumed, -1 if it must start over.
+ */
+static int lookup_offload_resume (struct kvs_ctx *ctx,
+                                  flux_msg_handler_t *mh,
+                                  const flux_msg_t *msg,
+                                  bool plus,
+                                  lookup_t *lh)
+{
+    json_t *root_dirent = NULL;
+    flux_msg_t *msgcpy;
+
+    /* rootdir is optional */
+    (void)flux_request_unpack (msg, NULL, "{ s:o }",
+                               "rootdir", &root_dirent);
+
+    if (lookup_set_krm (lh, ctx->krm, ctx->h, root_dirent ? false : true) < 0
+        || !(msgcpy = flux_msg_copy (msg, true))) {
+        lookup_destroy (lh);
+        return -1;
+    }
+    if (flux_msg_aux_set (msgcpy, "lookup_handle", lh, NULL) < 0) {
+        flux_msg_destroy (msgcpy);
+        lookup_destroy (lh);
+        return -1;
+    }
+    if (plus)
+        lookup_plus_request_process (ctx->h, mh, msgcpy, ctx);
+    else
+        lookup_request_process (ctx->h, mh, msgcpy, ctx);
+    flux_msg_destroy (msgcpy);
+    return 0;
+}
+
+static void lookup_offload_done_cb (const flux_msg_t *msg,
+                                    bool plus,
+                                    const char *payload,
+                                    int errnum,
+                                    lookup_t *lh,
+                                    void *aux,
+                                    void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    flux_msg_handler_t *mh = aux;
+
+    if (payload) {
+        if (flux_respond (ctx->h, msg, payload) < 0)
+            flux_log_error (ctx->h, "%s: flux_respond", __FUNCTION__);
+    }
+    else if (errnum) {
+        if (flux_respond_error (ctx->h, msg, errnum, NULL) < 0)
+            flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
+    }
+    else if (lh && lookup_offload_resume (ctx, mh, msg, plus, lh) == 0)
+        return;
+    else if (plus)
+        lookup_plus_request_process (ctx->h, mh, msg, ctx);
+    else
+        lookup_request_process (ctx->h, mh, msg, ctx);
+}
+
+static void lookup_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                               const flux_msg_t *msg, void *arg)
+{
+    if (lookup_offload (arg, mh, msg, false) < 0)
+        lookup_request_process (h, mh, msg, arg);
+}
+
+/* FLUX_KVS_RAW is not supported, since the value is returned as JSON
+ * alongside the root information.
+ */
+static void lookup_plus_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                                    const flux_msg_t *msg, void *arg)
+{
+    int flags;
+
+    if (flux_request_unpack (msg, NULL, "{ s:i }", "flags", &flags) == 0
+        && (flags & FLUX_KVS_RAW)) {
+        if (flux_respond_error (h,
+                                msg,
+                                EPROTO,
+                                "FLUX_KVS_RAW is not supported by lookup-plus")
+            < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        return;
+    }
+    if (lookup_offload (arg, mh, msg, true) < 0)
+        lookup_plus_request_process (h, mh, msg, arg);
+}
+
 
 static int finalize_transaction_req (treq_t *tr,
                                      const flux_msg_t *req,
@@ -1514,50 +1868,190 @@ static void finalize_transaction_bynames (struct kvs_ctx *ctx,
     }
 }
 
-/* kvs.relaycommit (rank 0 only, no response).
+/* Commits received on a non-zero rank, whether from local users or from
+ * the kvs modules of downstream ranks, are queued and relayed upstream as
+ * one kvs.relaycommit request per reactor loop iteration.  Each interior
+ * rank therefore sends its parent a single request for the commits of its
+ * whole subtree, rather than rank 0 receiving a request per commit.
+ *
+ * Each entry keeps its own name and flags, so rank 0 merges the batch
+ * with kvstxn_mgr_merge_ready_transactions() under the usual rules, and
+ * can fall back to applying entries individually on error.
+ */
+static json_t *relay_commit_batch (struct kvs_ctx *ctx)
+{
+    if (!ctx->relay_commits) {
+        if (!(ctx->relay_commits = json_array ())) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        flux_watcher_start (ctx->relay_w);
+    }
+    return ctx->relay_commits;
+}
+
+static int relay_commit_queue (struct kvs_ctx *ctx,
+                               const char *name,
+                               const char *ns,
+                               json_t *ops,
+                               int flags)
+{
+    json_t *commits;
+    json_t *o;
+
+    if (!(commits = relay_commit_batch (ctx)))
+        return -1;
+    if (!(o = json_pack ("{ s:s s:s s:O s:i }",
+                         "name", name,
+                         "namespace", ns,
+                         "ops", ops,
+                         "flags", flags))
+        || json_array_append_new (commits, o) < 0) {
+        json_decref (o);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+/* Fail every commit in a batch that could not be relayed upstream.
+ * Commits that originated on this rank are finalized here.  Commits
+ * relayed from downstream have no treq_t here, so an error event is sent
+ * for them, as rank 0 would, and their originating rank responds.
+ */
+static void relay_commit_fail (struct kvs_ctx *ctx,
+                               json_t *commits,
+                               int errnum)
+{
+    size_t index;
+    json_t *entry;
+
+    json_array_foreach (commits, index, entry) {
+        struct kvsroot *root;
+        const char *name;
+        const char *ns;
+        json_t *names;
+
+        if (json_unpack (entry, "{ s:s s:s }",
+                         "name", &name,
+                         "namespace", &ns) < 0) {
+            flux_log (ctx->h, LOG_ERR, "%s: malformed commit", __FUNCTION__);
+            continue;
+        }
+        if ((root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns))
+            && treq_mgr_lookup_transaction (root->trm, name)) {
+            if (!(names = json_pack ("[ s ]", name))) {
+                flux_log (ctx->h, LOG_ERR, "%s: json_pack", __FUNCTION__);
+                continue;
+            }
+            finalize_transaction_bynames (ctx, root, names, errnum);
+            json_decref (names);
+        }
+        else if (error_event_send_to_name (ctx, ns, name, errnum) < 0)
+            flux_log_error (ctx->h, "%s: error_event_send_to_name",
+                            __FUNCTION__);
+    }
+}
+
+static void relay_commit_flush (struct kvs_ctx *ctx)
+{
+    json_t *commits = ctx->relay_commits;
+    flux_future_t *f;
+
+    if (!commits)
+        return;
+    ctx->relay_commits = NULL;
+    if (!(f = flux_rpc_pack (ctx->h,
+                             "kvs.relaycommit",
+                             FLUX_NODEID_UPSTREAM,
+                             FLUX_RPC_NORESPONSE,
+                             "{ s:O }",
+                             "commits", commits))) {
+        int saved_errno = errno;
+        flux_log_error (ctx->h, "%s: flux_rpc_pack", __FUNCTION__);
+        relay_commit_fail (ctx, commits, saved_errno);
+    }
+    flux_future_destroy (f);
+    json_decref (commits);
+}
+
+static void relay_prep_cb (flux_reactor_t *r, flux_watcher_t *w,
+                           int revents, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+
+    relay_commit_flush (ctx);
+    flux_watcher_stop (w);
+}
+
+/* kvs.relaycommit (no response).
+ * On rank 0, add each commit in the batch to the ready queue of its
+ * namespace.  On other ranks, add the batch to this rank's queue for
+ * relay upstream.
  */
 static void relaycommit_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                     const flux_msg_t *msg, void *arg)
 {
     struct kvs_ctx *ctx = arg;
-    struct kvsroot *root;
-    const char *ns;
-    const char *name;
-    int flags;
-    json_t *ops = NULL;
+    json_t *commits;
+    json_t *entry;
+    size_t index;
 
-    if (flux_request_unpack (msg, NULL, "{ s:o s:s s:s s:i }",
-                             "ops", &ops,
-                             "name", &name,
-                             "namespace", &ns,
-                             "flags", &flags) < 0) {
+    if (flux_request_unpack (msg, NULL, "{ s:o }", "commits", &commits) < 0
+        || !json_is_array (commits)) {
         flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
         return;
     }
 
-    /* namespace must exist given we are on rank 0 */
-    if (!(root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns))) {
-        flux_log (h, LOG_ERR, "%s: namespace %s not available",
-                  __FUNCTION__, ns);
-        errno = ENOTSUP;
-        goto error;
-    }
+    if (ctx->rank != 0) {
+        json_t *batch;
 
-    if (kvstxn_mgr_add_transaction (root->ktm, name, ops, flags) < 0) {
-        flux_log_error (h, "%s: kvstxn_mgr_add_transaction",
-                        __FUNCTION__);
-        goto error;
+        if (!(batch = relay_commit_batch (ctx))
+            || json_array_extend (batch, commits) < 0) {
+            flux_log_error (h, "%s: error queueing commits", __FUNCTION__);
+            relay_commit_fail (ctx, commits, ENOMEM);
+        }
+        return;
     }
 
-    return;
+    json_array_foreach (commits, index, entry) {
+        struct kvsroot *root;
+        const char *ns;
+        const char *name;
+        int flags;
+        json_t *ops;
+
+        if (json_unpack (entry, "{ s:o s:s s:s s:i }",
+                         "ops", &ops,
+                         "name", &name,
+                         "namespace", &ns,
+                         "flags", &flags) < 0) {
+            flux_log (h, LOG_ERR, "%s: malformed commit", __FUNCTION__);
+            continue;
+        }
 
+        /* namespace must exist given we are on rank 0 */
+        if (!(root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns))) {
+            flux_log (h, LOG_ERR, "%s: namespace %s not available",
+                      __FUNCTION__, ns);
+            errno = ENOTSUP;
+            goto error;
+        }
+
+        if (kvstxn_mgr_add_transaction (root->ktm, name, ops, flags) < 0) {
+            flux_log_error (h, "%s: kvstxn_mgr_add_transaction",
+                            __FUNCTION__);
+            goto error;
+        }
+        continue;
 error:
-    /* An error has occurred, so we will return an error similarly to
-     * how an error would be returned via a transaction error in
-     * kvstxn_apply().
-     */
-    if (error_event_send_to_name (ctx, ns, name, errno) < 0)
-        flux_log_error (h, "%s: error_event_send_to_name", __FUNCTION__);
+        /* An error has occurred, so we will return an error similarly to
+         * how an error would be returned via a transaction error in
+         * kvstxn_apply().
+         */
+        if (error_event_send_to_name (ctx, ns, name, errno) < 0)
+            flux_log_error (h, "%s: error_event_send_to_name", __FUNCTION__);
+    }
 }
 
 /* kvs.commit
@@ -1630,19 +2124,11 @@ static void commit_request_cb (flux_t *h, flux_msg_handler_t *mh,
         }
     }
     else {
-        flux_future_t *f;
-
-        /* route to rank 0 as instance owner */
-        if (!(f = flux_rpc_pack (h, "kvs.relaycommit", 0, FLUX_RPC_NORESPONSE,
-                                 "{ s:O s:s s:s s:i }",
-                                 "ops", ops,
-                                 "name", treq_get_name (tr),
-                                 "namespace", ns,
-                                 "flags", flags))) {
-            flux_log_error (h, "%s: flux_rpc_pack", __FUNCTION__);
+        /* route toward rank 0 as instance owner, via interior ranks */
+        if (relay_commit_queue (ctx, treq_get_name (tr), ns, ops, flags) < 0) {
+            flux_log_error (h, "%s: relay_commit_queue", __FUNCTION__);
             goto error;
         }
-        flux_future_destroy (f);
     }
     return;
 
@@ -1983,11 +2469,14 @@ static void error_event_cb (flux_t *h, flux_msg_handler_t *mh,
     finalize_transaction_bynames (ctx, root, names, errnum);
 }
 
-/* Optimization: the current rootdir object is optionally included
- * in the kvs.namespace-<NS>-setroot event.  Prime the local cache with it.
- * If there are complications, just skip it.  Not critical.
+/* Optimization: the current rootdir object, or a delta from a prior
+ * rootdir, is optionally included in the kvs.namespace-<NS>-setroot event.
+ * Prime the local cache with it.  If there are complications, just skip
+ * it.  Not critical.
  */
-static void prime_cache_with_rootdir (struct kvs_ctx *ctx, json_t *rootdir)
+static void prime_cache_with_rootdir (struct kvs_ctx *ctx,
+                                      json_t *rootdir,
+                                      const char *rootref)
 {
     struct cache_entry *entry;
     char ref[BLOBREF_MAX_STRING_SIZE];
@@ -2007,6 +2496,11 @@ static void prime_cache_with_rootdir (struct kvs_ctx *ctx, json_t *rootdir)
         flux_log_error (ctx->h, "%s: blobref_hash", __FUNCTION__);
         goto done;
     }
+    if (strcmp (ref, rootref) != 0) {
+        flux_log (ctx->h, LOG_ERR, "%s: rootdir does not match rootref",
+                  __FUNCTION__);
+        goto done;
+    }
     if ((entry = cache_lookup (ctx->cache, ref)))
         goto done; // already in cache, possibly dirty/invalid - we don't care
     if (!(entry = cache_entry_create (ref))) {
@@ -2027,10 +2521,57 @@ done:
     free (data);
 }
 
+/* Apply a rootdir delta to the previous rootdir, if it is in cache.
+ */
+static void prime_cache_with_delta (struct kvs_ctx *ctx,
+                                    json_t *delta,
+                                    const char *rootref)
+{
+    struct cache_entry *entry;
+    const char *prevref;
+    json_t *entries;
+    json_t *rootdir = NULL;
+    const char *name;
+    json_t *value;
+
+    if (cache_lookup (ctx->cache, rootref))
+        return;
+    if (json_unpack (delta, "{ s:s s:o }",
+                     "prevref", &prevref,
+                     "entries", &entries) < 0) {
+        flux_log (ctx->h, LOG_ERR, "%s: invalid rootdir delta", __FUNCTION__);
+        return;
+    }
+    if (!(entry = cache_lookup (ctx->cache, prevref))
+        || !cache_entry_get_valid (entry))
+        return;
+    if (!(rootdir = treeobj_copy ((json_t *)cache_entry_get_treeobj (entry)))) {
+        flux_log_error (ctx->h, "%s: treeobj_copy", __FUNCTION__);
+        return;
+    }
+    json_object_foreach (entries, name, value) {
+        int rc;
+        if (json_is_null (value))
+            rc = treeobj_delete_entry (rootdir, name);
+        else
+            rc = treeobj_insert_entry (rootdir, name, value);
+        if (rc < 0) {
+            flux_log_error (ctx->h, "%s: error applying rootdir delta",
+                            __FUNCTION__);
+            goto done;
+        }
+    }
+    prime_cache_with_rootdir (ctx, rootdir, rootref);
+done:
+    json_decref (rootdir);
+}
+
 /* Alter the (rootref, rootseq) in response to a setroot event.
+ * 'rootdir' and 'delta' are optional.
  */
 static void setroot_event_process (struct kvs_ctx *ctx, struct kvsroot *root,
                                    json_t *names, json_t *rootdir,
+                                   json_t *delta,
                                    const char *rootref, int rootseq)
 {
     int errnum = 0;
@@ -2050,12 +2591,36 @@ static void setroot_event_process (struct kvs_ctx *ctx, struct kvsroot *root,
      * in event message.  Ignore failure here - object will be fetched on
      * demand from content cache if not in local cache.
      */
-    if (!json_is_null (rootdir))
-        prime_cache_with_rootdir (ctx, rootdir);
+    if (rootdir && !json_is_null (rootdir))
+        prime_cache_with_rootdir (ctx, rootdir, rootref);
+    else if (delta)
+        prime_cache_with_delta (ctx, delta, rootref);
 
     setroot (ctx, root, rootref, rootseq);
 }
 
+/* Only the final (rootref, rootseq) of a batched setroot event matters
+ * here, since names includes all transactions in the batch.
+ */
+static int setroot_event_unpack (const flux_msg_t *msg,
+                                 const char **ns,
+                                 int *rootseq,
+                                 const char **rootref,
+                                 json_t **names,
+                                 json_t **rootdir,
+                                 json_t **delta)
+{
+    *rootdir = NULL;
+    *delta = NULL;
+    return flux_event_unpack (msg, NULL, "{ s:s s:i s:s s:o s?o s?o }",
+                              "namespace", ns,
+                              "rootseq", rootseq,
+                              "rootref", rootref,
+                              "names", names,
+                              "rootdir", rootdir,
+                              "rootdir_delta", delta);
+}
+
 static void setroot_event_cb (flux_t *h, flux_msg_handler_t *mh,
                               const flux_msg_t *msg, void *arg)
 {
@@ -2064,15 +2629,12 @@ static void setroot_event_cb (flux_t *h, flux_msg_handler_t *mh,
     const char *ns;
     int rootseq;
     const char *rootref;
-    json_t *rootdir = NULL;
-    json_t *names = NULL;
+    json_t *rootdir;
+    json_t *delta;
+    json_t *names;
 
-    if (flux_event_unpack (msg, NULL, "{ s:s s:i s:s s:o s:o }",
-                           "namespace", &ns,
-                           "rootseq", &rootseq,
-                           "rootref", &rootref,
-                           "names", &names,
-                           "rootdir", &rootdir) < 0) {
+    if (setroot_event_unpack (msg, &ns, &rootseq, &rootref,
+                              &names, &rootdir, &delta) < 0) {
         flux_log_error (ctx->h, "%s: flux_event_unpack", __FUNCTION__);
         return;
     }
@@ -2111,7 +2673,7 @@ static void setroot_event_cb (flux_t *h, flux_msg_handler_t *mh,
         return;
     }
 
-    setroot_event_process (ctx, root, names, rootdir, rootref, rootseq);
+    setroot_event_process (ctx, root, names, rootdir, delta, rootref, rootseq);
 }
 
 static bool disconnect_cmp (const flux_msg_t *msg, void *arg)
@@ -2193,6 +2755,7 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
     tstat_t ts = { .min = 0.0, .max = 0.0, .M = 0.0, .S = 0.0, .newM = 0.0,
                    .newS = 0.0, .n = 0 };
     int size = 0, incomplete = 0, dirty = 0;
+    int served, unserved;
     double scale = 1E-3;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
@@ -2246,10 +2809,16 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
         }
     }
 
+    readpool_get_stats (ctx->readpool, &served, &unserved);
+
     if (flux_respond_pack (h, msg,
-                           "{ s:O s:O }",
+                           "{ s:O s:O s:{ s:i s:i s:i } }",
                            "cache", cstats,
-                           "namespace", nsstats) < 0)
+                           "namespace", nsstats,
+                           "lookup threads",
+                             "count", ctx->readpool ? ctx->lookup_threads : 0,
+                             "#served", served,
+                             "#unserved", unserved) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
     json_decref (tstats);
     json_decref (cstats);
@@ -2476,17 +3045,22 @@ static void start_root_remove (struct kvs_ctx *ctx, const char *ns)
 
 static int namespace_remove (struct kvs_ctx *ctx, const char *ns)
 {
+    struct kvsroot *root;
     flux_msg_t *msg = NULL;
     int saved_errno, rc = -1;
     char *topic = NULL;
 
     /* Namespace doesn't exist or is already in process of being
      * removed */
-    if (!kvsroot_mgr_lookup_root_safe (ctx->krm, ns)) {
+    if (!(root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns))) {
         /* silently succeed */
         goto done;
     }
 
+    /* publish queued setroots before the namespace is removed */
+    if (setroot_event_flush (ctx, root) < 0)
+        flux_log_error (ctx->h, "%s: setroot_event_flush", __FUNCTION__);
+
     if (asprintf (&topic, "kvs.namespace-%s-removed", ns) < 0) {
         saved_errno = errno;
         goto cleanup;
@@ -2620,7 +3194,9 @@ error:
  * received, are put onto a queue to be processed after an unpause. By
  * doing so, a particular rank will not be kept up to date on changes
  * to the KVS.  This can be used for testing purposes, such as testing
- * if read-your-writes consistency is working.
+ * if read-your-writes consistency is working.  On rank 0, publication
+ * of setroot events is also held, so that commits applied during the
+ * pause are published as one batched event.
  */
 static void setroot_pause_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                       const flux_msg_t *msg, void *arg)
@@ -2672,27 +3248,24 @@ static void setroot_unpause_process_msg (struct kvs_ctx *ctx,
     const char *ns;
     int rootseq;
     const char *rootref;
-    json_t *rootdir = NULL;
-    json_t *names = NULL;
+    json_t *rootdir;
+    json_t *delta;
+    json_t *names;
 
-    if (flux_event_unpack (msg, NULL, "{ s:s s:i s:s s:o s:o }",
-                           "namespace", &ns,
-                           "rootseq", &rootseq,
-                           "rootref", &rootref,
-                           "names", &names,
-                           "rootdir", &rootdir) < 0) {
+    if (setroot_event_unpack (msg, &ns, &rootseq, &rootref,
+                              &names, &rootdir, &delta) < 0) {
         flux_log_error (ctx->h, "%s: flux_event_unpack", __FUNCTION__);
         return;
     }
 
-    setroot_event_process (ctx, root, names, rootdir, rootref, rootseq);
+    setroot_event_process (ctx, root, names, rootdir, delta, rootref, rootseq);
     return;
 }
 
 /* This RPC request is specifically used as a test hook.  It
  * unpauses/allows the processing of setroot events.  Any setroot
  * events that were received during a pause will be processed in the
- * order they were received.
+ * order they were received, after rank 0 publishes any it held.
  */
 static void setroot_unpause_request_cb (flux_t *h, flux_msg_handler_t *mh,
                                         const flux_msg_t *msg, void *arg)
@@ -2723,6 +3296,12 @@ static void setroot_unpause_request_cb (flux_t *h, flux_msg_handler_t *mh,
 
     root->setroot_pause = false;
 
+    /* rank 0: publish setroot events held during the pause */
+    if (ctx->rank == 0) {
+        if (setroot_event_flush (ctx, root) < 0)
+            flux_log_error (ctx->h, "%s: setroot_event_flush", __FUNCTION__);
+    }
+
     /* user never called pause if !root->setroot_queue*/
     if (root->setroot_queue) {
         while ((m = zlist_pop (root->setroot_queue))) {
@@ -2786,6 +3365,8 @@ static void process_args (struct kvs_ctx *ctx, int ac, char **av)
     for (i = 0; i < ac; i++) {
         if (strncmp (av[i], "transaction-merge=", 13) == 0)
             ctx->transaction_merge = strtoul (av[i]+13, NULL, 10);
+        else if (strncmp (av[i], "lookup-threads=", 15) == 0)
+            ctx->lookup_threads = strtoul (av[i]+15, NULL, 10);
         else
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
     }
@@ -2930,6 +3511,16 @@ int mod_main (flux_t *h, int argc, char **argv)
         goto done;
     }
     process_args (ctx, argc, argv);
+    if (ctx->lookup_threads > 0) {
+        if (!(ctx->readpool = readpool_create (flux_get_reactor (h),
+                                               ctx->cache,
+                                               ctx->lookup_threads,
+                                               lookup_offload_done_cb,
+                                               ctx))) {
+            flux_log_error (h, "error starting lookup threads");
+            goto done;
+        }
+    }
     if (ctx->rank == 0) {
         struct kvsroot *root;
         char rootref[BLOBREF_MAX_STRING_SIZE];
@@ -2979,6 +3570,12 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "flux_reactor_run");
         goto done;
     }
+    if (ctx->rank == 0) {
+        if (kvsroot_mgr_iter_roots (ctx->krm, setroot_flush_root_cb, ctx) < 0)
+            flux_log_error (h, "error publishing queued setroot events");
+    }
+    else
+        relay_commit_flush (ctx);
     /* Checkpoint the KVS root to the content backing store.
      * If backing store is not loaded, silently proceed without checkpoint.
      */
@@ -90,6 +90,8 @@ static void kvsroot_destroy (void *data)
             zlist_destroy (&root->synclist);
         if (root->setroot_queue)
             zlist_destroy (&root->setroot_queue);
+        json_decref (root->setroot_batch);
+        json_decref (root->setroot_prevdir);
         free (data);
     }
 }
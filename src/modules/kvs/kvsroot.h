@@ -12,6 +12,7 @@
 #define _FLUX_KVS_KVSROOT_H
 
 #include <stdbool.h>
+#include <jansson.h>
 #include <flux/core.h>
 
 #include "cache.h"
@@ -35,6 +36,9 @@ struct kvsroot {
     bool remove;
     bool setroot_pause;
     zlist_t *setroot_queue;
+    json_t *setroot_batch;      /* rank 0: setroots not yet published */
+    json_t *setroot_prevdir;    /* rank 0: root dir preceding the batch */
+    char setroot_prevref[BLOBREF_MAX_STRING_SIZE];
 };
 
 /* return -1 on error, 0 on success, 1 on success & to stop iterating */
@@ -73,6 +73,14 @@ struct lookup {
     /* potential return values from lookup */
     json_t *val;           /* value of lookup */
 
+    /* value of FLUX_KVS_RAW lookup, either a single blob held in the
+     * cache or a buffer owned by the lookup.
+     */
+    struct cache_entry *raw_entry;
+    void *raw_data;
+    int raw_len;
+    bool raw_valid;
+
     /* if valref_missing_refs is true, iterate on refs, else
      * return missing_ref string.
      */
@@ -100,6 +108,16 @@ struct lookup {
     } state;
 };
 
+/* A lookup without a kvsroot_mgr_t may run on a reader thread,
+ * so it uses the shared cache lookup.
+ */
+static struct cache_entry *lookup_cache_entry (lookup_t *lh, const char *ref)
+{
+    if (!lh->krm)
+        return cache_lookup_shared (lh->cache, ref);
+    return cache_lookup (lh->cache, ref);
+}
+
 static bool last_pathcomp (zlist_t *pathcomps, const void *data)
 {
     return (zlist_tail (pathcomps) == data);
@@ -237,7 +255,8 @@ static lookup_process_t symlink_check_namespace (lookup_t *lh,
     struct kvsroot *root = NULL;
     lookup_process_t ret = LOOKUP_PROCESS_ERROR;
 
-    root = kvsroot_mgr_lookup_root (lh->krm, ns);
+    if (lh->krm)
+        root = kvsroot_mgr_lookup_root (lh->krm, ns);
 
     if (!root) {
         free (lh->missing_namespace);
@@ -392,7 +411,7 @@ static lookup_process_t walk (lookup_t *lh)
                 goto error;
             }
 
-            if (!(entry = cache_lookup (lh->cache, refstr))
+            if (!(entry = lookup_cache_entry (lh, refstr))
                 || !cache_entry_get_valid (entry)) {
                 lh->missing_ref = refstr;
                 return LOOKUP_PROCESS_LOAD_MISSING_REFS;
@@ -522,7 +541,15 @@ lookup_t *lookup_create (struct cache *cache,
     lookup_t *lh = NULL;
     int saved_errno;
 
-    if (!cache || !krm || !path) {
+    if (!cache || !path || (!krm && !root_ref)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    /* raw values have no tree object form */
+    if ((flags & FLUX_KVS_RAW)
+        && (flags & (FLUX_KVS_READDIR | FLUX_KVS_READLINK
+                     | FLUX_KVS_TREEOBJ))) {
         errno = EINVAL;
         return NULL;
     }
@@ -596,12 +623,30 @@ void lookup_destroy (lookup_t *lh)
         free (lh->root_ref);
         free (lh->path);
         json_decref (lh->val);
+        cache_entry_decref (lh->raw_entry);
+        free (lh->raw_data);
         free (lh->missing_namespace);
         zlist_destroy (&lh->levels);
         free (lh);
     }
 }
 
+int lookup_set_krm (lookup_t *lh,
+                    kvsroot_mgr_t *krm,
+                    flux_t *h,
+                    bool ns_root)
+{
+    if (!lh || !krm || lh->krm || (ns_root && !lh->ns_name)) {
+        errno = EINVAL;
+        return -1;
+    }
+    lh->krm = krm;
+    lh->h = h;
+    if (ns_root)
+        lh->root_ref_set_by_user = false;
+    return 0;
+}
+
 int lookup_get_errnum (lookup_t *lh)
 {
     if (lh) {
@@ -665,7 +710,7 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
                 if (!(ref = treeobj_get_blobref (lh->valref_missing_refs, i)))
                     return -1;
 
-                if (!(entry = cache_lookup (lh->cache, ref))
+                if (!(entry = lookup_cache_entry (lh, ref))
                     || !cache_entry_get_valid (entry)) {
 
                     /* valref points to raw data, raw_data flag is always
@@ -685,6 +730,31 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
     return -1;
 }
 
+int lookup_get_raw (lookup_t *lh, const void **data, int *len)
+{
+    if (!lh
+        || lh->state != LOOKUP_STATE_FINISHED
+        || !(lh->flags & FLUX_KVS_RAW)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!lh->raw_valid) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (lh->raw_entry) {
+        if (cache_entry_get_raw (lh->raw_entry, data, len) < 0)
+            return -1;
+    }
+    else {
+        if (data)
+            *data = lh->raw_data;
+        if (len)
+            *len = lh->raw_len;
+    }
+    return 0;
+}
+
 const char *lookup_missing_namespace (lookup_t *lh)
 {
    if (lh
@@ -754,7 +824,7 @@ static int get_single_blobref_valref_value (lookup_t *lh, bool *stall)
         lh->errnum = errno;
         return -1;
     }
-    if (!(entry = cache_lookup (lh->cache, reftmp))
+    if (!(entry = lookup_cache_entry (lh, reftmp))
         || !cache_entry_get_valid (entry)) {
         lh->valref_missing_refs = lh->wdirent;
         (*stall) = true;
@@ -765,6 +835,14 @@ static int get_single_blobref_valref_value (lookup_t *lh, bool *stall)
         lh->errnum = ENOTRECOVERABLE;
         return -1;
     }
+    /* raw value is read from the cache entry when the response is sent */
+    if ((lh->flags & FLUX_KVS_RAW)) {
+        lh->raw_entry = entry;
+        cache_entry_incref (entry);
+        lh->raw_valid = true;
+        (*stall) = false;
+        return 0;
+    }
     if (!(lh->val = treeobj_create_val (valdata, len))) {
         lh->errnum = errno;
         return -1;
@@ -787,7 +865,7 @@ static int get_multi_blobref_valref_length (lookup_t *lh, int refcount,
             lh->errnum = errno;
             return -1;
         }
-        if (!(entry = cache_lookup (lh->cache, reftmp))
+        if (!(entry = lookup_cache_entry (lh, reftmp))
             || !cache_entry_get_valid (entry)) {
             lh->valref_missing_refs = lh->wdirent;
             (*stall) = true;
@@ -838,7 +916,7 @@ static char *get_multi_blobref_valref_data (lookup_t *lh, int refcount,
         reftmp = treeobj_get_blobref (lh->wdirent, i);
         assert (reftmp);
 
-        entry = cache_lookup (lh->cache, reftmp);
+        entry = lookup_cache_entry (lh, reftmp);
         assert (entry);
         assert (cache_entry_get_valid (entry));
 
@@ -873,6 +951,16 @@ static int get_multi_blobref_valref_value (lookup_t *lh, int refcount,
     if (!(valbuf = get_multi_blobref_valref_data (lh, refcount, total_len)))
         goto done;
 
+    if ((lh->flags & FLUX_KVS_RAW)) {
+        lh->raw_data = valbuf;
+        lh->raw_len = total_len;
+        lh->raw_valid = true;
+        valbuf = NULL;
+        (*stall) = false;
+        rc = 0;
+        goto done;
+    }
+
     if (!(lh->val = treeobj_create_val (valbuf, total_len))) {
         lh->errnum = errno;
         goto done;
@@ -963,7 +1051,7 @@ lookup_process_t lookup (lookup_t *lh)
                         lh->errnum = EISDIR;
                         goto error;
                     }
-                    if (!(entry = cache_lookup (lh->cache, lh->root_ref))
+                    if (!(entry = lookup_cache_entry (lh, lh->root_ref))
                         || !cache_entry_get_valid (entry)) {
                         lh->missing_ref = lh->root_ref;
                         return LOOKUP_PROCESS_LOAD_MISSING_REFS;
@@ -1061,7 +1149,7 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = errno;
                     goto error;
                 }
-                if (!(entry = cache_lookup (lh->cache, reftmp))
+                if (!(entry = lookup_cache_entry (lh, reftmp))
                     || !cache_entry_get_valid (entry)) {
                     lh->missing_ref = reftmp;
                     return LOOKUP_PROCESS_LOAD_MISSING_REFS;
@@ -1137,7 +1225,16 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = ENOTDIR;
                     goto error;
                 }
-                if (!(lh->val = treeobj_deep_copy (lh->wdirent))) {
+                if ((lh->flags & FLUX_KVS_RAW)) {
+                    if (treeobj_decode_val (lh->wdirent,
+                                            &lh->raw_data,
+                                            &lh->raw_len) < 0) {
+                        lh->errnum = errno;
+                        goto error;
+                    }
+                    lh->raw_valid = true;
+                }
+                else if (!(lh->val = treeobj_deep_copy (lh->wdirent))) {
                     lh->errnum = errno;
                     goto error;
                 }
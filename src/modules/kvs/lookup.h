@@ -37,6 +37,10 @@ typedef int (*lookup_ref_f)(lookup_t *c,
  * - root_seq is not used and is solely used for convenience being
  *   passed alongside root_ref.  Can be retrieved later with
  *   lookup_get_root_seq().  Will not be stored if root_ref is NULL.
+ * - krm may be NULL if root_ref is specified.  Such a lookup reads the
+ *   cache with cache_lookup_shared(), so it may be run on a reader
+ *   thread that holds the cache read lock.  A symlink into another
+ *   namespace returns LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE.
  */
 lookup_t *lookup_create (struct cache *cache,
                          kvsroot_mgr_t *krm,
@@ -48,6 +52,18 @@ lookup_t *lookup_create (struct cache *cache,
                          int flags,
                          flux_t *h);
 
+/* Give a lookup created without a kvsroot_mgr_t to the thread that
+ * owns 'krm', typically after it stalled on a reader thread.  The next
+ * lookup() resumes the walk at the level where it stalled, using 'krm'
+ * for namespaces and 'h' for logging.  Set 'ns_root' if the root_ref
+ * was taken from the namespace rather than given by the requester, so
+ * the namespace is rechecked on replay as for other namespace lookups.
+ */
+int lookup_set_krm (lookup_t *lh,
+                    kvsroot_mgr_t *krm,
+                    flux_t *h,
+                    bool ns_root);
+
 /* Destroy a lookup handle */
 void lookup_destroy (lookup_t *lh);
 
@@ -67,6 +83,13 @@ int lookup_set_aux_errnum (lookup_t *lh, int errnum);
  * memory. */
 json_t *lookup_get_value (lookup_t *lh);
 
+/* Get resulting value of a FLUX_KVS_RAW lookup after lookup() returns
+ * LOOKUP_PROCESS_FINISHED.  The data remains valid until the lookup
+ * handle is destroyed.  Returns -1 with errno ENOENT if no value was
+ * found, or EINVAL if FLUX_KVS_RAW was not set.
+ */
+int lookup_get_raw (lookup_t *lh, const void **data, int *len);
+
 /* On lookup stall b/c of missing reference(s), get missing reference
  * that should be loaded into the KVS cache via callback function.
  *
@@ -0,0 +1,418 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "lookup.h"
+#include "readpool.h"
+
+struct readpool_req {
+    const flux_msg_t *msg;
+    bool plus;
+    void *aux;
+
+    /* inputs, owned by the request */
+    char *ns;
+    char *root_ref;
+    int root_seq;
+    char *key;
+    int flags;
+    struct flux_msg_cred cred;
+
+    /* outputs */
+    char *payload;
+    int errnum;
+    lookup_t *lh;               /* stalled lookup, passed to the owner */
+
+    struct readpool_req *next;
+};
+
+/* FIFO of requests, linked through the requests so that handing a
+ * request between threads never allocates.
+ */
+struct reqlist {
+    struct readpool_req *head;
+    struct readpool_req *tail;
+};
+
+struct readpool {
+    struct cache *cache;
+    pthread_t *threads;
+    int nthreads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct reqlist pending;     /* submitted, not yet taken by a reader */
+    struct reqlist done;        /* finished, not yet seen by the owner */
+    bool shutdown;
+
+    int efd;                    /* signaled when 'done' becomes non-empty */
+    flux_watcher_t *w;
+    readpool_done_f cb;
+    void *arg;
+
+    int served;
+    int unserved;
+};
+
+static void readpool_req_destroy (struct readpool_req *req)
+{
+    if (req) {
+        int saved_errno = errno;
+        flux_msg_decref (req->msg);
+        free (req->ns);
+        free (req->root_ref);
+        free (req->key);
+        free (req->payload);
+        lookup_destroy (req->lh);
+        free (req);
+        errno = saved_errno;
+    }
+}
+
+static void reqlist_append (struct reqlist *l, struct readpool_req *req)
+{
+    req->next = NULL;
+    if (l->tail)
+        l->tail->next = req;
+    else
+        l->head = req;
+    l->tail = req;
+}
+
+static struct readpool_req *reqlist_pop (struct reqlist *l)
+{
+    struct readpool_req *req;
+
+    if ((req = l->head)) {
+        if (!(l->head = req->next))
+            l->tail = NULL;
+        req->next = NULL;
+    }
+    return req;
+}
+
+static struct readpool_req *readpool_req_create (const flux_msg_t *msg,
+                                                 bool plus,
+                                                 const char *ns,
+                                                 const char *root_ref,
+                                                 int root_seq,
+                                                 const char *key,
+                                                 int flags,
+                                                 struct flux_msg_cred cred,
+                                                 void *aux)
+{
+    struct readpool_req *req;
+
+    if (!(req = calloc (1, sizeof (*req))))
+        return NULL;
+    if ((ns && !(req->ns = strdup (ns)))
+        || !(req->root_ref = strdup (root_ref))
+        || !(req->key = strdup (key))) {
+        readpool_req_destroy (req);
+        return NULL;
+    }
+    req->msg = flux_msg_incref (msg);
+    req->plus = plus;
+    req->root_seq = root_seq;
+    req->flags = flags;
+    req->cred = cred;
+    req->aux = aux;
+    return req;
+}
+
+/* Encode the response payload, mirroring lookup_request_cb() and
+ * lookup_plus_request_cb() in kvs.c.
+ */
+static int encode_payload (struct readpool_req *req, json_t *val)
+{
+    json_t *o;
+
+    if (req->plus) {
+        if (!val)
+            o = json_pack ("{ s:i s:i s:s }",
+                           "errno", ENOENT,
+                           "rootseq", req->root_seq,
+                           "rootref", req->root_ref);
+        else
+            o = json_pack ("{ s:O s:i s:s }",
+                           "val", val,
+                           "rootseq", req->root_seq,
+                           "rootref", req->root_ref);
+    }
+    else {
+        if (!val) {
+            req->errnum = ENOENT;
+            return 0;
+        }
+        o = json_pack ("{ s:O }", "val", val);
+    }
+    if (!o || !(req->payload = json_dumps (o, JSON_COMPACT))) {
+        json_decref (o);
+        return -1;
+    }
+    json_decref (o);
+    return 0;
+}
+
+/* Run the lookup under the cache read lock.  The value returned by
+ * lookup_get_value() is a copy, so it may be encoded after the lock
+ * is released.  A lookup that stalls is kept so the owner can resume
+ * it where it stopped.  Its walk holds references on the cache entries
+ * it has passed through, so they cannot expire in the meantime.
+ */
+static void readpool_serve (struct readpool *rp, struct readpool_req *req)
+{
+    lookup_t *lh;
+    lookup_process_t ret;
+    json_t *val = NULL;
+
+    cache_read_lock (rp->cache);
+    if (!(lh = lookup_create (rp->cache,
+                              NULL,
+                              req->ns,
+                              req->root_ref,
+                              req->root_seq,
+                              req->key,
+                              req->cred,
+                              req->flags,
+                              NULL))) {
+        cache_read_unlock (rp->cache);
+        return;
+    }
+    ret = lookup (lh);
+    if (ret == LOOKUP_PROCESS_FINISHED)
+        val = lookup_get_value (lh);
+    else if (ret == LOOKUP_PROCESS_ERROR)
+        req->errnum = lookup_get_errnum (lh);
+    if (ret == LOOKUP_PROCESS_LOAD_MISSING_REFS
+        || ret == LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE)
+        req->lh = lh;
+    else
+        lookup_destroy (lh);
+    cache_read_unlock (rp->cache);
+
+    if (ret == LOOKUP_PROCESS_FINISHED) {
+        if (encode_payload (req, val) < 0)
+            req->errnum = 0; // let the owner retry
+    }
+    json_decref (val);
+}
+
+static void readpool_notify (struct readpool *rp)
+{
+    uint64_t val = 1;
+
+    /* The counter is cleared by each read, so it cannot overflow.
+     */
+    while (write (rp->efd, &val, sizeof (val)) < 0 && errno == EINTR)
+        ;
+}
+
+static void *readpool_thread (void *arg)
+{
+    struct readpool *rp = arg;
+    struct readpool_req *req;
+    bool wake;
+
+    for (;;) {
+        req = NULL;
+        pthread_mutex_lock (&rp->lock);
+        while (!rp->shutdown && !(req = reqlist_pop (&rp->pending)))
+            pthread_cond_wait (&rp->cond, &rp->lock);
+        pthread_mutex_unlock (&rp->lock);
+        if (!req)
+            break;
+
+        readpool_serve (rp, req);
+
+        pthread_mutex_lock (&rp->lock);
+        wake = (rp->done.head == NULL);
+        reqlist_append (&rp->done, req);
+        pthread_mutex_unlock (&rp->lock);
+        if (wake)
+            readpool_notify (rp);
+    }
+    return NULL;
+}
+
+/* Clear the eventfd before taking the done list, so a reader that
+ * appends after the list is taken signals again.
+ */
+static void readpool_done_cb (flux_reactor_t *r,
+                              flux_watcher_t *w,
+                              int revents,
+                              void *arg)
+{
+    struct readpool *rp = arg;
+    struct readpool_req *req;
+    struct reqlist done;
+    uint64_t val;
+
+    if (read (rp->efd, &val, sizeof (val)) < 0 && errno != EAGAIN)
+        return;
+    pthread_mutex_lock (&rp->lock);
+    done = rp->done;
+    rp->done.head = rp->done.tail = NULL;
+    pthread_mutex_unlock (&rp->lock);
+
+    while ((req = reqlist_pop (&done))) {
+        if (req->payload || req->errnum)
+            rp->served++;
+        else
+            rp->unserved++;
+        rp->cb (req->msg,
+                req->plus,
+                req->payload,
+                req->errnum,
+                req->lh,
+                req->aux,
+                rp->arg);
+        req->lh = NULL;
+        readpool_req_destroy (req);
+    }
+}
+
+int readpool_submit (struct readpool *rp,
+                     const flux_msg_t *msg,
+                     bool plus,
+                     const char *ns,
+                     const char *root_ref,
+                     int root_seq,
+                     const char *key,
+                     int flags,
+                     struct flux_msg_cred cred,
+                     void *aux)
+{
+    struct readpool_req *req;
+
+    if (!rp || !msg || !root_ref || !key) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(req = readpool_req_create (msg,
+                                     plus,
+                                     ns,
+                                     root_ref,
+                                     root_seq,
+                                     key,
+                                     flags,
+                                     cred,
+                                     aux)))
+        return -1;
+    pthread_mutex_lock (&rp->lock);
+    reqlist_append (&rp->pending, req);
+    pthread_cond_signal (&rp->cond);
+    pthread_mutex_unlock (&rp->lock);
+    return 0;
+}
+
+void readpool_get_stats (struct readpool *rp, int *served, int *unserved)
+{
+    if (served)
+        *served = rp ? rp->served : 0;
+    if (unserved)
+        *unserved = rp ? rp->unserved : 0;
+}
+
+static void reqlist_clear (struct reqlist *l)
+{
+    struct readpool_req *req;
+
+    while ((req = reqlist_pop (l)))
+        readpool_req_destroy (req);
+}
+
+void readpool_destroy (struct readpool *rp)
+{
+    if (rp) {
+        int saved_errno = errno;
+        int i;
+
+        pthread_mutex_lock (&rp->lock);
+        rp->shutdown = true;
+        pthread_cond_broadcast (&rp->cond);
+        pthread_mutex_unlock (&rp->lock);
+        for (i = 0; i < rp->nthreads; i++)
+            pthread_join (rp->threads[i], NULL);
+        free (rp->threads);
+        reqlist_clear (&rp->pending);
+        reqlist_clear (&rp->done);
+        flux_watcher_destroy (rp->w);
+        if (rp->efd >= 0)
+            close (rp->efd);
+        pthread_cond_destroy (&rp->cond);
+        pthread_mutex_destroy (&rp->lock);
+        free (rp);
+        errno = saved_errno;
+    }
+}
+
+struct readpool *readpool_create (flux_reactor_t *r,
+                                  struct cache *cache,
+                                  int nthreads,
+                                  readpool_done_f cb,
+                                  void *arg)
+{
+    struct readpool *rp;
+    int e;
+
+    if (!r || !cache || nthreads <= 0 || !cb) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(rp = calloc (1, sizeof (*rp))))
+        return NULL;
+    rp->cache = cache;
+    rp->cb = cb;
+    rp->arg = arg;
+    rp->efd = -1;
+    pthread_mutex_init (&rp->lock, NULL);
+    pthread_cond_init (&rp->cond, NULL);
+    if ((rp->efd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+        goto error;
+    if (!(rp->w = flux_fd_watcher_create (r,
+                                          rp->efd,
+                                          FLUX_POLLIN,
+                                          readpool_done_cb,
+                                          rp)))
+        goto error;
+    flux_watcher_start (rp->w);
+    if (!(rp->threads = calloc (nthreads, sizeof (rp->threads[0]))))
+        goto error;
+    for (rp->nthreads = 0; rp->nthreads < nthreads; rp->nthreads++) {
+        if ((e = pthread_create (&rp->threads[rp->nthreads],
+                                 NULL,
+                                 readpool_thread,
+                                 rp)) != 0) {
+            errno = e;
+            goto error;
+        }
+    }
+    return rp;
+error:
+    readpool_destroy (rp);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,80 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_KVS_READPOOL_H
+#define _FLUX_KVS_READPOOL_H
+
+#include <stdbool.h>
+#include <flux/core.h>
+
+#include "cache.h"
+#include "lookup.h"
+
+/* Pool of reader threads that serve KVS lookups against a snapshot
+ * root reference, reading the cache under its read lock.  The thread
+ * that owns the cache submits lookups and keeps ownership of everything
+ * else, including cache fills.
+ *
+ * A lookup that completes is encoded on the reader thread and returned
+ * as a response payload.  A lookup that needs anything the reader cannot
+ * provide (a missing blob, a namespace) is returned unserved, along with
+ * its stalled lookup handle so the owner can resume the walk.
+ */
+
+/* Called on the owner's reactor for each submitted lookup.
+ * If 'payload' is non-NULL, respond with it.  Otherwise if 'errnum' is
+ * non-zero, respond with that error.  Otherwise the lookup was not served.
+ * If 'lh' is non-NULL, it is the stalled lookup and the callback takes
+ * ownership of it (see lookup_set_krm()).
+ */
+typedef void (*readpool_done_f)(const flux_msg_t *msg,
+                                bool plus,
+                                const char *payload,
+                                int errnum,
+                                lookup_t *lh,
+                                void *aux,
+                                void *arg);
+
+struct readpool *readpool_create (flux_reactor_t *r,
+                                  struct cache *cache,
+                                  int nthreads,
+                                  readpool_done_f cb,
+                                  void *arg);
+
+/* Stop and join reader threads.  Lookups in progress are discarded
+ * without calling the done callback.
+ */
+void readpool_destroy (struct readpool *rp);
+
+/* Submit a lookup of 'key' in directory 'root_ref'.  If 'plus' is true,
+ * the payload is formatted as a kvs.lookup-plus response, otherwise as
+ * a kvs.lookup response.  A reference is taken on 'msg' until the done
+ * callback returns.  'aux' is passed through to the done callback.
+ */
+int readpool_submit (struct readpool *rp,
+                     const flux_msg_t *msg,
+                     bool plus,
+                     const char *ns,
+                     const char *root_ref,
+                     int root_seq,
+                     const char *key,
+                     int flags,
+                     struct flux_msg_cred cred,
+                     void *aux);
+
+/* Get counts of lookups served and not served by reader threads.
+ */
+void readpool_get_stats (struct readpool *rp, int *served, int *unserved);
+
+#endif /* !_FLUX_KVS_READPOOL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -12,6 +12,8 @@
 #include "config.h"
 #endif
 #include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
 #include <jansson.h>
 
 #include "src/common/libkvs/treeobj.h"
@@ -562,6 +564,83 @@ void cache_remove_entry_tests (void)
     cache_destroy (cache);
 }
 
+#define SHARED_ENTRIES  64
+#define SHARED_READERS  4
+#define SHARED_LOOKUPS  200000
+
+struct shared_reader {
+    pthread_t t;
+    struct cache *cache;
+    int misses;
+};
+
+static void *shared_reader_thread (void *arg)
+{
+    struct shared_reader *sr = arg;
+    char ref[32];
+    int i;
+
+    for (i = 0; i < SHARED_LOOKUPS; i++) {
+        if (i % 1000 == 0)
+            cache_read_lock (sr->cache);
+        snprintf (ref, sizeof (ref), "shared-ref-%d", i % SHARED_ENTRIES);
+        if (!cache_lookup_shared (sr->cache, ref))
+            sr->misses++;
+        if (i % 1000 == 999)
+            cache_read_unlock (sr->cache);
+    }
+    if (i % 1000 != 0)
+        cache_read_unlock (sr->cache);
+    return NULL;
+}
+
+/* Shared readers must find every entry, while the owner looks up
+ * other entries concurrently.
+ */
+void cache_shared_lookup_tests (void)
+{
+    struct cache *cache;
+    struct shared_reader sr[SHARED_READERS];
+    char ref[32];
+    int misses = 0;
+    int owner_misses = 0;
+    int i;
+
+    if (!(cache = cache_create (NULL)))
+        BAIL_OUT ("cache_create failed");
+    for (i = 0; i < SHARED_ENTRIES; i++) {
+        struct cache_entry *e;
+        snprintf (ref, sizeof (ref), "shared-ref-%d", i);
+        if (!(e = cache_entry_create (ref))
+            || cache_entry_set_raw (e, "abcd", 4) < 0
+            || cache_insert (cache, e) < 0)
+            BAIL_OUT ("could not create cache entry");
+    }
+    for (i = 0; i < SHARED_READERS; i++) {
+        sr[i].cache = cache;
+        sr[i].misses = 0;
+        if (pthread_create (&sr[i].t, NULL, shared_reader_thread, &sr[i]) != 0)
+            BAIL_OUT ("pthread_create failed");
+    }
+    for (i = 0; i < SHARED_LOOKUPS; i++) {
+        snprintf (ref, sizeof (ref), "shared-ref-%d",
+                  (i * 7) % SHARED_ENTRIES);
+        if (!cache_lookup (cache, ref))
+            owner_misses++;
+        (void)cache_lookup (cache, "shared-ref-missing");
+    }
+    for (i = 0; i < SHARED_READERS; i++) {
+        if (pthread_join (sr[i].t, NULL) != 0)
+            BAIL_OUT ("pthread_join failed");
+        misses += sr[i].misses;
+    }
+    ok (misses == 0,
+        "cache_lookup_shared found every entry with concurrent readers");
+    ok (owner_misses == 0,
+        "cache_lookup found every entry with concurrent readers");
+    cache_destroy (cache);
+}
+
 void cache_expiration_tests (void)
 {
     struct cache *cache;
@@ -726,6 +805,7 @@ int main (int argc, char *argv[])
     cache_expiration_tests ();
     cache_blobref_tests ();
     cache_remove_entry_tests ();
+    cache_shared_lookup_tests ();
 
     done_testing ();
     return (0);
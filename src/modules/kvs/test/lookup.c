@@ -387,7 +387,7 @@ void basic_lookup (void) {
                              krm,
                              NULL,
                              root_ref,
-                             18,
+                             0,
                              "val",
                              owner_cred,
                              0,
@@ -3319,6 +3319,264 @@ void lookup_stall_ref_expire_cache_entries (void) {
     json_decref (root);
 }
 
+/* lookup without a kvsroot_mgr_t, as done by reader threads */
+void lookup_no_krm (void) {
+    json_t *root;
+    json_t *test;
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    lookup_t *lh;
+    char valref_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+
+    ltest_init (&cache, &krm);
+
+    /* This cache is
+     *
+     * valref_ref
+     * "abcd"
+     *
+     * root_ref
+     * "val" : val to "foo"
+     * "valref" : valref to valref_ref
+     * "symlinkNS" : symlinkNS to "val" in namespace=A
+     */
+
+    blobref_hash ("sha1", "abcd", 4, valref_ref, sizeof (valref_ref));
+    (void)cache_insert (cache, create_cache_entry_raw (valref_ref, "abcd", 4));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_val (root, "val", "foo", 3);
+    _treeobj_insert_entry_valref (root, "valref", valref_ref);
+    _treeobj_insert_entry_symlink (root, "symlinkNS", "A", "val");
+    treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    ok (lookup_create (cache,
+                       NULL,
+                       KVS_PRIMARY_NAMESPACE,
+                       NULL,
+                       0,
+                       "val",
+                       owner_cred,
+                       0,
+                       NULL) == NULL,
+        "lookup_create without krm fails without root ref");
+
+    cache_read_lock (cache);
+
+    ok ((lh = lookup_create (cache,
+                             NULL,
+                             KVS_PRIMARY_NAMESPACE,
+                             root_ref,
+                             0,
+                             "val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create val without krm");
+    test = treeobj_create_val ("foo", 3);
+    check_value (lh, test, "lookup val without krm");
+    json_decref (test);
+
+    ok ((lh = lookup_create (cache,
+                             NULL,
+                             NULL,
+                             root_ref,
+                             0,
+                             "valref",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create valref without krm");
+    test = treeobj_create_val ("abcd", 4);
+    check_value (lh, test, "lookup valref without krm");
+    json_decref (test);
+
+    ok ((lh = lookup_create (cache,
+                             NULL,
+                             NULL,
+                             root_ref,
+                             0,
+                             "symlinkNS",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create symlinkNS without krm");
+    ok (lookup (lh) == LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE,
+        "lookup symlinkNS without krm stalls on namespace");
+    ok (lookup_missing_namespace (lh)
+        && !strcmp (lookup_missing_namespace (lh), "A"),
+        "lookup_missing_namespace returns A");
+    lookup_destroy (lh);
+
+    cache_read_unlock (cache);
+
+    json_decref (root);
+    ltest_finalize (cache, krm);
+}
+
+/* FLUX_KVS_RAW lookups return value bytes, not a tree object */
+void check_raw (lookup_t *lh, const char *expected, const char *msg)
+{
+    const void *data;
+    int len;
+
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "%s: lookup finished", msg);
+    ok (lookup_get_value (lh) == NULL,
+        "%s: lookup_get_value returns NULL", msg);
+    ok (lookup_get_raw (lh, &data, &len) == 0
+        && len == strlen (expected)
+        && !memcmp (data, expected, len),
+        "%s: lookup_get_raw returns expected value", msg);
+    lookup_destroy (lh);
+}
+
+void lookup_raw (void) {
+    json_t *root;
+    json_t *valref_multi;
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    lookup_t *lh;
+    const void *data;
+    int len;
+    char valref1_ref[BLOBREF_MAX_STRING_SIZE];
+    char valref2_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+
+    ltest_init (&cache, &krm);
+
+    /* This cache is
+     *
+     * valref1_ref
+     * "abcd"
+     *
+     * valref2_ref
+     * "efgh"
+     *
+     * root_ref
+     * "val" : val to "foo"
+     * "valref" : valref to valref1_ref
+     * "valref_multi" : valref to [ valref1_ref, valref2_ref ]
+     */
+
+    blobref_hash ("sha1", "abcd", 4, valref1_ref, sizeof (valref1_ref));
+    blobref_hash ("sha1", "efgh", 4, valref2_ref, sizeof (valref2_ref));
+    (void)cache_insert (cache, create_cache_entry_raw (valref1_ref, "abcd", 4));
+    (void)cache_insert (cache, create_cache_entry_raw (valref2_ref, "efgh", 4));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_val (root, "val", "foo", 3);
+    _treeobj_insert_entry_valref (root, "valref", valref1_ref);
+    valref_multi = treeobj_create_valref (valref1_ref);
+    treeobj_append_blobref (valref_multi, valref2_ref);
+    treeobj_insert_entry (root, "valref_multi", valref_multi);
+    json_decref (valref_multi);
+    treeobj_hash ("sha1", root, root_ref, sizeof (root_ref));
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref, 0);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "val",
+                             owner_cred,
+                             FLUX_KVS_RAW,
+                             NULL)) != NULL,
+        "lookup_create val raw");
+    check_raw (lh, "foo", "lookup val raw");
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "valref",
+                             owner_cred,
+                             FLUX_KVS_RAW,
+                             NULL)) != NULL,
+        "lookup_create valref raw");
+    check_raw (lh, "abcd", "lookup valref raw");
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "valref_multi",
+                             owner_cred,
+                             FLUX_KVS_RAW,
+                             NULL)) != NULL,
+        "lookup_create valref_multi raw");
+    check_raw (lh, "abcdefgh", "lookup valref_multi raw");
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "missing",
+                             owner_cred,
+                             FLUX_KVS_RAW,
+                             NULL)) != NULL,
+        "lookup_create missing raw");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup missing raw finished");
+    errno = 0;
+    ok (lookup_get_raw (lh, &data, &len) < 0 && errno == ENOENT,
+        "lookup_get_raw on missing key fails with ENOENT");
+    lookup_destroy (lh);
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             ".",
+                             owner_cred,
+                             FLUX_KVS_RAW,
+                             NULL)) != NULL,
+        "lookup_create root raw");
+    check_error (lh, EISDIR, "lookup root raw");
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             NULL,
+                             0,
+                             "val",
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create val");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup val finished");
+    errno = 0;
+    ok (lookup_get_raw (lh, &data, &len) < 0 && errno == EINVAL,
+        "lookup_get_raw fails with EINVAL without FLUX_KVS_RAW");
+    lookup_destroy (lh);
+
+    errno = 0;
+    ok (lookup_create (cache,
+                       krm,
+                       KVS_PRIMARY_NAMESPACE,
+                       NULL,
+                       0,
+                       "val",
+                       owner_cred,
+                       FLUX_KVS_RAW | FLUX_KVS_TREEOBJ,
+                       NULL) == NULL
+        && errno == EINVAL,
+        "lookup_create fails with FLUX_KVS_RAW | FLUX_KVS_TREEOBJ");
+
+    json_decref (root);
+    ltest_finalize (cache, krm);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3341,6 +3599,8 @@ int main (int argc, char *argv[])
     lookup_stall_ref ();
     lookup_stall_namespace_removed ();
     lookup_stall_ref_expire_cache_entries ();
+    lookup_no_krm ();
+    lookup_raw ();
 
     done_testing ();
     return (0);
@@ -0,0 +1,305 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libkvs/treeobj.h"
+#include "src/common/libutil/blobref.h"
+#include "src/modules/kvs/cache.h"
+#include "src/modules/kvs/kvsroot.h"
+#include "src/modules/kvs/lookup.h"
+#include "src/modules/kvs/readpool.h"
+
+struct flux_msg_cred owner_cred = { .userid = 0, .rolemask = FLUX_ROLE_OWNER };
+
+struct result {
+    char *payload;
+    int errnum;
+    lookup_t *lh;
+    bool served;
+    bool done;
+};
+
+struct test_ctx {
+    flux_reactor_t *r;
+    struct result results[8];
+    int count;
+    int expected;
+};
+
+static void done_cb (const flux_msg_t *msg,
+                     bool plus,
+                     const char *payload,
+                     int errnum,
+                     lookup_t *lh,
+                     void *aux,
+                     void *arg)
+{
+    struct test_ctx *ctx = arg;
+    struct result *res = aux;
+
+    res->payload = payload ? strdup (payload) : NULL;
+    res->errnum = errnum;
+    res->lh = lh;
+    res->served = (payload || errnum);
+    res->done = true;
+    if (++ctx->count == ctx->expected)
+        flux_reactor_stop (ctx->r);
+}
+
+static int missing_ref_cb (lookup_t *lh, const char *ref, void *data)
+{
+    char *buf = data;
+
+    if (strlen (ref) >= BLOBREF_MAX_STRING_SIZE)
+        return -1;
+    strcpy (buf, ref);
+    return 0;
+}
+
+static void insert_treeobj (struct cache *cache,
+                            json_t *o,
+                            char *ref,
+                            int ref_len)
+{
+    struct cache_entry *entry;
+    char *s;
+
+    if (!(s = treeobj_encode (o))
+        || blobref_hash ("sha1", s, strlen (s), ref, ref_len) < 0
+        || !(entry = cache_entry_create (ref))
+        || cache_entry_set_raw (entry, s, strlen (s)) < 0
+        || cache_insert (cache, entry) < 0)
+        BAIL_OUT ("error inserting cache entry");
+    free (s);
+}
+
+static void submit (struct readpool *rp,
+                    bool plus,
+                    const char *root_ref,
+                    const char *key,
+                    struct result *res)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_request_encode ("kvs.lookup", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    ok (readpool_submit (rp,
+                         msg,
+                         plus,
+                         "primary",
+                         root_ref,
+                         42,
+                         key,
+                         0,
+                         owner_cred,
+                         res) == 0,
+        "readpool_submit %s%s works", key, plus ? " (plus)" : "");
+    flux_msg_destroy (msg);
+}
+
+void test_lookups (void)
+{
+    struct test_ctx ctx;
+    struct cache *cache;
+    struct readpool *rp;
+    kvsroot_mgr_t *krm;
+    json_t *root;
+    json_t *dir;
+    json_t *val;
+    json_t *dirval;
+    char dir_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    char *s;
+    int served, unserved;
+    json_t *o;
+    int seq;
+    int i;
+
+    memset (&ctx, 0, sizeof (ctx));
+    if (!(ctx.r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    if (!(cache = cache_create (ctx.r)))
+        BAIL_OUT ("cache_create failed");
+
+    /* root_ref
+     * "val" : val to "foo"
+     * "dir" : dirref to dir_ref, which is not in the cache
+     *
+     * dir_ref
+     * "val" : val to "bar"
+     */
+    dir = treeobj_create_dir ();
+    dirval = treeobj_create_val ("bar", 3);
+    treeobj_insert_entry (dir, "val", dirval);
+    if (!(s = treeobj_encode (dir))
+        || blobref_hash ("sha1", s, strlen (s), dir_ref, sizeof (dir_ref)) < 0)
+        BAIL_OUT ("error computing directory blobref");
+    free (s);
+    root = treeobj_create_dir ();
+    val = treeobj_create_val ("foo", 3);
+    treeobj_insert_entry (root, "val", val);
+    o = treeobj_create_dirref (dir_ref);
+    treeobj_insert_entry (root, "dir", o);
+    json_decref (o);
+    insert_treeobj (cache, root, root_ref, sizeof (root_ref));
+
+    ok ((rp = readpool_create (ctx.r, cache, 2, done_cb, &ctx)) != NULL,
+        "readpool_create works");
+
+    submit (rp, false, root_ref, "val", &ctx.results[0]);
+    submit (rp, false, root_ref, "missing", &ctx.results[1]);
+    submit (rp, true, root_ref, "missing", &ctx.results[2]);
+    submit (rp, false, root_ref, "dir.val", &ctx.results[3]);
+    submit (rp, true, root_ref, "val", &ctx.results[4]);
+    ctx.expected = 5;
+
+    ok (flux_reactor_run (ctx.r, 0) >= 0,
+        "reactor ran until all lookups were returned");
+    for (i = 0; i < ctx.expected; i++) {
+        if (!ctx.results[i].done)
+            break;
+    }
+    ok (i == ctx.expected,
+        "all lookups were returned");
+
+    o = NULL;
+    ok (ctx.results[0].payload
+        && (o = json_loads (ctx.results[0].payload, 0, NULL))
+        && json_equal (json_object_get (o, "val"), val),
+        "lookup of cached value was served with its value");
+    json_decref (o);
+
+    ok (ctx.results[1].served
+        && !ctx.results[1].payload
+        && ctx.results[1].errnum == ENOENT,
+        "lookup of missing key was served with ENOENT");
+
+    o = NULL;
+    ok (ctx.results[2].payload
+        && (o = json_loads (ctx.results[2].payload, 0, NULL))
+        && json_unpack (o, "{s:i s:i}", "errno", &i, "rootseq", &seq) == 0
+        && i == ENOENT
+        && seq == 42,
+        "lookup-plus of missing key was served with errno and rootseq");
+    json_decref (o);
+
+    ok (!ctx.results[3].served,
+        "lookup through uncached directory was not served");
+    ok (ctx.results[3].lh != NULL,
+        "stalled lookup handle was returned");
+    ok (lookup_iter_missing_refs (ctx.results[3].lh, missing_ref_cb, ref) == 0
+        && !strcmp (ref, dir_ref),
+        "stalled lookup is missing only the uncached directory");
+
+    o = NULL;
+    ok (ctx.results[4].payload
+        && (o = json_loads (ctx.results[4].payload, 0, NULL))
+        && json_equal (json_object_get (o, "val"), val)
+        && json_object_get (o, "rootref")
+        && !strcmp (json_string_value (json_object_get (o, "rootref")),
+                    root_ref),
+        "lookup-plus of cached value was served with value and rootref");
+    json_decref (o);
+
+    readpool_get_stats (rp, &served, &unserved);
+    ok (served == 4 && unserved == 1,
+        "readpool_get_stats reports 4 served, 1 unserved");
+
+    readpool_destroy (rp);
+
+    /* Resume the stalled lookup on this thread once the directory is
+     * cached, as the kvs module does.
+     */
+    if (!(krm = kvsroot_mgr_create (NULL, NULL)))
+        BAIL_OUT ("kvsroot_mgr_create failed");
+    insert_treeobj (cache, dir, ref, sizeof (ref));
+    ok (lookup_set_krm (ctx.results[3].lh, krm, NULL, false) == 0,
+        "lookup_set_krm works on stalled lookup");
+    errno = 0;
+    ok (lookup_set_krm (ctx.results[3].lh, krm, NULL, false) < 0
+        && errno == EINVAL,
+        "lookup_set_krm fails with EINVAL if krm is already set");
+    o = NULL;
+    ok (lookup (ctx.results[3].lh) == LOOKUP_PROCESS_FINISHED
+        && (o = lookup_get_value (ctx.results[3].lh))
+        && json_equal (o, dirval),
+        "resumed lookup finds dir.val");
+    json_decref (o);
+    lookup_destroy (ctx.results[3].lh);
+    kvsroot_mgr_destroy (krm);
+
+    for (i = 0; i < ctx.expected; i++)
+        free (ctx.results[i].payload);
+    json_decref (dirval);
+    json_decref (dir);
+    json_decref (val);
+    json_decref (root);
+    cache_destroy (cache);
+    flux_reactor_destroy (ctx.r);
+}
+
+void test_errors (void)
+{
+    flux_reactor_t *r;
+    struct cache *cache;
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    if (!(cache = cache_create (r)))
+        BAIL_OUT ("cache_create failed");
+
+    errno = 0;
+    ok (readpool_create (NULL, cache, 1, done_cb, NULL) == NULL
+        && errno == EINVAL,
+        "readpool_create r=NULL fails with EINVAL");
+    errno = 0;
+    ok (readpool_create (r, cache, 0, done_cb, NULL) == NULL
+        && errno == EINVAL,
+        "readpool_create nthreads=0 fails with EINVAL");
+    errno = 0;
+    ok (readpool_create (r, cache, 1, NULL, NULL) == NULL
+        && errno == EINVAL,
+        "readpool_create cb=NULL fails with EINVAL");
+    errno = 0;
+    ok (readpool_submit (NULL, NULL, false, NULL, NULL, 0, NULL, 0,
+                         owner_cred, NULL) < 0
+        && errno == EINVAL,
+        "readpool_submit rp=NULL fails with EINVAL");
+    lives_ok ({readpool_destroy (NULL);},
+              "readpool_destroy NULL doesn't crash");
+
+    cache_destroy (cache);
+    flux_reactor_destroy (r);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_lookups ();
+    test_errors ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
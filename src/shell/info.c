@@ -164,6 +164,50 @@ out:
     return rc;
 }
 
+/*  Parse jobinfo object {"jobspec":{...}, "R":{...}} delivered by the
+ *   job-exec module through the file named by FLUX_SHELL_JOBINFO
+ *   ("-" for stdin).  This avoids a job-info lookup per shell at launch.
+ */
+static int shell_init_jobinfo_file (flux_shell_t *shell,
+                                    struct shell_info *info,
+                                    const char *path)
+{
+    int rc = -1;
+    char *s;
+    json_t *o = NULL;
+    json_t *jobspec;
+    json_t *R;
+    json_error_t error;
+
+    if (!(s = parse_arg_file (path)))
+        return -1;
+    if (!(o = json_loads (s, 0, &error))) {
+        shell_log_error ("error parsing jobinfo: %s", error.text);
+        goto out;
+    }
+    if (json_unpack_ex (o, &error, 0,
+                        "{s:o s:o}",
+                        "jobspec", &jobspec,
+                        "R", &R) < 0) {
+        shell_log_error ("error decoding jobinfo: %s", error.text);
+        goto out;
+    }
+    if (!(info->jobspec = jobspec_parse_json (jobspec, &error))) {
+        shell_log_error ("error parsing jobspec: %s", error.text);
+        goto out;
+    }
+    info->R = json_incref (R);
+    if (!(info->rcalc = rcalc_create_json (info->R))) {
+        shell_log_error ("error decoding R");
+        goto out;
+    }
+    rc = 0;
+out:
+    json_decref (o);
+    free (s);
+    return rc;
+}
+
 static int get_per_resource_option (struct jobspec *jobspec,
                                     const char **typep,
                                     int *countp)
@@ -187,6 +231,7 @@ struct shell_info *shell_info_create (flux_shell_t *shell)
     struct shell_info *info;
     char *R = NULL;
     char *jobspec = NULL;
+    const char *jobinfo;
     const char *per_resource = NULL;
     int per_resource_count = -1;
     int broker_rank = shell->broker_rank;
@@ -202,7 +247,14 @@ struct shell_info *shell_info_create (flux_shell_t *shell)
     jobspec = optparse_check_and_loadfile (shell->p, "jobspec");
     R = optparse_check_and_loadfile (shell->p, "resources");
 
-    if (shell_init_jobinfo (shell, info, jobspec, R) < 0)
+    /*  If neither was provided on the cmdline, check for jobinfo
+     *   passed in by the job-exec module.
+     */
+    if (!jobspec && !R && (jobinfo = getenv ("FLUX_SHELL_JOBINFO"))) {
+        if (shell_init_jobinfo_file (shell, info, jobinfo) < 0)
+            goto error;
+    }
+    else if (shell_init_jobinfo (shell, info, jobspec, R) < 0)
         goto error;
 
     /* Done with potentially allocated jobspec, R strings */
@@ -13,6 +13,12 @@
  * Depending on inputs from user, a service is started to receive
  * stdin from front-end command or file is read for redirected
  * standard input.
+ *
+ * Each shell maintains a single watch on the guest.input eventlog,
+ * shared by all local tasks.  Data events are demultiplexed to local
+ * tasks by the rank idset in the event context.  The watch is started
+ * when the first task is initialized, and canceled once stdin is closed
+ * for all local tasks.
  */
 
 #if HAVE_CONFIG_H
@@ -45,8 +51,8 @@ enum {
 };
 
 struct shell_task_input_kvs {
-    flux_future_t *input_f;
-    bool input_header_parsed;
+    bool started;
+    bool closed;
 };
 
 struct shell_task_input {
@@ -63,25 +69,27 @@ struct shell_input_type_file {
     char *rankstr;
 };
 
+struct shell_input_kvs {
+    flux_future_t *input_f;
+    bool input_header_parsed;
+    int open_count;     /* number of local tasks with stdin open */
+};
+
 struct shell_input {
     flux_shell_t *shell;
     int stdin_type;
     struct shell_task_input *task_inputs;
     int ntasks;
     struct shell_input_type_file stdin_file;
+    struct shell_input_kvs input_kvs;
 };
 
-static void shell_task_input_kvs_cleanup (struct shell_task_input_kvs *kp)
+static void shell_input_kvs_cleanup (struct shell_input_kvs *kp)
 {
     flux_future_destroy (kp->input_f);
     kp->input_f = NULL;
 }
 
-static void shell_task_input_cleanup (struct shell_task_input *tp)
-{
-    shell_task_input_kvs_cleanup (&(tp->input_kvs));
-}
-
 static void shell_input_type_file_cleanup (struct shell_input_type_file *fp)
 {
     close (fp->fd);
@@ -93,10 +101,8 @@ void shell_input_destroy (struct shell_input *in)
 {
     if (in) {
         int saved_errno = errno;
-        int i;
         shell_input_type_file_cleanup (&(in->stdin_file));
-        for (i = 0; i < in->ntasks; i++)
-            shell_task_input_cleanup (&(in->task_inputs[i]));
+        shell_input_kvs_cleanup (&(in->input_kvs));
         free (in->task_inputs);
         free (in);
         errno = saved_errno;
@@ -435,26 +441,80 @@ static int shell_input_init (flux_plugin_t *p,
     return 0;
 }
 
-/*  Return 1 if idset string 'set' contains the integer id.
- *  O/w, return 0, or -1 on failure to decode 'set'.
+/*  Close stdin for task_input, and cancel the shared guest.input watch
+ *   once stdin has been closed for all local tasks.
  */
-static int idset_string_contains (const char *set, uint32_t id)
+static void shell_task_input_kvs_close (struct shell_task_input *task_input)
+{
+    struct shell_input_kvs *kp = &(task_input->in->input_kvs);
+
+    if (!task_input->input_kvs.started || task_input->input_kvs.closed)
+        return;
+    task_input->input_kvs.closed = true;
+    if (--kp->open_count == 0 && kp->input_f) {
+        if (flux_job_event_watch_cancel (kp->input_f) < 0)
+            shell_log_errno ("flux_job_event_watch_cancel");
+    }
+}
+
+static void shell_task_input_kvs_write (struct shell_task_input *task_input,
+                                        const char *stream,
+                                        const char *data,
+                                        int len,
+                                        bool eof)
 {
-    int rc;
-    struct idset *idset;
-    if (strcmp (set, "all") == 0)
-        return 1;
-    if (!(idset = idset_decode (set)))
-        return shell_log_errno ("idset_decode (%s)", set);
-    rc = idset_test (idset, id);
+    flux_shell_task_t *task = task_input->task;
+
+    if (len > 0) {
+        if (flux_subprocess_write (task->proc, stream, data, len) < 0) {
+            if (errno != EPIPE)
+                shell_die_errno (1, "flux_subprocess_write");
+            else
+                eof = true; /* Pretend that we got eof */
+        }
+    }
+    if (eof) {
+        if (flux_subprocess_close (task->proc, stream) < 0)
+            shell_die_errno (1, "flux_subprocess_close");
+        shell_task_input_kvs_close (task_input);
+    }
+}
+
+/*  Deliver data event to all local tasks in the rank idset 'rank'.
+ *  The idset is decoded once per event, not once per task.
+ */
+static void shell_input_kvs_data (struct shell_input *in,
+                                  const char *rank,
+                                  const char *stream,
+                                  const char *data,
+                                  int len,
+                                  bool eof)
+{
+    struct idset *idset = NULL;
+    bool all = !strcmp (rank, "all");
+    int i;
+
+    if (!all && !(idset = idset_decode (rank))) {
+        shell_log_errno ("idset_decode (%s)", rank);
+        return;
+    }
+    for (i = 0; i < in->ntasks; i++) {
+        struct shell_task_input *task_input = &in->task_inputs[i];
+
+        if (task_input->type != FLUX_TASK_INPUT_KVS
+            || !task_input->input_kvs.started
+            || task_input->input_kvs.closed)
+            continue;
+        if (all || idset_test (idset, task_input->task->rank))
+            shell_task_input_kvs_write (task_input, stream, data, len, eof);
+    }
     idset_destroy (idset);
-    return rc;
 }
 
-static void shell_task_input_kvs_input_cb (flux_future_t *f, void *arg)
+static void shell_input_kvs_input_cb (flux_future_t *f, void *arg)
 {
-    struct shell_task_input *task_input = arg;
-    struct shell_task_input_kvs *kp = &(task_input->input_kvs);
+    struct shell_input *in = arg;
+    struct shell_input_kvs *kp = &(in->input_kvs);
     const char *entry;
     json_t *o;
     const char *name;
@@ -476,61 +536,45 @@ static void shell_task_input_kvs_input_cb (flux_future_t *f, void *arg)
         kp->input_header_parsed = true;
     }
     else if (!strcmp (name, "data")) {
-        flux_shell_task_t *task = task_input->task;
-        const char *rank = NULL;
+        const char *stream;
+        const char *rank;
+        char *data = NULL;
+        int len;
+        bool eof;
         if (!kp->input_header_parsed)
             shell_die (1, "stream data read before header");
-        if (iodecode (context, NULL, &rank, NULL, NULL, NULL) < 0)
+        if (iodecode (context, &stream, &rank, &data, &len, &eof) < 0)
             shell_die (1, "malformed event context");
-        if (idset_string_contains (rank, task->rank) == 1) {
-            const char *stream;
-            char *data = NULL;
-            int len;
-            bool eof;
-            if (iodecode (context, &stream, NULL, &data, &len, &eof) < 0)
-                shell_die (1, "malformed event context");
-            if (len > 0) {
-                if (flux_subprocess_write (task->proc,
-                                           stream,
-                                           data,
-                                           len) < 0) {
-                    if (errno != EPIPE)
-                        shell_die_errno (1, "flux_subprocess_write");
-                    else
-                        eof = true; /* Pretend that we got eof */
-                }
-            }
-            if (eof) {
-                if (flux_subprocess_close (task->proc, stream) < 0)
-                    shell_die_errno (1, "flux_subprocess_close");
-                if (flux_job_event_watch_cancel (f) < 0)
-                    shell_die_errno (1, "flux_job_event_watch_cancel");
-            }
-            free (data);
-        }
+        shell_input_kvs_data (in, rank, stream, data, len, eof);
+        free (data);
     }
     json_decref (o);
     flux_future_reset (f);
     return;
 done:
-    shell_task_input_kvs_cleanup (kp);
+    shell_input_kvs_cleanup (kp);
 }
 
-static int shell_task_input_kvs_start (struct shell_task_input *ti)
+static int shell_input_kvs_start (struct shell_input *in)
 {
-    struct shell_task_input_kvs *kp = &(ti->input_kvs);
+    struct shell_input_kvs *kp = &(in->input_kvs);
     flux_future_t *f = NULL;
+
+    if (kp->input_f)
+        return 0;
     /*  Start watching kvs guest.input eventlog.
      *  Since this function is called after shell initialization
      *   barrier, we are guaranteed that input eventlog exists.
+     *  All local tasks are initialized and started before control
+     *   returns to the reactor, so no task can miss input events.
      */
-    if (!(f = flux_job_event_watch (ti->in->shell->h,
-                                    ti->in->shell->info->jobid,
+    if (!(f = flux_job_event_watch (in->shell->h,
+                                    in->shell->info->jobid,
                                     "guest.input",
                                     0)))
             shell_die_errno (1, "flux_job_event_watch");
 
-    if (flux_future_then (f, -1., shell_task_input_kvs_input_cb, ti) < 0) {
+    if (flux_future_then (f, -1., shell_input_kvs_input_cb, in) < 0) {
         flux_future_destroy (f);
         shell_die_errno (1, "flux_future_then");
     }
@@ -538,6 +582,15 @@ static int shell_task_input_kvs_start (struct shell_task_input *ti)
     return 0;
 }
 
+static int shell_task_input_kvs_start (struct shell_task_input *ti)
+{
+    if (shell_input_kvs_start (ti->in) < 0)
+        return -1;
+    ti->input_kvs.started = true;
+    ti->in->input_kvs.open_count++;
+    return 0;
+}
+
 static struct shell_task_input *get_task_input (struct shell_input *in,
                                                 flux_shell_task_t *task)
 {
@@ -584,11 +637,8 @@ static int shell_input_task_exit (flux_plugin_t *p,
         return -1;
 
     task_input = get_task_input (in, task);
-    if (task_input->type == FLUX_TASK_INPUT_KVS
-        && task_input->input_kvs.input_f) {
-        if (flux_job_event_watch_cancel (task_input->input_kvs.input_f) < 0)
-            shell_log_errno ("flux_job_event_watch_cancel");
-    }
+    if (task_input->type == FLUX_TASK_INPUT_KVS)
+        shell_task_input_kvs_close (task_input);
     return 0;
 }
 
@@ -210,7 +210,9 @@ static int recursive_parse_jobspec_resources (struct jobspec *job,
     return rc;
 }
 
-struct jobspec *jobspec_parse (const char *jobspec, json_error_t *error)
+/* Parse jobspec object 'o'. A reference on 'o' is stolen, even on error.
+ */
+static struct jobspec *jobspec_parse_object (json_t *o, json_error_t *error)
 {
     struct jobspec *job;
     int version;
@@ -219,10 +221,10 @@ struct jobspec *jobspec_parse (const char *jobspec, json_error_t *error)
 
     if (!(job = calloc (1, sizeof (*job)))) {
         set_error (error, "Out of memory");
+        json_decref (o);
         goto error;
     }
-    if (!(job->jobspec = json_loads (jobspec, 0, error)))
-        goto error;
+    job->jobspec = o;
 
     /* N.B.: members of jobspec like environment and shell.options may
      *  be modified with json_object_update_new() via the shell API
@@ -305,6 +307,24 @@ error:
     return NULL;
 }
 
+struct jobspec *jobspec_parse (const char *jobspec, json_error_t *error)
+{
+    json_t *o;
+
+    if (!(o = json_loads (jobspec, 0, error)))
+        return NULL;
+    return jobspec_parse_object (o, error);
+}
+
+struct jobspec *jobspec_parse_json (json_t *jobspec, json_error_t *error)
+{
+    if (!jobspec) {
+        set_error (error, "Invalid argument");
+        return NULL;
+    }
+    return jobspec_parse_object (json_incref (jobspec), error);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -28,6 +28,11 @@ struct jobspec {
 };
 
 struct jobspec *jobspec_parse (const char *jobspec, json_error_t *error);
+
+/* Same as above, but parse an already decoded jobspec object.
+ * A reference is taken on 'jobspec'.
+ */
+struct jobspec *jobspec_parse_json (json_t *jobspec, json_error_t *error);
 void jobspec_destroy (struct jobspec *job);
 
 #endif /* !_SHELL_JOBSPEC_H */
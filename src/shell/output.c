@@ -27,7 +27,14 @@
  *   task sends an EOF for both stdout and stderr.
  * - completion reference also taken for each KVS commit, to ensure
  *   commits complete before shell exits
- * - all shells (even the leader) send I/O to the service with RPC
+ * - all shells (even the leader) send I/O to the service with RPC, using
+ *   the compact binary ioencode_raw() framing to avoid JSON escaping
+ * - Output from all local tasks is coalesced into a single write buffer
+ *   that is sent to the leader when it exceeds output.write-batch-size
+ *   bytes or output.write-batch-timeout seconds after the first append.
+ *   Each frame in the batch is prefixed by its 32-bit length in network
+ *   byte order.  Frames are appended in the order they are read from
+ *   tasks, so per-task ordering is preserved.
  * - Any errors getting I/O to the leader are logged by RPC completion
  *   callbacks.
  * - Any outstanding RPCs at shell_output_destroy() are synchronously waited for
@@ -45,6 +52,8 @@
 #endif
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <arpa/inet.h>
 #include <jansson.h>
 #include <flux/core.h>
 
@@ -92,11 +101,20 @@ struct shell_output {
     zhash_t *fds;
     const char *stdout_buffer_type;
     const char *stderr_buffer_type;
+    char *wbuf;
+    int wbuf_size;
+    int wbuf_used;
+    int wbuf_max;
+    double wbuf_timeout;
+    flux_watcher_t *wbuf_timer;
 };
 
 static const int shell_output_lwm = 100;
 static const int shell_output_hwm = 1000;
 
+static const int default_write_batch_size = 65536;
+static const double default_write_batch_timeout = 0.005;
+
 /* Pause/resume output on 'stream' of 'task'.
  */
 static void shell_output_control_task (struct shell_task *task,
@@ -394,30 +412,86 @@ static int shell_output_file (struct shell_output *out)
     return 0;
 }
 
-/* Convert 'iodecode' object to an valid RFC 24 data event.
- * N.B. the iodecode object is a valid "context" for the event.
+/* Convert binary 'iodecode_raw' frame to an valid RFC 24 data event.
+ * Output travels from shells to the leader in binary form, and is only
+ * converted to the RFC 24 JSON representation here.
  */
-static void shell_output_write_cb (flux_t *h,
-                                   flux_msg_handler_t *mh,
-                                   const flux_msg_t *msg,
-                                   void *arg)
+static int shell_output_append_frame (struct shell_output *out,
+                                      const void *buf,
+                                      int size,
+                                      int *eofcount)
 {
-    struct shell_output *out = arg;
-    bool eof = false;
+    const char *stream;
+    const char *rank;
+    const char *data;
+    int len;
+    bool eof;
     json_t *o;
     json_t *entry;
 
-    if (flux_request_unpack (msg, NULL, "o", &o) < 0)
-        goto error;
-    if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
-        goto error;
-    if (!(entry = eventlog_entry_pack (0., "data", "O", o))) // increfs 'o'
-        goto error;
+    if (iodecode_raw (buf, size, &stream, &rank, &data, &len, &eof) < 0)
+        return -1;
+    if (eof)
+        (*eofcount)++;
+    if (!(o = ioencode (stream, rank, data, len, eof)))
+        return -1;
+    entry = eventlog_entry_pack (0., "data", "O", o); // increfs 'o'
+    json_decref (o);
+    if (!entry)
+        return -1;
     if (json_array_append_new (out->output, entry) < 0) {
         json_decref (entry);
         errno = ENOMEM;
-        goto error;
+        return -1;
+    }
+    return 0;
+}
+
+/* Unpack a batch of length-prefixed frames sent by shell_output_flush().
+ * A frame that cannot be decoded is logged and skipped, so that it does
+ * not cost the output or EOFs of the other frames in the batch.  If the
+ * framing itself is truncated, the frames before it are kept.
+ */
+static void shell_output_append_batch (struct shell_output *out,
+                                       const char *buf,
+                                       int size,
+                                       int *eofcount)
+{
+    while (size > 0) {
+        uint32_t len;
+
+        if (size < sizeof (len)) {
+            shell_log_error ("dropping truncated output batch");
+            return;
+        }
+        memcpy (&len, buf, sizeof (len));
+        len = ntohl (len);
+        buf += sizeof (len);
+        size -= sizeof (len);
+        if (len > size) {
+            shell_log_error ("dropping truncated output batch");
+            return;
+        }
+        if (shell_output_append_frame (out, buf, len, eofcount) < 0)
+            shell_log_errno ("dropping malformed output frame");
+        buf += len;
+        size -= len;
     }
+}
+
+static void shell_output_write_cb (flux_t *h,
+                                   flux_msg_handler_t *mh,
+                                   const flux_msg_t *msg,
+                                   void *arg)
+{
+    struct shell_output *out = arg;
+    const void *buf;
+    int size;
+    int eofcount = 0;
+
+    if (flux_request_decode_raw (msg, NULL, &buf, &size) < 0)
+        goto error;
+    shell_output_append_batch (out, buf, size, &eofcount);
     /* Error failing to commit is a fatal error.  Should be cleaner in
      * future. Issue #2378 */
     if ((out->stdout_type == FLUX_OUTPUT_TYPE_TERM
@@ -439,8 +513,9 @@ static void shell_output_write_cb (flux_t *h,
         shell_log_error ("json_array_clear failed");
         goto error;
     }
-    if (eof) {
-        if (--out->eof_pending == 0) {
+    if (eofcount > 0) {
+        out->eof_pending -= eofcount;
+        if (out->eof_pending == 0) {
             flux_msg_handler_stop (mh);
             if (flux_shell_remove_completion_ref (out->shell, "output.write") < 0)
                 shell_log_errno ("flux_shell_remove_completion_ref");
@@ -474,6 +549,78 @@ static void shell_output_write_completion (flux_future_t *f, void *arg)
         shell_output_control (out, false);
 }
 
+/* Send any buffered output to the leader in one write RPC.
+ * If the RPC cannot be sent, the output stays buffered and the timer
+ * is restarted to retry.
+ */
+static int shell_output_flush (struct shell_output *out)
+{
+    flux_future_t *f = NULL;
+
+    flux_watcher_stop (out->wbuf_timer);
+    if (out->wbuf_used == 0)
+        return 0;
+    if (!(f = shell_svc_raw (out->shell->svc,
+                             "write",
+                             0,
+                             0,
+                             out->wbuf,
+                             out->wbuf_used))) {
+        flux_watcher_start (out->wbuf_timer);
+        return -1;
+    }
+    out->wbuf_used = 0; // sent, so the buffer may be reused
+    if (flux_future_then (f, -1, shell_output_write_completion, out) < 0)
+        goto error;
+    if (zlist_append (out->pending_writes, f) < 0)
+        shell_log_error ("zlist_append failed");
+
+    if (zlist_size (out->pending_writes) >= shell_output_hwm)
+        shell_output_control (out, true);
+    return 0;
+error:
+    flux_future_destroy (f);
+    return -1;
+}
+
+static void shell_output_flush_cb (flux_reactor_t *r,
+                                   flux_watcher_t *w,
+                                   int revents,
+                                   void *arg)
+{
+    struct shell_output *out = arg;
+
+    if (shell_output_flush (out) < 0)
+        shell_log_errno ("shell_output_write");
+}
+
+/* Append a length-prefixed frame to the write buffer, growing it as needed.
+ */
+static int shell_output_wbuf_append (struct shell_output *out,
+                                     const void *frame,
+                                     int size)
+{
+    uint32_t len = htonl (size);
+    int need = out->wbuf_used + sizeof (len) + size;
+
+    if (need > out->wbuf_size) {
+        int newsize = out->wbuf_size ? out->wbuf_size : 4096;
+        char *newbuf;
+
+        while (newsize < need)
+            newsize *= 2;
+        if (!(newbuf = realloc (out->wbuf, newsize)))
+            return -1;
+        out->wbuf = newbuf;
+        out->wbuf_size = newsize;
+    }
+    memcpy (out->wbuf + out->wbuf_used, &len, sizeof (len));
+    out->wbuf_used += sizeof (len);
+    memcpy (out->wbuf + out->wbuf_used, frame, size);
+    out->wbuf_used += size;
+    return 0;
+}
+
 static int shell_output_write (struct shell_output *out,
                                int rank,
                                const char *stream,
@@ -481,31 +628,29 @@ static int shell_output_write (struct shell_output *out,
                                int len,
                                bool eof)
 {
-    flux_future_t *f = NULL;
-    json_t *o = NULL;
+    void *buf = NULL;
+    int size;
     char rankstr[64];
+    bool first;
 
     snprintf (rankstr, sizeof (rankstr), "%d", rank);
-    if (!(o = ioencode (stream, rankstr, data, len, eof))) {
-        shell_log_errno ("ioencode");
+    if (!(buf = ioencode_raw (stream, rankstr, data, len, eof, &size))) {
+        shell_log_errno ("ioencode_raw");
         return -1;
     }
-
-    if (!(f = flux_shell_rpc_pack (out->shell, "write", 0, 0, "O", o)))
+    first = (out->wbuf_used == 0);
+    if (shell_output_wbuf_append (out, buf, size) < 0)
         goto error;
-    if (flux_future_then (f, -1, shell_output_write_completion, out) < 0)
-        goto error;
-    if (zlist_append (out->pending_writes, f) < 0)
-        shell_log_error ("zlist_append failed");
-    json_decref (o);
+    free (buf);
 
-    if (zlist_size (out->pending_writes) >= shell_output_hwm)
-        shell_output_control (out, true);
+    if (out->wbuf_used >= out->wbuf_max)
+        return shell_output_flush (out);
+    if (first) {
+        flux_watcher_start (out->wbuf_timer);
+    }
     return 0;
-
 error:
-    flux_future_destroy (f);
-    json_decref (o);
+    free (buf);
     return -1;
 }
 
@@ -519,6 +664,12 @@ void shell_output_destroy (struct shell_output *out)
 {
     if (out) {
         int saved_errno = errno;
+        if (out->wbuf_used > 0 && out->pending_writes) {
+            if (shell_output_flush (out) < 0)
+                shell_log_errno ("shell_output_write");
+        }
+        flux_watcher_destroy (out->wbuf_timer);
+        free (out->wbuf);
         if (out->pending_writes) {
             flux_future_t *f;
 
@@ -934,6 +1085,34 @@ static int output_eventlogger_start (struct shell_output *out)
     return 0;
 }
 
+static int shell_output_write_batch_init (struct shell_output *out)
+{
+    flux_reactor_t *r = flux_get_reactor (out->shell->h);
+
+    out->wbuf_max = default_write_batch_size;
+    out->wbuf_timeout = default_write_batch_timeout;
+
+    if (flux_shell_getopt_unpack (out->shell,
+                                  "output",
+                                  "{s?i s?F}",
+                                  "write-batch-size", &out->wbuf_max,
+                                  "write-batch-timeout",
+                                    &out->wbuf_timeout) < 0)
+        return shell_log_errno ("invalid output.write-batch option");
+    if (out->wbuf_max <= 0)
+        return shell_log_errn (EINVAL, "invalid output.write-batch-size");
+    if (out->wbuf_timeout < 0.)
+        return shell_log_errn (EINVAL, "invalid output.write-batch-timeout");
+
+    out->wbuf_timer = flux_timeout_watcher_create (r,
+                                                   out->wbuf_timeout,
+                                                   shell_output_flush_cb,
+                                                   out);
+    if (!out->wbuf_timer)
+        return shell_log_errno ("flux_timeout_watcher_create");
+    return 0;
+}
+
 struct shell_output *shell_output_create (flux_shell_t *shell)
 {
     struct shell_output *out;
@@ -959,6 +1138,8 @@ struct shell_output *shell_output_create (flux_shell_t *shell)
 
     if (!(out->pending_writes = zlist_new ()))
         goto error;
+    if (shell_output_write_batch_init (out) < 0)
+        goto error;
     if (shell->info->shell_rank == 0) {
         if (output_type_requires_service (out->stdout_type)
             || output_type_requires_service (out->stderr_type)) {
@@ -226,6 +226,21 @@ int main (int argc, char **argv)
             jobspec_destroy (js);
     }
 
+    for (i = 0; good_input[i].desc; i++) {
+        json_t *o = json_loads (good_input[i].s, 0, NULL);
+        if (!o)
+            BAIL_OUT ("json_loads good.%d failed", i);
+        js = jobspec_parse_json (o, &error);
+        ok (js != NULL
+            && js->task_count == good_output[i].task_count
+            && js->slot_count == good_output[i].slot_count,
+            "good.%d (%s) jobspec_parse_json works", i, good_input[i].desc);
+        json_decref (o);
+        jobspec_destroy (js);
+    }
+    js = jobspec_parse_json (NULL, &error);
+    ok (js == NULL, "jobspec_parse_json (NULL) fails");
+
     done_testing ();
     return 0;
 }
@@ -0,0 +1,11 @@
+#!/bin/bash
+
+# Accept every jobspec, appending a line to file $1 for each one.
+
+while read line
+do
+    echo validated >>$1
+    echo '{"errnum": 0}'
+done <&0
+
+exit 0
@@ -16,6 +16,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <time.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
@@ -32,7 +33,7 @@
 
 int cmd_submitbench (optparse_t *p, int argc, char **argv);
 
-const char *usage_msg = "[OPTIONS] jobspec";
+const char *usage_msg = "[OPTIONS] jobspec [jobspec...]";
 static struct optparse_option opts[] =  {
     { .name = "repeat", .key = 'r', .has_arg = 1, .arginfo = "N",
       .usage = "Run N instances of jobspec",
@@ -40,6 +41,10 @@ static struct optparse_option opts[] =  {
     { .name = "fanout", .key = 'f', .has_arg = 1, .arginfo = "N",
       .usage = "Run at most N RPCs in parallel",
     },
+    { .name = "batch", .key = 'b', .has_arg = 1, .arginfo = "N",
+      .usage = "Submit N jobs per RPC with flux_job_submit_batch(),"
+               " taking each from the next jobspec argument in turn",
+    },
     { .name = "urgency", .key = 'u', .has_arg = 1, .arginfo = "N",
       .usage = "Set job urgency (0-31, default=16)",
     },
@@ -98,12 +103,16 @@ struct submitbench_ctx {
     int rxcount;
     int totcount;
     int max_queue_depth;
+    int batch;
     optparse_t *p;
     void *jobspec;
     int jobspecsz;
+    void **extra;       // additional jobspecs for --batch
+    int extra_count;
     const char *J;
     int urgency;
     uint32_t owner;
+    int errors;
 };
 
 /* Read entire file 'name' ("-" for stdin).  Exit program on error.
@@ -149,6 +158,67 @@ void submitbench_continuation (flux_future_t *f, void *arg)
     ctx->rxcount++;
 }
 
+/* handle submit-batch RPC response
+ */
+void submitbench_batch_continuation (flux_future_t *f, void *arg)
+{
+    struct submitbench_ctx *ctx = arg;
+    int count = (intptr_t)flux_future_aux_get (f, "count");
+    flux_jobid_t id;
+    const char *errstr;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (flux_job_submit_batch_get_id (f, i, &id, &errstr) < 0) {
+            if (errno == ENOSYS)
+                log_msg_exit ("submit: job-ingest module is not loaded");
+            if (ctx->extra_count == 0)
+                log_msg_exit ("submit: %s",
+                              errstr ? errstr : future_strerror (f, errno));
+            /* With several jobspecs, some may be expected to fail.
+             * Report each failure in place of its jobid.
+             */
+            printf ("error %d: %s\n",
+                    errno,
+                    errstr ? errstr : future_strerror (f, errno));
+            ctx->errors++;
+            continue;
+        }
+        printf ("%ju\n", (uintmax_t)id);
+    }
+    flux_future_destroy (f);
+
+    ctx->rxcount += count;
+}
+
+/* Submit up to ctx->batch jobs in one RPC.  Each job after the first
+ * takes the next of the extra jobspecs in turn, if there are any.
+ */
+static void submitbench_batch (struct submitbench_ctx *ctx,
+                               const char *jobspec,
+                               int flags)
+{
+    const char *jobspecs[ctx->batch];
+    flux_future_t *f;
+    int count = ctx->totcount - ctx->txcount;
+    int i;
+
+    if (count > ctx->batch)
+        count = ctx->batch;
+    for (i = 0; i < count; i++) {
+        int n = (ctx->txcount + i) % (ctx->extra_count + 1);
+        jobspecs[i] = n == 0 ? jobspec : ctx->extra[n - 1];
+    }
+    if (!(f = flux_job_submit_batch (ctx->h, count, jobspecs,
+                                     ctx->urgency, flags)))
+        log_err_exit ("flux_job_submit_batch");
+    if (flux_future_aux_set (f, "count", (void *)(intptr_t)count, NULL) < 0)
+        log_err_exit ("flux_future_aux_set");
+    if (flux_future_then (f, -1., submitbench_batch_continuation, ctx) < 0)
+        log_err_exit ("flux_future_then");
+    ctx->txcount += count;
+}
+
 /* prep - called before event loop would block
  * Prevent loop from blocking if 'check' could send RPCs.
  * Stop the prep/check watchers if RPCs have all been sent,
@@ -196,6 +266,10 @@ void submitbench_check (flux_reactor_t *r, flux_watcher_t *w,
             flags |= FLUX_JOB_PRE_SIGNED;
         }
 #endif
+        if (ctx->batch > 0) {
+            submitbench_batch (ctx, ctx->J ? ctx->J : ctx->jobspec, flags);
+            return;
+        }
         if (!(f = flux_job_submit (ctx->h, ctx->J ? ctx->J : ctx->jobspec,
                                    ctx->urgency, flags)))
             log_err_exit ("flux_job_submit");
@@ -213,7 +287,7 @@ int cmd_submitbench (optparse_t *p, int argc, char **argv)
 
     memset (&ctx, 0, sizeof (ctx));
 
-    if (optindex != argc - 1) {
+    if (optindex == argc) {
         optparse_print_usage (p);
         exit (1);
     }
@@ -248,7 +322,23 @@ int cmd_submitbench (optparse_t *p, int argc, char **argv)
     ctx.p = p;
     ctx.max_queue_depth = optparse_get_int (p, "fanout", 256);
     ctx.totcount = optparse_get_int (p, "repeat", 1);
+    ctx.batch = optparse_get_int (p, "batch", 0);
+    if (ctx.batch < 0)
+        log_msg_exit ("--batch must be a positive integer");
     ctx.jobspecsz = read_jobspec (argv[optindex++], &ctx.jobspec);
+    if (optindex < argc) {
+        if (ctx.batch == 0)
+            log_msg_exit ("multiple jobspecs require --batch");
+#if HAVE_FLUX_SECURITY
+        if (ctx.sec)
+            log_msg_exit ("multiple jobspecs cannot be pre-signed");
+#endif
+        ctx.extra_count = argc - optindex;
+        if (!(ctx.extra = calloc (ctx.extra_count, sizeof (ctx.extra[0]))))
+            log_err_exit ("calloc");
+        for (int i = 0; i < ctx.extra_count; i++)
+            (void)read_jobspec (argv[optindex++], &ctx.extra[i]);
+    }
     ctx.urgency = optparse_get_int (p, "urgency", FLUX_JOB_URGENCY_DEFAULT);
 
     const char *tmp;
@@ -277,7 +367,10 @@ int cmd_submitbench (optparse_t *p, int argc, char **argv)
 #endif
     flux_close (ctx.h);
     free (ctx.jobspec);
-    return 0;
+    for (int i = 0; i < ctx.extra_count; i++)
+        free (ctx.extra[i]);
+    free (ctx.extra);
+    return ctx.errors > 0 ? 1 : 0;
 }
 
 
@@ -15,6 +15,7 @@
 #include <jansson.h>
 #include <signal.h>
 #include <stdio.h>
+#include <string.h>
 #include <flux/core.h>
 
 #include "src/common/libutil/read_all.h"
@@ -36,16 +37,55 @@ void cancel_cb (int sig)
     flux_future_destroy (f2);
 }
 
+/* Send an events-journal-update request with payload 'arg', which is
+ * a JSON object without the matchtag, e.g. '{"add":[id]}', and wait for
+ * it to be accepted.
+ */
+void update (const char *arg)
+{
+    flux_future_t *f2;
+    json_t *o;
+
+    if (!(o = json_loads (arg, 0, NULL))
+        || json_object_set_new (o,
+                                "matchtag",
+                                json_integer (flux_rpc_get_matchtag (f))) < 0)
+        log_msg_exit ("error decoding update payload: %s", arg);
+    if (!(f2 = flux_rpc_pack (h,
+                              "job-manager.events-journal-update",
+                              FLUX_NODEID_ANY,
+                              0,
+                              "O",
+                              o)))
+        log_err_exit ("flux_rpc_pack");
+    if (flux_rpc_get (f2, NULL) < 0)
+        log_msg_exit ("job-manager.events-journal-update: %s",
+                      future_strerror (f2, errno));
+    flux_future_destroy (f2);
+    json_decref (o);
+}
+
 int main (int argc, char *argv[])
 {
     ssize_t inlen;
     void *inbuf;
+    json_t *o;
+    bool credit = false;
+    bool hold = false;
+    int i = 1;
 
     if (!(h = flux_open (NULL, 0)))
         log_err_exit ("flux_open");
 
-    if (argc != 1) {
-        fprintf (stderr, "Usage: events_journal_stream <payload\n");
+    /* --hold: never grant credit, so that events are held by the service
+     */
+    if (argc > 1 && !strcmp (argv[1], "--hold")) {
+        hold = true;
+        i++;
+    }
+    if (argc > i && argv[i][0] != '{') {
+        fprintf (stderr,
+                 "Usage: events_journal_stream [--hold] [UPDATE...] <payload\n");
         exit (1);
     }
 
@@ -54,6 +94,15 @@ int main (int argc, char *argv[])
     if (inlen > 0)  // flux stringified JSON payloads are sent with \0-term
         inlen++;    //  and read_all() ensures inbuf has one, not acct in inlen
 
+    /* If the request asks for flow control, grant one credit back to
+     * the service for each response consumed.
+     */
+    if (inlen > 0 && (o = json_loads (inbuf, 0, NULL))) {
+        if (json_object_get (o, "credit") && !hold)
+            credit = true;
+        json_decref (o);
+    }
+
     if (!(f = flux_rpc_raw (h,
                             "job-manager.events-journal",
                             inbuf,
@@ -65,6 +114,9 @@ int main (int argc, char *argv[])
     if (signal (SIGUSR1, cancel_cb) == SIG_ERR)
         log_err_exit ("signal");
 
+    for (; i < argc; i++)
+        update (argv[i]);
+
     while (1) {
         json_t *events;
         size_t index;
@@ -82,6 +134,9 @@ int main (int argc, char *argv[])
             free (s);
         }
         flux_future_reset (f);
+        if (credit
+            && flux_rpc_credit (f, "job-manager.events-journal-credit", 1) < 0)
+            log_err_exit ("flux_rpc_credit");
     }
     flux_future_destroy (f);
     free (inbuf);
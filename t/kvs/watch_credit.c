@@ -0,0 +1,144 @@
+/************************************************************\
+ * Copyright 2021 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/log.h"
+
+#define KEY "test.credit"
+#define COMMITS 5
+
+/* The kvs lookup API doesn't accept a credit, so we build the
+ * kvs-watch.lookup request from scratch here.
+ */
+flux_future_t *watch (flux_t *h, int credit)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_rpc_pack (h,
+                             "kvs-watch.lookup",
+                             FLUX_NODEID_ANY,
+                             FLUX_RPC_STREAMING,
+                             "{s:s s:s s:i s:i}",
+                             "key", KEY,
+                             "namespace", KVS_PRIMARY_NAMESPACE,
+                             "flags", FLUX_KVS_WATCH,
+                             "credit", credit)))
+        log_err_exit ("flux_rpc kvs-watch.lookup");
+    return f;
+}
+
+void put (flux_t *h, int value)
+{
+    flux_kvs_txn_t *txn;
+    flux_future_t *f;
+
+    if (!(txn = flux_kvs_txn_create ())
+        || flux_kvs_txn_pack (txn, 0, KEY, "i", value) < 0)
+        log_err_exit ("error creating transaction");
+    if (!(f = flux_kvs_commit (h, NULL, 0, txn))
+        || flux_future_get (f, NULL) < 0)
+        log_err_exit ("flux_kvs_commit");
+    flux_future_destroy (f);
+    flux_kvs_txn_destroy (txn);
+}
+
+/* Wait up to 'timeout' seconds for a response.
+ * Return true if a value response was received.
+ */
+bool get_response (flux_future_t *f, double timeout)
+{
+    if (flux_future_wait_for (f, timeout) < 0) {
+        if (errno == ETIMEDOUT)
+            return false;
+        log_err_exit ("flux_future_wait_for");
+    }
+    if (flux_rpc_get (f, NULL) < 0)
+        log_msg_exit ("kvs-watch.lookup: %s", future_strerror (f, errno));
+    flux_future_reset (f);
+    return true;
+}
+
+int main (int argc, char **argv)
+{
+    flux_t *h;
+    flux_future_t *f;
+    flux_future_t *f2;
+    int count;
+    int i;
+
+    if (argc != 1) {
+        fprintf (stderr, "Usage: watch_credit\n");
+        exit (1);
+    }
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+
+    f = watch (h, 0);
+    if (flux_rpc_get (f, NULL) == 0 || errno != EPROTO)
+        log_msg_exit ("watch with credit=0 was not rejected with EPROTO");
+    flux_future_destroy (f);
+    log_msg ("watch with credit=0 failed with EPROTO");
+
+    put (h, 0);
+    f = watch (h, 1);
+    if (!get_response (f, 5.))
+        log_msg_exit ("initial response was not received");
+    log_msg ("initial response received");
+
+    for (i = 1; i <= COMMITS; i++)
+        put (h, i);
+    if (get_response (f, 0.5))
+        log_msg_exit ("response received without credit");
+    log_msg ("watcher paused after %d commits", COMMITS);
+
+    /* Each grant yields at most one response.  Changes made while the
+     * watcher was paused are coalesced, so it catches up in fewer than
+     * COMMITS responses, after which further credit goes unused.
+     */
+    count = 0;
+    for (;;) {
+        if (flux_rpc_credit (f, "kvs-watch.credit", 1) < 0)
+            log_err_exit ("flux_rpc_credit");
+        if (!get_response (f, count == 0 ? 5. : 0.5))
+            break;
+        if (++count > COMMITS)
+            log_msg_exit ("received %d responses for %d commits",
+                          count, COMMITS);
+    }
+    if (count == 0)
+        log_msg_exit ("response was not received after granting credit");
+    log_msg ("watcher resumed, %d responses for %d commits", count, COMMITS);
+
+    if (!(f2 = flux_rpc_pack (h,
+                              "kvs-watch.cancel",
+                              FLUX_NODEID_ANY,
+                              FLUX_RPC_NORESPONSE,
+                              "{s:i}",
+                              "matchtag", (int)flux_rpc_get_matchtag (f))))
+        log_err_exit ("flux_rpc kvs-watch.cancel");
+    flux_future_destroy (f2);
+    if (flux_rpc_get (f, NULL) == 0 || errno != ENODATA)
+        log_msg_exit ("canceled watcher did not terminate with ENODATA");
+    log_msg ("canceled watcher terminated with ENODATA");
+
+    flux_future_destroy (f);
+    flux_close (h);
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
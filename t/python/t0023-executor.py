@@ -39,6 +39,26 @@ class ShamJobEventWatchFuture:
         return self.log_event
 
 
+class ShamJournalRPC:
+    """Acts like a job-manager.events-journal streaming RPC."""
+
+    def __init__(self, events):
+        self.events = events
+
+    def get(self):
+        return {"events": self.events}
+
+    def reset(self):
+        pass
+
+
+def journal_entry(jobid, seq, name, context=None):
+    entry = {"name": name, "timestamp": 0}
+    if context is not None:
+        entry["context"] = context
+    return {"id": jobid, "eventlog_seq": seq, "entry": entry}
+
+
 class TestFluxExecutor(unittest.TestCase):
     """Tests for FluxExecutor."""
 
@@ -129,6 +149,22 @@ class TestFluxExecutor(unittest.TestCase):
             self.assertIsInstance(future.exception(), JobException)
             self.assertTrue(flag.is_set())
 
+    def test_journal(self):
+        with FluxExecutor(threads=2, journal=True) as executor:
+            expected_events = set(["submit", "start", "finish", "clean"])
+            futures = [
+                executor.submit(JobspecV1.from_command([cmd]))
+                for cmd in ("true", "false", "/not/a/real/app")
+            ]
+            for event in executor.EVENTS:
+                futures[0].add_event_callback(
+                    event, lambda fut, event: expected_events.discard(event.name)
+                )
+            self.assertEqual(futures[0].result(), 0)
+            self.assertEqual(futures[1].result(), 1)
+            self.assertIsInstance(futures[2].exception(), JobException)
+        self.assertFalse(expected_events)
+
 
 class TestFluxExecutorThread(unittest.TestCase):
     """Simple synchronous tests for _FluxExecutorThread."""
@@ -237,6 +273,52 @@ class TestFluxExecutorThread(unittest.TestCase):
             elif os.WIFSIGNALED(exit_status):
                 self.assertEqual(fut.result(), -os.WTERMSIG(exit_status))
 
+    def test_journal_dispatch(self):
+        thread = _FluxExecutorThread(
+            threading.Event(), collections.deque(), 0.01, (), {}, journal=True
+        )
+        journal_update = thread._FluxExecutorThread__journal_update
+        journal = ShamJournalRPC([])
+        thread._FluxExecutorThread__journal_rpc = journal
+        thread._FluxExecutorThread__remaining_flux_futures = 1
+        updates = []
+        thread._FluxExecutorThread__journal_update_ids = (
+            lambda action, jobid: updates.append((action, jobid))
+        )
+        fut = FluxExecutorFuture(threading.get_ident())
+        events = []
+        for event in ("submit", "start", "finish", "clean"):
+            fut.add_event_callback(event, lambda fut, event: events.append(event.name))
+        # the job is added to the stream once its jobid is known
+        thread._FluxExecutorThread__track_job(42, fut)
+        self.assertEqual(updates, [("add", 42)])
+        self.assertEqual(events, [])
+        # the journal then sends the events already in its history
+        journal.events = [
+            journal_entry(42, 0, "submit"),
+            journal_entry(42, -1, "annotations"),
+            journal_entry(42, 1, "start"),
+        ]
+        journal_update(journal)
+        self.assertEqual(events, ["submit", "start"])
+        # duplicates are dropped, events for other jobs are ignored
+        journal.events = [
+            journal_entry(42, 1, "start"),
+            journal_entry(43, 1, "start"),
+            journal_entry(42, 2, "finish", {"status": 256}),
+        ]
+        journal_update(journal)
+        self.assertEqual(events, ["submit", "start", "finish"])
+        self.assertEqual(fut.result(), 1)
+        self.assertEqual(1, thread._FluxExecutorThread__remaining_flux_futures)
+        journal.events = [journal_entry(42, 3, "clean")]
+        journal_update(journal)
+        self.assertEqual(events, ["submit", "start", "finish", "clean"])
+        self.assertEqual(0, thread._FluxExecutorThread__remaining_flux_futures)
+        self.assertFalse(thread._FluxExecutorThread__tracked_jobs)
+        # the job is removed from the stream once it is clean
+        self.assertEqual(updates, [("add", 42), ("remove", 42)])
+
 
 class TestFluxExecutorFuture(unittest.TestCase):
     """Tests for FluxExecutorFuture."""
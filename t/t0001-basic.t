@@ -190,6 +190,30 @@ test_expect_success 'tbon.parent-endpoint can be read on not rank 0' '
        NUM=`flux start ${ARGS} --size 4 flux exec -n flux getattr tbon.parent-endpoint | grep ipc | wc -l` &&
        test $NUM -eq 3
 '
+test_expect_success 'tbon.transport defaults to zmq' '
+	flux start ${ARGS} flux getattr tbon.transport >transport.out &&
+	echo zmq >transport.exp &&
+	test_cmp transport.exp transport.out
+'
+test_expect_success 'tbon.transport=stream works over ipc' '
+	flux start ${ARGS} -s4 -o,--setattr=tbon.transport=stream \
+		flux exec -n flux getattr rank >stream_ipc.out &&
+	test $(wc -l <stream_ipc.out) -eq 4
+'
+test_expect_success 'tbon.transport=stream works over tcp' '
+	flux start ${ARGS} -s4 -o,--setattr=tbon.transport=stream \
+		-o,--setattr=tbon.endpoint=tcp://127.0.0.1:* \
+		flux exec -n flux getattr tbon.transport >stream_tcp.out &&
+	test $(grep -c stream stream_tcp.out) -eq 4
+'
+test_expect_success 'tbon.transport cannot be changed at runtime' '
+	test_must_fail flux start ${ARGS} \
+		flux setattr tbon.transport stream
+'
+test_expect_success 'unknown tbon.transport fails' '
+	test_must_fail flux start ${ARGS} \
+		-o,--setattr=tbon.transport=carrier-pigeon /bin/true
+'
 test_expect_success 'flux start --bootstrap=pmi (singlton) cleans up rundir' '
 	flux start ${ARGS} --bootstrap=pmi \
 		flux getattr rundir >rundir_pmi.out &&
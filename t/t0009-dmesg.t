@@ -102,5 +102,38 @@ test_expect_success 'logged non-ascii characters handled ok' '
 test_expect_success 'dmesg request with empty payload fails with EPROTO(71)' '
 	${RPC} log.dmesg 71 </dev/null
 '
+wait_logfile() {
+	for i in $(seq 1 100); do
+		grep -q "$1" forward.log && return 0
+		sleep 0.1
+	done
+	return 1
+}
+test_expect_success 'capture forwarded log entries in log-filename' '
+	flux setattr log-filename $(pwd)/forward.log
+'
+test_expect_success 'repeated log entries forwarded from rank 1 are collapsed' '
+	flux exec -r 1 sh -c "seq 1 5 | sed -e s/.*/dupmsg/ | \
+		flux logger --appname=duptest" &&
+	flux exec -r 1 flux logger --appname=duptest dupdone &&
+	wait_logfile dupdone &&
+	grep duptest forward.log >duptest.out &&
+	test $(grep -c "dupmsg" duptest.out) -eq 1 &&
+	test $(sed -n -e "s/.*last message repeated \([0-9]*\) times/\1/p" \
+		duptest.out | awk "{s+=\$1} END {print s}") -eq 4
+'
+test_expect_success 'log-forward-rate-limit drops excess entries from rank 1' '
+	flux exec -r 1 sh -c "flux setattr log-forward-rate-limit 2 && \
+		seq 1 20 | flux logger --appname=ratetest && \
+		flux setattr log-forward-rate-limit 1000" &&
+	flux exec -r 1 flux logger --appname=ratetest ratedone &&
+	wait_logfile ratedone &&
+	grep ratetest forward.log >ratetest.out &&
+	test $(grep -c ": [0-9]*$" ratetest.out) -lt 20 &&
+	grep "messages dropped by log-forward-rate-limit" ratetest.out
+'
+test_expect_success 'log-forward-rate-limit rejects negative values' '
+	test_must_fail flux setattr log-forward-rate-limit -1
+'
 
 test_done
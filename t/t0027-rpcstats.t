@@ -0,0 +1,75 @@
+#!/bin/sh
+
+test_description='Test broker request statistics'
+
+. `dirname $0`/sharness.sh
+
+test_under_flux 2 minimal
+
+# Print the number of requests the local broker is tracking, which
+# includes the broker.rpcstats request made to get it.
+pending_count () {
+	flux python -c "import flux; \
+		print(flux.Flux().rpc(\"broker.rpcstats\").get()[\"pending\"])"
+}
+wait_pending () {
+	local i=0
+	while test $(pending_count) -ne $1; do
+		test $i -lt 100 || return 1
+		sleep 0.1
+		i=$((i+1))
+	done
+}
+
+test_expect_success 'flux rpcstats prints a header' '
+	flux rpcstats >header.out &&
+	head -1 header.out | grep "^TOPIC"
+'
+test_expect_success 'flux rpcstats counts attr.get requests' '
+	flux rpcstats --clear >/dev/null &&
+	for i in 1 2 3 4 5; do flux getattr log-count >/dev/null; done &&
+	flux rpcstats attr.get >attr.out &&
+	cat attr.out &&
+	grep "^attr.get " attr.out | awk "{exit (\$2 >= 5 ? 0 : 1)}"
+'
+test_expect_success 'flux rpcstats counts error responses' '
+	flux rpcstats --clear >/dev/null &&
+	test_must_fail flux getattr nosuchattr &&
+	flux rpcstats attr.get >err.out &&
+	grep "^attr.get " err.out | awk "{exit (\$3 >= 1 ? 0 : 1)}"
+'
+test_expect_success 'flux rpcstats --clear clears statistics' '
+	flux getattr log-count >/dev/null &&
+	flux rpcstats --clear >/dev/null &&
+	flux rpcstats attr.get >clear.out &&
+	test_must_fail grep "^attr.get " clear.out
+'
+test_expect_success 'flux rpcstats --service aggregates by service' '
+	flux getattr log-count >/dev/null &&
+	flux rpcstats --service >service.out &&
+	grep "^attr " service.out &&
+	test_must_fail grep "^attr\." service.out
+'
+test_expect_success HAVE_JQ 'flux rpcstats --json includes histograms' '
+	flux getattr log-count >/dev/null &&
+	flux rpcstats --json >stats.json &&
+	jq -e ".[] | select(.topic == \"attr.get\") | .latency.buckets" \
+		stats.json
+'
+test_expect_success 'flux rpcstats --rank queries another broker' '
+	flux exec -r 1 flux getattr log-count >/dev/null &&
+	flux rpcstats --rank=1 >rank1.out &&
+	grep "^attr.get " rank1.out
+'
+test_expect_success NO_CHAIN_LINT 'pending requests are dropped on disconnect' '
+	base=$(pending_count) &&
+	flux dmesg -f >follow.out &
+	pid=$! &&
+	wait_pending $((base+1)) &&
+	kill $pid &&
+	wait_pending $base
+'
+test_expect_success 'flux rpcstats fails on extra arguments' '
+	test_must_fail flux rpcstats a b
+'
+test_done
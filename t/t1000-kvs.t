@@ -421,6 +421,19 @@ test_expect_success 'kvs: put/get --raw works with multiple key=val pairs' '
 	flux kvs get --raw $DIR.a $DIR.b >twovals.actual &&
 	test_cmp twovals.expected twovals.actual
 '
+test_expect_success 'kvs: get --raw --at works' '
+	flux kvs unlink -Rf $DIR &&
+	flux kvs put --raw $DIR.a=xyz &&
+	flux kvs put --append --raw $DIR.a=zyx &&
+	printf "%s" "xyzzyx" >rawat.expected &&
+	flux kvs get --raw --at $(flux kvs get --treeobj .) $DIR.a >rawat.actual &&
+	test_cmp rawat.expected rawat.actual
+'
+test_expect_success 'kvs: get --raw on a directory fails' '
+	flux kvs unlink -Rf $DIR &&
+	flux kvs put $DIR.a=1 &&
+	test_must_fail flux kvs get --raw $DIR
+'
 test_expect_success 'kvs: put --raw a=- reads value from stdin' '
 	flux kvs unlink -Rf $DIR &&
 	printf "%s" "abc" | flux kvs put --raw $DIR.a=- &&
@@ -1229,6 +1242,11 @@ test_expect_success 'lookup request with empty payload fails with EPROTO(71)' '
 test_expect_success 'lookup-plus request with empty payload fails with EPROTO(71)' '
 	${RPC} kvs.lookup-plus 71 </dev/null
 '
+test_expect_success 'lookup-plus request with FLUX_KVS_RAW fails with EPROTO(71)' '
+	flux kvs put test.rawplus=1 &&
+	echo "{\"key\":\"test.rawplus\",\"flags\":512,\"namespace\":\"primary\"}" \
+		| ${RPC} kvs.lookup-plus 71
+'
 test_expect_success 'commit request with empty payload fails with EPROTO(71)' '
 	${RPC} kvs.commit 71 </dev/null
 '
@@ -401,6 +401,46 @@ test_expect_success 'kvs: causal consistency (unlink)' '
         grep "No such file or directory" output
 '
 
+#
+# setroot events carry root directory changes so other ranks need
+# not fault in the new root directory
+#
+
+test_expect_success 'kvs: new root directory is cached on other ranks' '
+        flux kvs put deltatest1=1 deltatest2=1 &&
+        VERS=$(flux kvs version) &&
+        flux exec -n -r 1 sh -c "flux kvs wait ${VERS}" &&
+        flux exec -n -r 1 sh -c "flux kvs get deltatest2" &&
+        flux kvs put deltatest1=2 &&
+        VERS=$(flux kvs version) &&
+        flux exec -n -r 1 sh -c "flux kvs wait ${VERS}" &&
+        flux exec -n -r 1 sh -c "flux module stats --parse \"cache.#faults\" kvs" > faults-a.out &&
+        flux exec -n -r 1 sh -c "flux kvs get deltatest1" > delta.out &&
+        flux exec -n -r 1 sh -c "flux module stats --parse \"cache.#faults\" kvs" > faults-b.out &&
+        echo "2" > delta.exp &&
+        test_cmp delta.exp delta.out &&
+        test_cmp faults-a.out faults-b.out
+'
+
+test_expect_success NO_CHAIN_LINT 'kvs: commits to other namespace complete while primary is busy' '
+        flux kvs namespace create busytestns &&
+        ${FLUX_BUILD_DIR}/t/kvs/commit_order -f 64 -c 4096 test.busy &
+        pid=$! &&
+        for i in $(seq 1 10); do \
+            run_timeout 5 flux kvs put --namespace=busytestns test.busy=$i \
+                || return 1; \
+            VERS=$(flux kvs version --namespace=busytestns) && \
+            run_timeout 5 flux exec -n -r 1 \
+                sh -c "flux kvs wait --namespace=busytestns ${VERS}" \
+                || return 1; \
+        done &&
+        wait $pid &&
+        echo "10" > busy.exp &&
+        flux exec -n -r 1 sh -c "flux kvs get --namespace=busytestns test.busy" > busy.out &&
+        test_cmp busy.exp busy.out &&
+        flux kvs namespace remove busytestns
+'
+
 #
 # test read-your-writes consistency
 #
@@ -486,6 +526,21 @@ test_expect_success NO_ASAN 'kvs: clear stats globally' '
         flux exec -n sh -c "flux module stats --parse \"namespace.primary.#no-op stores\" kvs | grep -q 0"
 '
 
+#
+# test commits relayed through interior ranks
+#
+
+test_expect_success 'kvs: concurrent commits from all ranks are relayed' '
+        flux kvs unlink -Rf $DIR &&
+        flux exec -n sh -c "for i in \$(seq 1 8); do \
+                flux kvs put --no-merge $DIR.\$(flux getattr rank).\$i=\$i & \
+                flux kvs put $DIR.\$(flux getattr rank).m\$i=\$i & \
+            done; wait" &&
+        for i in `seq 0 $((${SIZE} - 1))`; do
+            test $(flux kvs ls -1 $DIR.$i | wc -l) -eq 16 || return 1
+        done
+'
+
 #
 # test fence api
 #
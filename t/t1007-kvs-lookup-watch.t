@@ -72,6 +72,34 @@ test_expect_success NO_CHAIN_LINT 'flux kvs get --watch returns commit order' '
 	test_monotonicity <seq.out
 '
 
+test_expect_success NO_CHAIN_LINT,HAVE_JQ 'flux kvs get --watch observes each commit of a batched setroot event' '
+	flux kvs put test.batch=1 &&
+	flux exec -n -r 1 flux kvs get --watch --count=4 test.batch \
+		>batch.out &
+	pid=$! &&
+	$waitfile --count=1 --timeout=10 \
+		  --pattern="[0-9]+" batch.out >/dev/null &&
+	flux event sub --count=1 kvs.namespace-primary-setroot \
+		>batch-event.out &
+	evpid=$! &&
+	VERS=$(flux kvs version) &&
+	${FLUX_BUILD_DIR}/t/kvs/setrootevents --pause &&
+	putpids="" &&
+	for i in 2 3 4; \
+	    do flux kvs put --no-merge test.batch=$i & \
+	    putpids="$putpids $!" && \
+	    VERS=$(($VERS+1)) && \
+	    flux kvs wait $VERS || return 1; \
+	done &&
+	${FLUX_BUILD_DIR}/t/kvs/setrootevents --unpause &&
+	wait $putpids &&
+	wait $evpid &&
+	wait $pid &&
+	cut -f2 batch-event.out | jq -e ".setroots | length == 3" &&
+	printf "1\n2\n3\n4\n" >batch.exp &&
+	test_cmp batch.exp batch.out
+'
+
 test_expect_success 'kvs/commit_order test works (similar to above, with higher concurrency)' '
 	$FLUX_BUILD_DIR/t/kvs/commit_order -f 16 -c 1024 test.d
 '
@@ -665,4 +693,8 @@ test_expect_success 'flux kvs get --watch allows owner access to guest ns' '
 test_expect_success 'kvs-watch.lookup request with empty payload fails with EPROTO(71)' '
 	${RPC} kvs-watch.lookup 71 </dev/null
 '
+
+test_expect_success 'kvs-watch.lookup with credit pauses and resumes watcher' '
+	${FLUX_BUILD_DIR}/t/kvs/watch_credit
+'
 test_done
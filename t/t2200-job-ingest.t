@@ -25,6 +25,7 @@ BINDINGS_VALIDATOR=${FLUX_SOURCE_DIR}/src/modules/job-ingest/validators/validate
 JSONSCHEMA_VALIDATOR=${FLUX_SOURCE_DIR}/src/modules/job-ingest/validators/validate-schema.py
 FAKE_VALIDATOR=${SHARNESS_TEST_SRCDIR}/ingest/fake-validate.sh
 BAD_VALIDATOR=${SHARNESS_TEST_SRCDIR}/ingest/bad-validate.sh
+COUNT_VALIDATOR=${SHARNESS_TEST_SRCDIR}/ingest/count-validate.sh
 
 DUMMY_EVENTLOG=test.ingest.eventlog
 
@@ -158,6 +159,36 @@ test_expect_success NO_ASAN 'job-ingest: submit job 100 times, reuse signature'
 	${SUBMITBENCH} ${SUBMITBENCH_OPT_R} -r 100 use_case_2.6.json
 '
 
+test_expect_success NO_ASAN 'job-ingest: submit job 100 times in batches of 10' '
+	${SUBMITBENCH} -b 10 -r 100 use_case_2.6.json >batch.ids &&
+	test $(wc -l <batch.ids) -eq 100 &&
+	sort -n batch.ids | uniq >batch.sorted &&
+	test_cmp batch.ids batch.sorted
+'
+
+test_expect_success HAVE_JQ 'job-ingest: batch with an undecodable J fails that job' '
+	cat >batch.json <<-EOF &&
+	{"jobs":[{"J":"badjob"}], "urgency":16, "flags":0}
+	EOF
+	${RPC} job-ingest.submit-batch <batch.json >batch.out &&
+	jq -e ".jobs[0].errnum" batch.out
+'
+
+test_expect_success 'job-ingest: batch with an invalid jobspec rejects only that job' '
+	echo "{\"version\":1}" >invalid.json &&
+	test_must_fail ${SUBMITBENCH} -b 2 -r 2 \
+		use_case_2.6.json invalid.json >mixed.out &&
+	cat mixed.out &&
+	test $(wc -l <mixed.out) -eq 2 &&
+	head -1 mixed.out | grep "^[0-9][0-9]*$" &&
+	tail -1 mixed.out | grep "^error [0-9][0-9]*: Missing key"
+'
+
+test_expect_success 'submit-batch request with empty jobs array fails with EPROTO(71)' '
+	echo "{\"jobs\":[], \"urgency\":16, \"flags\":0}" \
+		| ${RPC} job-ingest.submit-batch 71
+'
+
 test_expect_success HAVE_FLUX_SECURITY 'job-ingest: submit user != signed user fails' '
 	! FLUX_HANDLE_USERID=9999 flux job submit basic.json 2>baduser.out &&
 	grep -q "signer=$(id -u) != requestor=9999" baduser.out
@@ -215,6 +246,69 @@ test_expect_success 'job-ingest: validator unexpected exit is handled' '
 	grep "unexpectedly exited" badvalidator.out
 '
 
+test_expect_success 'job-ingest: validator results are cached' '
+	ingest_module reload \
+		validator=${COUNT_VALIDATOR} validator-args=$(pwd)/count.out &&
+	flux job submit basic.json &&
+	flux job submit basic.json &&
+	test $(wc -l <count.out) -eq 1
+'
+
+test_expect_success 'job-ingest: config reload flushes validator cache' '
+	flux config reload &&
+	flux job submit basic.json &&
+	test $(wc -l <count.out) -eq 2
+'
+
+test_expect_success 'job-ingest: validator-cache=0 disables the cache' '
+	rm -f count.out &&
+	ingest_module reload \
+		validator=${COUNT_VALIDATOR} validator-args=$(pwd)/count.out \
+		validator-cache=0 &&
+	flux job submit basic.json &&
+	flux job submit basic.json &&
+	test $(wc -l <count.out) -eq 2
+'
+
+test_expect_success 'job-ingest: invalid validator-cache is rejected' '
+	flux module remove job-ingest &&
+	test_must_fail flux module load job-ingest \
+		validator=${COUNT_VALIDATOR} validator-cache=-1 &&
+	flux module load job-ingest
+'
+
+test_expect_success 'job-ingest: reload with built-in validator' '
+	ingest_module reload
+'
+
+test_expect_success 'job-ingest: valid jobspecs accepted by built-in validator' '
+	test_valid ${JOBSPEC}/valid/*
+'
+
+test_expect_success 'job-ingest: invalid jobs rejected by built-in validator' '
+	test_invalid ${JOBSPEC}/invalid/*
+'
+
+test_expect_success 'job-ingest: built-in validator reports the reason' '
+	${Y2J} <${JOBSPEC}/invalid/resource_slot_not_labelled.yaml \
+		>nolabel.json &&
+	test_must_fail flux job submit nolabel.json 2>nolabel.out &&
+	grep "slots must have labels" nolabel.out
+'
+
+test_expect_success 'job-ingest: built-in validator with version 1 enforced' '
+	ingest_module reload validator-args="--require-version,1" &&
+	test_valid ${JOBSPEC}/valid_v1/*
+'
+
+test_expect_success 'job-ingest: unknown args fall back to python validator' '
+	flux dmesg -C &&
+	flux module reload job-ingest validator-args=--require-version,2 &&
+	flux dmesg | grep "built-in validator does not support" &&
+	test_must_fail flux job submit basic.json &&
+	flux module reload job-ingest
+'
+
 test_expect_success 'job-ingest: reload dummy job-manager in fail mode' '
 	ingest_module reload batch-count=4 &&
 	flux module remove job-manager &&
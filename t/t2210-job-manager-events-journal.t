@@ -341,6 +341,148 @@ test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: eventlog seqs are correc
         kill -s USR1 $pid &&
         wait $pid
 '
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: events-journal works with credit' '
+        $jq -j -c -n "{credit:1}" \
+          | $EVENTS_JOURNAL_STREAM > events10.out &
+        pid=$! &&
+        jobid=`flux job submit basic.json | flux job id` &&
+        wait_event_name ${jobid} clean events10.out &&
+        check_event_name ${jobid} submit events10.out &&
+        check_event_name ${jobid} alloc events10.out &&
+        check_event_name ${jobid} start events10.out &&
+        check_event_name ${jobid} finish events10.out &&
+        kill -s USR1 $pid &&
+        wait $pid
+'
+
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: events-journal ends stream when held events overflow' '
+        $jq -j -c -n "{credit:1}" \
+          | $EVENTS_JOURNAL_STREAM --hold > events10a.out 2> events10a.err &
+        pid=$! &&
+        for i in $(seq 1 8); do \
+            flux job submit basic.json || return 1; \
+        done > overflow.ids &&
+        flux job wait-event $(tail -1 overflow.ids) clean &&
+        test_must_fail wait $pid &&
+        grep "too many events held" events10a.err
+'
+
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: events-journal ids filter works' '
+        flux queue stop &&
+        jobid1=`flux job submit basic.json | flux job id` &&
+        jobid2=`flux job submit basic.json | flux job id` &&
+        $jq -j -c -n "{ids:[${jobid1}]}" \
+          | $EVENTS_JOURNAL_STREAM > events11.out &
+        pid=$! &&
+        flux queue start &&
+        flux job wait-event ${jobid2} clean &&
+        wait_event_name ${jobid1} clean events11.out &&
+        check_event_name ${jobid1} submit events11.out &&
+        check_event_name ${jobid1} start events11.out &&
+        test_must_fail check_event_name ${jobid2} submit events11.out &&
+        test_must_fail check_event_name ${jobid2} clean events11.out &&
+        kill -s USR1 $pid &&
+        wait $pid
+'
+
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: events-journal ids added in-stream are backfilled' '
+        jobid=`flux job submit basic.json | flux job id` &&
+        flux job wait-event ${jobid} clean &&
+        $jq -j -c -n "{ids:[]}" \
+          | $EVENTS_JOURNAL_STREAM "{\"add\":[${jobid}]}" > events12.out &
+        pid=$! &&
+        wait_event_name ${jobid} clean events12.out &&
+        check_event_name_eventlog_seq ${jobid} 0 submit events12.out &&
+        check_event_name ${jobid} start events12.out &&
+        test $(grep -c "\"name\": \"clean\"" events12.out) -eq 1 &&
+        kill -s USR1 $pid &&
+        wait $pid
+'
+
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: events-journal ids removed in-stream are not sent' '
+        flux queue stop &&
+        jobid=`flux job submit basic.json | flux job id` &&
+        $jq -j -c -n "{ids:[]}" \
+          | $EVENTS_JOURNAL_STREAM "{\"add\":[${jobid}]}" \
+                "{\"remove\":[${jobid}]}" > events13.out &
+        pid=$! &&
+        wait_event_name ${jobid} submit events13.out &&
+        flux queue start &&
+        flux job wait-event ${jobid} clean &&
+        kill -s USR1 $pid &&
+        wait $pid &&
+        test_must_fail check_event_name ${jobid} start events13.out &&
+        test_must_fail check_event_name ${jobid} clean events13.out
+'
+
+test_expect_success HAVE_JQ 'job-manager: events-journal update fails on stream without ids' '
+        $jq -j -c -n "{}" \
+          | test_must_fail $EVENTS_JOURNAL_STREAM "{\"add\":[1]}" \
+            2> update1.err &&
+        grep "not opened with ids" update1.err
+'
+
+test_expect_success HAVE_JQ 'job-manager: events-journal update fails on bad jobid array' '
+        $jq -j -c -n "{ids:[]}" \
+          | test_must_fail $EVENTS_JOURNAL_STREAM "{\"add\":[\"foo\"]}" \
+            2> update2.err &&
+        grep "should be arrays of jobids" update2.err
+'
+
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: events-journal userid filter works' '
+        $jq -j -c -n "{userid:9999}" \
+          | $EVENTS_JOURNAL_STREAM > events14.out &
+        pid1=$! &&
+        $jq -j -c -n "{userid:$(id -u)}" \
+          | $EVENTS_JOURNAL_STREAM > events15.out &
+        pid2=$! &&
+        jobid=`flux job submit basic.json | flux job id` &&
+        wait_event_name ${jobid} clean events15.out &&
+        kill -s USR1 $pid1 $pid2 &&
+        wait $pid1 &&
+        wait $pid2 &&
+        test_must_be_empty events14.out
+'
+
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: events-journal guests only see their own jobs' '
+        $jq -j -c -n "{}" \
+          | FLUX_HANDLE_ROLEMASK=0x2 FLUX_HANDLE_USERID=9999 \
+            $EVENTS_JOURNAL_STREAM > events16.out &
+        pid1=$! &&
+        $jq -j -c -n "{}" \
+          | $EVENTS_JOURNAL_STREAM > events17.out &
+        pid2=$! &&
+        jobid=`flux job submit basic.json | flux job id` &&
+        wait_event_name ${jobid} clean events17.out &&
+        kill -s USR1 $pid1 $pid2 &&
+        wait $pid1 &&
+        wait $pid2 &&
+        test_must_be_empty events16.out
+'
+
+test_expect_success HAVE_JQ,NO_CHAIN_LINT 'job-manager: events-journal guest ids stream receives own job events' '
+        flux queue stop &&
+        jobid=`FLUX_HANDLE_ROLEMASK=0x2 flux job submit basic.json \
+          | flux job id` &&
+        $jq -j -c -n "{ids:[]}" \
+          | FLUX_HANDLE_ROLEMASK=0x2 \
+            $EVENTS_JOURNAL_STREAM "{\"add\":[${jobid}]}" > events18.out &
+        pid=$! &&
+        wait_event_name ${jobid} submit events18.out &&
+        flux queue start &&
+        wait_event_name ${jobid} clean events18.out &&
+        check_event_name ${jobid} start events18.out &&
+        kill -s USR1 $pid &&
+        wait $pid
+'
+
+test_expect_success HAVE_JQ 'job-manager: events-journal guests cannot watch other users' '
+        $jq -j -c -n "{userid:$(id -u)}" > cc5.in &&
+        test_must_fail env FLUX_HANDLE_ROLEMASK=0x2 FLUX_HANDLE_USERID=9999 \
+            $EVENTS_JOURNAL_STREAM < cc5.in 2> cc5.err &&
+        grep "guests can only watch their own jobs" cc5.err
+'
+
 test_expect_success 'job-manager: events-journal request fails with EPROTO on empty payload' '
         $RPC job-manager.events-journal 71 < /dev/null
 '
@@ -362,4 +504,22 @@ test_expect_success HAVE_JQ 'job-manager: events-journal request fails if deny n
         grep "deny should be an object" cc3.err
 '
 
+test_expect_success HAVE_JQ 'job-manager: events-journal request fails if credit not positive' '
+        $jq -j -c -n "{credit:0}" > cc4.in &&
+        test_must_fail $EVENTS_JOURNAL_STREAM < cc4.in 2> cc4.err &&
+        grep "credit should be positive" cc4.err
+'
+
+test_expect_success HAVE_JQ 'job-manager: events-journal request fails if ids not an array' '
+        $jq -j -c -n "{ids:5}" > cc6.in &&
+        test_must_fail $EVENTS_JOURNAL_STREAM < cc6.in 2> cc6.err &&
+        grep "ids should be an array" cc6.err
+'
+
+test_expect_success HAVE_JQ 'job-manager: events-journal request fails if ids not jobids' '
+        $jq -j -c -n "{ids:[\"foo\"]}" > cc7.in &&
+        test_must_fail $EVENTS_JOURNAL_STREAM < cc7.in 2> cc7.err &&
+        grep "ids should be an array of jobids" cc7.err
+'
+
 test_done
@@ -70,6 +70,65 @@ test_expect_success 'job-exec: bad job-shell config causes module failure' '
 	) &&
 	grep "error reading config value exec.job-shell" ${name}.log
 '
+test_expect_success 'job-exec: bad max-start-per-loop config causes module failure' '
+	name=bad-mspl &&
+	mkdir ${name}.d &&
+	cat <<-EOF > ${name}.d/exec.toml &&
+	[exec]
+	max-start-per-loop = "foo"
+	EOF
+	( export FLUX_CONF_DIR=${name}.d &&
+	  test_must_fail flux start -s1 flux dmesg > ${name}.log 2>&1
+	) &&
+	grep "error reading config value exec.max-start-per-loop" ${name}.log
+'
+test_expect_success 'job-exec: max-start-per-loop=0 causes module failure' '
+	test_must_fail flux module reload -f job-exec max-start-per-loop=0
+'
+test_expect_success 'job-exec: max-start-per-loop < -1 causes module failure' '
+	flux dmesg -C &&
+	test_must_fail flux module reload -f job-exec max-start-per-loop=-2 &&
+	flux dmesg | grep "max-start-per-loop must be positive or -1"
+'
+test_expect_success 'job-exec: bad max-start-per-loop value causes module failure' '
+	flux dmesg -C &&
+	test_must_fail flux module reload -f job-exec max-start-per-loop=4x &&
+	flux dmesg | grep "invalid max-start-per-loop value: 4x" &&
+	test_must_fail flux module reload -f job-exec max-start-per-loop= &&
+	test_must_fail flux module reload -f job-exec \
+		max-start-per-loop=99999999999999999999
+'
+test_expect_success 'job-exec: job shells start one per loop by default' '
+	name=mspl-default &&
+	flux start -s4 sh -c \
+		"flux mini run -N4 hostname && flux dmesg" > ${name}.log 2>&1 &&
+	grep "started 4 job shells in 4 loop iterations" ${name}.log
+'
+test_expect_success 'job-exec: max-start-per-loop batches job shell starts' '
+	name=mspl &&
+	mkdir ${name}.d &&
+	cat <<-EOF > ${name}.d/exec.toml &&
+	[exec]
+	max-start-per-loop = 2
+	EOF
+	( export FLUX_CONF_DIR=${name}.d &&
+	  flux start -s4 sh -c \
+		"flux mini run -N4 hostname && flux dmesg" > ${name}.log 2>&1
+	) &&
+	grep "started 4 job shells in 2 loop iterations" ${name}.log
+'
+test_expect_success 'job-exec: jobs run with max-start-per-loop=-1' '
+	flux module reload -f job-exec max-start-per-loop=-1 &&
+	flux mini run hostname &&
+	flux module reload -f job-exec
+'
+test_expect_success 'job-exec: max-start-per-loop=-1 starts all shells at once' '
+	name=mspl-unlimited &&
+	flux start -s4 sh -c \
+		"flux module reload -f job-exec max-start-per-loop=-1 \
+		 && flux mini run -N4 hostname && flux dmesg" > ${name}.log 2>&1 &&
+	grep "started 4 job shells in 1 loop iterations" ${name}.log
+'
 test_expect_success 'job-exec: can specify imp path on cmdline' '
 	flux dmesg -C &&
 	flux module reload -f job-exec imp=/path/to/imp &&
@@ -271,6 +271,12 @@ test_expect_success 'job-shell: cover invalid buffer type' '
 	flux job attach $id 2> stderr-invalid-buffering.out &&
 	grep "invalid buffer type" stderr-invalid-buffering.out
 '
+test_expect_success 'job-shell: invalid output.write-batch-size is rejected' '
+	id=$(flux mini submit --setopt "output.write-batch-size=0" hostname) &&
+	flux job wait-event $id clean &&
+	( flux job attach $id; flux dmesg ) > write-batch-size.out 2>&1 &&
+	grep "invalid output.write-batch-size" write-batch-size.out
+'
 test_expect_success 'job-shell: creates missing TMPDIR by default' '
     TMPDIR=$(pwd)/mytmpdir flux mini run true &&
     test -d mytmpdir